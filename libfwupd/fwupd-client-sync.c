@@ -443,6 +443,57 @@ fwupd_client_get_upgrades(FwupdClient *self,
 	return g_steal_pointer(&helper->array);
 }
 
+static void
+fwupd_client_get_upgrades_all_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientHelper *helper = (FwupdClientHelper *)user_data;
+	helper->array =
+	    fwupd_client_get_upgrades_all_finish(FWUPD_CLIENT(source), res, &helper->error);
+	g_main_loop_quit(helper->loop);
+}
+
+/**
+ * fwupd_client_get_upgrades_all:
+ * @self: a #FwupdClient
+ * @cancellable: (nullable): optional #GCancellable
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets all the upgrades for all the devices in one request to the daemon.
+ *
+ * Only the device ID and the releases are set on each returned device, and devices without
+ * any upgrades are not included.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 2.0.1
+ **/
+GPtrArray *
+fwupd_client_get_upgrades_all(FwupdClient *self, GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail(FWUPD_IS_CLIENT(self), NULL);
+	g_return_val_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect(self, cancellable, error))
+		return NULL;
+
+	/* call async version and run loop until complete */
+	helper = fwupd_client_helper_new(self);
+	fwupd_client_get_upgrades_all_async(self,
+					    cancellable,
+					    fwupd_client_get_upgrades_all_cb,
+					    helper);
+	g_main_loop_run(helper->loop);
+	if (helper->array == NULL) {
+		g_propagate_error(error, g_steal_pointer(&helper->error));
+		return NULL;
+	}
+	return g_steal_pointer(&helper->array);
+}
+
 static void
 fwupd_client_get_details_bytes_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -1812,6 +1863,58 @@ fwupd_client_refresh_remote(FwupdClient *self,
 	return TRUE;
 }
 
+static void
+fwupd_client_refresh_remotes_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientHelper *helper = (FwupdClientHelper *)user_data;
+	helper->ret = fwupd_client_refresh_remotes_finish(FWUPD_CLIENT(source), res, &helper->error);
+	g_main_loop_quit(helper->loop);
+}
+
+/**
+ * fwupd_client_refresh_remotes:
+ * @self: a #FwupdClient
+ * @remotes: (element-type FwupdRemote): remotes
+ * @download_flags: download flags, e.g. %FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_P2P
+ * @cancellable: (nullable): optional #GCancellable
+ * @error: (nullable): optional return location for an error
+ *
+ * Refreshes remotes by downloading new metadata for all of them at the same time.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 2.0.1
+ **/
+gboolean
+fwupd_client_refresh_remotes(FwupdClient *self,
+			     GPtrArray *remotes,
+			     FwupdClientDownloadFlags download_flags,
+			     GCancellable *cancellable,
+			     GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail(FWUPD_IS_CLIENT(self), FALSE);
+	g_return_val_if_fail(remotes != NULL, FALSE);
+	g_return_val_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* call async version and run loop until complete */
+	helper = fwupd_client_helper_new(self);
+	fwupd_client_refresh_remotes_async(self,
+					   remotes,
+					   download_flags,
+					   cancellable,
+					   fwupd_client_refresh_remotes_cb,
+					   helper);
+	g_main_loop_run(helper->loop);
+	if (!helper->ret) {
+		g_propagate_error(error, g_steal_pointer(&helper->error));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fwupd_client_modify_remote_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -46,6 +46,9 @@ fwupd_client_get_upgrades(FwupdClient *self,
 			  GCancellable *cancellable,
 			  GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
 GPtrArray *
+fwupd_client_get_upgrades_all(FwupdClient *self, GCancellable *cancellable, GError **error)
+    G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1);
+GPtrArray *
 fwupd_client_get_details(FwupdClient *self,
 			 const gchar *filename,
 			 GCancellable *cancellable,
@@ -179,6 +182,12 @@ fwupd_client_refresh_remote(FwupdClient *self,
 			    GCancellable *cancellable,
 			    GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
 gboolean
+fwupd_client_refresh_remotes(FwupdClient *self,
+			     GPtrArray *remotes,
+			     FwupdClientDownloadFlags download_flags,
+			     GCancellable *cancellable,
+			     GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
+gboolean
 fwupd_client_modify_remote(FwupdClient *self,
 			   const gchar *remote_id,
 			   const gchar *key,
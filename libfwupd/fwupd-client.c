@@ -14,6 +14,7 @@
 #include <gio/gunixfdlist.h>
 #endif
 
+#include <errno.h>
 #include <fcntl.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -78,6 +79,12 @@ typedef struct {
 	gchar *user_agent;
 	GHashTable *hints; /* str:str */
 	GHashTable *immediate_requests; /* str:FwupdRequest */
+	GMutex devices_mutex;		/* for @devices */
+	GHashTable *devices;		/* str:GVariant, the last a{sv} for DeviceChangedDelta */
+	FwupdFeatureFlags feature_flags; /* as accepted by the daemon */
+	GArray *signal_ids;		 /* element-type guint, subscriptions on @proxy */
+	guint signal_device_changed_id;
+	guint signal_device_changed_delta_id;
 } FwupdClientPrivate;
 
 #ifdef HAVE_LIBCURL
@@ -568,13 +575,87 @@ fwupd_client_properties_changed_cb(GDBusProxy *proxy,
 	}
 }
 
+/* @value is either a{sv} or (a{sv}) */
 static void
-fwupd_client_signal_cb(GDBusProxy *proxy,
+fwupd_client_devices_cache_insert(FwupdClient *self, GVariant *value)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	const gchar *device_id = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->devices_mutex);
+	g_autoptr(GVariant) dict = NULL;
+
+	if (g_variant_is_of_type(value, G_VARIANT_TYPE_TUPLE))
+		dict = g_variant_get_child_value(value, 0);
+	else
+		dict = g_variant_ref(value);
+	if (!g_variant_lookup(dict, FWUPD_RESULT_KEY_DEVICE_ID, "&s", &device_id))
+		return;
+	g_hash_table_insert(priv->devices, g_strdup(device_id), g_steal_pointer(&dict));
+}
+
+static void
+fwupd_client_devices_cache_remove(FwupdClient *self, const gchar *device_id)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->devices_mutex);
+	g_hash_table_remove(priv->devices, device_id);
+}
+
+/* returns the new a{sv} for the device, with @changed and @removed applied */
+static GVariant *
+fwupd_client_devices_cache_apply_delta(FwupdClient *self,
+				       const gchar *device_id,
+				       GVariant *changed,
+				       GVariant *removed)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	GVariant *dict_old;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->devices_mutex);
+	g_autoptr(GVariantDict) dict = NULL;
+	g_autoptr(GVariant) dict_new = NULL;
+	g_autoptr(GVariant) dict_tmp = NULL;
+
+	/* if we missed the device being added then this will only be a partial device */
+	dict_old = g_hash_table_lookup(priv->devices, device_id);
+	if (dict_old == NULL)
+		g_debug("no cached device %s for DeviceChangedDelta", device_id);
+	dict_tmp = g_variant_ref_sink(fwupd_device_variant_apply_delta(dict_old, changed, removed));
+	dict = g_variant_dict_new(dict_tmp);
+	g_variant_dict_insert(dict, FWUPD_RESULT_KEY_DEVICE_ID, "s", device_id);
+	dict_new = g_variant_ref_sink(g_variant_dict_end(dict));
+	g_hash_table_insert(priv->devices, g_strdup(device_id), g_variant_ref(dict_new));
+	return g_steal_pointer(&dict_new);
+}
+
+static void
+fwupd_client_emit_device_changed(FwupdClient *self, FwupdDevice *dev)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+
+	g_debug("Emitting ::device-changed(%s)", fwupd_device_get_id(dev));
+	fwupd_client_signal_emit_object(self, SIGNAL_DEVICE_CHANGED, G_OBJECT(dev));
+
+	/* invalidate request */
+	if (fwupd_device_get_status(dev) != FWUPD_STATUS_WAITING_FOR_USER) {
+		FwupdRequest *req =
+		    g_hash_table_lookup(priv->immediate_requests, fwupd_device_get_id(dev));
+		if (req != NULL) {
+			fwupd_client_request_invalidate(self, req);
+			g_hash_table_remove(priv->immediate_requests, fwupd_device_get_id(dev));
+		}
+	}
+}
+
+static void
+fwupd_client_signal_cb(GDBusConnection *connection,
 		       const gchar *sender_name,
+		       const gchar *object_path,
+		       const gchar *interface_name,
 		       const gchar *signal_name,
 		       GVariant *parameters,
-		       FwupdClient *self)
+		       gpointer user_data)
 {
+	FwupdClient *self = FWUPD_CLIENT(user_data);
 	FwupdClientPrivate *priv = GET_PRIVATE(self);
 	g_autoptr(FwupdDevice) dev = NULL;
 	g_autoptr(GError) error = NULL;
@@ -589,6 +670,7 @@ fwupd_client_signal_cb(GDBusProxy *proxy,
 			g_warning("failed to build FwupdDevice[DeviceAdded]: %s", error->message);
 			return;
 		}
+		fwupd_client_devices_cache_insert(self, parameters);
 		g_debug("Emitting ::device-added(%s)", fwupd_device_get_id(dev));
 		fwupd_client_signal_emit_object(self, SIGNAL_DEVICE_ADDED, G_OBJECT(dev));
 		return;
@@ -599,29 +681,44 @@ fwupd_client_signal_cb(GDBusProxy *proxy,
 			g_warning("failed to build FwupdDevice[DeviceRemoved]: %s", error->message);
 			return;
 		}
+		if (fwupd_device_get_id(dev) != NULL)
+			fwupd_client_devices_cache_remove(self, fwupd_device_get_id(dev));
 		g_debug("Emitting ::device-removed(%s)", fwupd_device_get_id(dev));
 		fwupd_client_signal_emit_object(self, SIGNAL_DEVICE_REMOVED, G_OBJECT(dev));
 		return;
 	}
 	if (g_strcmp0(signal_name, "DeviceChanged") == 0) {
+		fwupd_client_devices_cache_insert(self, parameters);
+
+		/* only until the subscription is removed, as DeviceChangedDelta is used instead */
+		if (priv->feature_flags & FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA)
+			return;
 		dev = fwupd_device_new();
 		if (!fwupd_codec_from_variant(FWUPD_CODEC(dev), parameters, &error)) {
 			g_warning("failed to build FwupdDevice[DeviceChanged]: %s", error->message);
 			return;
 		}
-		g_debug("Emitting ::device-changed(%s)", fwupd_device_get_id(dev));
-		fwupd_client_signal_emit_object(self, SIGNAL_DEVICE_CHANGED, G_OBJECT(dev));
-
-		/* invalidate request */
-		if (fwupd_device_get_status(dev) != FWUPD_STATUS_WAITING_FOR_USER) {
-			FwupdRequest *req =
-			    g_hash_table_lookup(priv->immediate_requests, fwupd_device_get_id(dev));
-			if (req != NULL) {
-				fwupd_client_request_invalidate(self, req);
-				g_hash_table_remove(priv->immediate_requests,
-						    fwupd_device_get_id(dev));
-			}
+		fwupd_client_emit_device_changed(self, dev);
+		return;
+	}
+	if (g_strcmp0(signal_name, "DeviceChangedDelta") == 0) {
+		const gchar *device_id = NULL;
+		g_autoptr(GVariant) changed = NULL;
+		g_autoptr(GVariant) removed = NULL;
+		g_autoptr(GVariant) val = NULL;
+
+		/* the daemon has not yet accepted the feature flag */
+		if ((priv->feature_flags & FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA) == 0)
+			return;
+		g_variant_get(parameters, "(&s@a{sv}@as)", &device_id, &changed, &removed);
+		val = fwupd_client_devices_cache_apply_delta(self, device_id, changed, removed);
+		dev = fwupd_device_new();
+		if (!fwupd_codec_from_variant(FWUPD_CODEC(dev), val, &error)) {
+			g_warning("failed to build FwupdDevice[DeviceChangedDelta]: %s",
+				  error->message);
+			return;
 		}
+		fwupd_client_emit_device_changed(self, dev);
 		return;
 	}
 	if (g_strcmp0(signal_name, "DeviceRequest") == 0) {
@@ -645,6 +742,90 @@ fwupd_client_signal_cb(GDBusProxy *proxy,
 	g_debug("Unknown signal name '%s' from %s", signal_name, sender_name);
 }
 
+static guint
+fwupd_client_signal_subscribe(FwupdClient *self, const gchar *signal_name)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	return g_dbus_connection_signal_subscribe(g_dbus_proxy_get_connection(priv->proxy),
+						  g_dbus_proxy_get_name(priv->proxy),
+						  FWUPD_DBUS_INTERFACE,
+						  signal_name,
+						  FWUPD_DBUS_PATH,
+						  NULL,
+						  G_DBUS_SIGNAL_FLAGS_NONE,
+						  fwupd_client_signal_cb,
+						  self,
+						  NULL);
+}
+
+static void
+fwupd_client_signal_unsubscribe(FwupdClient *self, guint *subscription_id)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	if (*subscription_id == 0)
+		return;
+	g_dbus_connection_signal_unsubscribe(g_dbus_proxy_get_connection(priv->proxy),
+					     *subscription_id);
+	*subscription_id = 0;
+}
+
+/* each signal is subscribed on its own so that the bus only sends the ones that are needed, e.g.
+ * not the full DeviceChanged when the client is using DeviceChangedDelta */
+static void
+fwupd_client_signals_subscribe(FwupdClient *self)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	const gchar *signal_names[] = {"Changed",
+				       "DeviceAdded",
+				       "DeviceRemoved",
+				       "DeviceRequest",
+				       NULL};
+	for (guint i = 0; signal_names[i] != NULL; i++) {
+		guint subscription_id = fwupd_client_signal_subscribe(self, signal_names[i]);
+		g_array_append_val(priv->signal_ids, subscription_id);
+	}
+	priv->signal_device_changed_id = fwupd_client_signal_subscribe(self, "DeviceChanged");
+}
+
+static void
+fwupd_client_signals_unsubscribe(FwupdClient *self)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	if (priv->proxy == NULL)
+		return;
+	for (guint i = 0; i < priv->signal_ids->len; i++) {
+		guint *subscription_id = &g_array_index(priv->signal_ids, guint, i);
+		fwupd_client_signal_unsubscribe(self, subscription_id);
+	}
+	g_array_set_size(priv->signal_ids, 0);
+	fwupd_client_signal_unsubscribe(self, &priv->signal_device_changed_id);
+	fwupd_client_signal_unsubscribe(self, &priv->signal_device_changed_delta_id);
+}
+
+/* only one of DeviceChanged or DeviceChangedDelta is needed once the daemon has accepted
+ * the feature flags, but until then both may be subscribed */
+static void
+fwupd_client_signals_ensure_device_changed(FwupdClient *self,
+					   gboolean device_changed,
+					   gboolean device_changed_delta)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	if (priv->proxy == NULL)
+		return;
+	if (device_changed_delta && priv->signal_device_changed_delta_id == 0) {
+		priv->signal_device_changed_delta_id =
+		    fwupd_client_signal_subscribe(self, "DeviceChangedDelta");
+	}
+	if (device_changed && priv->signal_device_changed_id == 0) {
+		priv->signal_device_changed_id =
+		    fwupd_client_signal_subscribe(self, "DeviceChanged");
+	}
+	if (!device_changed_delta)
+		fwupd_client_signal_unsubscribe(self, &priv->signal_device_changed_delta_id);
+	if (!device_changed)
+		fwupd_client_signal_unsubscribe(self, &priv->signal_device_changed_id);
+}
+
 /**
  * fwupd_client_get_main_context:
  * @self: a #FwupdClient
@@ -880,10 +1061,7 @@ fwupd_client_connect_get_proxy_cb(GObject *source, GAsyncResult *res, gpointer u
 			 "g-properties-changed",
 			 G_CALLBACK(fwupd_client_properties_changed_cb),
 			 self);
-	g_signal_connect(G_DBUS_PROXY(priv->proxy),
-			 "g-signal",
-			 G_CALLBACK(fwupd_client_signal_cb),
-			 self);
+	fwupd_client_signals_subscribe(self);
 	val = g_dbus_proxy_get_cached_property(priv->proxy, "DaemonVersion");
 	if (val != NULL)
 		fwupd_client_set_daemon_version(self, g_variant_get_string(val, NULL));
@@ -949,7 +1127,7 @@ fwupd_client_connect_get_connection_cb(GObject *source, GAsyncResult *res, gpoin
 		return;
 	}
 	g_dbus_proxy_new(connection,
-			 G_DBUS_PROXY_FLAGS_NONE,
+			 G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
 			 NULL,
 			 NULL, /* bus_name */
 			 FWUPD_DBUS_PATH,
@@ -1025,7 +1203,7 @@ fwupd_client_connect_async(FwupdClient *self,
 
 	/* typical case */
 	g_dbus_proxy_new_for_bus(G_BUS_TYPE_SYSTEM,
-				 G_DBUS_PROXY_FLAGS_NONE,
+				 G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
 				 NULL,
 				 FWUPD_DBUS_SERVICE,
 				 FWUPD_DBUS_PATH,
@@ -1088,6 +1266,7 @@ fwupd_client_disconnect(FwupdClient *self, GError **error)
 		return FALSE;
 	}
 	g_signal_handlers_disconnect_by_data(priv->proxy, self);
+	fwupd_client_signals_unsubscribe(self);
 	g_clear_object(&priv->proxy);
 
 	/* success */
@@ -1111,6 +1290,7 @@ fwupd_client_quit_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 	}
 
 	/* success */
+	fwupd_client_signals_unsubscribe(self);
 	g_clear_object(&priv->proxy);
 	g_task_return_boolean(task, TRUE);
 }
@@ -1652,6 +1832,7 @@ static void
 fwupd_client_get_devices_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(GTask) task = G_TASK(user_data);
+	FwupdClient *self = g_task_get_source_object(task);
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) array = NULL;
 	g_autoptr(GVariant) val = NULL;
@@ -1669,6 +1850,15 @@ fwupd_client_get_devices_cb(GObject *source, GAsyncResult *res, gpointer user_da
 	}
 	fwupd_device_array_ensure_parents(array);
 
+	/* so that DeviceChangedDelta can be applied to devices added before we connected */
+	if (g_variant_is_of_type(val, G_VARIANT_TYPE("(aa{sv})"))) {
+		g_autoptr(GVariant) untuple = g_variant_get_child_value(val, 0);
+		for (gsize i = 0; i < g_variant_n_children(untuple); i++) {
+			g_autoptr(GVariant) dict = g_variant_get_child_value(untuple, i);
+			fwupd_client_devices_cache_insert(self, dict);
+		}
+	}
+
 	/* success */
 	g_task_return_pointer(task, g_steal_pointer(&array), (GDestroyNotify)g_ptr_array_unref);
 }
@@ -2371,6 +2561,93 @@ fwupd_client_get_upgrades_finish(FwupdClient *self, GAsyncResult *res, GError **
 	return g_task_propagate_pointer(G_TASK(res), error);
 }
 
+static void
+fwupd_client_get_upgrades_all_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK(user_data);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) array = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	val = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &error);
+	if (val == NULL) {
+		fwupd_client_fixup_dbus_error(error);
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	array = fwupd_codec_array_from_variant(val, FWUPD_TYPE_DEVICE, &error);
+	if (array == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+
+	/* success */
+	g_task_return_pointer(task, g_steal_pointer(&array), (GDestroyNotify)g_ptr_array_unref);
+}
+
+/**
+ * fwupd_client_get_upgrades_all_async:
+ * @self: a #FwupdClient
+ * @cancellable: (nullable): optional #GCancellable
+ * @callback: (scope async) (closure callback_data): the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets all the upgrades for all the devices in one request to the daemon.
+ *
+ * You must have called [method@Client.connect_async] on @self before using
+ * this method.
+ *
+ * Since: 2.0.1
+ **/
+void
+fwupd_client_get_upgrades_all_async(FwupdClient *self,
+				    GCancellable *cancellable,
+				    GAsyncReadyCallback callback,
+				    gpointer callback_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail(FWUPD_IS_CLIENT(self));
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+	g_return_if_fail(priv->proxy != NULL);
+
+	/* call into daemon */
+	task = g_task_new(self, cancellable, callback, callback_data);
+	g_dbus_proxy_call(priv->proxy,
+			  "GetUpgradesForAll",
+			  NULL,
+			  G_DBUS_CALL_FLAGS_NONE,
+			  FWUPD_CLIENT_DBUS_PROXY_TIMEOUT,
+			  cancellable,
+			  fwupd_client_get_upgrades_all_cb,
+			  g_steal_pointer(&task));
+}
+
+/**
+ * fwupd_client_get_upgrades_all_finish:
+ * @self: a #FwupdClient
+ * @res: (not nullable): the asynchronous result
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets the result of [method@FwupdClient.get_upgrades_all_async].
+ *
+ * Only the device ID and the releases are set on each returned device, and devices without
+ * any upgrades are not included.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 2.0.1
+ **/
+GPtrArray *
+fwupd_client_get_upgrades_all_finish(FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail(FWUPD_IS_CLIENT(self), NULL);
+	g_return_val_if_fail(g_task_is_valid(res, self), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer(G_TASK(res), error);
+}
+
 static void
 fwupd_client_modify_config_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -4176,6 +4453,69 @@ fwupd_client_refresh_remote_data_free(FwupdClientRefreshRemoteData *data)
 	g_free(data);
 }
 
+static gboolean
+fwupd_client_refresh_remote_signature_unchanged(FwupdRemote *remote, GBytes *signature)
+{
+	GChecksumType checksum_kind;
+	g_autofree gchar *checksum = NULL;
+
+	if (fwupd_remote_get_checksum(remote) == NULL)
+		return FALSE;
+	checksum_kind = fwupd_checksum_guess_kind(fwupd_remote_get_checksum(remote));
+	checksum = g_compute_checksum_for_bytes(checksum_kind, signature);
+	return g_strcmp0(checksum, fwupd_remote_get_checksum(remote)) == 0;
+}
+
+static gboolean
+fwupd_client_refresh_remote_verify_metadata(FwupdRemote *remote, GBytes *metadata, GError **error)
+{
+	GChecksumType checksum_kind;
+	g_autofree gchar *checksum = NULL;
+
+	if (fwupd_remote_get_checksum_metadata(remote) == NULL)
+		return TRUE;
+	checksum_kind = fwupd_checksum_guess_kind(fwupd_remote_get_checksum_metadata(remote));
+	checksum = g_compute_checksum_for_bytes(checksum_kind, metadata);
+	if (g_strcmp0(checksum, fwupd_remote_get_checksum_metadata(remote)) != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_FILE,
+			    "metadata checksum expected %s and got %s",
+			    fwupd_remote_get_checksum_metadata(remote),
+			    checksum);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static GPtrArray *
+fwupd_client_refresh_remote_build_metadata_urls(FwupdRemote *remote,
+						FwupdClientDownloadFlags download_flags,
+						GError **error)
+{
+	g_autoptr(GPtrArray) urls = g_ptr_array_new_with_free_func(g_free);
+
+	/* maybe get metadata from Passim */
+	if (fwupd_remote_has_flag(remote, FWUPD_REMOTE_FLAG_ALLOW_P2P_METADATA) &&
+	    fwupd_remote_get_checksum_metadata(remote) != NULL &&
+	    fwupd_remote_get_username(remote) == NULL &&
+	    fwupd_remote_get_password(remote) == NULL) {
+		g_autofree gchar *basename =
+		    g_path_get_basename(fwupd_remote_get_metadata_uri(remote));
+		g_ptr_array_add(urls,
+				g_strdup_printf("https://localhost:27500/%s?sha256=%s",
+						basename,
+						fwupd_remote_get_checksum_metadata(remote)));
+	}
+	if ((download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_P2P) == 0) {
+		g_autofree gchar *uri = fwupd_remote_build_metadata_uri(remote, error);
+		if (uri == NULL)
+			return NULL;
+		g_ptr_array_add(urls, g_steal_pointer(&uri));
+	}
+	return g_steal_pointer(&urls);
+}
+
 static void
 fwupd_client_refresh_remote_update_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -4214,20 +4554,9 @@ fwupd_client_refresh_remote_metadata_cb(GObject *source, GAsyncResult *res, gpoi
 	data->metadata = g_steal_pointer(&bytes);
 
 	/* verify this was what we expected */
-	if (fwupd_remote_get_checksum_metadata(data->remote) != NULL) {
-		GChecksumType checksum_kind =
-		    fwupd_checksum_guess_kind(fwupd_remote_get_checksum_metadata(data->remote));
-		g_autofree gchar *checksum =
-		    g_compute_checksum_for_bytes(checksum_kind, data->metadata);
-		if (g_strcmp0(checksum, fwupd_remote_get_checksum_metadata(data->remote)) != 0) {
-			g_task_return_new_error(task,
-						FWUPD_ERROR,
-						FWUPD_ERROR_INVALID_FILE,
-						"metadata checksum expected %s and got %s",
-						fwupd_remote_get_checksum_metadata(data->remote),
-						checksum);
-			return;
-		}
+	if (!fwupd_client_refresh_remote_verify_metadata(data->remote, data->metadata, &error)) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
 	}
 
 	/* send all this to fwupd */
@@ -4249,7 +4578,7 @@ fwupd_client_refresh_remote_signature_cb(GObject *source, GAsyncResult *res, gpo
 	FwupdClientRefreshRemoteData *data = g_task_get_task_data(task);
 	FwupdClient *self = g_task_get_source_object(task);
 	GCancellable *cancellable = g_task_get_cancellable(task);
-	g_autoptr(GPtrArray) urls = g_ptr_array_new_with_free_func(g_free);
+	g_autoptr(GPtrArray) urls = NULL;
 
 	/* save signature */
 	bytes = fwupd_client_download_bytes_finish(FWUPD_CLIENT(source), res, &error);
@@ -4268,40 +4597,20 @@ fwupd_client_refresh_remote_signature_cb(GObject *source, GAsyncResult *res, gpo
 	}
 
 	/* is the signature checksum the same? */
-	if (fwupd_remote_get_checksum(data->remote) != NULL) {
-		GChecksumType checksum_kind =
-		    fwupd_checksum_guess_kind(fwupd_remote_get_checksum(data->remote));
-		g_autofree gchar *checksum = g_compute_checksum_for_data(
-		    checksum_kind,
-		    (const guchar *)g_bytes_get_data(data->signature, NULL),
-		    g_bytes_get_size(data->signature));
-		if (g_strcmp0(checksum, fwupd_remote_get_checksum(data->remote)) == 0) {
-			g_info("metadata signature of %s is unchanged, skipping",
-			       fwupd_remote_get_id(data->remote));
-			g_task_return_boolean(task, TRUE);
-			return;
-		}
+	if (fwupd_client_refresh_remote_signature_unchanged(data->remote, data->signature)) {
+		g_info("metadata signature of %s is unchanged, skipping",
+		       fwupd_remote_get_id(data->remote));
+		g_task_return_boolean(task, TRUE);
+		return;
 	}
 
 	/* maybe get metadata from Passim */
-	if (fwupd_remote_has_flag(data->remote, FWUPD_REMOTE_FLAG_ALLOW_P2P_METADATA) &&
-	    fwupd_remote_get_checksum_metadata(data->remote) != NULL &&
-	    fwupd_remote_get_username(data->remote) == NULL &&
-	    fwupd_remote_get_password(data->remote) == NULL) {
-		g_autofree gchar *basename =
-		    g_path_get_basename(fwupd_remote_get_metadata_uri(data->remote));
-		g_ptr_array_add(urls,
-				g_strdup_printf("https://localhost:27500/%s?sha256=%s",
-						basename,
-						fwupd_remote_get_checksum_metadata(data->remote)));
-	}
-	if ((data->download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_P2P) == 0) {
-		g_autofree gchar *uri = fwupd_remote_build_metadata_uri(data->remote, &error);
-		if (uri == NULL) {
-			g_task_return_error(task, g_steal_pointer(&error));
-			return;
-		}
-		g_ptr_array_add(urls, g_steal_pointer(&uri));
+	urls = fwupd_client_refresh_remote_build_metadata_urls(data->remote,
+							       data->download_flags,
+							       &error);
+	if (urls == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
 	}
 	fwupd_client_download_bytes2_async(self,
 					   urls,
@@ -4830,16 +5139,29 @@ static void
 fwupd_client_set_feature_flags_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(GTask) task = G_TASK(user_data);
+	FwupdClient *self = g_task_get_source_object(task);
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	FwupdFeatureFlags *feature_flags = g_task_get_task_data(task);
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GVariant) val = NULL;
 
 	val = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &error);
 	if (val == NULL) {
+		gboolean delta = (priv->feature_flags & FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA) > 0;
+		fwupd_client_signals_ensure_device_changed(self, !delta, delta);
 		fwupd_client_fixup_dbus_error(error);
 		g_task_return_error(task, g_steal_pointer(&error));
 		return;
 	}
 
+	/* the daemon will only send what we asked for from now on */
+	priv->feature_flags = *feature_flags;
+	if (priv->feature_flags & FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA) {
+		fwupd_client_signals_ensure_device_changed(self, FALSE, TRUE);
+	} else {
+		fwupd_client_signals_ensure_device_changed(self, TRUE, FALSE);
+	}
+
 	/* success */
 	g_task_return_boolean(task, TRUE);
 }
@@ -4872,8 +5194,13 @@ fwupd_client_set_feature_flags_async(FwupdClient *self,
 	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
 	g_return_if_fail(priv->proxy != NULL);
 
+	/* the bus processes the match rule before the method call, so no delta is missed */
+	if (feature_flags & FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA)
+		fwupd_client_signals_ensure_device_changed(self, TRUE, TRUE);
+
 	/* call into daemon */
 	task = g_task_new(self, cancellable, callback, callback_data);
+	g_task_set_task_data(task, g_memdup2(&feature_flags, sizeof(feature_flags)), g_free);
 	g_dbus_proxy_call(priv->proxy,
 			  "SetFeatureFlags",
 			  g_variant_new("(t)", (guint64)feature_flags),
@@ -5405,14 +5732,9 @@ fwupd_client_download_ipfs(FwupdClient *self,
 	return g_steal_pointer(&bstdout);
 }
 
-static GBytes *
-fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GError **error)
+static void
+fwupd_client_download_http_setup(CURL *curl, const gchar *url, gchar *errbuf, GByteArray *buf)
 {
-	CURLcode res;
-	gchar errbuf[CURL_ERROR_SIZE] = {'\0'};
-	glong status_code = 0;
-	g_autoptr(GByteArray) buf = g_byte_array_new();
-
 	/* relax the SSL checks on localhost URLs and broken corporate proxies */
 	if (fwupd_client_is_localhost(url) || g_getenv("DISABLE_SSL_STRICT") != NULL) {
 		(void)curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
@@ -5422,16 +5744,23 @@ fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GErr
 		(void)curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 1L);
 	}
 
-	fwupd_client_set_status(self, FWUPD_STATUS_DOWNLOADING);
 	(void)curl_easy_setopt(curl, CURLOPT_URL, url);
 	(void)curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errbuf);
 	(void)curl_easy_setopt(curl,
 			       CURLOPT_WRITEFUNCTION,
 			       fwupd_client_download_write_callback_cb);
 	(void)curl_easy_setopt(curl, CURLOPT_WRITEDATA, buf);
-	res = curl_easy_perform(curl);
-	fwupd_client_set_status(self, FWUPD_STATUS_IDLE);
-	fwupd_client_set_percentage(self, 100);
+}
+
+static GBytes *
+fwupd_client_download_http_check(CURL *curl,
+				 CURLcode res,
+				 const gchar *errbuf,
+				 GByteArray *buf,
+				 GError **error)
+{
+	glong status_code = 0;
+
 	if (res != CURLE_OK) {
 		if (errbuf[0] != '\0') {
 			g_set_error(error,
@@ -5499,6 +5828,21 @@ fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GErr
 	return g_bytes_new(buf->data, buf->len);
 }
 
+static GBytes *
+fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GError **error)
+{
+	CURLcode res;
+	gchar errbuf[CURL_ERROR_SIZE] = {'\0'};
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+
+	fwupd_client_download_http_setup(curl, url, errbuf, buf);
+	fwupd_client_set_status(self, FWUPD_STATUS_DOWNLOADING);
+	res = curl_easy_perform(curl);
+	fwupd_client_set_status(self, FWUPD_STATUS_IDLE);
+	fwupd_client_set_percentage(self, 100);
+	return fwupd_client_download_http_check(curl, res, errbuf, buf, error);
+}
+
 static gboolean
 fwupd_client_download_error_is_fatal(const GError *error)
 {
@@ -5678,6 +6022,719 @@ fwupd_client_download_bytes_finish(FwupdClient *self, GAsyncResult *res, GError
 	return g_task_propagate_pointer(G_TASK(res), error);
 }
 
+#ifdef HAVE_LIBCURL
+typedef struct {
+	FwupdCurlHelper *helper;
+	guint url_idx;
+	guint retries;
+	GByteArray *buf;
+	gchar errbuf[CURL_ERROR_SIZE];
+	gchar *if_none_match;
+	gchar *if_modified_since;
+	gchar *etag;
+	gchar *last_modified;
+	gboolean not_modified;
+	GBytes *blob;
+	GError *error;
+} FwupdCurlTransfer;
+
+static void
+fwupd_client_curl_transfer_free(FwupdCurlTransfer *transfer)
+{
+	if (transfer->helper != NULL)
+		fwupd_client_curl_helper_free(transfer->helper);
+	if (transfer->blob != NULL)
+		g_bytes_unref(transfer->blob);
+	if (transfer->error != NULL)
+		g_error_free(transfer->error);
+	g_byte_array_unref(transfer->buf);
+	g_free(transfer->if_none_match);
+	g_free(transfer->if_modified_since);
+	g_free(transfer->etag);
+	g_free(transfer->last_modified);
+	g_free(transfer);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FwupdCurlTransfer, fwupd_client_curl_transfer_free)
+
+static size_t
+fwupd_client_download_header_callback_cb(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+	FwupdCurlTransfer *transfer = (FwupdCurlTransfer *)userdata;
+	gsize realsize = size * nmemb;
+	gchar *value;
+	g_autofree gchar *line = g_strndup(ptr, realsize);
+
+	/* each redirect starts a new set of headers */
+	if (g_str_has_prefix(line, "HTTP/")) {
+		g_clear_pointer(&transfer->etag, g_free);
+		g_clear_pointer(&transfer->last_modified, g_free);
+		return realsize;
+	}
+	value = g_strstr_len(line, -1, ":");
+	if (value == NULL)
+		return realsize;
+	*value = '\0';
+	value = g_strstrip(value + 1);
+	if (g_ascii_strcasecmp(line, "ETag") == 0) {
+		g_free(transfer->etag);
+		transfer->etag = g_strdup(value);
+	} else if (g_ascii_strcasecmp(line, "Last-Modified") == 0) {
+		g_free(transfer->last_modified);
+		transfer->last_modified = g_strdup(value);
+	}
+	return realsize;
+}
+
+static FwupdCurlTransfer *
+fwupd_client_curl_transfer_new(FwupdClient *self,
+			       GPtrArray *urls,
+			       FwupdClientDownloadFlags flags,
+			       GError **error)
+{
+	g_autoptr(FwupdCurlTransfer) transfer = g_new0(FwupdCurlTransfer, 1);
+
+	transfer->buf = g_byte_array_new();
+	transfer->helper = fwupd_client_curl_new(self, error);
+	if (transfer->helper == NULL)
+		return NULL;
+	transfer->helper->urls = fwupd_client_filter_locations(urls, flags, error);
+	if (transfer->helper->urls == NULL)
+		return NULL;
+
+	/* the per-transfer progress would just fight with the other transfers */
+	(void)curl_easy_setopt(transfer->helper->curl, CURLOPT_NOPROGRESS, 1L);
+	(void)curl_easy_setopt(transfer->helper->curl, CURLOPT_PRIVATE, transfer);
+	(void)curl_easy_setopt(transfer->helper->curl,
+			       CURLOPT_HEADERFUNCTION,
+			       fwupd_client_download_header_callback_cb);
+	(void)curl_easy_setopt(transfer->helper->curl, CURLOPT_HEADERDATA, transfer);
+	return g_steal_pointer(&transfer);
+}
+
+static gboolean
+fwupd_client_curl_transfer_start(FwupdClient *self,
+				 CURLM *multi,
+				 FwupdCurlTransfer *transfer,
+				 GError **error)
+{
+	FwupdCurlHelper *helper = transfer->helper;
+	const gchar *url = g_ptr_array_index(helper->urls, transfer->url_idx);
+	CURLMcode rc;
+
+	g_info("downloading %s", url);
+	if (!fwupd_client_curl_helper_set_proxy(self, helper, url, error))
+		return FALSE;
+
+	/* only ask for the content if it changed since we last got it */
+	if (helper->headers != NULL) {
+		curl_slist_free_all(helper->headers);
+		helper->headers = NULL;
+	}
+	if (transfer->if_none_match != NULL) {
+		g_autofree gchar *header =
+		    g_strdup_printf("If-None-Match: %s", transfer->if_none_match);
+		helper->headers = curl_slist_append(helper->headers, header);
+	}
+	if (transfer->if_modified_since != NULL) {
+		g_autofree gchar *header =
+		    g_strdup_printf("If-Modified-Since: %s", transfer->if_modified_since);
+		helper->headers = curl_slist_append(helper->headers, header);
+	}
+	(void)curl_easy_setopt(helper->curl, CURLOPT_HTTPHEADER, helper->headers);
+
+	g_byte_array_set_size(transfer->buf, 0);
+	transfer->errbuf[0] = '\0';
+	fwupd_client_download_http_setup(helper->curl, url, transfer->errbuf, transfer->buf);
+	rc = curl_multi_add_handle(multi, helper->curl);
+	if (rc != CURLM_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "failed to download %s: %s",
+			    url,
+			    curl_multi_strerror(rc));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* returns TRUE if the transfer should be started again */
+static gboolean
+fwupd_client_curl_transfer_done(FwupdClient *self, FwupdCurlTransfer *transfer, CURLcode res)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	FwupdCurlHelper *helper = transfer->helper;
+	const gchar *url = g_ptr_array_index(helper->urls, transfer->url_idx);
+	glong status_code = 0;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	/* the copy we already have is still valid */
+	(void)curl_easy_getinfo(helper->curl, CURLINFO_RESPONSE_CODE, &status_code);
+	if (res == CURLE_OK && status_code == 304) {
+		g_info("%s was not modified", url);
+		transfer->not_modified = TRUE;
+		return FALSE;
+	}
+
+	blob = fwupd_client_download_http_check(helper->curl,
+						res,
+						transfer->errbuf,
+						transfer->buf,
+						&error_local);
+	if (blob != NULL) {
+		transfer->blob = g_steal_pointer(&blob);
+		return FALSE;
+	}
+	if (transfer->retries < priv->download_retries &&
+	    !fwupd_client_download_error_is_fatal(error_local)) {
+		g_debug("ignoring and trying again: %s", error_local->message);
+		transfer->retries++;
+		return TRUE;
+	}
+	if (transfer->url_idx < helper->urls->len - 1) {
+		g_info("failed to download %s: %s, trying next URI…", url, error_local->message);
+		transfer->url_idx++;
+		transfer->retries = 0;
+		return TRUE;
+	}
+	transfer->error = g_steal_pointer(&error_local);
+	return FALSE;
+}
+
+/* downloads all the transfers at the same time, with errors set on each transfer */
+static gboolean
+fwupd_client_download_http_multi(FwupdClient *self,
+				 GPtrArray *transfers,
+				 GCancellable *cancellable,
+				 GError **error)
+{
+	CURLM *multi;
+	gboolean ret = FALSE;
+	guint done = 0;
+
+	/* nothing to do */
+	if (transfers->len == 0)
+		return TRUE;
+
+	multi = curl_multi_init();
+	if (multi == NULL) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INTERNAL,
+				    "failed to setup networking");
+		return FALSE;
+	}
+	fwupd_client_set_status(self, FWUPD_STATUS_DOWNLOADING);
+	fwupd_client_set_percentage(self, 0);
+	for (guint i = 0; i < transfers->len; i++) {
+		FwupdCurlTransfer *transfer = g_ptr_array_index(transfers, i);
+		if (!fwupd_client_curl_transfer_start(self, multi, transfer, error))
+			goto out;
+	}
+	while (done < transfers->len) {
+		CURLMcode rc;
+		CURLMsg *msg;
+		gint msgs_left = 0;
+		gint running = 0;
+
+		rc = curl_multi_perform(multi, &running);
+		if (rc != CURLM_OK) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INTERNAL,
+				    "failed to download: %s",
+				    curl_multi_strerror(rc));
+			goto out;
+		}
+		while ((msg = curl_multi_info_read(multi, &msgs_left)) != NULL) {
+			FwupdCurlTransfer *transfer;
+			char *transfer_ptr = NULL;
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+			(void)curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer_ptr);
+			transfer = (FwupdCurlTransfer *)transfer_ptr;
+			(void)curl_multi_remove_handle(multi, msg->easy_handle);
+			if (fwupd_client_curl_transfer_done(self, transfer, msg->data.result) &&
+			    fwupd_client_curl_transfer_start(self,
+							     multi,
+							     transfer,
+							     &transfer->error))
+				continue;
+			done++;
+			fwupd_client_set_percentage(self, (done * 100) / transfers->len);
+		}
+		if (g_cancellable_set_error_if_cancelled(cancellable, error))
+			goto out;
+		if (running > 0) {
+			rc = curl_multi_wait(multi, NULL, 0, 1000, NULL);
+			if (rc != CURLM_OK) {
+				g_set_error(error,
+					    FWUPD_ERROR,
+					    FWUPD_ERROR_INTERNAL,
+					    "failed to wait for download: %s",
+					    curl_multi_strerror(rc));
+				goto out;
+			}
+		}
+	}
+
+	/* success */
+	ret = TRUE;
+out:
+	for (guint i = 0; i < transfers->len; i++) {
+		FwupdCurlTransfer *transfer = g_ptr_array_index(transfers, i);
+		(void)curl_multi_remove_handle(multi, transfer->helper->curl);
+	}
+	(void)curl_multi_cleanup(multi);
+	fwupd_client_set_status(self, FWUPD_STATUS_IDLE);
+	return ret;
+}
+
+typedef struct {
+	FwupdRemote *remote;
+	gboolean fallback; /* not HTTP, so uses fwupd_client_refresh_remote_async() */
+	GBytes *signature;
+	GBytes *metadata;
+	gchar *etag;
+	gchar *last_modified;
+} FwupdClientRefreshRemotesItem;
+
+static void
+fwupd_client_refresh_remotes_item_free(FwupdClientRefreshRemotesItem *item)
+{
+	if (item->signature != NULL)
+		g_bytes_unref(item->signature);
+	if (item->metadata != NULL)
+		g_bytes_unref(item->metadata);
+	g_object_unref(item->remote);
+	g_free(item->etag);
+	g_free(item->last_modified);
+	g_free(item);
+}
+
+typedef struct {
+	FwupdClientDownloadFlags download_flags;
+	GPtrArray *items; /* element-type FwupdClientRefreshRemotesItem */
+	GKeyFile *validators;
+	gchar *validators_fn;
+	guint idx;
+} FwupdClientRefreshRemotesData;
+
+static void
+fwupd_client_refresh_remotes_data_free(FwupdClientRefreshRemotesData *data)
+{
+	g_ptr_array_unref(data->items);
+	g_key_file_unref(data->validators);
+	g_free(data->validators_fn);
+	g_free(data);
+}
+
+static gchar *
+fwupd_client_refresh_remotes_get_validators_filename(void)
+{
+	const gchar *root = g_getenv("CACHE_DIRECTORY");
+
+	/* if not run from a systemd unit with a cache directory set */
+	if (root == NULL)
+		root = g_get_user_cache_dir();
+	return g_build_filename(root, "fwupd", "remotes-http.conf", NULL);
+}
+
+static void
+fwupd_client_refresh_remotes_load_validators(FwupdClientRefreshRemotesData *data,
+					     FwupdRemote *remote,
+					     FwupdCurlTransfer *transfer)
+{
+	const gchar *id = fwupd_remote_get_id(remote);
+	g_autofree gchar *checksum = g_key_file_get_string(data->validators, id, "Checksum", NULL);
+
+	/* only valid if the daemon still has the signature that was returned with these */
+	if (checksum == NULL || g_strcmp0(checksum, fwupd_remote_get_checksum(remote)) != 0)
+		return;
+	transfer->if_none_match = g_key_file_get_string(data->validators, id, "ETag", NULL);
+	transfer->if_modified_since =
+	    g_key_file_get_string(data->validators, id, "LastModified", NULL);
+}
+
+static void
+fwupd_client_refresh_remotes_thread_cb(GTask *task,
+				       gpointer source_object,
+				       gpointer task_data,
+				       GCancellable *cancellable)
+{
+	FwupdClient *self = FWUPD_CLIENT(source_object);
+	FwupdClientRefreshRemotesData *data = g_task_get_task_data(task);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) items_sig = g_ptr_array_new();
+	g_autoptr(GPtrArray) items_metadata = g_ptr_array_new();
+	g_autoptr(GPtrArray) transfers_sig =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fwupd_client_curl_transfer_free);
+	g_autoptr(GPtrArray) transfers_metadata =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fwupd_client_curl_transfer_free);
+
+	/* download all the signatures at once */
+	for (guint i = 0; i < data->items->len; i++) {
+		FwupdClientRefreshRemotesItem *item = g_ptr_array_index(data->items, i);
+		g_autofree gchar *uri = NULL;
+		g_autoptr(FwupdCurlTransfer) transfer = NULL;
+		g_autoptr(GPtrArray) urls = g_ptr_array_new_with_free_func(g_free);
+
+		if (item->fallback)
+			continue;
+		uri = fwupd_remote_build_metadata_sig_uri(item->remote, &error);
+		if (uri == NULL) {
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		g_ptr_array_add(urls, g_steal_pointer(&uri));
+		transfer = fwupd_client_curl_transfer_new(self,
+							  urls,
+							  FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+							  &error);
+		if (transfer == NULL) {
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		fwupd_client_refresh_remotes_load_validators(data, item->remote, transfer);
+		g_ptr_array_add(items_sig, item);
+		g_ptr_array_add(transfers_sig, g_steal_pointer(&transfer));
+	}
+	if (!fwupd_client_download_http_multi(self, transfers_sig, cancellable, &error)) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+
+	/* only get the metadata for the remotes where the signature changed */
+	for (guint i = 0; i < items_sig->len; i++) {
+		FwupdClientRefreshRemotesItem *item = g_ptr_array_index(items_sig, i);
+		FwupdCurlTransfer *transfer_sig = g_ptr_array_index(transfers_sig, i);
+		g_autoptr(FwupdCurlTransfer) transfer = NULL;
+		g_autoptr(GPtrArray) urls = NULL;
+
+		if (transfer_sig->error != NULL) {
+			g_propagate_prefixed_error(&error,
+						   g_steal_pointer(&transfer_sig->error),
+						   "Failed to download metadata for %s: ",
+						   fwupd_remote_get_id(item->remote));
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		if (transfer_sig->not_modified) {
+			g_info("metadata signature of %s is not modified, skipping",
+			       fwupd_remote_get_id(item->remote));
+			continue;
+		}
+		item->signature = g_steal_pointer(&transfer_sig->blob);
+		item->etag = g_steal_pointer(&transfer_sig->etag);
+		item->last_modified = g_steal_pointer(&transfer_sig->last_modified);
+		if (!fwupd_remote_load_signature_bytes(item->remote, item->signature, &error)) {
+			g_prefix_error(&error, "Failed to load signature: ");
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		if (fwupd_client_refresh_remote_signature_unchanged(item->remote,
+								    item->signature)) {
+			g_info("metadata signature of %s is unchanged, skipping",
+			       fwupd_remote_get_id(item->remote));
+			continue;
+		}
+		urls = fwupd_client_refresh_remote_build_metadata_urls(item->remote,
+								       data->download_flags,
+								       &error);
+		if (urls == NULL) {
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		transfer = fwupd_client_curl_transfer_new(self,
+							  urls,
+							  FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+							  &error);
+		if (transfer == NULL) {
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		g_ptr_array_add(items_metadata, item);
+		g_ptr_array_add(transfers_metadata, g_steal_pointer(&transfer));
+	}
+	if (!fwupd_client_download_http_multi(self, transfers_metadata, cancellable, &error)) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	for (guint i = 0; i < items_metadata->len; i++) {
+		FwupdClientRefreshRemotesItem *item = g_ptr_array_index(items_metadata, i);
+		FwupdCurlTransfer *transfer = g_ptr_array_index(transfers_metadata, i);
+		if (transfer->error != NULL) {
+			g_propagate_prefixed_error(&error,
+						   g_steal_pointer(&transfer->error),
+						   "Failed to download metadata for %s: ",
+						   fwupd_remote_get_id(item->remote));
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		if (!fwupd_client_refresh_remote_verify_metadata(item->remote,
+								 transfer->blob,
+								 &error)) {
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		item->metadata = g_steal_pointer(&transfer->blob);
+	}
+
+	/* success */
+	g_task_return_boolean(task, TRUE);
+}
+
+static void
+fwupd_client_refresh_remotes_save_validators(FwupdClientRefreshRemotesData *data,
+					     FwupdClientRefreshRemotesItem *item)
+{
+	const gchar *id = fwupd_remote_get_id(item->remote);
+	g_autofree gchar *checksum = NULL;
+
+	/* not modified, so keep what we have */
+	if (item->signature == NULL)
+		return;
+	(void)g_key_file_remove_group(data->validators, id, NULL);
+
+	/* the server does not support conditional requests */
+	if (item->etag == NULL && item->last_modified == NULL)
+		return;
+
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, item->signature);
+	g_key_file_set_string(data->validators, id, "Checksum", checksum);
+	if (item->etag != NULL)
+		g_key_file_set_string(data->validators, id, "ETag", item->etag);
+	if (item->last_modified != NULL)
+		g_key_file_set_string(data->validators, id, "LastModified", item->last_modified);
+}
+
+static gboolean
+fwupd_client_refresh_remotes_save(FwupdClientRefreshRemotesData *data, GError **error)
+{
+	g_autofree gchar *dirname = g_path_get_dirname(data->validators_fn);
+	if (g_mkdir_with_parents(dirname, 0755) == -1) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_WRITE,
+			    "failed to create %s: %s",
+			    dirname,
+			    g_strerror(errno));
+		return FALSE;
+	}
+	return g_key_file_save_to_file(data->validators, data->validators_fn, error);
+}
+
+static void
+fwupd_client_refresh_remotes_next(gpointer user_data);
+
+static void
+fwupd_client_refresh_remotes_item_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = G_TASK(user_data);
+	FwupdClientRefreshRemotesData *data = g_task_get_task_data(task);
+	FwupdClientRefreshRemotesItem *item = g_ptr_array_index(data->items, data->idx);
+
+	if (item->fallback) {
+		if (!fwupd_client_refresh_remote_finish(FWUPD_CLIENT(source), res, &error)) {
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+	} else {
+		if (!fwupd_client_update_metadata_bytes_finish(FWUPD_CLIENT(source),
+							       res,
+							       &error)) {
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		fwupd_client_refresh_remotes_save_validators(data, item);
+	}
+	data->idx++;
+	fwupd_client_refresh_remotes_next(g_steal_pointer(&task));
+}
+
+/* sends the new metadata to the daemon one remote at a time */
+static void
+fwupd_client_refresh_remotes_next(gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK(user_data);
+	FwupdClient *self = g_task_get_source_object(task);
+	FwupdClientRefreshRemotesData *data = g_task_get_task_data(task);
+	GCancellable *cancellable = g_task_get_cancellable(task);
+	g_autoptr(GError) error_local = NULL;
+
+	for (; data->idx < data->items->len; data->idx++) {
+		FwupdClientRefreshRemotesItem *item = g_ptr_array_index(data->items, data->idx);
+		if (item->fallback) {
+			fwupd_client_refresh_remote_async(self,
+							  item->remote,
+							  data->download_flags,
+							  cancellable,
+							  fwupd_client_refresh_remotes_item_cb,
+							  g_steal_pointer(&task));
+			return;
+		}
+		if (item->metadata != NULL) {
+			fwupd_client_update_metadata_bytes_async(
+			    self,
+			    fwupd_remote_get_id(item->remote),
+			    item->metadata,
+			    item->signature,
+			    cancellable,
+			    fwupd_client_refresh_remotes_item_cb,
+			    g_steal_pointer(&task));
+			return;
+		}
+
+		/* not modified, or the signature was unchanged */
+		fwupd_client_refresh_remotes_save_validators(data, item);
+	}
+
+	/* not fatal, as we just download the signature again next time */
+	if (!fwupd_client_refresh_remotes_save(data, &error_local))
+		g_info("failed to save %s: %s", data->validators_fn, error_local->message);
+
+	/* success */
+	g_task_return_boolean(task, TRUE);
+}
+
+static void
+fwupd_client_refresh_remotes_download_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = G_TASK(user_data);
+
+	if (!g_task_propagate_boolean(G_TASK(res), &error)) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	fwupd_client_refresh_remotes_next(g_steal_pointer(&task));
+}
+#endif
+
+/**
+ * fwupd_client_refresh_remotes_async:
+ * @self: a #FwupdClient
+ * @remotes: (element-type FwupdRemote): remotes
+ * @download_flags: download flags, e.g. %FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_P2P
+ * @cancellable: (nullable): optional #GCancellable
+ * @callback: (scope async) (closure callback_data): the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Refreshes remotes by downloading new metadata for all of them at the same time.
+ *
+ * The server is asked to only send the metadata signature if it has changed since the last
+ * refresh, and if it has not then the metadata is not downloaded or sent to the daemon.
+ *
+ * NOTE: This method is thread-safe, but progress signals will be
+ * emitted in the global default main context, if not explicitly set with
+ * [method@Client.set_main_context].
+ *
+ * Since: 2.0.1
+ **/
+void
+fwupd_client_refresh_remotes_async(FwupdClient *self,
+				   GPtrArray *remotes,
+				   FwupdClientDownloadFlags download_flags,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data)
+{
+	g_autoptr(GTask) task = NULL;
+#ifdef HAVE_LIBCURL
+	FwupdClientRefreshRemotesData *data;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GTask) task_download = NULL;
+#endif
+
+	g_return_if_fail(FWUPD_IS_CLIENT(self));
+	g_return_if_fail(remotes != NULL);
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	task = g_task_new(self, cancellable, callback, callback_data);
+#ifdef HAVE_LIBCURL
+	data = g_new0(FwupdClientRefreshRemotesData, 1);
+	data->download_flags = download_flags;
+	data->items =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fwupd_client_refresh_remotes_item_free);
+	data->validators = g_key_file_new();
+	data->validators_fn = fwupd_client_refresh_remotes_get_validators_filename();
+	if (g_file_test(data->validators_fn, G_FILE_TEST_EXISTS) &&
+	    !g_key_file_load_from_file(data->validators,
+				       data->validators_fn,
+				       G_KEY_FILE_NONE,
+				       &error_local)) {
+		g_info("ignoring %s: %s", data->validators_fn, error_local->message);
+	}
+	g_task_set_task_data(task,
+			     data,
+			     (GDestroyNotify)fwupd_client_refresh_remotes_data_free);
+
+	for (guint i = 0; i < remotes->len; i++) {
+		FwupdRemote *remote = g_ptr_array_index(remotes, i);
+		FwupdClientRefreshRemotesItem *item;
+
+		/* nothing to do */
+		if (fwupd_remote_get_kind(remote) != FWUPD_REMOTE_KIND_DOWNLOAD) {
+			g_debug("ignoring %s as %s",
+				fwupd_remote_get_id(remote),
+				fwupd_remote_kind_to_string(fwupd_remote_get_kind(remote)));
+			continue;
+		}
+
+		/* sanity check */
+		if (fwupd_remote_get_metadata_uri_sig(remote) == NULL ||
+		    fwupd_remote_get_metadata_uri(remote) == NULL) {
+			g_task_return_new_error(task,
+						FWUPD_ERROR,
+						FWUPD_ERROR_NOT_SUPPORTED,
+						"no metadata URIs for %s",
+						fwupd_remote_get_id(remote));
+			return;
+		}
+		item = g_new0(FwupdClientRefreshRemotesItem, 1);
+		item->remote = g_object_ref(remote);
+		item->fallback =
+		    !fwupd_client_is_url_http(fwupd_remote_get_metadata_uri_sig(remote)) ||
+		    !fwupd_client_is_url_http(fwupd_remote_get_metadata_uri(remote));
+		g_ptr_array_add(data->items, item);
+	}
+
+	/* download in a thread, then send to the daemon in the callback */
+	task_download = g_task_new(self,
+				   cancellable,
+				   fwupd_client_refresh_remotes_download_cb,
+				   g_steal_pointer(&task));
+	g_task_set_task_data(task_download, data, NULL);
+	g_task_run_in_thread(task_download, fwupd_client_refresh_remotes_thread_cb);
+#else
+	g_task_return_new_error(task, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "no libcurl support");
+#endif
+}
+
+/**
+ * fwupd_client_refresh_remotes_finish:
+ * @self: a #FwupdClient
+ * @res: (not nullable): the asynchronous result
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets the result of [method@FwupdClient.refresh_remotes_async].
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 2.0.1
+ **/
+gboolean
+fwupd_client_refresh_remotes_finish(FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail(FWUPD_IS_CLIENT(self), FALSE);
+	g_return_val_if_fail(g_task_is_valid(res, self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean(G_TASK(res), error);
+}
+
 #ifdef HAVE_LIBCURL
 static void
 fwupd_client_upload_bytes_thread_cb(GTask *task,
@@ -7425,6 +8482,10 @@ fwupd_client_init(FwupdClient *self)
 	priv->battery_threshold = FWUPD_BATTERY_LEVEL_INVALID;
 	priv->immediate_requests =
 	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_object_unref);
+	g_mutex_init(&priv->devices_mutex);
+	priv->devices =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+	priv->signal_ids = g_array_new(FALSE, FALSE, sizeof(guint));
 
 	/* we get this one for free */
 	fwupd_client_add_hint(self, "locale", g_getenv("LANG"));
@@ -7448,11 +8509,15 @@ fwupd_client_finalize(GObject *object)
 	g_free(priv->host_security_id);
 	g_hash_table_unref(priv->hints);
 	g_hash_table_unref(priv->immediate_requests);
+	g_hash_table_unref(priv->devices);
+	g_mutex_clear(&priv->devices_mutex);
 	g_mutex_clear(&priv->idle_mutex);
 	if (priv->idle_id != 0)
 		g_source_remove(priv->idle_id);
 	g_ptr_array_unref(priv->idle_sources);
 	g_mutex_clear(&priv->proxy_mutex);
+	fwupd_client_signals_unsubscribe(self);
+	g_array_unref(priv->signal_ids);
 	if (priv->proxy != NULL)
 		g_object_unref(priv->proxy);
 
@@ -173,6 +173,16 @@ fwupd_client_get_upgrades_finish(FwupdClient *self,
 				 GAsyncResult *res,
 				 GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
 void
+fwupd_client_get_upgrades_all_async(FwupdClient *self,
+				    GCancellable *cancellable,
+				    GAsyncReadyCallback callback,
+				    gpointer callback_data) G_GNUC_NON_NULL(1);
+GPtrArray *
+fwupd_client_get_upgrades_all_finish(FwupdClient *self,
+				     GAsyncResult *res,
+				     GError **error) G_GNUC_WARN_UNUSED_RESULT
+    G_GNUC_NON_NULL(1, 2);
+void
 fwupd_client_get_details_bytes_async(FwupdClient *self,
 				     GBytes *bytes,
 				     GCancellable *cancellable,
@@ -391,6 +401,17 @@ fwupd_client_refresh_remote_finish(FwupdClient *self,
 				   GAsyncResult *res,
 				   GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
 void
+fwupd_client_refresh_remotes_async(FwupdClient *self,
+				   GPtrArray *remotes,
+				   FwupdClientDownloadFlags download_flags,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data) G_GNUC_NON_NULL(1, 2);
+gboolean
+fwupd_client_refresh_remotes_finish(FwupdClient *self,
+				    GAsyncResult *res,
+				    GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
+void
 fwupd_client_modify_remote_async(FwupdClient *self,
 				 const gchar *remote_id,
 				 const gchar *key,
@@ -734,7 +734,11 @@ fwupd_unix_input_stream_from_bytes(GBytes *bytes, GError **error)
 #endif
 
 #ifdef HAVE_MEMFD_CREATE
+#ifdef F_SEAL_SHRINK
+	fd = memfd_create("fwupd", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
 	fd = memfd_create("fwupd", MFD_CLOEXEC);
+#endif
 #else
 	/* emulate in-memory file by an unlinked temporary file */
 	fd = g_mkstemp(tmp_file);
@@ -770,6 +774,11 @@ fwupd_unix_input_stream_from_bytes(GBytes *bytes, GError **error)
 			    rc);
 		return NULL;
 	}
+#if defined(HAVE_MEMFD_CREATE) && defined(F_SEAL_SHRINK)
+	/* the daemon can map the memfd directly if it is guaranteed not to shrink */
+	if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+		g_debug("failed to seal memfd: %s", g_strerror(errno));
+#endif
 	if (lseek(fd, 0, SEEK_SET) < 0) {
 		g_set_error(error,
 			    FWUPD_ERROR,
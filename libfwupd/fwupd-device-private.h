@@ -14,5 +14,13 @@ G_BEGIN_DECLS
 
 void
 fwupd_device_incorporate(FwupdDevice *self, FwupdDevice *donor) G_GNUC_NON_NULL(1, 2);
+gboolean
+fwupd_device_variant_diff(GVariant *val_old,
+			  GVariant *val_new,
+			  GVariantBuilder *changed,
+			  GVariantBuilder *removed) G_GNUC_NON_NULL(2, 3, 4);
+GVariant *
+fwupd_device_variant_apply_delta(GVariant *val_old, GVariant *changed, GVariant *removed)
+    G_GNUC_NON_NULL(2, 3);
 
 G_END_DECLS
@@ -4003,6 +4003,96 @@ fwupd_device_array_ensure_parents(GPtrArray *devices)
 	}
 }
 
+/**
+ * fwupd_device_variant_diff:
+ * @val_old: (nullable): the last `a{sv}` for the device
+ * @val_new: the current `a{sv}` for the device
+ * @changed: a #GVariantBuilder of type `a{sv}`
+ * @removed: a #GVariantBuilder of type `as`
+ *
+ * Adds the properties that have been added or changed to @changed, and the keys of the
+ * properties that have been removed to @removed.
+ *
+ * Returns: %TRUE if the device has changed
+ *
+ * Since: 2.0.1
+ **/
+gboolean
+fwupd_device_variant_diff(GVariant *val_old,
+			  GVariant *val_new,
+			  GVariantBuilder *changed,
+			  GVariantBuilder *removed)
+{
+	const gchar *key;
+	gboolean ret = FALSE;
+	GVariant *value;
+	GVariantIter iter;
+	g_autoptr(GVariantDict) dict_old = g_variant_dict_new(val_old);
+	g_autoptr(GVariantDict) dict_new = g_variant_dict_new(val_new);
+
+	g_return_val_if_fail(val_new != NULL, FALSE);
+	g_return_val_if_fail(changed != NULL, FALSE);
+	g_return_val_if_fail(removed != NULL, FALSE);
+
+	/* added or changed */
+	g_variant_iter_init(&iter, val_new);
+	while (g_variant_iter_next(&iter, "{&sv}", &key, &value)) {
+		g_autoptr(GVariant) value_old = g_variant_dict_lookup_value(dict_old, key, NULL);
+		if (value_old == NULL || !g_variant_equal(value_old, value)) {
+			g_variant_builder_add(changed, "{sv}", key, value);
+			ret = TRUE;
+		}
+		g_variant_unref(value);
+	}
+
+	/* removed */
+	if (val_old == NULL)
+		return ret;
+	g_variant_iter_init(&iter, val_old);
+	while (g_variant_iter_next(&iter, "{&sv}", &key, &value)) {
+		if (!g_variant_dict_contains(dict_new, key)) {
+			g_variant_builder_add(removed, "s", key);
+			ret = TRUE;
+		}
+		g_variant_unref(value);
+	}
+	return ret;
+}
+
+/**
+ * fwupd_device_variant_apply_delta:
+ * @val_old: (nullable): the last `a{sv}` for the device
+ * @changed: the `a{sv}` of added or changed properties
+ * @removed: the `as` of removed property keys
+ *
+ * Applies the output of fwupd_device_variant_diff() to the last `a{sv}` for the device.
+ *
+ * Returns: (transfer full): a floating `a{sv}`
+ *
+ * Since: 2.0.1
+ **/
+GVariant *
+fwupd_device_variant_apply_delta(GVariant *val_old, GVariant *changed, GVariant *removed)
+{
+	const gchar *key;
+	GVariant *value;
+	GVariantIter iter;
+	g_autoptr(GVariantDict) dict = g_variant_dict_new(val_old);
+
+	g_return_val_if_fail(changed != NULL, NULL);
+	g_return_val_if_fail(removed != NULL, NULL);
+
+	g_variant_iter_init(&iter, changed);
+	while (g_variant_iter_next(&iter, "{&sv}", &key, &value)) {
+		g_variant_dict_insert_value(dict, key, value);
+		g_variant_unref(value);
+	}
+	g_variant_iter_init(&iter, removed);
+	while (g_variant_iter_next(&iter, "&s", &key))
+		g_variant_dict_remove(dict, key);
+	return g_variant_dict_end(dict);
+}
+
 /**
  * fwupd_device_compare:
  * @self1: (not nullable): a device
@@ -428,6 +428,10 @@ fwupd_plugin_flag_to_string(FwupdPluginFlags plugin_flag)
 		return "ready";
 	if (plugin_flag == FWUPD_PLUGIN_FLAG_TEST_ONLY)
 		return "test-only";
+	if (plugin_flag == FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL)
+		return "thread-safe-install";
+	if (plugin_flag == FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE)
+		return "security-attrs-cacheable";
 	return NULL;
 }
 
@@ -484,6 +488,10 @@ fwupd_plugin_flag_from_string(const gchar *plugin_flag)
 		return FWUPD_PLUGIN_FLAG_READY;
 	if (g_strcmp0(plugin_flag, "test-only") == 0)
 		return FWUPD_PLUGIN_FLAG_TEST_ONLY;
+	if (g_strcmp0(plugin_flag, "thread-safe-install") == 0)
+		return FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL;
+	if (g_strcmp0(plugin_flag, "security-attrs-cacheable") == 0)
+		return FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE;
 	return FWUPD_PLUGIN_FLAG_UNKNOWN;
 }
 
@@ -578,6 +586,8 @@ fwupd_feature_flag_to_string(FwupdFeatureFlags feature_flag)
 		return "allow-authentication";
 	if (feature_flag == FWUPD_FEATURE_FLAG_REQUESTS_NON_GENERIC)
 		return "requests-non-generic";
+	if (feature_flag == FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA)
+		return "device-changed-delta";
 	return NULL;
 }
 
@@ -616,6 +626,8 @@ fwupd_feature_flag_from_string(const gchar *feature_flag)
 		return FWUPD_FEATURE_FLAG_ALLOW_AUTHENTICATION;
 	if (g_strcmp0(feature_flag, "requests-non-generic") == 0)
 		return FWUPD_FEATURE_FLAG_REQUESTS_NON_GENERIC;
+	if (g_strcmp0(feature_flag, "device-changed-delta") == 0)
+		return FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA;
 	return FWUPD_FEATURE_FLAG_UNKNOWN;
 }
 
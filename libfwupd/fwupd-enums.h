@@ -234,6 +234,14 @@ typedef enum {
 	 * Since: 1.9.8
 	 */
 	FWUPD_FEATURE_FLAG_REQUESTS_NON_GENERIC = 1 << 9, /* Since: 1.9.8 */
+	/**
+	 * FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA:
+	 *
+	 * Can apply the changed properties from the `DeviceChangedDelta` signal.
+	 *
+	 * Since: 2.0.1
+	 */
+	FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA = 1 << 10, /* Since: 2.0.1 */
 	/*< private >*/
 	FWUPD_FEATURE_FLAG_UNKNOWN = G_MAXUINT64,
 } FwupdFeatureFlags;
@@ -1009,6 +1017,23 @@ typedef enum {
 	 * Since: 2.0.0
 	 */
 	FWUPD_PLUGIN_FLAG_TEST_ONLY = 1ull << 18,
+	/**
+	 * FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL:
+	 *
+	 * The plugin can write firmware to different devices at the same time from worker threads.
+	 *
+	 * Since: 2.0.1
+	 */
+	FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL = 1ull << 19,
+	/**
+	 * FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE:
+	 *
+	 * The plugin only changes its host security attributes when one of its devices changes or
+	 * after signalling a security change, and so the attributes can be cached.
+	 *
+	 * Since: 2.0.1
+	 */
+	FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE = 1ull << 20,
 	/**
 	 * FWUPD_PLUGIN_FLAG_UNKNOWN:
 	 *
@@ -6,6 +6,8 @@
 
 #include "config.h"
 
+#include <glib/gstdio.h>
+#include <jcat.h>
 #include <locale.h>
 #include <string.h>
 
@@ -15,6 +17,7 @@
 #include "fwupd-codec.h"
 #include "fwupd-common.h"
 #include "fwupd-device-private.h"
+#include "fwupd-enums-private.h"
 #include "fwupd-enums.h"
 #include "fwupd-error.h"
 #include "fwupd-plugin.h"
@@ -112,7 +115,7 @@ fwupd_enums_func(void)
 		g_assert_cmpstr(tmp, !=, NULL);
 		g_assert_cmpint(fwupd_feature_flag_from_string(tmp), ==, i);
 	}
-	for (guint64 i = 1; i <= FWUPD_FEATURE_FLAG_ALLOW_AUTHENTICATION; i *= 2) {
+	for (guint64 i = 1; i <= FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA; i *= 2) {
 		const gchar *tmp = fwupd_feature_flag_to_string(i);
 		if (tmp == NULL)
 			g_warning("missing feature flag 0x%x", (guint)i);
@@ -550,6 +553,74 @@ fwupd_common_history_report_func(void)
 			"}");
 }
 
+static void
+fwupd_device_variant_delta_func(void)
+{
+	gboolean ret;
+	GVariantBuilder changed;
+	GVariantBuilder removed;
+	g_autofree gchar *str_applied = NULL;
+	g_autofree gchar *str_new = NULL;
+	g_autoptr(FwupdDevice) dev_applied = fwupd_device_new();
+	g_autoptr(FwupdDevice) dev_new = fwupd_device_new();
+	g_autoptr(FwupdDevice) dev_old = fwupd_device_new();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) val_applied = NULL;
+	g_autoptr(GVariant) val_changed = NULL;
+	g_autoptr(GVariant) val_new = NULL;
+	g_autoptr(GVariant) val_old = NULL;
+	g_autoptr(GVariant) val_removed = NULL;
+	g_autoptr(GVariantDict) dict_changed = NULL;
+
+	fwupd_device_set_id(dev_old, "USB:foo");
+	fwupd_device_set_name(dev_old, "ColorHug2");
+	fwupd_device_set_summary(dev_old, "Colorimeter");
+	fwupd_device_add_guid(dev_old, "2082b5e0-7a64-478a-b1b2-e3404fab6dad");
+	val_old = g_variant_ref_sink(fwupd_codec_to_variant(FWUPD_CODEC(dev_old),
+							    FWUPD_CODEC_FLAG_NONE));
+
+	/* one property changed, one added and one removed */
+	fwupd_device_set_id(dev_new, "USB:foo");
+	fwupd_device_set_name(dev_new, "ColorHug2");
+	fwupd_device_add_guid(dev_new, "2082b5e0-7a64-478a-b1b2-e3404fab6dad");
+	fwupd_device_add_guid(dev_new, "00000000-0000-0000-0000-000000000000");
+	fwupd_device_set_percentage(dev_new, 50);
+	val_new = g_variant_ref_sink(fwupd_codec_to_variant(FWUPD_CODEC(dev_new),
+							    FWUPD_CODEC_FLAG_NONE));
+
+	/* only the differences are included */
+	g_variant_builder_init(&changed, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_init(&removed, G_VARIANT_TYPE("as"));
+	ret = fwupd_device_variant_diff(val_old, val_new, &changed, &removed);
+	g_assert_true(ret);
+	val_changed = g_variant_ref_sink(g_variant_builder_end(&changed));
+	val_removed = g_variant_ref_sink(g_variant_builder_end(&removed));
+	dict_changed = g_variant_dict_new(val_changed);
+	g_assert_true(g_variant_dict_contains(dict_changed, FWUPD_RESULT_KEY_GUID));
+	g_assert_true(g_variant_dict_contains(dict_changed, FWUPD_RESULT_KEY_PERCENTAGE));
+	g_assert_false(g_variant_dict_contains(dict_changed, FWUPD_RESULT_KEY_NAME));
+	g_assert_cmpint(g_variant_n_children(val_removed), ==, 1);
+
+	/* applying the delta gives the new device */
+	val_applied = g_variant_ref_sink(
+	    fwupd_device_variant_apply_delta(val_old, val_changed, val_removed));
+	ret = fwupd_codec_from_variant(FWUPD_CODEC(dev_applied), val_applied, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpstr(fwupd_device_get_summary(dev_applied), ==, NULL);
+	str_applied = fwupd_codec_to_string(FWUPD_CODEC(dev_applied));
+	str_new = fwupd_codec_to_string(FWUPD_CODEC(dev_new));
+	g_assert_cmpstr(str_applied, ==, str_new);
+
+	/* no changes */
+	g_variant_builder_init(&changed, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_init(&removed, G_VARIANT_TYPE("as"));
+	ret = fwupd_device_variant_diff(val_new, val_new, &changed, &removed);
+	g_assert_false(ret);
+	g_variant_builder_clear(&changed);
+	g_variant_builder_clear(&removed);
+}
+
 static void
 fwupd_device_func(void)
 {
@@ -834,6 +905,170 @@ fwupd_client_remotes_func(void)
 	g_assert_null(remote3);
 }
 
+#ifdef HAVE_LIBCURL
+typedef struct {
+	GBytes *blob;
+	guint cnt_ok;
+	guint cnt_not_modified;
+} FwupdTestHttpServer;
+
+static gboolean
+fwupd_test_http_server_incoming_cb(GSocketService *service,
+				   GSocketConnection *connection,
+				   GObject *source_object,
+				   gpointer user_data)
+{
+	FwupdTestHttpServer *server = (FwupdTestHttpServer *)user_data;
+	GOutputStream *ostr = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+	gboolean not_modified = FALSE;
+	g_autoptr(GDataInputStream) dstr = NULL;
+	g_autoptr(GString) str = g_string_new(NULL);
+
+	/* read the request headers up to the blank line */
+	dstr = g_data_input_stream_new(g_io_stream_get_input_stream(G_IO_STREAM(connection)));
+	g_data_input_stream_set_newline_type(dstr, G_DATA_STREAM_NEWLINE_TYPE_CR_LF);
+	g_filter_input_stream_set_close_base_stream(G_FILTER_INPUT_STREAM(dstr), FALSE);
+	while (TRUE) {
+		g_autofree gchar *line = g_data_input_stream_read_line(dstr, NULL, NULL, NULL);
+		if (line == NULL || line[0] == '\0')
+			break;
+		if (g_strcmp0(line, "If-None-Match: \"abc\"") == 0)
+			not_modified = TRUE;
+	}
+
+	/* only send the content when the client does not already have it */
+	if (not_modified) {
+		g_string_append(str, "HTTP/1.1 304 Not Modified\r\n");
+		server->cnt_not_modified++;
+	} else {
+		g_string_append(str, "HTTP/1.1 200 OK\r\n");
+		g_string_append_printf(str,
+				       "Content-Length: %u\r\n",
+				       (guint)g_bytes_get_size(server->blob));
+		server->cnt_ok++;
+	}
+	g_string_append(str, "ETag: \"abc\"\r\nConnection: close\r\n\r\n");
+	if (!not_modified)
+		g_string_append_len(str,
+				    g_bytes_get_data(server->blob, NULL),
+				    g_bytes_get_size(server->blob));
+	(void)g_output_stream_write_all(ostr, str->str, str->len, NULL, NULL, NULL);
+	(void)g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+	return TRUE;
+}
+
+static void
+fwupd_client_async_result_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	GAsyncResult **result = (GAsyncResult **)user_data;
+	*result = g_object_ref(res);
+}
+
+static void
+fwupd_client_refresh_remotes_func(void)
+{
+	gboolean ret;
+	guint16 port;
+	FwupdTestHttpServer server = {0};
+	g_autofree gchar *cachedir = NULL;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *fn_dir = NULL;
+	g_autofree gchar *metadata_uri = NULL;
+	g_autofree gchar *validators = NULL;
+	g_autoptr(FwupdClient) client = fwupd_client_new();
+	g_autoptr(FwupdRemote) remote = fwupd_remote_new();
+	g_autoptr(GAsyncResult) res1 = NULL;
+	g_autoptr(GAsyncResult) res2 = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GOutputStream) ostr = g_memory_output_stream_new_resizable();
+	g_autoptr(GPtrArray) remotes = g_ptr_array_new();
+	g_autoptr(GSocketService) service = g_socket_service_new();
+	g_autoptr(JcatFile) jcat_file = jcat_file_new();
+	g_autoptr(JcatItem) jcat_item = jcat_item_new("firmware.xml.gz");
+
+	/* save the HTTP validators somewhere we can check */
+	cachedir = g_dir_make_tmp("fwupd-self-test-XXXXXX", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(cachedir);
+	(void)g_setenv("CACHE_DIRECTORY", cachedir, TRUE);
+
+	/* this is the same signature the daemon already has */
+	jcat_file_add_item(jcat_file, jcat_item);
+	ret = jcat_file_export_stream(jcat_file, ostr, JCAT_EXPORT_FLAG_NONE, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_output_stream_close(ostr, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	server.blob = g_memory_output_stream_steal_as_bytes(G_MEMORY_OUTPUT_STREAM(ostr));
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, server.blob);
+
+	/* a stand-in for the real server */
+	port = g_socket_listener_add_any_inet_port(G_SOCKET_LISTENER(service), NULL, &error);
+	g_assert_no_error(error);
+	g_assert_cmpint(port, !=, 0);
+	g_signal_connect(service,
+			 "incoming",
+			 G_CALLBACK(fwupd_test_http_server_incoming_cb),
+			 &server);
+	g_socket_service_start(service);
+
+	metadata_uri = g_strdup_printf("http://127.0.0.1:%u/firmware.xml.gz", port);
+	fwupd_remote_set_id(remote, "self-test");
+	fwupd_remote_set_kind(remote, FWUPD_REMOTE_KIND_DOWNLOAD);
+	fwupd_remote_set_metadata_uri(remote, metadata_uri);
+	fwupd_remote_set_checksum_sig(remote, checksum);
+	g_ptr_array_add(remotes, remote);
+	fwupd_client_set_user_agent(client, "fwupd/2.0.1");
+
+	/* signature is downloaded, but is unchanged so not sent to the daemon */
+	fwupd_client_refresh_remotes_async(client,
+					   remotes,
+					   FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					   NULL,
+					   fwupd_client_async_result_cb,
+					   &res1);
+	while (res1 == NULL)
+		g_main_context_iteration(NULL, TRUE);
+	ret = fwupd_client_refresh_remotes_finish(client, res1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(server.cnt_ok, ==, 1);
+	g_assert_cmpint(server.cnt_not_modified, ==, 0);
+
+	/* the ETag was saved */
+	fn_dir = g_build_filename(cachedir, "fwupd", NULL);
+	fn = g_build_filename(fn_dir, "remotes-http.conf", NULL);
+	ret = g_file_get_contents(fn, &validators, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_nonnull(g_strstr_len(validators, -1, "ETag=\"abc\""));
+
+	/* the server says it has not changed, so nothing else to do */
+	fwupd_client_refresh_remotes_async(client,
+					   remotes,
+					   FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					   NULL,
+					   fwupd_client_async_result_cb,
+					   &res2);
+	while (res2 == NULL)
+		g_main_context_iteration(NULL, TRUE);
+	ret = fwupd_client_refresh_remotes_finish(client, res2, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(server.cnt_ok, ==, 1);
+	g_assert_cmpint(server.cnt_not_modified, ==, 1);
+
+	g_socket_service_stop(service);
+	g_bytes_unref(server.blob);
+	(void)g_unlink(fn);
+	(void)g_rmdir(fn_dir);
+	(void)g_rmdir(cachedir);
+	(void)g_unsetenv("CACHE_DIRECTORY");
+}
+#endif
+
 static gboolean
 fwupd_has_system_bus(void)
 {
@@ -941,6 +1176,7 @@ fwupd_security_attr_func(void)
 	g_autoptr(FwupdSecurityAttr) attr1 = fwupd_security_attr_new("org.fwupd.hsi.bar");
 	g_autoptr(FwupdSecurityAttr) attr2 = fwupd_security_attr_new(NULL);
 	g_autoptr(FwupdSecurityAttr) attr3 = fwupd_security_attr_new(NULL);
+	g_autoptr(FwupdSecurityAttr) attr4 = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GVariant) data = NULL;
 
@@ -1052,6 +1288,18 @@ fwupd_security_attr_func(void)
 	g_assert_no_error(error);
 	g_assert_true(ret);
 
+	/* deep copy */
+	fwupd_security_attr_set_result_fallback(attr1, FWUPD_SECURITY_ATTR_RESULT_NOT_ENABLED);
+	fwupd_security_attr_set_bios_setting_current_value(attr1, "Disabled");
+	attr4 = fwupd_security_attr_copy(attr1);
+	g_assert_cmpint(fwupd_security_attr_get_result_fallback(attr4),
+			==,
+			FWUPD_SECURITY_ATTR_RESULT_NOT_ENABLED);
+	g_assert_cmpstr(fwupd_security_attr_get_bios_setting_current_value(attr4), ==, "Disabled");
+	g_assert_true(fwupd_security_attr_has_flag(attr4, FWUPD_SECURITY_ATTR_FLAG_SUCCESS));
+	fwupd_security_attr_set_result_fallback(attr1, FWUPD_SECURITY_ATTR_RESULT_UNKNOWN);
+	fwupd_security_attr_set_bios_setting_current_value(attr1, NULL);
+
 	/* from JSON */
 	ret = fwupd_codec_from_json_string(FWUPD_CODEC(attr2), json, &error);
 	if (g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
@@ -1247,8 +1495,12 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/request", fwupd_request_func);
 	g_test_add_func("/fwupd/device", fwupd_device_func);
 	g_test_add_func("/fwupd/device{filter}", fwupd_device_filter_func);
+	g_test_add_func("/fwupd/device{variant-delta}", fwupd_device_variant_delta_func);
 	g_test_add_func("/fwupd/security-attr", fwupd_security_attr_func);
 	g_test_add_func("/fwupd/bios-attrs", fwupd_bios_settings_func);
+#ifdef HAVE_LIBCURL
+	g_test_add_func("/fwupd/client{refresh-remotes}", fwupd_client_refresh_remotes_func);
+#endif
 	if (fwupd_has_system_bus()) {
 		g_test_add_func("/fwupd/client{remotes}", fwupd_client_remotes_func);
 		g_test_add_func("/fwupd/client{devices}", fwupd_client_devices_func);
@@ -0,0 +1,319 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuBufferedInputStream"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "fwupd-codec.h"
+
+#include "fu-buffered-input-stream.h"
+#include "fu-input-stream.h"
+
+/**
+ * FuBufferedInputStream:
+ *
+ * A seekable input stream that reads ahead from another seekable input stream.
+ *
+ * Reads smaller than the window are served from a buffer that is refilled with a single seek
+ * and read of the base stream, so parsing many small nearby headers does not need a syscall
+ * for each one. Larger reads go straight to the base stream.
+ */
+
+struct _FuBufferedInputStream {
+	GInputStream parent_instance;
+	GInputStream *base_stream;
+	gsize size;
+	gsize pos;
+	gsize window;
+	GByteArray *buf;
+	gsize buf_offset;
+	guint hits;
+	guint misses;
+};
+
+static void
+fu_buffered_input_stream_seekable_iface_init(GSeekableIface *iface);
+static void
+fu_buffered_input_stream_codec_iface_init(FwupdCodecInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(FuBufferedInputStream,
+			fu_buffered_input_stream,
+			G_TYPE_INPUT_STREAM,
+			G_IMPLEMENT_INTERFACE(G_TYPE_SEEKABLE,
+					      fu_buffered_input_stream_seekable_iface_init)
+			    G_IMPLEMENT_INTERFACE(FWUPD_TYPE_CODEC,
+						  fu_buffered_input_stream_codec_iface_init))
+
+static void
+fu_buffered_input_stream_add_string(FwupdCodec *codec, guint idt, GString *str)
+{
+	FuBufferedInputStream *self = FU_BUFFERED_INPUT_STREAM(codec);
+	fwupd_codec_string_append_hex(str, idt, "Size", self->size);
+	fwupd_codec_string_append_hex(str, idt, "Window", self->window);
+	fwupd_codec_string_append_int(str, idt, "Hits", self->hits);
+	fwupd_codec_string_append_int(str, idt, "Misses", self->misses);
+}
+
+static void
+fu_buffered_input_stream_codec_iface_init(FwupdCodecInterface *iface)
+{
+	iface->add_string = fu_buffered_input_stream_add_string;
+}
+
+static goffset
+fu_buffered_input_stream_tell(GSeekable *seekable)
+{
+	FuBufferedInputStream *self = FU_BUFFERED_INPUT_STREAM(seekable);
+	return self->pos;
+}
+
+static gboolean
+fu_buffered_input_stream_can_seek(GSeekable *seekable)
+{
+	return TRUE;
+}
+
+static gboolean
+fu_buffered_input_stream_seek(GSeekable *seekable,
+			      goffset offset,
+			      GSeekType type,
+			      GCancellable *cancellable,
+			      GError **error)
+{
+	FuBufferedInputStream *self = FU_BUFFERED_INPUT_STREAM(seekable);
+	goffset pos = offset;
+
+	g_return_val_if_fail(FU_IS_BUFFERED_INPUT_STREAM(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* the base stream is only seeked when the buffer is refilled */
+	if (type == G_SEEK_CUR)
+		pos += self->pos;
+	else if (type == G_SEEK_END)
+		pos += self->size;
+	if (pos < 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "cannot seek to negative offset 0x%x",
+			    (guint)(-pos));
+		return FALSE;
+	}
+	self->pos = pos;
+	return TRUE;
+}
+
+static gboolean
+fu_buffered_input_stream_can_truncate(GSeekable *seekable)
+{
+	return FALSE;
+}
+
+static gboolean
+fu_buffered_input_stream_truncate(GSeekable *seekable,
+				  goffset offset,
+				  GCancellable *cancellable,
+				  GError **error)
+{
+	g_set_error_literal(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "cannot truncate FuBufferedInputStream");
+	return FALSE;
+}
+
+static void
+fu_buffered_input_stream_seekable_iface_init(GSeekableIface *iface)
+{
+	iface->tell = fu_buffered_input_stream_tell;
+	iface->can_seek = fu_buffered_input_stream_can_seek;
+	iface->seek = fu_buffered_input_stream_seek;
+	iface->can_truncate = fu_buffered_input_stream_can_truncate;
+	iface->truncate_fn = fu_buffered_input_stream_truncate;
+}
+
+/**
+ * fu_buffered_input_stream_new:
+ * @stream: a seekable base #GInputStream
+ * @window: the number of bytes to read ahead, e.g. 0x1000
+ * @error: (nullable): optional return location for an error
+ *
+ * Creates a read-ahead input stream where content is read from the donor stream.
+ *
+ * Returns: (transfer full): a #FuBufferedInputStream, or %NULL on error
+ *
+ * Since: 2.0.1
+ **/
+GInputStream *
+fu_buffered_input_stream_new(GInputStream *stream, gsize window, GError **error)
+{
+	g_autoptr(FuBufferedInputStream) self = g_object_new(FU_TYPE_BUFFERED_INPUT_STREAM, NULL);
+
+	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
+	g_return_val_if_fail(window > 0, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	if (!G_IS_SEEKABLE(stream) || !g_seekable_can_seek(G_SEEKABLE(stream))) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "base stream is not seekable");
+		return NULL;
+	}
+	if (!fu_input_stream_size(stream, &self->size, error)) {
+		g_prefix_error(error, "failed to get size: ");
+		return NULL;
+	}
+	self->base_stream = g_object_ref(stream);
+	self->window = window;
+
+	/* success */
+	return G_INPUT_STREAM(g_steal_pointer(&self));
+}
+
+/**
+ * fu_buffered_input_stream_get_hits:
+ * @self: a #FuBufferedInputStream
+ *
+ * Gets the number of reads that were served entirely from the buffer.
+ *
+ * Returns: integer
+ *
+ * Since: 2.0.1
+ **/
+guint
+fu_buffered_input_stream_get_hits(FuBufferedInputStream *self)
+{
+	g_return_val_if_fail(FU_IS_BUFFERED_INPUT_STREAM(self), G_MAXUINT);
+	return self->hits;
+}
+
+/**
+ * fu_buffered_input_stream_get_misses:
+ * @self: a #FuBufferedInputStream
+ *
+ * Gets the number of times the base stream had to be read.
+ *
+ * Returns: integer
+ *
+ * Since: 2.0.1
+ **/
+guint
+fu_buffered_input_stream_get_misses(FuBufferedInputStream *self)
+{
+	g_return_val_if_fail(FU_IS_BUFFERED_INPUT_STREAM(self), G_MAXUINT);
+	return self->misses;
+}
+
+static gssize
+fu_buffered_input_stream_read_base(FuBufferedInputStream *self,
+				   guint8 *buffer,
+				   gsize count,
+				   GCancellable *cancellable,
+				   GError **error)
+{
+	self->misses++;
+	if (!g_seekable_seek(G_SEEKABLE(self->base_stream),
+			     self->pos,
+			     G_SEEK_SET,
+			     cancellable,
+			     error))
+		return -1;
+	return g_input_stream_read(self->base_stream, buffer, count, cancellable, error);
+}
+
+static gssize
+fu_buffered_input_stream_read(GInputStream *stream,
+			      void *buffer,
+			      gsize count,
+			      GCancellable *cancellable,
+			      GError **error)
+{
+	FuBufferedInputStream *self = FU_BUFFERED_INPUT_STREAM(stream);
+	gsize done = 0;
+	guint misses = self->misses;
+
+	g_return_val_if_fail(FU_IS_BUFFERED_INPUT_STREAM(self), -1);
+	g_return_val_if_fail(error == NULL || *error == NULL, -1);
+
+	while (done < count && self->pos < self->size) {
+		gsize remaining = count - done;
+		gssize rc;
+
+		/* already buffered */
+		if (self->pos >= self->buf_offset && self->pos < self->buf_offset + self->buf->len) {
+			gsize buf_pos = self->pos - self->buf_offset;
+			gsize n = MIN(remaining, self->buf->len - buf_pos);
+			memcpy((guint8 *)buffer + done, self->buf->data + buf_pos, n);
+			self->pos += n;
+			done += n;
+			continue;
+		}
+
+		/* too big to be worth buffering */
+		if (remaining >= self->window) {
+			rc = fu_buffered_input_stream_read_base(self,
+								(guint8 *)buffer + done,
+								remaining,
+								cancellable,
+								error);
+			if (rc < 0)
+				return -1;
+			if (rc == 0)
+				break;
+			self->pos += rc;
+			done += rc;
+			continue;
+		}
+
+		/* refill */
+		g_byte_array_set_size(self->buf, self->window);
+		rc = fu_buffered_input_stream_read_base(self,
+							self->buf->data,
+							self->buf->len,
+							cancellable,
+							error);
+		if (rc < 0) {
+			g_byte_array_set_size(self->buf, 0);
+			return -1;
+		}
+		g_byte_array_set_size(self->buf, rc);
+		self->buf_offset = self->pos;
+		if (rc == 0)
+			break;
+	}
+	if (done > 0 && self->misses == misses)
+		self->hits++;
+	return done;
+}
+
+static void
+fu_buffered_input_stream_finalize(GObject *object)
+{
+	FuBufferedInputStream *self = FU_BUFFERED_INPUT_STREAM(object);
+	if (self->base_stream != NULL)
+		g_object_unref(self->base_stream);
+	g_byte_array_unref(self->buf);
+	G_OBJECT_CLASS(fu_buffered_input_stream_parent_class)->finalize(object);
+}
+
+static void
+fu_buffered_input_stream_class_init(FuBufferedInputStreamClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	GInputStreamClass *istream_class = G_INPUT_STREAM_CLASS(klass);
+	istream_class->read_fn = fu_buffered_input_stream_read;
+	object_class->finalize = fu_buffered_input_stream_finalize;
+}
+
+static void
+fu_buffered_input_stream_init(FuBufferedInputStream *self)
+{
+	self->buf = g_byte_array_new();
+}
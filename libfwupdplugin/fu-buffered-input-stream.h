@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <fwupd.h>
+
+#define FU_TYPE_BUFFERED_INPUT_STREAM (fu_buffered_input_stream_get_type())
+
+G_DECLARE_FINAL_TYPE(FuBufferedInputStream,
+		     fu_buffered_input_stream,
+		     FU,
+		     BUFFERED_INPUT_STREAM,
+		     GInputStream)
+
+GInputStream *
+fu_buffered_input_stream_new(GInputStream *stream, gsize window, GError **error)
+    G_GNUC_NON_NULL(1);
+guint
+fu_buffered_input_stream_get_hits(FuBufferedInputStream *self) G_GNUC_NON_NULL(1);
+guint
+fu_buffered_input_stream_get_misses(FuBufferedInputStream *self) G_GNUC_NON_NULL(1);
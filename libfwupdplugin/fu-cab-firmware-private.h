@@ -0,0 +1,13 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "fu-cab-firmware.h"
+
+gboolean
+fu_cab_firmware_compute_checksum(const guint8 *buf, gsize bufsz, guint32 *checksum, GError **error)
+    G_GNUC_NON_NULL(3);
@@ -12,7 +12,8 @@
 
 #include "fu-byte-array.h"
 #include "fu-bytes.h"
-#include "fu-cab-firmware.h"
+#include "fu-cab-firmware-private.h"
+#include "fu-cab-folder-input-stream.h"
 #include "fu-cab-image.h"
 #include "fu-cab-struct.h"
 #include "fu-chunk-array.h"
@@ -105,19 +106,18 @@ fu_cab_firmware_set_only_basename(FuCabFirmware *self, gboolean only_basename)
 
 typedef struct {
 	GInputStream *stream;
+	gsize streamsz;
 	FwupdInstallFlags install_flags;
 	gsize rsvd_folder;
 	gsize rsvd_block;
 	gsize size_total;
 	FuCabCompression compression;
-	GPtrArray *folder_data; /* of FuCompositeInputStream */
-	z_stream zstrm;
+	GPtrArray *folder_data; /* of FuCompositeInputStream or FuCabFolderInputStream */
 } FuCabFirmwareParseHelper;
 
 static void
 fu_cab_firmware_parse_helper_free(FuCabFirmwareParseHelper *helper)
 {
-	inflateEnd(&helper->zstrm);
 	if (helper->stream != NULL)
 		g_object_unref(helper->stream);
 	if (helper->folder_data != NULL)
@@ -128,7 +128,7 @@ fu_cab_firmware_parse_helper_free(FuCabFirmwareParseHelper *helper)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuCabFirmwareParseHelper, fu_cab_firmware_parse_helper_free)
 
 /* compute the MS cabinet checksum */
-static gboolean
+gboolean
 fu_cab_firmware_compute_checksum(const guint8 *buf, gsize bufsz, guint32 *checksum, GError **error)
 {
 	for (gsize i = 0; i < bufsz; i += 4) {
@@ -191,17 +191,22 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 	gsize blob_uncomp;
 	gsize hdr_sz;
 	gsize size_max = fu_firmware_get_size_max(FU_FIRMWARE(self));
-	g_autoptr(FuStructCabData) st = NULL;
+	guint8 buf[FU_STRUCT_CAB_DATA_SIZE] = {0x0};
+	FuStructCabDataView st = {0};
 	g_autoptr(GInputStream) partial_stream = NULL;
 
-	/* parse header */
-	st = fu_struct_cab_data_parse_stream(helper->stream, *offset, error);
-	if (st == NULL)
+	/* parse header, which is done once per block so avoid allocating */
+	if (!fu_struct_cab_data_parse_stream_into(&st,
+						  buf,
+						  sizeof(buf),
+						  helper->stream,
+						  *offset,
+						  error))
 		return FALSE;
 
 	/* sanity check */
-	blob_comp = fu_struct_cab_data_get_comp(st);
-	blob_uncomp = fu_struct_cab_data_get_uncomp(st);
+	blob_comp = fu_struct_cab_data_view_get_comp(&st);
+	blob_uncomp = fu_struct_cab_data_view_get_uncomp(&st);
 	if (helper->compression == FU_CAB_COMPRESSION_NONE && blob_comp != blob_uncomp) {
 		g_set_error_literal(error,
 				    FWUPD_ERROR,
@@ -222,7 +227,27 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 		return FALSE;
 	}
 
-	hdr_sz = st->len + helper->rsvd_block;
+	hdr_sz = st.len + helper->rsvd_block;
+	if (*offset + hdr_sz + blob_comp > helper->streamsz) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "compressed data @0x%x truncated",
+			    (guint)*offset);
+		return FALSE;
+	}
+
+	/* inflated and verified when first read */
+	if (helper->compression == FU_CAB_COMPRESSION_MSZIP) {
+		guint32 checksum = fu_struct_cab_data_view_get_checksum(&st);
+		fu_cab_folder_input_stream_add_block(FU_CAB_FOLDER_INPUT_STREAM(folder_data),
+						     *offset + hdr_sz,
+						     blob_comp,
+						     blob_uncomp,
+						     checksum);
+		*offset += blob_comp + hdr_sz;
+		return TRUE;
+	}
 
 	/* verify checksum */
 	partial_stream =
@@ -230,7 +255,7 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 	if (partial_stream == NULL)
 		return FALSE;
 	if ((helper->install_flags & FWUPD_INSTALL_FLAG_IGNORE_CHECKSUM) == 0) {
-		guint32 checksum = fu_struct_cab_data_get_checksum(st);
+		guint32 checksum = fu_struct_cab_data_view_get_checksum(&st);
 		if (checksum != 0) {
 			guint32 checksum_actual = 0;
 			g_autoptr(GByteArray) hdr = g_byte_array_new();
@@ -259,103 +284,30 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 			}
 		}
 	}
-
-	/* decompress Zlib data after removing *another *header... */
-	if (helper->compression == FU_CAB_COMPRESSION_MSZIP) {
-		guint8 tmp[0x4000] = {0x0};
-		int zret;
-		g_autofree gchar *kind = NULL;
-		g_autoptr(GByteArray) buf = g_byte_array_new();
-		g_autoptr(GBytes) bytes_comp = NULL;
-		g_autoptr(GBytes) bytes_uncomp = NULL;
-
-		/* check compressed header */
-		bytes_comp =
-		    fu_input_stream_read_bytes(helper->stream, *offset + hdr_sz, blob_comp, error);
-		if (bytes_comp == NULL)
-			return FALSE;
-		kind = fu_memstrsafe(g_bytes_get_data(bytes_comp, NULL),
-				     g_bytes_get_size(bytes_comp),
-				     0x0,
-				     2,
-				     error);
-		if (kind == NULL)
-			return FALSE;
-		if (g_strcmp0(kind, "CK") != 0) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "compressed header invalid: %s",
-				    kind);
-			return FALSE;
-		}
-		helper->zstrm.avail_in = g_bytes_get_size(bytes_comp) - 2;
-		helper->zstrm.next_in = (z_const Bytef *)g_bytes_get_data(bytes_comp, NULL) + 2;
-		while (1) {
-			helper->zstrm.avail_out = sizeof(tmp);
-			helper->zstrm.next_out = tmp;
-			zret = inflate(&helper->zstrm, Z_BLOCK);
-			if (zret == Z_STREAM_END)
-				break;
-			g_byte_array_append(buf, tmp, sizeof(tmp) - helper->zstrm.avail_out);
-			if (zret != Z_OK) {
-				g_set_error(error,
-					    FWUPD_ERROR,
-					    FWUPD_ERROR_NOT_SUPPORTED,
-					    "inflate error @0x%x: %s",
-					    (guint)*offset,
-					    zError(zret));
-				return FALSE;
-			}
-		}
-		zret = inflateReset(&helper->zstrm);
-		if (zret != Z_OK) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "failed to reset inflate: %s",
-				    zError(zret));
-			return FALSE;
-		}
-		zret = inflateSetDictionary(&helper->zstrm, buf->data, buf->len);
-		if (zret != Z_OK) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "failed to set inflate dictionary: %s",
-				    zError(zret));
-			return FALSE;
-		}
-		bytes_uncomp = g_byte_array_free_to_bytes(g_steal_pointer(&buf)); /* nocheck */
-		fu_composite_input_stream_add_bytes(FU_COMPOSITE_INPUT_STREAM(folder_data),
-						    bytes_uncomp);
-	} else {
-		fu_composite_input_stream_add_partial_stream(
-		    FU_COMPOSITE_INPUT_STREAM(folder_data),
-		    FU_PARTIAL_INPUT_STREAM(partial_stream));
-	}
+	fu_composite_input_stream_add_partial_stream(FU_COMPOSITE_INPUT_STREAM(folder_data),
+						     FU_PARTIAL_INPUT_STREAM(partial_stream));
 
 	/* success */
 	*offset += blob_comp + hdr_sz;
 	return TRUE;
 }
 
-static gboolean
+static GInputStream *
 fu_cab_firmware_parse_folder(FuCabFirmware *self,
 			     FuCabFirmwareParseHelper *helper,
 			     guint idx,
 			     gsize offset,
-			     GInputStream *folder_data,
 			     GError **error)
 {
 	FuCabFirmwarePrivate *priv = GET_PRIVATE(self);
 	gsize offset_folder;
 	g_autoptr(GByteArray) st = NULL;
+	g_autoptr(GInputStream) folder_data = NULL;
 
 	/* parse header */
 	st = fu_struct_cab_folder_parse_stream(helper->stream, offset, error);
 	if (st == NULL)
-		return FALSE;
+		return NULL;
 
 	/* sanity check */
 	if (fu_struct_cab_folder_get_ndatab(st) == 0) {
@@ -363,7 +315,7 @@ fu_cab_firmware_parse_folder(FuCabFirmware *self,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_NOT_SUPPORTED,
 				    "no CFDATA blocks");
-		return FALSE;
+		return NULL;
 	}
 	helper->compression = fu_struct_cab_folder_get_compression(st);
 	if (helper->compression != FU_CAB_COMPRESSION_NONE)
@@ -375,18 +327,30 @@ fu_cab_firmware_parse_folder(FuCabFirmware *self,
 			    FWUPD_ERROR_NOT_SUPPORTED,
 			    "compression %s not supported",
 			    fu_cab_compression_to_string(helper->compression));
-		return FALSE;
+		return NULL;
+	}
+
+	/* MSZIP blocks are inflated on demand */
+	if (helper->compression == FU_CAB_COMPRESSION_MSZIP) {
+		gboolean verify_checksums =
+		    (helper->install_flags & FWUPD_INSTALL_FLAG_IGNORE_CHECKSUM) == 0;
+		folder_data =
+		    fu_cab_folder_input_stream_new(helper->stream, verify_checksums, error);
+		if (folder_data == NULL)
+			return NULL;
+	} else {
+		folder_data = fu_composite_input_stream_new();
 	}
 
 	/* parse CDATA */
 	offset_folder = fu_struct_cab_folder_get_offset(st);
 	for (guint i = 0; i < fu_struct_cab_folder_get_ndatab(st); i++) {
 		if (!fu_cab_firmware_parse_data(self, helper, &offset_folder, folder_data, error))
-			return FALSE;
+			return NULL;
 	}
 
 	/* success */
-	return TRUE;
+	return g_steal_pointer(&folder_data);
 }
 
 static gboolean
@@ -400,22 +364,27 @@ fu_cab_firmware_parse_file(FuCabFirmware *self,
 	guint16 date;
 	guint16 index;
 	guint16 time;
+	guint8 buf[FU_STRUCT_CAB_FILE_SIZE] = {0x0};
+	FuStructCabFileView st = {0};
 	g_autoptr(FuCabImage) img = fu_cab_image_new();
-	g_autoptr(GByteArray) st = NULL;
 	g_autoptr(GDateTime) created = NULL;
 	g_autoptr(GInputStream) stream = NULL;
 	g_autoptr(GString) filename = g_string_new(NULL);
 	g_autoptr(GTimeZone) tz_utc = g_time_zone_new_utc();
 
 	/* parse header */
-	st = fu_struct_cab_file_parse_stream(helper->stream, *offset, error);
-	if (st == NULL)
+	if (!fu_struct_cab_file_parse_stream_into(&st,
+						  buf,
+						  sizeof(buf),
+						  helper->stream,
+						  *offset,
+						  error))
 		return FALSE;
-	fu_firmware_set_offset(FU_FIRMWARE(img), fu_struct_cab_file_get_uoffset(st));
-	fu_firmware_set_size(FU_FIRMWARE(img), fu_struct_cab_file_get_usize(st));
+	fu_firmware_set_offset(FU_FIRMWARE(img), fu_struct_cab_file_view_get_uoffset(&st));
+	fu_firmware_set_size(FU_FIRMWARE(img), fu_struct_cab_file_view_get_usize(&st));
 
 	/* sanity check */
-	index = fu_struct_cab_file_get_index(st);
+	index = fu_struct_cab_file_view_get_index(&st);
 	if (index >= helper->folder_data->len) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -456,8 +425,8 @@ fu_cab_firmware_parse_file(FuCabFirmware *self,
 		fu_firmware_set_id(FU_FIRMWARE(img), filename->str);
 	}
 	stream = fu_partial_input_stream_new(folder_data,
-					     fu_struct_cab_file_get_uoffset(st),
-					     fu_struct_cab_file_get_usize(st),
+					     fu_struct_cab_file_view_get_uoffset(&st),
+					     fu_struct_cab_file_view_get_usize(&st),
 					     error);
 	if (stream == NULL)
 		return FALSE;
@@ -467,8 +436,8 @@ fu_cab_firmware_parse_file(FuCabFirmware *self,
 		return FALSE;
 
 	/* set created date time */
-	date = fu_struct_cab_file_get_date(st);
-	time = fu_struct_cab_file_get_time(st);
+	date = fu_struct_cab_file_view_get_date(&st);
+	time = fu_struct_cab_file_view_get_time(&st);
 	created = g_date_time_new(tz_utc,
 				  1980 + ((date & 0xFE00) >> 9),
 				  (date & 0x01E0) >> 5,
@@ -492,22 +461,8 @@ fu_cab_firmware_validate(FuFirmware *firmware, GInputStream *stream, gsize offse
 static FuCabFirmwareParseHelper *
 fu_cab_firmware_parse_helper_new(GInputStream *stream, FwupdInstallFlags flags, GError **error)
 {
-	int zret;
 	g_autoptr(FuCabFirmwareParseHelper) helper = g_new0(FuCabFirmwareParseHelper, 1);
 
-	/* zlib */
-	helper->zstrm.zalloc = zalloc;
-	helper->zstrm.zfree = zfree;
-	zret = inflateInit2(&helper->zstrm, -MAX_WBITS);
-	if (zret != Z_OK) {
-		g_set_error(error,
-			    FWUPD_ERROR,
-			    FWUPD_ERROR_NOT_SUPPORTED,
-			    "failed to initialize inflate: %s",
-			    zError(zret));
-		return NULL;
-	}
-
 	helper->stream = g_object_ref(stream);
 	helper->install_flags = flags;
 	helper->folder_data = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
@@ -592,6 +547,7 @@ fu_cab_firmware_parse(FuFirmware *firmware,
 	helper = fu_cab_firmware_parse_helper_new(stream, flags, error);
 	if (helper == NULL)
 		return FALSE;
+	helper->streamsz = streamsz;
 
 	/* reserved sizes */
 	offset += st->len;
@@ -608,8 +564,9 @@ fu_cab_firmware_parse(FuFirmware *firmware,
 
 	/* parse CFFOLDER */
 	for (guint i = 0; i < fu_struct_cab_header_get_nr_folders(st); i++) {
-		g_autoptr(GInputStream) folder_data = fu_composite_input_stream_new();
-		if (!fu_cab_firmware_parse_folder(self, helper, i, offset, folder_data, error))
+		g_autoptr(GInputStream) folder_data = NULL;
+		folder_data = fu_cab_firmware_parse_folder(self, helper, i, offset, error);
+		if (folder_data == NULL)
 			return FALSE;
 		if (!fu_input_stream_size(folder_data, &streamsz, error))
 			return FALSE;
@@ -0,0 +1,503 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuCabFirmware"
+
+#include "config.h"
+
+#include <string.h>
+#include <zlib.h>
+
+#include "fwupd-codec.h"
+
+#include "fu-byte-array.h"
+#include "fu-cab-firmware-private.h"
+#include "fu-cab-folder-input-stream.h"
+#include "fu-input-stream.h"
+#include "fu-mem.h"
+
+/*
+ * FuCabFolderInputStream:
+ *
+ * A seekable input stream of the uncompressed data of a MSZIP-compressed CFFOLDER.
+ *
+ * Each CFDATA block is only inflated (and the checksum verified) when a read needs it, and a
+ * small number of inflated blocks are kept for reuse. Each block uses the uncompressed data of the
+ * previous block as the deflate dictionary, so a random access may have to inflate from the
+ * nearest cached block onwards, but sequential reads inflate each block exactly once.
+ */
+
+/* each block is at most 32kB when uncompressed */
+#define FU_CAB_FOLDER_INPUT_STREAM_CACHE_MAX 8
+
+typedef struct {
+	gsize offset; /* of the compressed data in the base stream */
+	gsize size_comp;
+	gsize size_uncomp;
+	gsize global_offset;
+	guint32 checksum;
+	gboolean checksum_ok;
+	GBytes *blob; /* inflated, or %NULL if not cached */
+} FuCabFolderBlock;
+
+struct _FuCabFolderInputStream {
+	GInputStream parent_instance;
+	GInputStream *stream;
+	gboolean verify_checksums;
+	GArray *blocks; /* of FuCabFolderBlock */
+	GArray *lru;	/* of guint, least recently used first */
+	guint hint_idx;
+	guint inflate_cnt;
+	gsize size;
+	gsize pos;
+	z_stream zstrm;
+};
+
+static void
+fu_cab_folder_input_stream_seekable_iface_init(GSeekableIface *iface);
+static void
+fu_cab_folder_input_stream_codec_iface_init(FwupdCodecInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(FuCabFolderInputStream,
+			fu_cab_folder_input_stream,
+			G_TYPE_INPUT_STREAM,
+			G_IMPLEMENT_INTERFACE(G_TYPE_SEEKABLE,
+					      fu_cab_folder_input_stream_seekable_iface_init)
+			    G_IMPLEMENT_INTERFACE(FWUPD_TYPE_CODEC,
+						  fu_cab_folder_input_stream_codec_iface_init))
+
+static void
+fu_cab_folder_input_stream_add_string(FwupdCodec *codec, guint idt, GString *str)
+{
+	FuCabFolderInputStream *self = FU_CAB_FOLDER_INPUT_STREAM(codec);
+	fwupd_codec_string_append_hex(str, idt, "Size", self->size);
+	fwupd_codec_string_append_int(str, idt, "Blocks", self->blocks->len);
+	fwupd_codec_string_append_int(str, idt, "Cached", self->lru->len);
+	fwupd_codec_string_append_int(str, idt, "Inflated", self->inflate_cnt);
+}
+
+static void
+fu_cab_folder_input_stream_codec_iface_init(FwupdCodecInterface *iface)
+{
+	iface->add_string = fu_cab_folder_input_stream_add_string;
+}
+
+static goffset
+fu_cab_folder_input_stream_tell(GSeekable *seekable)
+{
+	FuCabFolderInputStream *self = FU_CAB_FOLDER_INPUT_STREAM(seekable);
+	return self->pos;
+}
+
+static gboolean
+fu_cab_folder_input_stream_can_seek(GSeekable *seekable)
+{
+	return TRUE;
+}
+
+static gboolean
+fu_cab_folder_input_stream_seek(GSeekable *seekable,
+				goffset offset,
+				GSeekType type,
+				GCancellable *cancellable,
+				GError **error)
+{
+	FuCabFolderInputStream *self = FU_CAB_FOLDER_INPUT_STREAM(seekable);
+	goffset pos = offset;
+
+	g_return_val_if_fail(FU_IS_CAB_FOLDER_INPUT_STREAM(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (type == G_SEEK_CUR)
+		pos += self->pos;
+	else if (type == G_SEEK_END)
+		pos += self->size;
+	if (pos < 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "cannot seek to negative offset 0x%x",
+			    (guint)(-pos));
+		return FALSE;
+	}
+	self->pos = pos;
+	return TRUE;
+}
+
+static gboolean
+fu_cab_folder_input_stream_can_truncate(GSeekable *seekable)
+{
+	return FALSE;
+}
+
+static gboolean
+fu_cab_folder_input_stream_truncate(GSeekable *seekable,
+				    goffset offset,
+				    GCancellable *cancellable,
+				    GError **error)
+{
+	g_set_error_literal(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "cannot truncate FuCabFolderInputStream");
+	return FALSE;
+}
+
+static void
+fu_cab_folder_input_stream_seekable_iface_init(GSeekableIface *iface)
+{
+	iface->tell = fu_cab_folder_input_stream_tell;
+	iface->can_seek = fu_cab_folder_input_stream_can_seek;
+	iface->seek = fu_cab_folder_input_stream_seek;
+	iface->can_truncate = fu_cab_folder_input_stream_can_truncate;
+	iface->truncate_fn = fu_cab_folder_input_stream_truncate;
+}
+
+/* adds a CFDATA block, where @offset is the start of the compressed data after the header */
+void
+fu_cab_folder_input_stream_add_block(FuCabFolderInputStream *self,
+				     gsize offset,
+				     gsize size_comp,
+				     gsize size_uncomp,
+				     guint32 checksum)
+{
+	FuCabFolderBlock block = {
+	    .offset = offset,
+	    .size_comp = size_comp,
+	    .size_uncomp = size_uncomp,
+	    .global_offset = self->size,
+	    .checksum = checksum,
+	};
+	g_return_if_fail(FU_IS_CAB_FOLDER_INPUT_STREAM(self));
+	g_array_append_val(self->blocks, block);
+	self->size += size_uncomp;
+}
+
+/* the number of CFDATA blocks inflated so far, including any inflated again after eviction */
+guint
+fu_cab_folder_input_stream_get_inflate_count(FuCabFolderInputStream *self)
+{
+	g_return_val_if_fail(FU_IS_CAB_FOLDER_INPUT_STREAM(self), G_MAXUINT);
+	return self->inflate_cnt;
+}
+
+GInputStream *
+fu_cab_folder_input_stream_new(GInputStream *stream, gboolean verify_checksums, GError **error)
+{
+	int zret;
+	g_autoptr(FuCabFolderInputStream) self =
+	    g_object_new(FU_TYPE_CAB_FOLDER_INPUT_STREAM, NULL);
+
+	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	zret = inflateInit2(&self->zstrm, -MAX_WBITS);
+	if (zret != Z_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "failed to initialize inflate: %s",
+			    zError(zret));
+		return NULL;
+	}
+	self->stream = g_object_ref(stream);
+	self->verify_checksums = verify_checksums;
+	return G_INPUT_STREAM(g_steal_pointer(&self));
+}
+
+static gboolean
+fu_cab_folder_input_stream_verify_block(FuCabFolderInputStream *self,
+					FuCabFolderBlock *block,
+					GBytes *blob_comp,
+					GError **error)
+{
+	guint32 checksum_actual = 0;
+	g_autoptr(GByteArray) hdr = g_byte_array_new();
+
+	if (!self->verify_checksums || block->checksum == 0 || block->checksum_ok)
+		return TRUE;
+	if (!fu_cab_firmware_compute_checksum(g_bytes_get_data(blob_comp, NULL),
+					      g_bytes_get_size(blob_comp),
+					      &checksum_actual,
+					      error))
+		return FALSE;
+	fu_byte_array_append_uint16(hdr, block->size_comp, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint16(hdr, block->size_uncomp, G_LITTLE_ENDIAN);
+	if (!fu_cab_firmware_compute_checksum(hdr->data, hdr->len, &checksum_actual, error))
+		return FALSE;
+	if (checksum_actual != block->checksum) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "invalid checksum at 0x%x, expected 0x%x, got 0x%x",
+			    (guint)block->offset,
+			    block->checksum,
+			    checksum_actual);
+		return FALSE;
+	}
+	block->checksum_ok = TRUE;
+	return TRUE;
+}
+
+static GBytes *
+fu_cab_folder_input_stream_inflate_block(FuCabFolderInputStream *self,
+					 FuCabFolderBlock *block,
+					 GBytes *dictionary,
+					 GError **error)
+{
+	int zret;
+	g_autofree gchar *kind = NULL;
+	g_autofree guint8 *buf = g_malloc0(MAX(block->size_uncomp, 1));
+	g_autoptr(GBytes) blob_comp = NULL;
+
+	/* check compressed header */
+	blob_comp =
+	    fu_input_stream_read_bytes(self->stream, block->offset, block->size_comp, error);
+	if (blob_comp == NULL)
+		return NULL;
+	if (g_bytes_get_size(blob_comp) != block->size_comp) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "compressed data @0x%x truncated",
+			    (guint)block->offset);
+		return NULL;
+	}
+	if (!fu_cab_folder_input_stream_verify_block(self, block, blob_comp, error))
+		return NULL;
+	kind = fu_memstrsafe(g_bytes_get_data(blob_comp, NULL),
+			     g_bytes_get_size(blob_comp),
+			     0x0,
+			     2,
+			     error);
+	if (kind == NULL)
+		return NULL;
+	if (g_strcmp0(kind, "CK") != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "compressed header invalid: %s",
+			    kind);
+		return NULL;
+	}
+
+	/* the previous block is the dictionary for this one */
+	zret = inflateReset(&self->zstrm);
+	if (zret != Z_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "failed to reset inflate: %s",
+			    zError(zret));
+		return NULL;
+	}
+	if (dictionary != NULL && g_bytes_get_size(dictionary) > 0) {
+		zret = inflateSetDictionary(&self->zstrm,
+					    g_bytes_get_data(dictionary, NULL),
+					    g_bytes_get_size(dictionary));
+		if (zret != Z_OK) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "failed to set inflate dictionary: %s",
+				    zError(zret));
+			return NULL;
+		}
+	}
+
+	/* inflate straight into a buffer of the declared size */
+	self->zstrm.avail_in = g_bytes_get_size(blob_comp) - 2;
+	self->zstrm.next_in = (z_const Bytef *)g_bytes_get_data(blob_comp, NULL) + 2;
+	self->zstrm.avail_out = block->size_uncomp;
+	self->zstrm.next_out = buf;
+	zret = inflate(&self->zstrm, Z_FINISH);
+	if (zret != Z_STREAM_END) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "inflate error @0x%x: %s",
+			    (guint)block->offset,
+			    zError(zret));
+		return NULL;
+	}
+	if (self->zstrm.avail_out != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "inflated 0x%x bytes @0x%x, expected 0x%x",
+			    (guint)(block->size_uncomp - self->zstrm.avail_out),
+			    (guint)block->offset,
+			    (guint)block->size_uncomp);
+		return NULL;
+	}
+	return g_bytes_new_take(g_steal_pointer(&buf), block->size_uncomp);
+}
+
+static void
+fu_cab_folder_input_stream_cache_touch(FuCabFolderInputStream *self, guint idx)
+{
+	for (guint i = 0; i < self->lru->len; i++) {
+		if (g_array_index(self->lru, guint, i) == idx) {
+			g_array_remove_index(self->lru, i);
+			break;
+		}
+	}
+	g_array_append_val(self->lru, idx);
+}
+
+static void
+fu_cab_folder_input_stream_cache_add(FuCabFolderInputStream *self, guint idx, GBytes *blob)
+{
+	FuCabFolderBlock *block = &g_array_index(self->blocks, FuCabFolderBlock, idx);
+
+	block->blob = g_bytes_ref(blob);
+	fu_cab_folder_input_stream_cache_touch(self, idx);
+	if (self->lru->len > FU_CAB_FOLDER_INPUT_STREAM_CACHE_MAX) {
+		guint idx_old = g_array_index(self->lru, guint, 0);
+		FuCabFolderBlock *block_old =
+		    &g_array_index(self->blocks, FuCabFolderBlock, idx_old);
+		g_clear_pointer(&block_old->blob, g_bytes_unref);
+		g_array_remove_index(self->lru, 0);
+	}
+}
+
+static GBytes *
+fu_cab_folder_input_stream_get_block(FuCabFolderInputStream *self, guint idx, GError **error)
+{
+	FuCabFolderBlock *block = &g_array_index(self->blocks, FuCabFolderBlock, idx);
+	guint idx_start = 0;
+	g_autoptr(GBytes) blob = NULL;
+
+	/* already inflated */
+	if (block->blob != NULL) {
+		fu_cab_folder_input_stream_cache_touch(self, idx);
+		return g_bytes_ref(block->blob);
+	}
+
+	/* inflate forwards from the nearest earlier cached block */
+	for (guint i = idx; i > 0; i--) {
+		FuCabFolderBlock *block_tmp = &g_array_index(self->blocks, FuCabFolderBlock, i - 1);
+		if (block_tmp->blob != NULL) {
+			blob = g_bytes_ref(block_tmp->blob);
+			idx_start = i;
+			break;
+		}
+	}
+	for (guint i = idx_start; i <= idx; i++) {
+		FuCabFolderBlock *block_tmp = &g_array_index(self->blocks, FuCabFolderBlock, i);
+		g_autoptr(GBytes) blob_tmp = NULL;
+
+		blob_tmp = fu_cab_folder_input_stream_inflate_block(self, block_tmp, blob, error);
+		if (blob_tmp == NULL)
+			return NULL;
+		self->inflate_cnt++;
+		fu_cab_folder_input_stream_cache_add(self, i, blob_tmp);
+		g_clear_pointer(&blob, g_bytes_unref);
+		blob = g_steal_pointer(&blob_tmp);
+	}
+	return g_steal_pointer(&blob);
+}
+
+static guint
+fu_cab_folder_input_stream_get_idx_for_offset(FuCabFolderInputStream *self, gsize offset)
+{
+	guint lo = 0;
+	guint hi = self->blocks->len;
+
+	/* sequential reads are usually satisfied by the same block */
+	if (self->hint_idx < self->blocks->len) {
+		FuCabFolderBlock *block =
+		    &g_array_index(self->blocks, FuCabFolderBlock, self->hint_idx);
+		if (offset >= block->global_offset &&
+		    offset < block->global_offset + block->size_uncomp)
+			return self->hint_idx;
+	}
+
+	/* find the first block ending after @offset */
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		FuCabFolderBlock *block = &g_array_index(self->blocks, FuCabFolderBlock, mid);
+		if (offset < block->global_offset + block->size_uncomp)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	self->hint_idx = lo;
+	return lo;
+}
+
+static gssize
+fu_cab_folder_input_stream_read(GInputStream *stream,
+				void *buffer,
+				gsize count,
+				GCancellable *cancellable,
+				GError **error)
+{
+	FuCabFolderInputStream *self = FU_CAB_FOLDER_INPUT_STREAM(stream);
+	gsize done = 0;
+
+	g_return_val_if_fail(FU_IS_CAB_FOLDER_INPUT_STREAM(self), -1);
+	g_return_val_if_fail(error == NULL || *error == NULL, -1);
+
+	while (done < count && self->pos < self->size) {
+		FuCabFolderBlock *block;
+		gsize n;
+		guint idx = fu_cab_folder_input_stream_get_idx_for_offset(self, self->pos);
+		g_autoptr(GBytes) blob = NULL;
+
+		if (idx >= self->blocks->len)
+			break;
+		blob = fu_cab_folder_input_stream_get_block(self, idx, error);
+		if (blob == NULL)
+			return -1;
+		block = &g_array_index(self->blocks, FuCabFolderBlock, idx);
+		n = MIN(count - done, block->global_offset + block->size_uncomp - self->pos);
+		memcpy((guint8 *)buffer + done,
+		       (const guint8 *)g_bytes_get_data(blob, NULL) + self->pos -
+			   block->global_offset,
+		       n);
+		self->pos += n;
+		done += n;
+	}
+	return done;
+}
+
+static void
+fu_cab_folder_input_stream_block_clear(FuCabFolderBlock *block)
+{
+	if (block->blob != NULL)
+		g_bytes_unref(block->blob);
+}
+
+static void
+fu_cab_folder_input_stream_finalize(GObject *object)
+{
+	FuCabFolderInputStream *self = FU_CAB_FOLDER_INPUT_STREAM(object);
+	inflateEnd(&self->zstrm);
+	if (self->stream != NULL)
+		g_object_unref(self->stream);
+	g_array_unref(self->blocks);
+	g_array_unref(self->lru);
+	G_OBJECT_CLASS(fu_cab_folder_input_stream_parent_class)->finalize(object);
+}
+
+static void
+fu_cab_folder_input_stream_class_init(FuCabFolderInputStreamClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	GInputStreamClass *istream_class = G_INPUT_STREAM_CLASS(klass);
+	istream_class->read_fn = fu_cab_folder_input_stream_read;
+	object_class->finalize = fu_cab_folder_input_stream_finalize;
+}
+
+static void
+fu_cab_folder_input_stream_init(FuCabFolderInputStream *self)
+{
+	self->blocks = g_array_new(FALSE, FALSE, sizeof(FuCabFolderBlock));
+	g_array_set_clear_func(self->blocks,
+			       (GDestroyNotify)fu_cab_folder_input_stream_block_clear);
+	self->lru = g_array_new(FALSE, FALSE, sizeof(guint));
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <fwupd.h>
+
+#define FU_TYPE_CAB_FOLDER_INPUT_STREAM (fu_cab_folder_input_stream_get_type())
+
+G_DECLARE_FINAL_TYPE(FuCabFolderInputStream,
+		     fu_cab_folder_input_stream,
+		     FU,
+		     CAB_FOLDER_INPUT_STREAM,
+		     GInputStream)
+
+GInputStream *
+fu_cab_folder_input_stream_new(GInputStream *stream, gboolean verify_checksums, GError **error)
+    G_GNUC_NON_NULL(1);
+void
+fu_cab_folder_input_stream_add_block(FuCabFolderInputStream *self,
+				     gsize offset,
+				     gsize size_comp,
+				     gsize size_uncomp,
+				     guint32 checksum) G_GNUC_NON_NULL(1);
+guint
+fu_cab_folder_input_stream_get_inflate_count(FuCabFolderInputStream *self) G_GNUC_NON_NULL(1);
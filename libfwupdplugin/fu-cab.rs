@@ -1,7 +1,7 @@
 // Copyright 2023 Richard Hughes <richard@hughsie.com>
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
-#[derive(ParseStream, New)]
+#[derive(ParseStream, ParseStreamInto, New)]
 struct FuStructCabData {
     checksum: u32le,
     comp: u16le,
@@ -28,7 +28,7 @@ enum FuCabFileAttribute {
     NameUtf8 = 0x80,
 }
 
-#[derive(ParseStream, New)]
+#[derive(ParseStream, ParseStreamInto, New)]
 struct FuStructCabFile {
     usize: u32le, // uncompressed
     uoffset: u32le, // uncompressed
@@ -41,6 +41,7 @@ struct _FuCompositeInputStream {
 	GInputStream parent_instance;
 	GPtrArray *items;		       /* of FuCompositeInputStreamItem */
 	FuCompositeInputStreamItem *last_item; /* no-ref */
+	guint hint_idx;			       /* index of the last item found */
 	goffset pos;
 	goffset pos_offset;
 	gsize total_size;
@@ -199,16 +200,43 @@ fu_composite_input_stream_can_seek(GSeekable *seekable)
 	return TRUE;
 }
 
+static gboolean
+fu_composite_input_stream_item_contains(FuCompositeInputStreamItem *item, gsize offset)
+{
+	gsize item_size = fu_partial_input_stream_get_size(item->partial_stream);
+	return offset >= item->global_offset && offset < item->global_offset + item_size;
+}
+
 static FuCompositeInputStreamItem *
 fu_composite_input_stream_get_item_for_offset(FuCompositeInputStream *self,
 					      gsize offset,
 					      GError **error)
 {
-	for (guint i = 0; i < self->items->len; i++) {
+	guint lo = 0;
+	guint hi = self->items->len;
+
+	/* sequential reads are usually satisfied by the same or the next item */
+	for (guint i = self->hint_idx; i < self->items->len && i <= self->hint_idx + 1; i++) {
 		FuCompositeInputStreamItem *item = g_ptr_array_index(self->items, i);
+		if (fu_composite_input_stream_item_contains(item, offset)) {
+			self->hint_idx = i;
+			return item;
+		}
+	}
+
+	/* items are sorted by global offset, so find the first item ending after @offset */
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		FuCompositeInputStreamItem *item = g_ptr_array_index(self->items, mid);
 		gsize item_size = fu_partial_input_stream_get_size(item->partial_stream);
 		if (offset < item->global_offset + item_size)
-			return item;
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	if (lo < self->items->len) {
+		self->hint_idx = lo;
+		return g_ptr_array_index(self->items, lo);
 	}
 	g_set_error(error,
 		    FWUPD_ERROR,
@@ -1106,6 +1106,24 @@ fu_context_load_quirks(FuContext *self, FuQuirksLoadFlags flags, GError **error)
 	return TRUE;
 }
 
+/**
+ * fu_context_get_quirks_profile:
+ * @self: a #FuContext
+ *
+ * Gets a summary of the quirk lookups done so far, for debugging.
+ *
+ * Returns: (transfer full): a string
+ *
+ * Since: 2.0.1
+ **/
+gchar *
+fu_context_get_quirks_profile(FuContext *self)
+{
+	FuContextPrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_CONTEXT(self), NULL);
+	return fu_quirks_get_lookup_profile(priv->quirks);
+}
+
 /**
  * fu_context_get_power_state:
  * @self: a #FuContext
@@ -56,6 +56,66 @@ fu_crc8(const guint8 *buf, gsize bufsz)
 	return fu_crc8_full(buf, bufsz, 0x00, 0x07);
 }
 
+/* building a table is more expensive than just using the bitwise method for tiny buffers */
+#define FU_CRC16_TABLE_THRESHOLD 64
+
+/* the number of different CRC-16 polynomials that get a lookup table */
+#define FU_CRC16_TABLE_CACHE_SIZE 8
+
+typedef struct {
+	guint16 polynomial;
+	guint16 table[256];
+} FuCrc16Table;
+
+G_LOCK_DEFINE_STATIC(crc16_tables);
+static FuCrc16Table crc16_tables[FU_CRC16_TABLE_CACHE_SIZE];
+static guint crc16_tables_len = 0;
+
+static guint16
+fu_crc16_step_bitwise(const guint8 *buf, gsize bufsz, guint16 crc, guint16 polynomial)
+{
+	for (gsize len = bufsz; len > 0; len--) {
+		crc = (guint16)(crc ^ (*buf++));
+		for (guint8 i = 0; i < 8; i++) {
+			if (crc & 0x1) {
+				crc = (crc >> 1) ^ polynomial;
+			} else {
+				crc >>= 1;
+			}
+		}
+	}
+	return crc;
+}
+
+static const guint16 *
+fu_crc16_get_table(guint16 polynomial)
+{
+	FuCrc16Table *item;
+
+	G_LOCK(crc16_tables);
+	for (guint i = 0; i < crc16_tables_len; i++) {
+		if (crc16_tables[i].polynomial == polynomial) {
+			G_UNLOCK(crc16_tables);
+			return crc16_tables[i].table;
+		}
+	}
+	if (crc16_tables_len >= G_N_ELEMENTS(crc16_tables)) {
+		G_UNLOCK(crc16_tables);
+		return NULL;
+	}
+
+	/* build once, and never modified afterwards */
+	item = &crc16_tables[crc16_tables_len];
+	item->polynomial = polynomial;
+	for (guint i = 0; i < 256; i++) {
+		guint8 tmp = (guint8)i;
+		item->table[i] = fu_crc16_step_bitwise(&tmp, 1, 0x0, polynomial);
+	}
+	crc16_tables_len++;
+	G_UNLOCK(crc16_tables);
+	return item->table;
+}
+
 /**
  * fu_crc16_full:
  * @buf: memory buffer
@@ -72,16 +132,19 @@ fu_crc8(const guint8 *buf, gsize bufsz)
 guint16
 fu_crc16_full(const guint8 *buf, gsize bufsz, guint16 crc, guint16 polynomial)
 {
-	for (gsize len = bufsz; len > 0; len--) {
-		crc = (guint16)(crc ^ (*buf++));
-		for (guint8 i = 0; i < 8; i++) {
-			if (crc & 0x1) {
-				crc = (crc >> 1) ^ polynomial;
-			} else {
-				crc >>= 1;
-			}
-		}
-	}
+	const guint16 *table;
+
+	/* not worth building a table for */
+	if (bufsz < FU_CRC16_TABLE_THRESHOLD)
+		return ~fu_crc16_step_bitwise(buf, bufsz, crc, polynomial);
+
+	/* cache is full of other polynomials */
+	table = fu_crc16_get_table(polynomial);
+	if (table == NULL)
+		return ~fu_crc16_step_bitwise(buf, bufsz, crc, polynomial);
+
+	for (gsize i = 0; i < bufsz; i++)
+		crc = (crc >> 8) ^ table[(crc ^ buf[i]) & 0xFF];
 	return ~crc;
 }
 
@@ -122,18 +185,6 @@ const struct {
     {FU_CRC32_KIND_Q, 0x814141AB, 0x00000000, FALSE, FALSE},
 };
 
-static guint8
-_reflect8(guint8 data)
-{
-	guint8 val = 0;
-	for (guint8 bit = 0; bit < 8; bit++) {
-		if (data & 0x01)
-			val |= 1 << (7 - bit);
-		data = (data >> 1);
-	}
-	return val;
-}
-
 static guint32
 _reflect32(guint32 data)
 {
@@ -146,6 +197,91 @@ _reflect32(guint32 data)
 	return val;
 }
 
+/*
+ * Slice-by-8 lookup tables, built once for each kind.
+ *
+ * Reflected kinds are computed in the reflected (LSB-first) domain using the reflected polynomial,
+ * and non-reflected kinds in the MSB-first domain; the value returned from fu_crc32_step() is
+ * always in the MSB-first domain so that it can be chained exactly as before.
+ */
+static guint32 crc32_tables[FU_CRC32_KIND_LAST][8][256];
+static gsize crc32_tables_init[FU_CRC32_KIND_LAST] = {0};
+
+static void
+fu_crc32_ensure_tables(FuCrc32Kind kind)
+{
+	if (g_once_init_enter(&crc32_tables_init[kind])) {
+		guint32 poly = crc32_map[kind].poly;
+		if (crc32_map[kind].reflected) {
+			guint32 poly_reflected = _reflect32(poly);
+			for (guint i = 0; i < 256; i++) {
+				guint32 crc = i;
+				for (guint8 bit = 0; bit < 8; bit++)
+					crc = (crc & 0x1) ? (crc >> 1) ^ poly_reflected : crc >> 1;
+				crc32_tables[kind][0][i] = crc;
+			}
+			for (guint i = 0; i < 256; i++) {
+				for (guint j = 1; j < 8; j++) {
+					guint32 tmp = crc32_tables[kind][j - 1][i];
+					crc32_tables[kind][j][i] =
+					    (tmp >> 8) ^ crc32_tables[kind][0][tmp & 0xFF];
+				}
+			}
+		} else {
+			for (guint i = 0; i < 256; i++) {
+				guint32 crc = (guint32)i << 24;
+				for (guint8 bit = 0; bit < 8; bit++)
+					crc = (crc & (1ul << 31)) ? (crc << 1) ^ poly : crc << 1;
+				crc32_tables[kind][0][i] = crc;
+			}
+			for (guint i = 0; i < 256; i++) {
+				for (guint j = 1; j < 8; j++) {
+					guint32 tmp = crc32_tables[kind][j - 1][i];
+					crc32_tables[kind][j][i] =
+					    (tmp << 8) ^ crc32_tables[kind][0][tmp >> 24];
+				}
+			}
+		}
+		g_once_init_leave(&crc32_tables_init[kind], 1);
+	}
+}
+
+static guint32
+fu_crc32_step_reflected(FuCrc32Kind kind, const guint8 *buf, gsize bufsz, guint32 crc)
+{
+	guint32(*t)[256] = crc32_tables[kind];
+	gsize i = 0;
+
+	for (; i + 8 <= bufsz; i += 8) {
+		guint32 one = crc ^ fu_memread_uint32(buf + i, G_LITTLE_ENDIAN);
+		guint32 two = fu_memread_uint32(buf + i + 4, G_LITTLE_ENDIAN);
+		crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^
+		      t[4][one >> 24] ^ t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^
+		      t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+	}
+	for (; i < bufsz; i++)
+		crc = (crc >> 8) ^ t[0][(crc ^ buf[i]) & 0xFF];
+	return crc;
+}
+
+static guint32
+fu_crc32_step_normal(FuCrc32Kind kind, const guint8 *buf, gsize bufsz, guint32 crc)
+{
+	guint32(*t)[256] = crc32_tables[kind];
+	gsize i = 0;
+
+	for (; i + 8 <= bufsz; i += 8) {
+		guint32 one = crc ^ fu_memread_uint32(buf + i, G_BIG_ENDIAN);
+		guint32 two = fu_memread_uint32(buf + i + 4, G_BIG_ENDIAN);
+		crc = t[7][one >> 24] ^ t[6][(one >> 16) & 0xFF] ^ t[5][(one >> 8) & 0xFF] ^
+		      t[4][one & 0xFF] ^ t[3][two >> 24] ^ t[2][(two >> 16) & 0xFF] ^
+		      t[1][(two >> 8) & 0xFF] ^ t[0][two & 0xFF];
+	}
+	for (; i < bufsz; i++)
+		crc = (crc << 8) ^ t[0][(crc >> 24) ^ buf[i]];
+	return crc;
+}
+
 /**
  * fu_crc32_step:
  * @kind: a #FuCrc32Kind, typically %FU_CRC32_KIND_STANDARD
@@ -166,18 +302,10 @@ fu_crc32_step(FuCrc32Kind kind, const guint8 *buf, gsize bufsz, guint32 crc)
 {
 	g_return_val_if_fail(kind < FU_CRC32_KIND_LAST, 0x0);
 
-	for (gsize i = 0; i < bufsz; ++i) {
-		guint32 tmp = crc32_map[kind].reflected ? _reflect8(buf[i]) : buf[i];
-		crc ^= tmp << 24;
-		for (guint8 bit = 0; bit < 8; bit++) {
-			if (crc & (1ul << 31)) {
-				crc = (crc << 1) ^ crc32_map[kind].poly;
-			} else {
-				crc = (crc << 1);
-			}
-		}
-	}
-	return crc;
+	fu_crc32_ensure_tables(kind);
+	if (crc32_map[kind].reflected)
+		return _reflect32(fu_crc32_step_reflected(kind, buf, bufsz, _reflect32(crc)));
+	return fu_crc32_step_normal(kind, buf, bufsz, crc);
 }
 
 /**
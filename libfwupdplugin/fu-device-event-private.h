@@ -10,6 +10,8 @@
 
 FuDeviceEvent *
 fu_device_event_new(const gchar *id);
+gchar *
+fu_device_event_normalize_id(const gchar *id) G_GNUC_NON_NULL(1);
 
 const gchar *
 fu_device_event_get_id(FuDeviceEvent *self) G_GNUC_NON_NULL(1);
@@ -17,7 +19,7 @@ fu_device_event_get_id(FuDeviceEvent *self) G_GNUC_NON_NULL(1);
 void
 fu_device_event_set_str(FuDeviceEvent *self, const gchar *key, const gchar *value)
     G_GNUC_NON_NULL(1, 2);
-const gchar *
+gchar *
 fu_device_event_get_str(FuDeviceEvent *self, const gchar *key, GError **error)
     G_GNUC_NON_NULL(1, 2);
 void
@@ -41,3 +43,6 @@ fu_device_event_copy_data(FuDeviceEvent *self,
 			  gsize bufsz,
 			  gsize *actual_length,
 			  GError **error) G_GNUC_NON_NULL(1, 2);
+gboolean
+fu_device_event_resolve_payload(FuDeviceEvent *self, GBytes *payload, GError **error)
+    G_GNUC_NON_NULL(1, 2);
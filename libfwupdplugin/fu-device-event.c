@@ -8,6 +8,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "fu-device-event-private.h"
 #include "fu-mem.h"
 
@@ -25,6 +27,15 @@ typedef struct {
 	GDestroyNotify destroy;
 } FuDeviceEventBlob;
 
+/* a payload stored outside the JSON, e.g. in a binary emulation archive */
+typedef struct {
+	guint64 offset;
+	guint64 size;
+} FuDeviceEventRef;
+
+/* payloads with more BASE-64 characters than this are stored as a hash in the event ID */
+#define FU_DEVICE_EVENT_DATA_INLINE_MAX 64
+
 typedef struct {
 	gchar *id;
 	GHashTable *values; /* (utf-8) (FuDeviceEventBlob) */
@@ -61,6 +72,60 @@ fu_device_event_blob_create(GType gtype, gpointer data, GDestroyNotify destroy)
 	return blob;
 }
 
+/**
+ * fu_device_event_normalize_id:
+ * @id: (not nullable): an event ID, e.g. `BulkTransfer:Endpoint=0x01,Data=AAAA,Length=0x3`
+ *
+ * Normalizes an event ID so that any large inline `Data=` payload is replaced by the SHA-1 hash
+ * of the BASE-64 string, e.g. `Data=#a9993e364706816aba3e25717850c26c9cd0d89d`.
+ *
+ * Both the event IDs saved in the emulation and the IDs used to find the event when replaying
+ * have to be normalized in the same way.
+ *
+ * Returns: (transfer full): string
+ *
+ * Since: 2.0.1
+ **/
+gchar *
+fu_device_event_normalize_id(const gchar *id)
+{
+	const gchar *tmp = id;
+	g_autoptr(GString) str = NULL;
+
+	g_return_val_if_fail(id != NULL, NULL);
+
+	/* nothing can be large enough to hash */
+	if (strlen(id) <= FU_DEVICE_EVENT_DATA_INLINE_MAX)
+		return g_strdup(id);
+
+	str = g_string_sized_new(strlen(id));
+	while (TRUE) {
+		const gchar *data = strstr(tmp, "Data=");
+		const gchar *end;
+		gsize datasz;
+
+		if (data == NULL)
+			break;
+		data += strlen("Data=");
+		end = strchr(data, ',');
+		if (end == NULL)
+			end = data + strlen(data);
+		datasz = end - data;
+		g_string_append_len(str, tmp, data - tmp);
+		if (datasz > FU_DEVICE_EVENT_DATA_INLINE_MAX && data[0] != '#') {
+			g_autofree gchar *csum = g_compute_checksum_for_data(G_CHECKSUM_SHA1,
+									     (const guchar *)data,
+									     datasz);
+			g_string_append_printf(str, "#%s", csum);
+		} else {
+			g_string_append_len(str, data, datasz);
+		}
+		tmp = end;
+	}
+	g_string_append(str, tmp);
+	return g_string_free(g_steal_pointer(&str), FALSE);
+}
+
 /**
  * fu_device_event_get_id:
  * @self: a #FuDeviceEvent
@@ -130,7 +195,7 @@ fu_device_event_set_i64(FuDeviceEvent *self, const gchar *key, gint64 value)
  * @key: (not nullable): a unique key, e.g. `Name`
  * @value: (not nullable): a #GBytes
  *
- * Sets a blob on the event. Note: blobs are stored internally as BASE-64 strings.
+ * Sets a blob on the event. The blob is only converted to BASE-64 when required.
  *
  * Since: 2.0.0
  **/
@@ -141,13 +206,12 @@ fu_device_event_set_bytes(FuDeviceEvent *self, const gchar *key, GBytes *value)
 	g_return_if_fail(FU_IS_DEVICE_EVENT(self));
 	g_return_if_fail(key != NULL);
 	g_return_if_fail(value != NULL);
-	g_hash_table_insert(
-	    priv->values,
-	    g_strdup(key),
-	    fu_device_event_blob_create(
-		G_TYPE_STRING,
-		g_base64_encode(g_bytes_get_data(value, NULL), g_bytes_get_size(value)),
-		g_free));
+	g_hash_table_insert(priv->values,
+			    g_strdup(key),
+			    fu_device_event_blob_create(G_TYPE_BYTES,
+							g_bytes_new(g_bytes_get_data(value, NULL),
+								    g_bytes_get_size(value)),
+							(GDestroyNotify)g_bytes_unref));
 }
 
 /**
@@ -157,7 +221,7 @@ fu_device_event_set_bytes(FuDeviceEvent *self, const gchar *key, GBytes *value)
  * @buf: (not nullable): a buffer
  * @bufsz: size of @buf
  *
- * Sets a memory buffer on the event. Note: memory buffers are stored internally as BASE-64 strings.
+ * Sets a memory buffer on the event. The buffer is only converted to BASE-64 when required.
  *
  * Since: 2.0.0
  **/
@@ -168,14 +232,15 @@ fu_device_event_set_data(FuDeviceEvent *self, const gchar *key, const guint8 *bu
 	g_return_if_fail(FU_IS_DEVICE_EVENT(self));
 	g_return_if_fail(key != NULL);
 	g_return_if_fail(buf != NULL);
-	g_hash_table_insert(
-	    priv->values,
-	    g_strdup(key),
-	    fu_device_event_blob_create(G_TYPE_STRING, g_base64_encode(buf, bufsz), g_free));
+	g_hash_table_insert(priv->values,
+			    g_strdup(key),
+			    fu_device_event_blob_create(G_TYPE_BYTES,
+							g_bytes_new(buf, bufsz),
+							(GDestroyNotify)g_bytes_unref));
 }
 
-static gpointer
-fu_device_event_lookup(FuDeviceEvent *self, const gchar *key, GType gtype, GError **error)
+static FuDeviceEventBlob *
+fu_device_event_lookup_blob(FuDeviceEvent *self, const gchar *key, GError **error)
 {
 	FuDeviceEventPrivate *priv = GET_PRIVATE(self);
 	FuDeviceEventBlob *blob = g_hash_table_lookup(priv->values, key);
@@ -183,6 +248,23 @@ fu_device_event_lookup(FuDeviceEvent *self, const gchar *key, GType gtype, GErro
 		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND, "no event for key %s", key);
 		return NULL;
 	}
+	if (blob->gtype == G_TYPE_POINTER) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "no payload loaded for key %s",
+			    key);
+		return NULL;
+	}
+	return blob;
+}
+
+static gpointer
+fu_device_event_lookup(FuDeviceEvent *self, const gchar *key, GType gtype, GError **error)
+{
+	FuDeviceEventBlob *blob = fu_device_event_lookup_blob(self, key, error);
+	if (blob == NULL)
+		return NULL;
 	if (blob->gtype != gtype) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -200,19 +282,34 @@ fu_device_event_lookup(FuDeviceEvent *self, const gchar *key, GType gtype, GErro
  * @key: (not nullable): a unique key, e.g. `Name`
  * @error: (nullable): optional return location for an error
  *
- * Gets a string value from the event.
+ * Gets a string value from the event. Binary values are returned as BASE-64.
  *
- * Returns: (nullable): string, or %NULL on error
+ * Returns: (transfer full) (nullable): string, or %NULL on error
  *
  * Since: 2.0.0
  **/
-const gchar *
+gchar *
 fu_device_event_get_str(FuDeviceEvent *self, const gchar *key, GError **error)
 {
+	FuDeviceEventBlob *blob;
+	const gchar *str;
+
 	g_return_val_if_fail(FU_IS_DEVICE_EVENT(self), NULL);
 	g_return_val_if_fail(key != NULL, NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
-	return (const gchar *)fu_device_event_lookup(self, key, G_TYPE_STRING, error);
+
+	/* blobs are only converted to BASE-64 when actually required */
+	blob = fu_device_event_lookup_blob(self, key, error);
+	if (blob == NULL)
+		return NULL;
+	if (blob->gtype == G_TYPE_BYTES) {
+		GBytes *bytes = (GBytes *)blob->data;
+		return g_base64_encode(g_bytes_get_data(bytes, NULL), g_bytes_get_size(bytes));
+	}
+	str = fu_device_event_lookup(self, key, G_TYPE_STRING, error);
+	if (str == NULL)
+		return NULL;
+	return g_strdup(str);
 }
 
 /**
@@ -255,6 +352,7 @@ fu_device_event_get_i64(FuDeviceEvent *self, const gchar *key, GError **error)
 GBytes *
 fu_device_event_get_bytes(FuDeviceEvent *self, const gchar *key, GError **error)
 {
+	FuDeviceEventBlob *blob;
 	const gchar *blobstr;
 	gsize bufsz = 0;
 	g_autofree guchar *buf = NULL;
@@ -263,6 +361,13 @@ fu_device_event_get_bytes(FuDeviceEvent *self, const gchar *key, GError **error)
 	g_return_val_if_fail(key != NULL, NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
+	/* no copy required */
+	blob = fu_device_event_lookup_blob(self, key, error);
+	if (blob == NULL)
+		return NULL;
+	if (blob->gtype == G_TYPE_BYTES)
+		return g_bytes_ref((GBytes *)blob->data);
+
 	blobstr = fu_device_event_lookup(self, key, G_TYPE_STRING, error);
 	if (blobstr == NULL)
 		return NULL;
@@ -293,18 +398,18 @@ fu_device_event_copy_data(FuDeviceEvent *self,
 			  gsize *actual_length,
 			  GError **error)
 {
-	const gchar *blobstr;
 	gsize bufsz_src = 0;
-	g_autofree guchar *buf_src = NULL;
+	const guint8 *buf_src;
+	g_autoptr(GBytes) blob = NULL;
 
 	g_return_val_if_fail(FU_IS_DEVICE_EVENT(self), FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	blobstr = fu_device_event_lookup(self, key, G_TYPE_STRING, error);
-	if (blobstr == NULL)
+	blob = fu_device_event_get_bytes(self, key, error);
+	if (blob == NULL)
 		return FALSE;
-	buf_src = g_base64_decode(blobstr, &bufsz_src);
+	buf_src = g_bytes_get_data(blob, &bufsz_src);
 	if (actual_length != NULL)
 		*actual_length = bufsz_src;
 	if (buf != NULL)
@@ -331,9 +436,24 @@ fu_device_event_add_json(FwupdCodec *codec, JsonBuilder *builder, FwupdCodecFlag
 		if (blob->gtype == G_TYPE_INT) {
 			json_builder_set_member_name(builder, (const gchar *)key);
 			json_builder_add_int_value(builder, *((gint64 *)blob->data));
-		} else if (blob->gtype == G_TYPE_BYTES || blob->gtype == G_TYPE_STRING) {
+		} else if (blob->gtype == G_TYPE_STRING) {
 			json_builder_set_member_name(builder, (const gchar *)key);
 			json_builder_add_string_value(builder, (const gchar *)blob->data);
+		} else if (blob->gtype == G_TYPE_BYTES) {
+			GBytes *bytes = (GBytes *)blob->data;
+			g_autofree gchar *str =
+			    g_base64_encode(g_bytes_get_data(bytes, NULL), g_bytes_get_size(bytes));
+			json_builder_set_member_name(builder, (const gchar *)key);
+			json_builder_add_string_value(builder, str);
+		} else if (blob->gtype == G_TYPE_POINTER) {
+			FuDeviceEventRef *ref = (FuDeviceEventRef *)blob->data;
+			json_builder_set_member_name(builder, (const gchar *)key);
+			json_builder_begin_object(builder);
+			json_builder_set_member_name(builder, "Offset");
+			json_builder_add_int_value(builder, ref->offset);
+			json_builder_set_member_name(builder, "Size");
+			json_builder_add_int_value(builder, ref->size);
+			json_builder_end_object(builder);
 		} else {
 			g_warning("invalid GType %s, ignoring", g_type_name(blob->gtype));
 		}
@@ -353,13 +473,41 @@ fu_device_event_from_json(FwupdCodec *codec, JsonNode *json_node, GError **error
 	json_object_iter_init(&iter, json_object);
 	while (json_object_iter_next(&iter, &member_name, &member_node)) {
 		GType gtype;
+
+		/* payload stored outside the JSON */
+		if (JSON_NODE_TYPE(member_node) == JSON_NODE_OBJECT) {
+			JsonObject *json_ref = json_node_get_object(member_node);
+			FuDeviceEventRef *ref;
+			gint64 offset;
+			gint64 size;
+
+			offset = json_object_get_int_member_with_default(json_ref, "Offset", -1);
+			size = json_object_get_int_member_with_default(json_ref, "Size", -1);
+			if (offset < 0 || size < 0) {
+				g_set_error(error,
+					    FWUPD_ERROR,
+					    FWUPD_ERROR_INVALID_DATA,
+					    "invalid payload reference for key %s",
+					    member_name);
+				return FALSE;
+			}
+			ref = g_new0(FuDeviceEventRef, 1);
+			ref->offset = offset;
+			ref->size = size;
+			g_hash_table_insert(
+			    priv->values,
+			    g_strdup(member_name),
+			    fu_device_event_blob_create(G_TYPE_POINTER, ref, g_free));
+			continue;
+		}
 		if (JSON_NODE_TYPE(member_node) != JSON_NODE_VALUE)
 			continue;
 		gtype = json_node_get_value_type(member_node);
 		if (gtype == G_TYPE_STRING) {
 			if (g_strcmp0(member_name, "Id") == 0) {
 				g_free(priv->id);
-				priv->id = json_node_dup_string(member_node);
+				priv->id =
+				    fu_device_event_normalize_id(json_node_get_string(member_node));
 				continue;
 			}
 			fu_device_event_set_str(self,
@@ -377,6 +525,61 @@ fu_device_event_from_json(FwupdCodec *codec, JsonNode *json_node, GError **error
 	return TRUE;
 }
 
+/**
+ * fu_device_event_resolve_payload:
+ * @self: a #FuDeviceEvent
+ * @payload: (not nullable): the payload section of a binary emulation archive
+ * @error: (nullable): optional return location for an error
+ *
+ * Resolves any `{"Offset":0,"Size":0}` payload references loaded using fwupd_codec_from_json()
+ * into sub-slices of @payload. No data is copied, so @payload can be a memory mapped file.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 2.0.1
+ **/
+gboolean
+fu_device_event_resolve_payload(FuDeviceEvent *self, GBytes *payload, GError **error)
+{
+	FuDeviceEventPrivate *priv = GET_PRIVATE(self);
+	GHashTableIter iter;
+	gpointer key, value;
+	gsize payloadsz = g_bytes_get_size(payload);
+
+	g_return_val_if_fail(FU_IS_DEVICE_EVENT(self), FALSE);
+	g_return_val_if_fail(payload != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	g_hash_table_iter_init(&iter, priv->values);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		FuDeviceEventBlob *blob = (FuDeviceEventBlob *)value;
+		FuDeviceEventRef *ref = (FuDeviceEventRef *)blob->data;
+
+		if (blob->gtype != G_TYPE_POINTER)
+			continue;
+		if (ref->offset > payloadsz || ref->size > payloadsz - ref->offset) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_DATA,
+				    "payload for key %s of 0x%x bytes @0x%x outside of 0x%x",
+				    (const gchar *)key,
+				    (guint)ref->size,
+				    (guint)ref->offset,
+				    (guint)payloadsz);
+			return FALSE;
+		}
+		g_hash_table_iter_replace(
+		    &iter,
+		    fu_device_event_blob_create(
+			G_TYPE_BYTES,
+			g_bytes_new_from_bytes(payload, ref->offset, ref->size),
+			(GDestroyNotify)g_bytes_unref));
+	}
+
+	/* success */
+	return TRUE;
+}
+
 static void
 fu_device_event_init(FuDeviceEvent *self)
 {
@@ -413,7 +616,10 @@ fu_device_event_codec_iface_init(FwupdCodecInterface *iface)
 
 /**
  * fu_device_event_new:
- * @id: a cache key
+ * @id: (nullable): a cache key
+ *
+ * Creates a new event. Any large payloads in @id are normalized using
+ * fu_device_event_normalize_id().
  *
  * Return value: (transfer full): a new #FuDeviceEvent object.
  *
@@ -424,6 +630,7 @@ fu_device_event_new(const gchar *id)
 {
 	FuDeviceEvent *self = g_object_new(FU_TYPE_DEVICE_EVENT, NULL);
 	FuDeviceEventPrivate *priv = GET_PRIVATE(self);
-	priv->id = g_strdup(id);
+	if (id != NULL)
+		priv->id = fu_device_event_normalize_id(id);
 	return FU_DEVICE_EVENT(self);
 }
@@ -18,6 +18,7 @@
 #include "fu-common.h"
 #include "fu-device-event-private.h"
 #include "fu-device-private.h"
+#include "fu-dump.h"
 #include "fu-input-stream.h"
 #include "fu-quirks.h"
 #include "fu-security-attr.h"
@@ -62,6 +63,8 @@ typedef struct {
 	GPtrArray *parent_backend_ids;	/* (nullable) */
 	GPtrArray *counterpart_guids;	/* (nullable) */
 	GPtrArray *events;		/* (nullable) (element-type FuDeviceEvent) */
+	GHashTable *events_index;	/* (nullable) (utf-8) (FuDeviceEventPositions) */
+	guint events_indexed;
 	guint event_idx;
 	guint remove_delay;    /* ms */
 	guint acquiesce_delay; /* ms */
@@ -109,10 +112,16 @@ typedef struct {
 	gboolean value;
 } FuDevicePrivateFlagItem;
 
+typedef struct {
+	GArray *positions; /* (element-type guint) */
+	guint cursor;
+} FuDeviceEventPositions;
+
 enum {
 	PROP_0,
 	PROP_PHYSICAL_ID,
 	PROP_LOGICAL_ID,
+	PROP_EQUIVALENT_ID,
 	PROP_BACKEND_ID,
 	PROP_CONTEXT,
 	PROP_BACKEND,
@@ -122,7 +131,7 @@ enum {
 	PROP_LAST
 };
 
-enum { SIGNAL_CHILD_ADDED, SIGNAL_CHILD_REMOVED, SIGNAL_REQUEST, SIGNAL_LAST };
+enum { SIGNAL_CHILD_ADDED, SIGNAL_CHILD_REMOVED, SIGNAL_REQUEST, SIGNAL_GUID_ADDED, SIGNAL_LAST };
 
 static guint signals[SIGNAL_LAST] = {0};
 
@@ -141,6 +150,9 @@ fu_device_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec
 	case PROP_LOGICAL_ID:
 		g_value_set_string(value, priv->logical_id);
 		break;
+	case PROP_EQUIVALENT_ID:
+		g_value_set_string(value, priv->equivalent_id);
+		break;
 	case PROP_BACKEND_ID:
 		g_value_set_string(value, priv->backend_id);
 		break;
@@ -176,6 +188,9 @@ fu_device_set_property(GObject *object, guint prop_id, const GValue *value, GPar
 	case PROP_LOGICAL_ID:
 		fu_device_set_logical_id(self, g_value_get_string(value));
 		break;
+	case PROP_EQUIVALENT_ID:
+		fu_device_set_equivalent_id(self, g_value_get_string(value));
+		break;
 	case PROP_BACKEND_ID:
 		fu_device_set_backend_id(self, g_value_get_string(value));
 		break;
@@ -847,6 +862,7 @@ fu_device_set_equivalent_id(FuDevice *self, const gchar *equivalent_id)
 
 	g_free(priv->equivalent_id);
 	priv->equivalent_id = g_strdup(equivalent_id);
+	g_object_notify(G_OBJECT(self), "equivalent-id");
 }
 
 /**
@@ -2045,13 +2061,23 @@ fu_device_get_firmware_size_max(FuDevice *self)
 	return priv->size_max;
 }
 
+/* anything indexing the device by GUID needs to know about GUIDs added after ->setup() */
+static void
+fu_device_add_guid_internal(FuDevice *self, const gchar *guid)
+{
+	if (fwupd_device_has_guid(FWUPD_DEVICE(self), guid))
+		return;
+	fwupd_device_add_guid(FWUPD_DEVICE(self), guid);
+	g_signal_emit(self, signals[SIGNAL_GUID_ADDED], 0, guid);
+}
+
 static void
 fu_device_add_guid_safe(FuDevice *self, const gchar *guid, FuDeviceInstanceFlags flags)
 {
 	/* add the device GUID before adding additional GUIDs from quirks
 	 * to ensure the bootloader GUID is listed after the runtime GUID */
 	if (flags & FU_DEVICE_INSTANCE_FLAG_VISIBLE)
-		fwupd_device_add_guid(FWUPD_DEVICE(self), guid);
+		fu_device_add_guid_internal(self, guid);
 	if (flags & FU_DEVICE_INSTANCE_FLAG_QUIRKS)
 		fu_device_add_guid_quirks(self, guid);
 }
@@ -2159,7 +2185,7 @@ fu_device_add_instance_id_full(FuDevice *self,
 
 	/* already done by ->setup(), so this must be ->registered() */
 	if (priv->done_setup)
-		fwupd_device_add_guid(FWUPD_DEVICE(self), guid);
+		fu_device_add_guid_internal(self, guid);
 }
 
 /**
@@ -4241,6 +4267,35 @@ fu_device_to_string(FuDevice *self)
 	return g_string_free(str, FALSE);
 }
 
+/**
+ * fu_device_dump:
+ * @self: a #FuDevice
+ * @log_domain: (nullable): optional log domain, typically %G_LOG_DOMAIN
+ * @title: (nullable): optional prefix title
+ *
+ * Logs the device at debug level, with an optional title.
+ *
+ * The device is only converted to a string if debugging is enabled for @log_domain, which
+ * makes this safe to use where devices are added, removed and updated.
+ *
+ * Since: 2.0.1
+ **/
+void
+fu_device_dump(FuDevice *self, const gchar *log_domain, const gchar *title)
+{
+	g_autofree gchar *str = NULL;
+
+	g_return_if_fail(FU_IS_DEVICE(self));
+
+	if (!fu_dump_is_enabled(log_domain))
+		return;
+	str = fu_device_to_string(self);
+	if (title != NULL)
+		g_log(log_domain, G_LOG_LEVEL_DEBUG, "%s %s", title, str);
+	else
+		g_log(log_domain, G_LOG_LEVEL_DEBUG, "%s", str);
+}
+
 /**
  * fu_device_set_context:
  * @self: a #FuDevice
@@ -5134,7 +5189,7 @@ fu_device_convert_instance_ids(FuDevice *self)
 	for (guint i = 0; i < instance_ids->len; i++) {
 		const gchar *instance_id = g_ptr_array_index(instance_ids, i);
 		g_autofree gchar *guid = fwupd_guid_hash_string(instance_id);
-		fwupd_device_add_guid(FWUPD_DEVICE(self), guid);
+		fu_device_add_guid_internal(self, guid);
 	}
 }
 
@@ -5523,6 +5578,7 @@ fu_device_incorporate(FuDevice *self, FuDevice *donor)
 	GPtrArray *instance_ids = fu_device_get_instance_ids(donor);
 	GPtrArray *parent_physical_ids = fu_device_get_parent_physical_ids(donor);
 	GPtrArray *parent_backend_ids = fu_device_get_parent_backend_ids(donor);
+	guint guids_len;
 	GHashTableIter iter;
 	gpointer key, value;
 
@@ -5625,7 +5681,12 @@ fu_device_incorporate(FuDevice *self, FuDevice *donor)
 	}
 
 	/* now the base class, where all the interesting bits are */
+	guids_len = fu_device_get_guids(self)->len;
 	fwupd_device_incorporate(FWUPD_DEVICE(self), FWUPD_DEVICE(donor));
+	for (guint i = guids_len; i < fu_device_get_guids(self)->len; i++) {
+		const gchar *guid = g_ptr_array_index(fu_device_get_guids(self), i);
+		g_signal_emit(self, signals[SIGNAL_GUID_ADDED], 0, guid);
+	}
 
 	/* remove the baseclass-added serial number if set */
 	if (fu_device_has_private_flag(self, FU_DEVICE_PRIVATE_FLAG_NO_SERIAL_NUMBER))
@@ -6488,6 +6549,77 @@ fu_device_ensure_events(FuDevice *self)
 	priv->events = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 }
 
+static void
+fu_device_event_positions_free(FuDeviceEventPositions *item)
+{
+	g_array_unref(item->positions);
+	g_free(item);
+}
+
+/* returns the first position not before @event_idx, or the first position if none */
+static guint
+fu_device_event_positions_find(FuDeviceEventPositions *item, guint event_idx)
+{
+	GArray *positions = item->positions;
+
+	/* the replay moved backwards, so bisect rather than scan from the start */
+	if (item->cursor > 0 && g_array_index(positions, guint, item->cursor - 1) >= event_idx) {
+		guint lo = 0;
+		guint hi = item->cursor - 1;
+		while (lo < hi) {
+			guint mid = lo + (hi - lo) / 2;
+			if (g_array_index(positions, guint, mid) < event_idx)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		item->cursor = lo;
+	}
+
+	/* amortized O(1) when replaying in order */
+	while (item->cursor < positions->len &&
+	       g_array_index(positions, guint, item->cursor) < event_idx)
+		item->cursor++;
+	if (item->cursor < positions->len)
+		return g_array_index(positions, guint, item->cursor);
+	return g_array_index(positions, guint, 0);
+}
+
+/* index any events added since the last lookup, using the normalized event ID */
+static void
+fu_device_ensure_events_index(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+
+	/* events were removed without using fu_device_clear_events() */
+	if (priv->events_index != NULL && priv->events_indexed > priv->events->len)
+		g_clear_pointer(&priv->events_index, g_hash_table_unref);
+	if (priv->events_index == NULL) {
+		priv->events_index =
+		    g_hash_table_new_full(g_str_hash,
+					  g_str_equal,
+					  g_free,
+					  (GDestroyNotify)fu_device_event_positions_free);
+		priv->events_indexed = 0;
+	}
+	for (guint i = priv->events_indexed; i < priv->events->len; i++) {
+		FuDeviceEvent *event = g_ptr_array_index(priv->events, i);
+		const gchar *id = fu_device_event_get_id(event);
+		FuDeviceEventPositions *item;
+
+		if (id == NULL)
+			continue;
+		item = g_hash_table_lookup(priv->events_index, id);
+		if (item == NULL) {
+			item = g_new0(FuDeviceEventPositions, 1);
+			item->positions = g_array_new(FALSE, FALSE, sizeof(guint));
+			g_hash_table_insert(priv->events_index, g_strdup(id), item);
+		}
+		g_array_append_val(item->positions, i);
+	}
+	priv->events_indexed = priv->events->len;
+}
+
 /**
  * fu_device_add_event:
  * @self: a #FuDevice
@@ -6562,6 +6694,9 @@ FuDeviceEvent *
 fu_device_load_event(FuDevice *self, const gchar *id, GError **error)
 {
 	FuDevicePrivate *priv = GET_PRIVATE(self);
+	FuDeviceEventPositions *item;
+	guint idx;
+	g_autofree gchar *id_normalized = NULL;
 
 	g_return_val_if_fail(FU_IS_DEVICE(self), NULL);
 	g_return_val_if_fail(id != NULL, NULL);
@@ -6583,29 +6718,23 @@ fu_device_load_event(FuDevice *self, const gchar *id, GError **error)
 		priv->event_idx = 0;
 	}
 
-	/* look for the next event in the sequence */
-	for (guint i = priv->event_idx; i < priv->events->len; i++) {
-		FuDeviceEvent *event = g_ptr_array_index(priv->events, i);
-		if (g_strcmp0(fu_device_event_get_id(event), id) == 0) {
-			g_debug("found in-order %s at position %u", id, i);
-			priv->event_idx = i + 1;
-			return event;
-		}
-	}
-
-	/* look for *any* event that matches */
-	for (guint i = 0; i < priv->events->len; i++) {
-		FuDeviceEvent *event = g_ptr_array_index(priv->events, i);
-		if (g_strcmp0(fu_device_event_get_id(event), id) == 0) {
-			g_debug("found out-of-order %s at position %u", id, i);
-			priv->event_idx = i + 1;
-			return event;
-		}
+	/* any large payload is stored as a hash */
+	id_normalized = fu_device_event_normalize_id(id);
+	fu_device_ensure_events_index(self);
+	item = g_hash_table_lookup(priv->events_index, id_normalized);
+	if (item == NULL) {
+		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL, "no event with ID %s", id);
+		return NULL;
 	}
 
-	/* nothing found */
-	g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL, "no event with ID %s", id);
-	return NULL;
+	/* look for the next event in the sequence, otherwise *any* event that matches */
+	idx = fu_device_event_positions_find(item, priv->event_idx);
+	if (idx >= priv->event_idx)
+		g_debug("found in-order %s at position %u", id_normalized, idx);
+	else
+		g_debug("found out-of-order %s at position %u", id_normalized, idx);
+	priv->event_idx = idx + 1;
+	return g_ptr_array_index(priv->events, idx);
 }
 
 /**
@@ -6661,6 +6790,7 @@ fu_device_clear_events(FuDevice *self)
 	if (priv->events == NULL)
 		return;
 	g_ptr_array_set_size(priv->events, 0);
+	g_clear_pointer(&priv->events_index, g_hash_table_unref);
 	priv->event_idx = 0;
 }
 
@@ -6733,6 +6863,25 @@ fu_device_class_init(FuDeviceClass *klass)
 					       G_TYPE_NONE,
 					       1,
 					       FWUPD_TYPE_REQUEST);
+	/**
+	 * FuDevice::guid-added:
+	 * @self: the #FuDevice instance that emitted the signal
+	 * @guid: the GUID
+	 *
+	 * The ::guid-added signal is emitted when a GUID has been added to the device.
+	 *
+	 * Since: 2.0.1
+	 **/
+	signals[SIGNAL_GUID_ADDED] = g_signal_new("guid-added",
+						  G_TYPE_FROM_CLASS(object_class),
+						  G_SIGNAL_RUN_LAST,
+						  0,
+						  NULL,
+						  NULL,
+						  g_cclosure_marshal_VOID__STRING,
+						  G_TYPE_NONE,
+						  1,
+						  G_TYPE_STRING);
 
 	/**
 	 * FuDevice:physical-id:
@@ -6762,6 +6911,20 @@ fu_device_class_init(FuDeviceClass *klass)
 				    G_PARAM_READWRITE | G_PARAM_STATIC_NAME);
 	g_object_class_install_property(object_class, PROP_LOGICAL_ID, pspec);
 
+	/**
+	 * FuDevice:equivalent-id:
+	 *
+	 * The device equivalent ID.
+	 *
+	 * Since: 2.0.1
+	 */
+	pspec = g_param_spec_string("equivalent-id",
+				    NULL,
+				    NULL,
+				    NULL,
+				    G_PARAM_READWRITE | G_PARAM_STATIC_NAME);
+	g_object_class_install_property(object_class, PROP_EQUIVALENT_ID, pspec);
+
 	/**
 	 * FuDevice:backend-id:
 	 *
@@ -6956,6 +7119,8 @@ fu_device_finalize(GObject *object)
 		g_ptr_array_unref(priv->counterpart_guids);
 	if (priv->events != NULL)
 		g_ptr_array_unref(priv->events);
+	if (priv->events_index != NULL)
+		g_hash_table_unref(priv->events_index);
 	if (priv->retry_recs != NULL)
 		g_ptr_array_unref(priv->retry_recs);
 	if (priv->instance_id_quirks != NULL)
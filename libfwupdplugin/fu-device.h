@@ -644,6 +644,8 @@ fu_device_new(FuContext *ctx);
 gchar *
 fu_device_to_string(FuDevice *self) G_GNUC_NON_NULL(1);
 void
+fu_device_dump(FuDevice *self, const gchar *log_domain, const gchar *title) G_GNUC_NON_NULL(1);
+void
 fu_device_add_string(FuDevice *self, guint idt, GString *str) G_GNUC_NON_NULL(1, 3);
 const gchar *
 fu_device_get_equivalent_id(FuDevice *self) G_GNUC_NON_NULL(1);
@@ -265,6 +265,7 @@ fu_dfuse_firmware_init(FuDfuseFirmware *self)
 {
 	fu_dfu_firmware_set_version(FU_DFU_FIRMWARE(self), FU_DFU_FIRMARE_VERSION_DFUSE);
 	fu_firmware_set_images_max(FU_FIRMWARE(self), 255);
+	fu_firmware_add_magic(FU_FIRMWARE(self), (const guint8 *)"DfuSe", 5, 0x0);
 }
 
 static void
@@ -10,6 +10,28 @@
 
 #include "fu-dump.h"
 
+/**
+ * fu_dump_is_enabled:
+ * @log_domain: (nullable): optional log domain, typically %G_LOG_DOMAIN
+ *
+ * Checks if verbose debugging output is wanted for a log domain, which allows callers to avoid
+ * building large debugging strings that are just going to be thrown away.
+ *
+ * This is always enabled when `FWUPD_VERBOSE` is set, and otherwise uses the same rules as the
+ * default GLib log writer, e.g. `G_MESSAGES_DEBUG`.
+ *
+ * Returns: %TRUE if a debug dump for @log_domain should be built
+ *
+ * Since: 2.0.1
+ **/
+gboolean
+fu_dump_is_enabled(const gchar *log_domain)
+{
+	if (g_getenv("FWUPD_VERBOSE") != NULL)
+		return TRUE;
+	return !g_log_writer_default_would_drop(G_LOG_LEVEL_DEBUG, log_domain);
+}
+
 /**
  * fu_dump_full:
  * @log_domain: (nullable): optional log domain, typically %G_LOG_DOMAIN
@@ -24,6 +24,8 @@ typedef enum {
 	FU_DUMP_FLAGS_LAST
 } FuDumpFlags;
 
+gboolean
+fu_dump_is_enabled(const gchar *log_domain);
 void
 fu_dump_raw(const gchar *log_domain, const gchar *title, const guint8 *data, gsize len)
     G_GNUC_NON_NULL(1);
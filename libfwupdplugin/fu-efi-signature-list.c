@@ -29,6 +29,7 @@
 
 struct _FuEfiSignatureList {
 	FuFirmware parent_instance;
+	GHashTable *checksums; /* nullable, SHA256 checksum:FuEfiSignature (noref) */
 };
 
 G_DEFINE_TYPE(FuEfiSignatureList, fu_efi_signature_list, FU_TYPE_FIRMWARE)
@@ -176,6 +177,82 @@ fu_efi_signature_list_get_version(FuEfiSignatureList *self)
 	return g_strdup_printf("%u", csum_cnt);
 }
 
+static gboolean
+fu_efi_signature_list_ensure_checksums(FuEfiSignatureList *self, GError **error)
+{
+	g_autoptr(GHashTable) checksums = NULL;
+	g_autoptr(GPtrArray) sigs = NULL;
+
+	/* cleared when signatures are added or removed */
+	if (self->checksums != NULL)
+		return TRUE;
+
+	sigs = fu_firmware_get_images(FU_FIRMWARE(self));
+	checksums = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	for (guint i = 0; i < sigs->len; i++) {
+		FuFirmware *sig = g_ptr_array_index(sigs, i);
+		gchar *checksum = fu_firmware_get_checksum(sig, G_CHECKSUM_SHA256, error);
+		if (checksum == NULL)
+			return FALSE;
+		g_hash_table_insert(checksums, checksum, sig);
+	}
+	self->checksums = g_steal_pointer(&checksums);
+	return TRUE;
+}
+
+static void
+fu_efi_signature_list_images_changed(FuFirmware *firmware)
+{
+	FuEfiSignatureList *self = FU_EFI_SIGNATURE_LIST(firmware);
+	g_clear_pointer(&self->checksums, g_hash_table_unref);
+}
+
+/**
+ * fu_efi_signature_list_has_checksum:
+ * @self: a #FuEfiSignatureList
+ * @checksum: (not nullable): a checksum string, typically a SHA256 Authenticode hash
+ * @error: (nullable): optional return location for an error
+ *
+ * Finds if the signature list contains an entry with a specific checksum.
+ *
+ * The SHA256 checksums of all the entries are only computed once, so this is much faster than
+ * fu_firmware_get_image_by_checksum() when checking lots of files against the same list.
+ *
+ * Returns: %TRUE if the checksum was found
+ *
+ * Since: 2.0.1
+ **/
+gboolean
+fu_efi_signature_list_has_checksum(FuEfiSignatureList *self,
+				   const gchar *checksum,
+				   GError **error)
+{
+	g_autoptr(FuFirmware) img = NULL;
+
+	g_return_val_if_fail(FU_IS_EFI_SIGNATURE_LIST(self), FALSE);
+	g_return_val_if_fail(checksum != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* use the index */
+	if (fwupd_checksum_guess_kind(checksum) == G_CHECKSUM_SHA256) {
+		if (!fu_efi_signature_list_ensure_checksums(self, error))
+			return FALSE;
+		if (!g_hash_table_contains(self->checksums, checksum)) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_FOUND,
+				    "no signature with checksum %s found",
+				    checksum);
+			return FALSE;
+		}
+		return TRUE;
+	}
+
+	/* fallback */
+	img = fu_firmware_get_image_by_checksum(FU_FIRMWARE(self), checksum, error);
+	return img != NULL;
+}
+
 static gboolean
 fu_efi_signature_list_validate(FuFirmware *firmware,
 			       GInputStream *stream,
@@ -223,6 +300,7 @@ fu_efi_signature_list_parse(FuFirmware *firmware,
 	/* parse each EFI_SIGNATURE_LIST */
 	if (!fu_input_stream_size(stream, &streamsz, error))
 		return FALSE;
+	g_clear_pointer(&self->checksums, g_hash_table_unref);
 	while (offset < streamsz) {
 		if (!fu_efi_signature_list_parse_list(self, stream, &offset, error))
 			return FALSE;
@@ -291,13 +369,25 @@ fu_efi_signature_list_new(void)
 	return g_object_new(FU_TYPE_EFI_SIGNATURE_LIST, NULL);
 }
 
+static void
+fu_efi_signature_list_finalize(GObject *obj)
+{
+	FuEfiSignatureList *self = FU_EFI_SIGNATURE_LIST(obj);
+	if (self->checksums != NULL)
+		g_hash_table_unref(self->checksums);
+	G_OBJECT_CLASS(fu_efi_signature_list_parent_class)->finalize(obj);
+}
+
 static void
 fu_efi_signature_list_class_init(FuEfiSignatureListClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
 	FuFirmwareClass *firmware_class = FU_FIRMWARE_CLASS(klass);
+	object_class->finalize = fu_efi_signature_list_finalize;
 	firmware_class->validate = fu_efi_signature_list_validate;
 	firmware_class->parse = fu_efi_signature_list_parse;
 	firmware_class->write = fu_efi_signature_list_write;
+	firmware_class->images_changed = fu_efi_signature_list_images_changed;
 }
 
 static void
@@ -13,3 +13,7 @@ G_DECLARE_FINAL_TYPE(FuEfiSignatureList, fu_efi_signature_list, FU, EFI_SIGNATUR
 
 FuFirmware *
 fu_efi_signature_list_new(void);
+gboolean
+fu_efi_signature_list_has_checksum(FuEfiSignatureList *self,
+				   const gchar *checksum,
+				   GError **error) G_GNUC_NON_NULL(1, 2);
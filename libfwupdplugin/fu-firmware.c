@@ -8,14 +8,19 @@
 
 #include "config.h"
 
+#include <string.h>
+
+#include "fu-buffered-input-stream.h"
 #include "fu-byte-array.h"
 #include "fu-bytes.h"
+#include "fu-cab-folder-input-stream.h"
 #include "fu-chunk-private.h"
 #include "fu-common.h"
 #include "fu-firmware.h"
 #include "fu-input-stream.h"
+#include "fu-mapped-input-stream.h"
 #include "fu-mem.h"
-#include "fu-partial-input-stream.h"
+#include "fu-partial-input-stream-private.h"
 #include "fu-string.h"
 
 /**
@@ -45,8 +50,11 @@ typedef struct {
 	gsize size_max;
 	guint images_max;
 	guint depth;
+	gsize stream_buffer_window;
 	GPtrArray *chunks;  /* nullable, element-type FuChunk */
 	GPtrArray *patches; /* nullable, element-type FuFirmwarePatch */
+	GPtrArray *magic;   /* nullable, element-type FuFirmwareMagic */
+	GHashTable *checksums; /* nullable, GChecksumType:checksum */
 } FuFirmwarePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(FuFirmware, fu_firmware, G_TYPE_OBJECT)
@@ -56,6 +64,9 @@ enum { PROP_0, PROP_PARENT, PROP_LAST };
 
 #define FU_FIRMWARE_IMAGE_DEPTH_MAX 50
 
+/* default read-ahead used when parsing streams that need a syscall for each read */
+#define FU_FIRMWARE_STREAM_BUFFER_WINDOW 0x1000
+
 /**
  * fu_firmware_flag_to_string:
  * @flag: a #FuFirmwareFlags, e.g. %FU_FIRMWARE_FLAG_DEDUPE_ID
@@ -138,6 +149,18 @@ fu_firmware_patch_free(FuFirmwarePatch *ptch)
 	g_free(ptch);
 }
 
+typedef struct {
+	gsize offset;
+	GBytes *blob;
+} FuFirmwareMagic;
+
+static void
+fu_firmware_magic_free(FuFirmwareMagic *magic)
+{
+	g_bytes_unref(magic->blob);
+	g_free(magic);
+}
+
 /**
  * fu_firmware_add_flag:
  * @firmware: a #FuFirmware
@@ -562,6 +585,48 @@ fu_firmware_get_idx(FuFirmware *self)
 	return priv->idx;
 }
 
+static void
+fu_firmware_invalidate_checksums(FuFirmware *self)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+	if (priv->checksums != NULL)
+		g_hash_table_remove_all(priv->checksums);
+}
+
+/* images have been added or removed */
+static void
+fu_firmware_images_changed(FuFirmware *self)
+{
+	FuFirmwareClass *klass = FU_FIRMWARE_GET_CLASS(self);
+	fu_firmware_invalidate_checksums(self);
+	if (klass->images_changed != NULL)
+		klass->images_changed(self);
+}
+
+/* only used for image lookups, as the subclassed checksum may be expensive */
+static gchar *
+fu_firmware_get_checksum_cached(FuFirmware *self, GChecksumType csum_kind, GError **error)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+	const gchar *checksum;
+	gchar *checksum_new;
+
+	/* computed from the images or properties, which can change without invalidating */
+	if (priv->bytes == NULL && priv->stream == NULL)
+		return fu_firmware_get_checksum(self, csum_kind, error);
+
+	if (priv->checksums == NULL)
+		priv->checksums = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	checksum = g_hash_table_lookup(priv->checksums, GINT_TO_POINTER(csum_kind));
+	if (checksum != NULL)
+		return g_strdup(checksum);
+	checksum_new = fu_firmware_get_checksum(self, csum_kind, error);
+	if (checksum_new == NULL)
+		return NULL;
+	g_hash_table_insert(priv->checksums, GINT_TO_POINTER(csum_kind), g_strdup(checksum_new));
+	return checksum_new;
+}
+
 /**
  * fu_firmware_set_bytes:
  * @self: a #FuPlugin
@@ -582,6 +647,7 @@ fu_firmware_set_bytes(FuFirmware *self, GBytes *bytes)
 	if (priv->bytes != NULL)
 		g_bytes_unref(priv->bytes);
 	priv->bytes = g_bytes_ref(bytes);
+	fu_firmware_invalidate_checksums(self);
 
 	/* the input stream is no longer valid */
 	g_clear_object(&priv->stream);
@@ -742,6 +808,7 @@ fu_firmware_set_stream(FuFirmware *self, GInputStream *stream, GError **error)
 		priv->streamsz = 0;
 	}
 	g_set_object(&priv->stream, stream);
+	fu_firmware_invalidate_checksums(self);
 	return TRUE;
 }
 
@@ -992,6 +1059,19 @@ fu_firmware_validate_for_offset(FuFirmware *self,
 	return FALSE;
 }
 
+/* memory-backed streams, and CAB folders that cache inflated blocks, do not need read-ahead */
+static gboolean
+fu_firmware_stream_is_buffered(GInputStream *stream)
+{
+	if (FU_IS_PARTIAL_INPUT_STREAM(stream)) {
+		FuPartialInputStream *partial = FU_PARTIAL_INPUT_STREAM(stream);
+		return fu_firmware_stream_is_buffered(
+		    fu_partial_input_stream_get_base_stream(partial));
+	}
+	return G_IS_MEMORY_INPUT_STREAM(stream) || FU_IS_MAPPED_INPUT_STREAM(stream) ||
+	       FU_IS_BUFFERED_INPUT_STREAM(stream) || FU_IS_CAB_FOLDER_INPUT_STREAM(stream);
+}
+
 /**
  * fu_firmware_parse_stream:
  * @self: a #FuFirmware
@@ -1002,6 +1082,9 @@ fu_firmware_validate_for_offset(FuFirmware *self,
  *
  * Parses a firmware from a stream, typically breaking the firmware into images.
  *
+ * If @stream is not backed by memory then it is wrapped in a #FuBufferedInputStream so that
+ * small header reads do not each need a seek and a read of the underlying stream.
+ *
  * Returns: %TRUE for success
  *
  * Since: 2.0.0
@@ -1016,6 +1099,7 @@ fu_firmware_parse_stream(FuFirmware *self,
 	FuFirmwareClass *klass = FU_FIRMWARE_GET_CLASS(self);
 	FuFirmwarePrivate *priv = GET_PRIVATE(self);
 	gsize streamsz = 0;
+	g_autoptr(GInputStream) stream_buffered = NULL;
 
 	g_return_val_if_fail(FU_IS_FIRMWARE(self), FALSE);
 	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), FALSE);
@@ -1031,6 +1115,7 @@ fu_firmware_parse_stream(FuFirmware *self,
 	}
 
 	/* check size */
+	fu_firmware_invalidate_checksums(self);
 	if (!fu_input_stream_size(stream, &streamsz, error))
 		return FALSE;
 	if (streamsz <= offset) {
@@ -1062,6 +1147,16 @@ fu_firmware_parse_stream(FuFirmware *self,
 		return FALSE;
 	}
 
+	/* read ahead when each read would otherwise be a syscall */
+	if (priv->stream_buffer_window > 0 && G_IS_SEEKABLE(stream) &&
+	    g_seekable_can_seek(G_SEEKABLE(stream)) && !fu_firmware_stream_is_buffered(stream)) {
+		stream_buffered =
+		    fu_buffered_input_stream_new(stream, priv->stream_buffer_window, error);
+		if (stream_buffered == NULL)
+			return FALSE;
+		stream = stream_buffered;
+	}
+
 	/* optional */
 	if (!fu_firmware_validate_for_offset(self, stream, &offset, flags, error))
 		return FALSE;
@@ -1092,8 +1187,18 @@ fu_firmware_parse_stream(FuFirmware *self,
 	}
 
 	/* optional */
-	if (klass->parse != NULL)
-		return klass->parse(self, stream, offset, flags, error);
+	if (klass->parse != NULL) {
+		if (!klass->parse(self, stream, offset, flags, error))
+			return FALSE;
+		if (stream_buffered != NULL) {
+			FuBufferedInputStream *buffered = FU_BUFFERED_INPUT_STREAM(stream_buffered);
+			g_debug("parsed %s with %u buffered reads and %u stream reads",
+				G_OBJECT_TYPE_NAME(self),
+				fu_buffered_input_stream_get_hits(buffered),
+				fu_buffered_input_stream_get_misses(buffered));
+		}
+		return TRUE;
+	}
 
 	/* verify alignment */
 	if (streamsz % (1ull << priv->alignment) != 0) {
@@ -1511,6 +1616,99 @@ fu_firmware_write(FuFirmware *self, GError **error)
 	return fu_firmware_get_bytes_with_patches(self, error);
 }
 
+/**
+ * fu_firmware_add_magic:
+ * @self: a #FuFirmware
+ * @buf: (not nullable): the magic bytes
+ * @bufsz: size of @buf
+ * @offset: offset of the magic from the start of the header
+ *
+ * Adds a signature that must be present for the firmware to be parsed, typically the same magic
+ * that is checked by the `->validate()` vfunc.
+ *
+ * This allows fu_firmware_new_from_gtypes() to skip the types that cannot match without trying
+ * to parse the stream. If more than one magic is added then any of them may match.
+ *
+ * Since: 2.0.1
+ **/
+void
+fu_firmware_add_magic(FuFirmware *self, const guint8 *buf, gsize bufsz, gsize offset)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+	FuFirmwareMagic *magic;
+
+	g_return_if_fail(FU_IS_FIRMWARE(self));
+	g_return_if_fail(buf != NULL);
+	g_return_if_fail(bufsz > 0);
+
+	/* ensure exists */
+	if (priv->magic == NULL)
+		priv->magic = g_ptr_array_new_with_free_func((GDestroyNotify)fu_firmware_magic_free);
+
+	magic = g_new0(FuFirmwareMagic, 1);
+	magic->offset = offset;
+	magic->blob = g_bytes_new(buf, bufsz);
+	g_ptr_array_add(priv->magic, magic);
+}
+
+/* the number of header bytes needed to check all the magic at the start offset */
+static gsize
+fu_firmware_get_magic_size(FuFirmware *self)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+	gsize magicsz = 0;
+
+	if (priv->magic == NULL)
+		return 0;
+	for (guint i = 0; i < priv->magic->len; i++) {
+		FuFirmwareMagic *magic = g_ptr_array_index(priv->magic, i);
+		magicsz = MAX(magicsz, magic->offset + g_bytes_get_size(magic->blob));
+	}
+	return magicsz;
+}
+
+/* @buf starts at the parse offset, and @search means the header may be found anywhere in it */
+static gboolean
+fu_firmware_check_magic_for_buf(FuFirmware *self,
+				const guint8 *buf,
+				gsize bufsz,
+				gboolean search,
+				GError **error)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+
+	/* nothing to check */
+	if (priv->magic == NULL)
+		return TRUE;
+
+	for (guint i = 0; i < priv->magic->len; i++) {
+		FuFirmwareMagic *magic = g_ptr_array_index(priv->magic, i);
+		gsize magicsz = g_bytes_get_size(magic->blob);
+		const guint8 *magicbuf = g_bytes_get_data(magic->blob, NULL);
+
+		if (magic->offset + magicsz > bufsz)
+			continue;
+		if (search) {
+			if (fu_memmem_safe(buf + magic->offset,
+					   bufsz - magic->offset,
+					   magicbuf,
+					   magicsz,
+					   NULL,
+					   NULL))
+				return TRUE;
+			continue;
+		}
+		if (memcmp(buf + magic->offset, magicbuf, magicsz) == 0)
+			return TRUE;
+	}
+	g_set_error(error,
+		    FWUPD_ERROR,
+		    FWUPD_ERROR_INVALID_FILE,
+		    "%s magic not found",
+		    G_OBJECT_TYPE_NAME(self));
+	return FALSE;
+}
+
 /**
  * fu_firmware_add_patch:
  * @self: a #FuFirmware
@@ -1534,6 +1732,7 @@ fu_firmware_add_patch(FuFirmware *self, gsize offset, GBytes *blob)
 	g_return_if_fail(blob != NULL);
 
 	/* ensure exists */
+	fu_firmware_invalidate_checksums(self);
 	if (priv->patches == NULL) {
 		priv->patches =
 		    g_ptr_array_new_with_free_func((GDestroyNotify)fu_firmware_patch_free);
@@ -1720,6 +1919,7 @@ fu_firmware_add_image_full(FuFirmware *self, FuFirmware *img, GError **error)
 	}
 
 	/* dedupe */
+	fu_firmware_invalidate_checksums(self);
 	for (guint i = 0; i < priv->images->len; i++) {
 		FuFirmware *img_tmp = g_ptr_array_index(priv->images, i);
 		if (priv->flags & FU_FIRMWARE_FLAG_DEDUPE_ID) {
@@ -1747,6 +1947,7 @@ fu_firmware_add_image_full(FuFirmware *self, FuFirmware *img, GError **error)
 	}
 
 	g_ptr_array_add(priv->images, g_object_ref(img));
+	fu_firmware_images_changed(self);
 
 	/* set the other way around */
 	fu_firmware_set_parent(img, self);
@@ -1818,6 +2019,43 @@ fu_firmware_get_images_max(FuFirmware *self)
 	return priv->images_max;
 }
 
+/**
+ * fu_firmware_set_stream_buffer_window:
+ * @self: a #FuFirmware
+ * @stream_buffer_window: size in bytes, or 0 to disable
+ *
+ * Sets the read-ahead used when parsing streams where each read would be a syscall, for
+ * instance file descriptors or compressed cabinet folders. Memory-backed streams are never
+ * buffered.
+ *
+ * Since: 2.0.1
+ **/
+void
+fu_firmware_set_stream_buffer_window(FuFirmware *self, gsize stream_buffer_window)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+	g_return_if_fail(FU_IS_FIRMWARE(self));
+	priv->stream_buffer_window = stream_buffer_window;
+}
+
+/**
+ * fu_firmware_get_stream_buffer_window:
+ * @self: a #FuFirmware
+ *
+ * Gets the read-ahead used when parsing streams where each read would be a syscall.
+ *
+ * Returns: size in bytes, or 0 if disabled
+ *
+ * Since: 2.0.1
+ **/
+gsize
+fu_firmware_get_stream_buffer_window(FuFirmware *self)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_FIRMWARE(self), 0);
+	return priv->stream_buffer_window;
+}
+
 /**
  * fu_firmware_remove_image:
  * @self: a #FuPlugin
@@ -1839,8 +2077,10 @@ fu_firmware_remove_image(FuFirmware *self, FuFirmware *img, GError **error)
 	g_return_val_if_fail(FU_IS_FIRMWARE(img), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	if (g_ptr_array_remove(priv->images, img))
+	if (g_ptr_array_remove(priv->images, img)) {
+		fu_firmware_images_changed(self);
 		return TRUE;
+	}
 
 	/* did not exist */
 	g_set_error(error,
@@ -1876,6 +2116,7 @@ fu_firmware_remove_image_by_idx(FuFirmware *self, guint64 idx, GError **error)
 	if (img == NULL)
 		return FALSE;
 	g_ptr_array_remove(priv->images, img);
+	fu_firmware_images_changed(self);
 	return TRUE;
 }
 
@@ -1904,6 +2145,7 @@ fu_firmware_remove_image_by_id(FuFirmware *self, const gchar *id, GError **error
 	if (img == NULL)
 		return FALSE;
 	g_ptr_array_remove(priv->images, img);
+	fu_firmware_images_changed(self);
 	return TRUE;
 }
 
@@ -2069,9 +2311,8 @@ fu_firmware_get_image_by_checksum(FuFirmware *self, const gchar *checksum, GErro
 		FuFirmware *img = g_ptr_array_index(priv->images, i);
 		g_autofree gchar *checksum_tmp = NULL;
 
-		/* if this expensive then the subclassed FuFirmware can
-		 * cache the result as required */
-		checksum_tmp = fu_firmware_get_checksum(img, csum_kind, error);
+		/* computed once per image, as this is often called in a loop */
+		checksum_tmp = fu_firmware_get_checksum_cached(img, csum_kind, error);
 		if (checksum_tmp == NULL)
 			return NULL;
 		if (g_strcmp0(checksum_tmp, checksum) == 0)
@@ -2374,6 +2615,7 @@ fu_firmware_init(FuFirmware *self)
 {
 	FuFirmwarePrivate *priv = GET_PRIVATE(self);
 	priv->images = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	priv->stream_buffer_window = FU_FIRMWARE_STREAM_BUFFER_WINDOW;
 }
 
 static void
@@ -2392,6 +2634,10 @@ fu_firmware_finalize(GObject *object)
 		g_ptr_array_unref(priv->chunks);
 	if (priv->patches != NULL)
 		g_ptr_array_unref(priv->patches);
+	if (priv->magic != NULL)
+		g_ptr_array_unref(priv->magic);
+	if (priv->checksums != NULL)
+		g_hash_table_unref(priv->checksums);
 	if (priv->parent != NULL)
 		g_object_remove_weak_pointer(G_OBJECT(priv->parent), (gpointer *)&priv->parent);
 	g_ptr_array_unref(priv->images);
@@ -2457,6 +2703,37 @@ fu_firmware_new_from_bytes(GBytes *fw)
 	return self;
 }
 
+/* this has to match the logic in fu_firmware_validate_for_offset() */
+static gboolean
+fu_firmware_new_from_gtypes_can_search(FuFirmware *self, FwupdInstallFlags flags, gsize streamsz)
+{
+	if (!fu_firmware_has_flag(self, FU_FIRMWARE_FLAG_ALWAYS_SEARCH) &&
+	    (flags & FWUPD_INSTALL_FLAG_NO_SEARCH) > 0)
+		return FALSE;
+	return streamsz <= FU_FIRMWARE_SEARCH_MAGIC_BUFSZ_MAX;
+}
+
+static gboolean
+fu_firmware_new_from_gtypes_parse(FuFirmware *self,
+				  GInputStream *stream,
+				  gsize offset,
+				  gsize streamsz,
+				  GBytes *blob_magic,
+				  FwupdInstallFlags flags,
+				  GError **error)
+{
+	/* skip types that cannot match without trying to parse the stream */
+	if (blob_magic != NULL &&
+	    !fu_firmware_check_magic_for_buf(
+		self,
+		g_bytes_get_data(blob_magic, NULL),
+		g_bytes_get_size(blob_magic),
+		fu_firmware_new_from_gtypes_can_search(self, flags, streamsz),
+		error))
+		return FALSE;
+	return fu_firmware_parse_stream(self, stream, offset, flags, error);
+}
+
 /**
  * fu_firmware_new_from_gtypes:
  * @stream: a #GInputStream
@@ -2467,6 +2744,10 @@ fu_firmware_new_from_bytes(GBytes *fw)
  *
  * Tries to parse the firmware with each #GType in order.
  *
+ * The header is read once and types that set a magic using fu_firmware_add_magic() are skipped
+ * without parsing if it cannot match. All the types share one read-ahead buffer when @stream is
+ * not already backed by memory.
+ *
  * Returns: (transfer full) (nullable): a #FuFirmware, or %NULL
  *
  * Since: 1.5.6
@@ -2479,8 +2760,15 @@ fu_firmware_new_from_gtypes(GInputStream *stream,
 			    ...)
 {
 	va_list args;
+	gboolean search_all = FALSE;
+	gsize magicsz = 0;
+	gsize streamsz = 0;
+	gsize window = 0;
 	g_autoptr(GArray) gtypes = g_array_new(FALSE, FALSE, sizeof(GType));
+	g_autoptr(GBytes) blob_magic = NULL;
 	g_autoptr(GError) error_all = NULL;
+	g_autoptr(GInputStream) stream_buffered = NULL;
+	g_autoptr(GPtrArray) firmwares = g_ptr_array_new_with_free_func(g_object_unref);
 
 	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
@@ -2504,12 +2792,55 @@ fu_firmware_new_from_gtypes(GInputStream *stream,
 		return NULL;
 	}
 
-	/* try each GType in turn */
+	/* the types that are allowed to search can only use the magic if the stream is small */
+	if (!fu_input_stream_size(stream, &streamsz, error))
+		return NULL;
 	for (guint i = 0; i < gtypes->len; i++) {
 		GType gtype = g_array_index(gtypes, GType, i);
-		g_autoptr(FuFirmware) firmware = g_object_new(gtype, NULL);
+		FuFirmware *firmware = g_object_new(gtype, NULL);
+		gsize magicsz_tmp = fu_firmware_get_magic_size(firmware);
+		g_ptr_array_add(firmwares, firmware);
+		window = MAX(window, fu_firmware_get_stream_buffer_window(firmware));
+		if (magicsz_tmp == 0)
+			continue;
+		magicsz = MAX(magicsz, magicsz_tmp);
+		if (fu_firmware_new_from_gtypes_can_search(firmware, flags, streamsz))
+			search_all = TRUE;
+	}
+
+	/* otherwise each type would refill its own read-ahead buffer */
+	if (window > 0 && G_IS_SEEKABLE(stream) && g_seekable_can_seek(G_SEEKABLE(stream)) &&
+	    !fu_firmware_stream_is_buffered(stream)) {
+		stream_buffered = fu_buffered_input_stream_new(stream, window, error);
+		if (stream_buffered == NULL)
+			return NULL;
+		stream = stream_buffered;
+	}
+
+	/* read the header once, or the entire stream if any type has to search for the magic --
+	 * but not if reading would consume data that the parsers need */
+	if (magicsz > 0 && offset < streamsz && G_IS_SEEKABLE(stream) &&
+	    g_seekable_can_seek(G_SEEKABLE(stream))) {
+		g_autoptr(GError) error_local = NULL;
+		blob_magic = fu_input_stream_read_bytes_borrowed(stream,
+								 offset,
+								 search_all ? G_MAXSIZE : magicsz,
+								 &error_local);
+		if (blob_magic == NULL)
+			g_debug("ignoring magic: %s", error_local->message);
+	}
+
+	/* try each GType in turn */
+	for (guint i = 0; i < firmwares->len; i++) {
+		FuFirmware *firmware = g_ptr_array_index(firmwares, i);
 		g_autoptr(GError) error_local = NULL;
-		if (!fu_firmware_parse_stream(firmware, stream, offset, flags, &error_local)) {
+		if (!fu_firmware_new_from_gtypes_parse(firmware,
+						       stream,
+						       offset,
+						       streamsz,
+						       blob_magic,
+						       flags,
+						       &error_local)) {
 			g_debug("%s", error_local->message);
 			if (error_all == NULL) {
 				g_propagate_error(&error_all, g_steal_pointer(&error_local));
@@ -2518,7 +2849,7 @@ fu_firmware_new_from_gtypes(GInputStream *stream,
 			}
 			continue;
 		}
-		return g_steal_pointer(&firmware);
+		return g_object_ref(firmware);
 	}
 
 	/* failed */
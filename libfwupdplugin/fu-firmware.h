@@ -78,6 +78,7 @@ struct _FuFirmwareClass {
 				     FuFirmware *other,
 				     FwupdInstallFlags flags,
 				     GError **error);
+	void (*images_changed)(FuFirmware *self);
 };
 
 /**
@@ -312,6 +313,11 @@ void
 fu_firmware_set_images_max(FuFirmware *self, guint images_max) G_GNUC_NON_NULL(1);
 guint
 fu_firmware_get_images_max(FuFirmware *self) G_GNUC_NON_NULL(1);
+void
+fu_firmware_set_stream_buffer_window(FuFirmware *self, gsize stream_buffer_window)
+    G_GNUC_NON_NULL(1);
+gsize
+fu_firmware_get_stream_buffer_window(FuFirmware *self) G_GNUC_NON_NULL(1);
 guint
 fu_firmware_get_depth(FuFirmware *self) G_GNUC_NON_NULL(1);
 guint64
@@ -431,3 +437,6 @@ fu_firmware_get_image_by_checksum(FuFirmware *self, const gchar *checksum, GErro
     G_GNUC_NON_NULL(1, 2);
 void
 fu_firmware_add_patch(FuFirmware *self, gsize offset, GBytes *blob) G_GNUC_NON_NULL(1, 3);
+void
+fu_firmware_add_magic(FuFirmware *self, const guint8 *buf, gsize bufsz, gsize offset)
+    G_GNUC_NON_NULL(1, 2);
@@ -175,24 +175,29 @@ fu_ifwi_cpd_firmware_parse(FuFirmware *firmware,
 	offset += fu_struct_ifwi_cpd_get_header_length(st_hdr);
 	for (guint32 i = 0; i < num_of_entries; i++) {
 		guint32 img_offset = 0;
+		guint8 buf[FU_STRUCT_IFWI_CPD_ENTRY_SIZE] = {0x0};
+		FuStructIfwiCpdEntryView st_ent = {0};
 		g_autofree gchar *id = NULL;
 		g_autoptr(FuFirmware) img = fu_firmware_new();
-		g_autoptr(GByteArray) st_ent = NULL;
 		g_autoptr(GInputStream) partial_stream = NULL;
 
 		/* the IDX is the position in the file */
 		fu_firmware_set_idx(img, i);
 
-		st_ent = fu_struct_ifwi_cpd_entry_parse_stream(stream, offset, error);
-		if (st_ent == NULL)
+		if (!fu_struct_ifwi_cpd_entry_parse_stream_into(&st_ent,
+								buf,
+								sizeof(buf),
+								stream,
+								offset,
+								error))
 			return FALSE;
 
 		/* copy name as id */
-		id = fu_struct_ifwi_cpd_entry_get_name(st_ent);
+		id = fu_struct_ifwi_cpd_entry_view_get_name(&st_ent);
 		fu_firmware_set_id(img, id);
 
 		/* copy offset, ignoring huffman and reserved bits */
-		img_offset = fu_struct_ifwi_cpd_entry_get_offset(st_ent);
+		img_offset = fu_struct_ifwi_cpd_entry_view_get_offset(&st_ent);
 		img_offset &= 0x1FFFFFF;
 		fu_firmware_set_offset(img, img_offset);
 
@@ -200,7 +205,7 @@ fu_ifwi_cpd_firmware_parse(FuFirmware *firmware,
 		partial_stream =
 		    fu_partial_input_stream_new(stream,
 						img_offset,
-						fu_struct_ifwi_cpd_entry_get_length(st_ent),
+						fu_struct_ifwi_cpd_entry_view_get_length(&st_ent),
 						error);
 		if (partial_stream == NULL)
 			return FALSE;
@@ -209,7 +214,7 @@ fu_ifwi_cpd_firmware_parse(FuFirmware *firmware,
 
 		/* read the manifest */
 		if (i == FU_IFWI_CPD_FIRMWARE_IDX_MANIFEST &&
-		    fu_struct_ifwi_cpd_entry_get_length(st_ent) >
+		    fu_struct_ifwi_cpd_entry_view_get_length(&st_ent) >
 			FU_STRUCT_IFWI_CPD_MANIFEST_SIZE) {
 			if (!fu_ifwi_cpd_firmware_parse_manifest(img, partial_stream, error))
 				return FALSE;
@@ -218,7 +223,7 @@ fu_ifwi_cpd_firmware_parse(FuFirmware *firmware,
 		/* success */
 		if (!fu_firmware_add_image_full(firmware, img, error))
 			return FALSE;
-		offset += st_ent->len;
+		offset += st_ent.len;
 	}
 
 	/* success */
@@ -324,6 +329,7 @@ static void
 fu_ifwi_cpd_firmware_init(FuIfwiCpdFirmware *self)
 {
 	fu_firmware_set_images_max(FU_FIRMWARE(self), FU_IFWI_CPD_FIRMWARE_ENTRIES_MAX);
+	fu_firmware_add_magic(FU_FIRMWARE(self), (const guint8 *)"$CPD", 4, 0x0);
 }
 
 static void
@@ -83,15 +83,20 @@ fu_ifwi_fpt_firmware_parse(FuFirmware *firmware,
 	for (guint i = 0; i < num_of_entries; i++) {
 		guint32 data_length;
 		guint32 partition_name;
+		guint8 buf[FU_STRUCT_IFWI_FPT_ENTRY_SIZE] = {0x0};
+		FuStructIfwiFptEntryView st_ent = {0};
 		g_autofree gchar *id = NULL;
 		g_autoptr(FuFirmware) img = fu_firmware_new();
-		g_autoptr(GByteArray) st_ent = NULL;
 
 		/* read IDX */
-		st_ent = fu_struct_ifwi_fpt_entry_parse_stream(stream, offset, error);
-		if (st_ent == NULL)
+		if (!fu_struct_ifwi_fpt_entry_parse_stream_into(&st_ent,
+								buf,
+								sizeof(buf),
+								stream,
+								offset,
+								error))
 			return FALSE;
-		partition_name = fu_struct_ifwi_fpt_entry_get_partition_name(st_ent);
+		partition_name = fu_struct_ifwi_fpt_entry_view_get_partition_name(&st_ent);
 		fu_firmware_set_idx(img, partition_name);
 
 		/* convert to text form for convenience */
@@ -100,9 +105,9 @@ fu_ifwi_fpt_firmware_parse(FuFirmware *firmware,
 			fu_firmware_set_id(img, id);
 
 		/* get data at offset using zero-copy */
-		data_length = fu_struct_ifwi_fpt_entry_get_length(st_ent);
+		data_length = fu_struct_ifwi_fpt_entry_view_get_length(&st_ent);
 		if (data_length != 0x0) {
-			guint32 data_offset = fu_struct_ifwi_fpt_entry_get_offset(st_ent);
+			guint32 data_offset = fu_struct_ifwi_fpt_entry_view_get_offset(&st_ent);
 			g_autoptr(GInputStream) partial_stream = NULL;
 			partial_stream =
 			    fu_partial_input_stream_new(stream, data_offset, data_length, error);
@@ -116,7 +121,7 @@ fu_ifwi_fpt_firmware_parse(FuFirmware *firmware,
 			return FALSE;
 
 		/* next */
-		offset += st_ent->len;
+		offset += st_ent.len;
 	}
 
 	/* success */
@@ -13,7 +13,7 @@ struct FuStructIfwiCpd {
     crc32: u32le,
 }
 
-#[derive(New, ParseStream)]
+#[derive(New, ParseStream, ParseStreamInto)]
 struct FuStructIfwiCpdEntry {
     name: [char; 12],
     offset: u32le,
@@ -60,7 +60,7 @@ struct FuStructIfwiFpt {
     fitc_build: u16le,
 }
 
-#[derive(New, ParseStream)]
+#[derive(New, ParseStream, ParseStreamInto)]
 struct FuStructIfwiFptEntry {
     partition_name: u32le,
     _reserved1: [u8; 4],
@@ -8,10 +8,14 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "fu-chunk-array.h"
 #include "fu-crc-private.h"
 #include "fu-input-stream.h"
+#include "fu-mapped-input-stream-private.h"
 #include "fu-mem-private.h"
+#include "fu-partial-input-stream-private.h"
 #include "fu-sum.h"
 
 /**
@@ -41,6 +45,37 @@ fu_input_stream_from_path(const gchar *path, GError **error)
 	return G_INPUT_STREAM(g_steal_pointer(&stream));
 }
 
+/*
+ * If @stream is a #FuMappedInputStream, or a #FuPartialInputStream of one, returns the mapped
+ * stream and the window of its memory that @stream represents.
+ */
+static FuMappedInputStream *
+fu_input_stream_get_mapped(GInputStream *stream, gsize *offset, gsize *size)
+{
+	if (FU_IS_MAPPED_INPUT_STREAM(stream)) {
+		FuMappedInputStream *mapped = FU_MAPPED_INPUT_STREAM(stream);
+		*offset = 0;
+		*size = g_bytes_get_size(fu_mapped_input_stream_get_bytes(mapped));
+		return mapped;
+	}
+	if (FU_IS_PARTIAL_INPUT_STREAM(stream)) {
+		FuPartialInputStream *partial = FU_PARTIAL_INPUT_STREAM(stream);
+		FuMappedInputStream *mapped;
+		gsize base_offset = 0;
+		gsize base_size = 0;
+
+		mapped = fu_input_stream_get_mapped(fu_partial_input_stream_get_base_stream(partial),
+						    &base_offset,
+						    &base_size);
+		if (mapped == NULL)
+			return NULL;
+		*offset = base_offset + fu_partial_input_stream_get_offset(partial);
+		*size = fu_partial_input_stream_get_size(partial);
+		return mapped;
+	}
+	return NULL;
+}
+
 /**
  * fu_input_stream_read_safe:
  * @stream: a #GInputStream
@@ -67,6 +102,9 @@ fu_input_stream_read_safe(GInputStream *stream,
 			  GError **error)
 {
 	gssize rc;
+	gsize mapped_offset = 0;
+	gsize mapped_size = 0;
+	FuMappedInputStream *mapped;
 
 	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), FALSE);
 	g_return_val_if_fail(buf != NULL, FALSE);
@@ -74,6 +112,25 @@ fu_input_stream_read_safe(GInputStream *stream,
 
 	if (!fu_memchk_write(bufsz, offset, count, error))
 		return FALSE;
+
+	/* copy directly from the mapped memory */
+	mapped = fu_input_stream_get_mapped(stream, &mapped_offset, &mapped_size);
+	if (mapped != NULL) {
+		const guint8 *data = g_bytes_get_data(fu_mapped_input_stream_get_bytes(mapped), NULL);
+		if (seek_set > mapped_size || count > mapped_size - seek_set) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_READ,
+				    "requested 0x%x and got 0x%x",
+				    (guint)count,
+				    seek_set < mapped_size ? (guint)(mapped_size - seek_set) : 0u);
+			return FALSE;
+		}
+		memcpy(buf + offset, data + mapped_offset + seek_set, count);
+		fu_mapped_input_stream_set_pos(mapped, mapped_offset + seek_set + count);
+		return TRUE;
+	}
+
 	if (!g_seekable_seek(G_SEEKABLE(stream), seek_set, G_SEEK_SET, NULL, error)) {
 		g_prefix_error(error, "seek to 0x%x: ", (guint)seek_set);
 		return FALSE;
@@ -264,6 +321,9 @@ GByteArray *
 fu_input_stream_read_byte_array(GInputStream *stream, gsize offset, gsize count, GError **error)
 {
 	guint8 tmp[0x8000];
+	gsize mapped_offset = 0;
+	gsize mapped_size = 0;
+	FuMappedInputStream *mapped;
 	g_autoptr(GByteArray) buf = g_byte_array_new();
 	g_autoptr(GError) error_local = NULL;
 
@@ -296,6 +356,16 @@ fu_input_stream_read_byte_array(GInputStream *stream, gsize offset, gsize count,
 		count = streamsz - offset;
 	}
 
+	/* copy directly from the mapped memory */
+	mapped = fu_input_stream_get_mapped(stream, &mapped_offset, &mapped_size);
+	if (mapped != NULL && offset < mapped_size) {
+		const guint8 *data = g_bytes_get_data(fu_mapped_input_stream_get_bytes(mapped), NULL);
+		count = MIN(count, mapped_size - offset);
+		g_byte_array_append(buf, data + mapped_offset + offset, count);
+		fu_mapped_input_stream_set_pos(mapped, mapped_offset + offset + count);
+		return g_steal_pointer(&buf);
+	}
+
 	/* seek back to start */
 	if (G_IS_SEEKABLE(stream) && g_seekable_can_seek(G_SEEKABLE(stream))) {
 		if (!g_seekable_seek(G_SEEKABLE(stream), offset, G_SEEK_SET, NULL, error))
@@ -364,6 +434,50 @@ fu_input_stream_read_bytes(GInputStream *stream, gsize offset, gsize count, GErr
 	return g_byte_array_free_to_bytes(g_steal_pointer(&buf)); /* nocheck */
 }
 
+/**
+ * fu_input_stream_read_bytes_borrowed:
+ * @stream: a #GInputStream
+ * @offset: offset in bytes into @stream to copy from
+ * @count: maximum number of bytes to read
+ * @error: (nullable): optional return location for an error
+ *
+ * Read a #GBytes from a stream in a safe way.
+ *
+ * If @stream is a #FuMappedInputStream, or a #FuPartialInputStream of one, then the returned
+ * buffer references the mapped memory rather than being a copy, and so keeps the mapping alive.
+ * Other streams are copied just like fu_input_stream_read_bytes().
+ *
+ * NOTE: The returned buffer may be smaller than @count!
+ *
+ * Returns: (transfer full): buffer
+ *
+ * Since: 2.0.1
+ **/
+GBytes *
+fu_input_stream_read_bytes_borrowed(GInputStream *stream,
+				    gsize offset,
+				    gsize count,
+				    GError **error)
+{
+	gsize mapped_offset = 0;
+	gsize mapped_size = 0;
+	FuMappedInputStream *mapped;
+
+	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	/* borrow a slice of the mapped memory */
+	mapped = fu_input_stream_get_mapped(stream, &mapped_offset, &mapped_size);
+	if (mapped != NULL && count != 0 && offset < mapped_size) {
+		count = MIN(count, mapped_size - offset);
+		fu_mapped_input_stream_set_pos(mapped, mapped_offset + offset + count);
+		return g_bytes_new_from_bytes(fu_mapped_input_stream_get_bytes(mapped),
+					      mapped_offset + offset,
+					      count);
+	}
+	return fu_input_stream_read_bytes(stream, offset, count, error);
+}
+
 /**
  * fu_input_stream_size:
  * @stream: a #GInputStream
@@ -0,0 +1,14 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "fu-mapped-input-stream.h"
+
+GBytes *
+fu_mapped_input_stream_get_bytes(FuMappedInputStream *self) G_GNUC_NON_NULL(1);
+void
+fu_mapped_input_stream_set_pos(FuMappedInputStream *self, gsize pos) G_GNUC_NON_NULL(1);
@@ -0,0 +1,369 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuMappedInputStream"
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "fwupd-codec.h"
+
+#include "fu-mapped-input-stream-private.h"
+
+/**
+ * FuMappedInputStream:
+ *
+ * A seekable input stream backed by memory, typically a read-only memory mapped file.
+ *
+ * Unlike other streams, fu_input_stream_read_safe(), fu_input_stream_read_bytes() and
+ * #FuPartialInputStream slices of this stream read straight from the memory without any
+ * syscalls, and fu_input_stream_read_bytes_borrowed() returns sub-slices with no copy.
+ *
+ * If a mapped file is truncated then reading the missing pages kills the process with `SIGBUS`,
+ * so only map files that cannot change, e.g. sealed memfds or files owned by the daemon.
+ */
+
+struct _FuMappedInputStream {
+	GInputStream parent_instance;
+	GBytes *bytes;
+	gsize pos;
+};
+
+static void
+fu_mapped_input_stream_seekable_iface_init(GSeekableIface *iface);
+static void
+fu_mapped_input_stream_codec_iface_init(FwupdCodecInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(FuMappedInputStream,
+			fu_mapped_input_stream,
+			G_TYPE_INPUT_STREAM,
+			G_IMPLEMENT_INTERFACE(G_TYPE_SEEKABLE,
+					      fu_mapped_input_stream_seekable_iface_init)
+			    G_IMPLEMENT_INTERFACE(FWUPD_TYPE_CODEC,
+						  fu_mapped_input_stream_codec_iface_init))
+
+static void
+fu_mapped_input_stream_add_string(FwupdCodec *codec, guint idt, GString *str)
+{
+	FuMappedInputStream *self = FU_MAPPED_INPUT_STREAM(codec);
+	fwupd_codec_string_append_hex(str, idt, "Size", g_bytes_get_size(self->bytes));
+	fwupd_codec_string_append_hex(str, idt, "Pos", self->pos);
+}
+
+static void
+fu_mapped_input_stream_codec_iface_init(FwupdCodecInterface *iface)
+{
+	iface->add_string = fu_mapped_input_stream_add_string;
+}
+
+static goffset
+fu_mapped_input_stream_tell(GSeekable *seekable)
+{
+	FuMappedInputStream *self = FU_MAPPED_INPUT_STREAM(seekable);
+	return self->pos;
+}
+
+static gboolean
+fu_mapped_input_stream_can_seek(GSeekable *seekable)
+{
+	return TRUE;
+}
+
+static gboolean
+fu_mapped_input_stream_seek(GSeekable *seekable,
+			    goffset offset,
+			    GSeekType type,
+			    GCancellable *cancellable,
+			    GError **error)
+{
+	FuMappedInputStream *self = FU_MAPPED_INPUT_STREAM(seekable);
+	goffset pos = offset;
+
+	g_return_val_if_fail(FU_IS_MAPPED_INPUT_STREAM(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* like a local file, seeking past the end is allowed but nothing can be read */
+	if (type == G_SEEK_CUR)
+		pos += self->pos;
+	else if (type == G_SEEK_END)
+		pos += g_bytes_get_size(self->bytes);
+	if (pos < 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "cannot seek to negative offset 0x%x",
+			    (guint)(-pos));
+		return FALSE;
+	}
+	self->pos = pos;
+	return TRUE;
+}
+
+static gboolean
+fu_mapped_input_stream_can_truncate(GSeekable *seekable)
+{
+	return FALSE;
+}
+
+static gboolean
+fu_mapped_input_stream_truncate(GSeekable *seekable,
+				goffset offset,
+				GCancellable *cancellable,
+				GError **error)
+{
+	g_set_error_literal(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "cannot truncate FuMappedInputStream");
+	return FALSE;
+}
+
+static void
+fu_mapped_input_stream_seekable_iface_init(GSeekableIface *iface)
+{
+	iface->tell = fu_mapped_input_stream_tell;
+	iface->can_seek = fu_mapped_input_stream_can_seek;
+	iface->seek = fu_mapped_input_stream_seek;
+	iface->can_truncate = fu_mapped_input_stream_can_truncate;
+	iface->truncate_fn = fu_mapped_input_stream_truncate;
+}
+
+/**
+ * fu_mapped_input_stream_get_bytes:
+ * @self: a #FuMappedInputStream
+ *
+ * Gets the memory backing the stream.
+ *
+ * Returns: (transfer none): a #GBytes
+ *
+ * Since: 2.0.1
+ **/
+GBytes *
+fu_mapped_input_stream_get_bytes(FuMappedInputStream *self)
+{
+	g_return_val_if_fail(FU_IS_MAPPED_INPUT_STREAM(self), NULL);
+	return self->bytes;
+}
+
+/**
+ * fu_mapped_input_stream_set_pos:
+ * @self: a #FuMappedInputStream
+ * @pos: offset in bytes
+ *
+ * Sets the stream position without going through the #GSeekable interface.
+ *
+ * Since: 2.0.1
+ **/
+void
+fu_mapped_input_stream_set_pos(FuMappedInputStream *self, gsize pos)
+{
+	g_return_if_fail(FU_IS_MAPPED_INPUT_STREAM(self));
+	self->pos = pos;
+}
+
+static gssize
+fu_mapped_input_stream_read(GInputStream *stream,
+			    void *buffer,
+			    gsize count,
+			    GCancellable *cancellable,
+			    GError **error)
+{
+	FuMappedInputStream *self = FU_MAPPED_INPUT_STREAM(stream);
+	gsize bufsz = 0;
+	const guint8 *buf = g_bytes_get_data(self->bytes, &bufsz);
+
+	if (self->pos >= bufsz)
+		return 0;
+	count = MIN(count, bufsz - self->pos);
+	memcpy(buffer, buf + self->pos, count);
+	self->pos += count;
+	return count;
+}
+
+static gssize
+fu_mapped_input_stream_skip(GInputStream *stream,
+			    gsize count,
+			    GCancellable *cancellable,
+			    GError **error)
+{
+	FuMappedInputStream *self = FU_MAPPED_INPUT_STREAM(stream);
+	gsize bufsz = g_bytes_get_size(self->bytes);
+
+	if (self->pos >= bufsz)
+		return 0;
+	count = MIN(count, bufsz - self->pos);
+	self->pos += count;
+	return count;
+}
+
+/**
+ * fu_mapped_input_stream_new:
+ * @bytes: a #GBytes, typically from g_mapped_file_get_bytes()
+ *
+ * Creates a seekable input stream that reads directly from @bytes.
+ *
+ * Returns: (transfer full): a #FuMappedInputStream
+ *
+ * Since: 2.0.1
+ **/
+GInputStream *
+fu_mapped_input_stream_new(GBytes *bytes)
+{
+	FuMappedInputStream *self = g_object_new(FU_TYPE_MAPPED_INPUT_STREAM, NULL);
+	g_return_val_if_fail(bytes != NULL, NULL);
+	self->bytes = g_bytes_ref(bytes);
+	return G_INPUT_STREAM(self);
+}
+
+/**
+ * fu_mapped_input_stream_new_from_path:
+ * @path: a filename
+ * @error: (nullable): optional return location for an error
+ *
+ * Maps a regular file read-only into memory.
+ *
+ * This must only be used for local files that are not modified in place while mapped, e.g.
+ * cabinet archives in the cache directory, data files installed with the daemon or files given to
+ * a short-lived command line tool. Use fu_input_stream_from_path() for anything else, especially
+ * files on removable media.
+ *
+ * Files with a reported size of zero, e.g. device nodes or files in `/proc`, cannot be mapped.
+ *
+ * Returns: (transfer full): a #FuMappedInputStream, or %NULL on error
+ *
+ * Since: 2.0.1
+ **/
+GInputStream *
+fu_mapped_input_stream_new_from_path(const gchar *path, GError **error)
+{
+	g_autoptr(GBytes) bytes = NULL;
+	g_autoptr(GMappedFile) mapped_file = NULL;
+
+	g_return_val_if_fail(path != NULL, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	if (!g_file_test(path, G_FILE_TEST_IS_REGULAR)) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "%s is not a regular file",
+			    path);
+		return NULL;
+	}
+	mapped_file = g_mapped_file_new(path, FALSE, error);
+	if (mapped_file == NULL) {
+		fwupd_error_convert(error);
+		return NULL;
+	}
+	if (g_mapped_file_get_length(mapped_file) == 0) {
+		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "%s has zero size", path);
+		return NULL;
+	}
+	bytes = g_mapped_file_get_bytes(mapped_file);
+	return fu_mapped_input_stream_new(bytes);
+}
+
+/**
+ * fu_mapped_input_stream_new_from_fd:
+ * @fd: a file descriptor
+ * @error: (nullable): optional return location for an error
+ *
+ * Maps a file descriptor read-only into memory. The file descriptor can be closed afterwards.
+ *
+ * Only regular files sealed against both shrinking and writing are supported, e.g. the memfds
+ * created by libfwupd. If another process truncated the file while it was mapped then reading
+ * the missing pages would crash this process, and if it could write the file then the contents
+ * could change after they had been verified.
+ *
+ * Returns: (transfer full): a #FuMappedInputStream, or %NULL on error
+ *
+ * Since: 2.0.1
+ **/
+GInputStream *
+fu_mapped_input_stream_new_from_fd(gint fd, GError **error)
+{
+#ifdef F_GET_SEALS
+	gint seals;
+	struct stat st = {0};
+	g_autoptr(GBytes) bytes = NULL;
+	g_autoptr(GMappedFile) mapped_file = NULL;
+
+	g_return_val_if_fail(fd >= 0, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	if (fstat(fd, &st) != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "failed to stat file descriptor: %s",
+			    g_strerror(errno));
+		return NULL;
+	}
+	if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "file descriptor is not a non-empty regular file");
+		return NULL;
+	}
+	seals = fcntl(fd, F_GET_SEALS);
+	if (seals < 0 || (seals & F_SEAL_SHRINK) == 0 || (seals & F_SEAL_WRITE) == 0) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "file descriptor is not sealed against shrinking and writing");
+		return NULL;
+	}
+	mapped_file = g_mapped_file_new_from_fd(fd, FALSE, error);
+	if (mapped_file == NULL) {
+		fwupd_error_convert(error);
+		return NULL;
+	}
+	if (g_mapped_file_get_length(mapped_file) != (gsize)st.st_size) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "file descriptor changed size while mapping");
+		return NULL;
+	}
+	bytes = g_mapped_file_get_bytes(mapped_file);
+	return fu_mapped_input_stream_new(bytes);
+#else
+	g_set_error_literal(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "sealed file descriptors are not supported");
+	return NULL;
+#endif
+}
+
+static void
+fu_mapped_input_stream_finalize(GObject *object)
+{
+	FuMappedInputStream *self = FU_MAPPED_INPUT_STREAM(object);
+	if (self->bytes != NULL)
+		g_bytes_unref(self->bytes);
+	G_OBJECT_CLASS(fu_mapped_input_stream_parent_class)->finalize(object);
+}
+
+static void
+fu_mapped_input_stream_class_init(FuMappedInputStreamClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	GInputStreamClass *istream_class = G_INPUT_STREAM_CLASS(klass);
+	istream_class->read_fn = fu_mapped_input_stream_read;
+	istream_class->skip = fu_mapped_input_stream_skip;
+	object_class->finalize = fu_mapped_input_stream_finalize;
+}
+
+static void
+fu_mapped_input_stream_init(FuMappedInputStream *self)
+{
+}
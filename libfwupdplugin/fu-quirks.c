@@ -15,6 +15,7 @@
 #include <sqlite3.h>
 #endif
 
+#include "fwupd-codec.h"
 #include "fwupd-common.h"
 #include "fwupd-enums-private.h"
 #include "fwupd-error.h"
@@ -80,11 +81,22 @@ struct _FuQuirks {
 	XbQuery *query_kv;
 	XbQuery *query_vs;
 	gboolean verbose;
+	GRecMutex lookup_mutex; /* lookups may happen from the coldplug worker pool */
+	GHashTable *lookup_cache; /* (key GUID\tkey) (value const gchar *) */
+	GHashTable *lookup_iter_cache; /* (key GUID) (value GPtrArray of interned key, value) */
+	guint lookup_cnt;
+	guint lookup_cache_hits;
+	gint64 lookup_usec;
 #ifdef HAVE_SQLITE
 	sqlite3 *db;
+	sqlite3_stmt *stmt_kv;
+	sqlite3_stmt *stmt_vs;
 #endif
 };
 
+/* stored in the lookup cache when neither the database nor the silo has a value */
+static const gchar fu_quirks_lookup_miss[] = "";
+
 G_DEFINE_TYPE(FuQuirks, fu_quirks, G_TYPE_OBJECT)
 
 #ifdef HAVE_SQLITE
@@ -414,6 +426,10 @@ fu_quirks_check_silo(FuQuirks *self, GError **error)
 	if (self->silo == NULL)
 		return FALSE;
 
+	/* any cached values may have changed */
+	g_hash_table_remove_all(self->lookup_cache);
+	g_hash_table_remove_all(self->lookup_iter_cache);
+
 	/* dump warnings to console, just once */
 	if (self->invalid_keys->len > 0) {
 		g_autofree gchar *str = NULL;
@@ -456,58 +472,74 @@ fu_quirks_check_silo(FuQuirks *self, GError **error)
 	return TRUE;
 }
 
-/**
- * fu_quirks_lookup_by_id:
- * @self: a #FuQuirks
- * @guid: GUID to lookup
- * @key: an ID to match the entry, e.g. `Name`
- *
- * Looks up an entry in the hardware database using a string value.
- *
- * Returns: (transfer none): values from the database, or %NULL if not found
- *
- * Since: 1.0.1
- **/
-const gchar *
-fu_quirks_lookup_by_id(FuQuirks *self, const gchar *guid, const gchar *key)
+#ifdef HAVE_SQLITE
+static sqlite3_stmt *
+fu_quirks_db_prepare(FuQuirks *self, const gchar *sql)
+{
+	sqlite3_stmt *stmt = NULL;
+	if (sqlite3_prepare_v3(self->db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL) !=
+	    SQLITE_OK) {
+		g_warning("failed to prepare SQL: %s", sqlite3_errmsg(self->db));
+		return NULL;
+	}
+	return stmt;
+}
+
+static sqlite3_stmt *
+fu_quirks_db_get_stmt(FuQuirks *self, const gchar *guid, const gchar *key)
+{
+	sqlite3_stmt *stmt;
+
+	/* these are prepared once and reused for every lookup */
+	if (key == NULL) {
+		if (self->stmt_vs == NULL)
+			self->stmt_vs = fu_quirks_db_prepare(
+			    self,
+			    "SELECT key, value FROM quirks WHERE guid = ?1");
+		stmt = self->stmt_vs;
+	} else {
+		if (self->stmt_kv == NULL)
+			self->stmt_kv = fu_quirks_db_prepare(
+			    self,
+			    "SELECT key, value FROM quirks WHERE guid = ?1 AND key = ?2");
+		stmt = self->stmt_kv;
+	}
+	if (stmt == NULL)
+		return NULL;
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
+	if (key != NULL)
+		sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
+	return stmt;
+}
+#endif
+
+static const gchar *
+fu_quirks_lookup_by_id_uncached(FuQuirks *self, const gchar *guid, const gchar *key)
 {
 	g_autoptr(GError) error = NULL;
 	g_autoptr(XbNode) n = NULL;
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
 
-	g_return_val_if_fail(FU_IS_QUIRKS(self), NULL);
-	g_return_val_if_fail(guid != NULL, NULL);
-	g_return_val_if_fail(key != NULL, NULL);
-
 #ifdef HAVE_SQLITE
 	/* this is generated from usb.ids and other static sources */
 	if (self->db != NULL && (self->load_flags & FU_QUIRKS_LOAD_FLAG_NO_CACHE) == 0) {
-		g_autoptr(sqlite3_stmt) stmt = NULL;
-		if (sqlite3_prepare_v2(self->db,
-				       "SELECT key, value FROM quirks WHERE guid = ?1 "
-				       "AND key = ?2 LIMIT 1",
-				       -1,
-				       &stmt,
-				       NULL) != SQLITE_OK) {
-			g_warning("failed to prepare SQL: %s", sqlite3_errmsg(self->db));
+		sqlite3_stmt *stmt = fu_quirks_db_get_stmt(self, guid, key);
+		if (stmt == NULL)
 			return NULL;
-		}
-		sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
-		sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
 		if (sqlite3_step(stmt) == SQLITE_ROW) {
 			const gchar *value = (const gchar *)sqlite3_column_text(stmt, 1);
-			if (value != NULL)
-				return g_intern_string(value);
+			if (value != NULL) {
+				value = g_intern_string(value);
+				sqlite3_reset(stmt);
+				return value;
+			}
 		}
+		sqlite3_reset(stmt);
 	}
 #endif
 
-	/* ensure up to date */
-	if (!fu_quirks_check_silo(self, &error)) {
-		g_warning("failed to build silo: %s", error->message);
-		return NULL;
-	}
-
 	/* no quirk data */
 	if (self->query_kv == NULL)
 		return NULL;
@@ -530,6 +562,138 @@ fu_quirks_lookup_by_id(FuQuirks *self, const gchar *guid, const gchar *key)
 	return xb_node_get_text(n);
 }
 
+/**
+ * fu_quirks_lookup_by_id:
+ * @self: a #FuQuirks
+ * @guid: GUID to lookup
+ * @key: an ID to match the entry, e.g. `Name`
+ *
+ * Looks up an entry in the hardware database using a string value.
+ *
+ * Returns: (transfer none): values from the database, or %NULL if not found
+ *
+ * Since: 1.0.1
+ **/
+const gchar *
+fu_quirks_lookup_by_id(FuQuirks *self, const gchar *guid, const gchar *key)
+{
+	const gchar *value;
+	gint64 start_usec = g_get_monotonic_time();
+	g_autofree gchar *cache_key = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GRecMutexLocker) locker = NULL;
+
+	g_return_val_if_fail(FU_IS_QUIRKS(self), NULL);
+	g_return_val_if_fail(guid != NULL, NULL);
+	g_return_val_if_fail(key != NULL, NULL);
+
+	locker = g_rec_mutex_locker_new(&self->lookup_mutex);
+
+	/* ensure up to date, which invalidates the cache if rebuilt */
+	if (!fu_quirks_check_silo(self, &error)) {
+		g_warning("failed to build silo: %s", error->message);
+		return NULL;
+	}
+
+	/* the same GUIDs and keys are queried for every device, so remember misses too */
+	self->lookup_cnt++;
+	cache_key = g_strdup_printf("%s\t%s", guid, key);
+	value = g_hash_table_lookup(self->lookup_cache, cache_key);
+	if (value != NULL) {
+		self->lookup_cache_hits++;
+	} else {
+		value = fu_quirks_lookup_by_id_uncached(self, guid, key);
+		if (value == NULL)
+			value = fu_quirks_lookup_miss;
+		g_hash_table_insert(self->lookup_cache,
+				    g_steal_pointer(&cache_key),
+				    (gpointer)value);
+	}
+	self->lookup_usec += g_get_monotonic_time() - start_usec;
+	if (value == fu_quirks_lookup_miss)
+		return NULL;
+	return value;
+}
+
+/**
+ * fu_quirks_get_lookup_profile:
+ * @self: a #FuQuirks
+ *
+ * Gets a summary of how many lookups were done using fu_quirks_lookup_by_id() and
+ * fu_quirks_lookup_by_id_iter(), how many were answered from the cache, and the total time spent.
+ *
+ * Returns: (transfer full): a string
+ *
+ * Since: 2.0.1
+ **/
+gchar *
+fu_quirks_get_lookup_profile(FuQuirks *self)
+{
+	GString *str = g_string_new(NULL);
+	g_autoptr(GRecMutexLocker) locker = NULL;
+
+	g_return_val_if_fail(FU_IS_QUIRKS(self), NULL);
+
+	locker = g_rec_mutex_locker_new(&self->lookup_mutex);
+	fwupd_codec_string_append_int(str, 0, "QuirkLookups", self->lookup_cnt);
+	fwupd_codec_string_append_int(str, 0, "QuirkCacheHits", self->lookup_cache_hits);
+	fwupd_codec_string_append_int(str,
+				      0,
+				      "QuirkCacheSize",
+				      g_hash_table_size(self->lookup_cache));
+	fwupd_codec_string_append_int(str, 0, "QuirkLookupUs", self->lookup_usec);
+	return g_string_free(str, FALSE);
+}
+
+/* all the keys and values for the GUID, with the database entries first */
+static GPtrArray *
+fu_quirks_lookup_by_id_iter_uncached(FuQuirks *self, const gchar *guid)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) kvs = g_ptr_array_new();
+	g_autoptr(GPtrArray) results = NULL;
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+
+#ifdef HAVE_SQLITE
+	/* this is generated from usb.ids and other static sources */
+	if (self->db != NULL && (self->load_flags & FU_QUIRKS_LOAD_FLAG_NO_CACHE) == 0) {
+		sqlite3_stmt *stmt = fu_quirks_db_get_stmt(self, guid, NULL);
+		if (stmt != NULL) {
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				const gchar *key = (const gchar *)sqlite3_column_text(stmt, 0);
+				const gchar *value = (const gchar *)sqlite3_column_text(stmt, 1);
+				g_ptr_array_add(kvs, (gpointer)g_intern_string(key));
+				g_ptr_array_add(kvs, (gpointer)g_intern_string(value));
+			}
+			sqlite3_reset(stmt);
+		}
+	}
+#endif
+
+	/* no quirk data */
+	if (self->query_vs == NULL)
+		return g_steal_pointer(&kvs);
+
+	/* query */
+	xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
+	results = xb_silo_query_with_context(self->silo, self->query_vs, &context, &error);
+	if (results == NULL) {
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
+		    !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
+			g_warning("failed to query: %s", error->message);
+		return g_steal_pointer(&kvs);
+	}
+	for (guint i = 0; i < results->len; i++) {
+		XbNode *n = g_ptr_array_index(results, i);
+		if (self->verbose)
+			g_debug("%s → %s", guid, xb_node_get_text(n));
+		g_ptr_array_add(kvs, (gpointer)g_intern_string(xb_node_get_attr(n, "key")));
+		g_ptr_array_add(kvs, (gpointer)g_intern_string(xb_node_get_text(n)));
+	}
+	return g_steal_pointer(&kvs);
+}
+
 /**
  * fu_quirks_lookup_by_id_iter:
  * @self: a #FuQuirks
@@ -551,84 +715,46 @@ fu_quirks_lookup_by_id_iter(FuQuirks *self,
 			    FuQuirksIter iter_cb,
 			    gpointer user_data)
 {
+	GPtrArray *kvs_cached;
+	gboolean found = FALSE;
+	gint64 start_usec = g_get_monotonic_time();
 	g_autoptr(GError) error = NULL;
-	g_autoptr(GPtrArray) results = NULL;
-	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	g_autoptr(GPtrArray) kvs = NULL;
+	g_autoptr(GRecMutexLocker) locker = NULL;
 
 	g_return_val_if_fail(FU_IS_QUIRKS(self), FALSE);
 	g_return_val_if_fail(guid != NULL, FALSE);
 	g_return_val_if_fail(iter_cb != NULL, FALSE);
 
-#ifdef HAVE_SQLITE
-	/* this is generated from usb.ids and other static sources */
-	if (self->db != NULL && (self->load_flags & FU_QUIRKS_LOAD_FLAG_NO_CACHE) == 0) {
-		g_autoptr(sqlite3_stmt) stmt = NULL;
-		if (key == NULL) {
-			if (sqlite3_prepare_v2(self->db,
-					       "SELECT key, value FROM quirks WHERE guid = ?1",
-					       -1,
-					       &stmt,
-					       NULL) != SQLITE_OK) {
-				g_warning("failed to prepare SQL: %s", sqlite3_errmsg(self->db));
-				return FALSE;
-			}
-			sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
-		} else {
-			if (sqlite3_prepare_v2(self->db,
-					       "SELECT key, value FROM quirks WHERE guid = ?1 "
-					       "AND key = ?2",
-					       -1,
-					       &stmt,
-					       NULL) != SQLITE_OK) {
-				g_warning("failed to prepare SQL: %s", sqlite3_errmsg(self->db));
-				return FALSE;
-			}
-			sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
-			sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
-		}
-		while (sqlite3_step(stmt) == SQLITE_ROW) {
-			const gchar *key_tmp = (const gchar *)sqlite3_column_text(stmt, 0);
-			const gchar *value = (const gchar *)sqlite3_column_text(stmt, 1);
-			iter_cb(self, key_tmp, value, user_data);
-		}
-	}
-#endif
+	locker = g_rec_mutex_locker_new(&self->lookup_mutex);
 
-	/* ensure up to date */
+	/* ensure up to date, which invalidates the cache if rebuilt */
 	if (!fu_quirks_check_silo(self, &error)) {
 		g_warning("failed to build silo: %s", error->message);
 		return FALSE;
 	}
 
-	/* no quirk data */
-	if (self->query_vs == NULL)
-		return FALSE;
-
-	/* query */
-	xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
-	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
-	if (key != NULL) {
-		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 1, key, NULL);
-		results = xb_silo_query_with_context(self->silo, self->query_kv, &context, &error);
+	/* every key is cached for the GUID, as each device asks for all of them */
+	self->lookup_cnt++;
+	kvs_cached = g_hash_table_lookup(self->lookup_iter_cache, guid);
+	if (kvs_cached != NULL) {
+		self->lookup_cache_hits++;
 	} else {
-		results = xb_silo_query_with_context(self->silo, self->query_vs, &context, &error);
-	}
-	if (results == NULL) {
-		if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-			return FALSE;
-		if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			return FALSE;
-		g_warning("failed to query: %s", error->message);
-		return FALSE;
-	}
-	for (guint i = 0; i < results->len; i++) {
-		XbNode *n = g_ptr_array_index(results, i);
-		if (self->verbose)
-			g_debug("%s → %s", guid, xb_node_get_text(n));
-		iter_cb(self, xb_node_get_attr(n, "key"), xb_node_get_text(n), user_data);
+		kvs_cached = fu_quirks_lookup_by_id_iter_uncached(self, guid);
+		g_hash_table_insert(self->lookup_iter_cache, g_strdup(guid), kvs_cached);
 	}
+	self->lookup_usec += g_get_monotonic_time() - start_usec;
 
-	return TRUE;
+	/* the callback may do a nested lookup which rebuilds the cache */
+	kvs = g_ptr_array_ref(kvs_cached);
+	for (guint i = 0; i + 1 < kvs->len; i += 2) {
+		const gchar *key_tmp = g_ptr_array_index(kvs, i);
+		if (key != NULL && g_strcmp0(key, key_tmp) != 0)
+			continue;
+		iter_cb(self, key_tmp, g_ptr_array_index(kvs, i + 1), user_data);
+		found = TRUE;
+	}
+	return found;
 }
 
 #ifdef HAVE_SQLITE
@@ -963,6 +1089,10 @@ fu_quirks_load(FuQuirks *self, FuQuirksLoadFlags load_flags, GError **error)
 	}
 #endif
 
+	/* any cached values may have changed */
+	g_hash_table_remove_all(self->lookup_cache);
+	g_hash_table_remove_all(self->lookup_iter_cache);
+
 	/* now silo */
 	return fu_quirks_check_silo(self, error);
 }
@@ -997,6 +1127,12 @@ fu_quirks_init(FuQuirks *self)
 {
 	self->possible_keys = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 	self->invalid_keys = g_ptr_array_new_with_free_func(g_free);
+	g_rec_mutex_init(&self->lookup_mutex);
+	self->lookup_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	self->lookup_iter_cache = g_hash_table_new_full(g_str_hash,
+							g_str_equal,
+							g_free,
+							(GDestroyNotify)g_ptr_array_unref);
 
 	/* built in */
 	fu_quirks_add_possible_key(self, FU_QUIRKS_BRANCH);
@@ -1054,11 +1190,18 @@ fu_quirks_finalize(GObject *obj)
 	if (self->silo != NULL)
 		g_object_unref(self->silo);
 #ifdef HAVE_SQLITE
+	if (self->stmt_kv != NULL)
+		sqlite3_finalize(self->stmt_kv);
+	if (self->stmt_vs != NULL)
+		sqlite3_finalize(self->stmt_vs);
 	if (self->db != NULL)
 		sqlite3_close(self->db);
 #endif
+	g_hash_table_unref(self->lookup_cache);
+	g_hash_table_unref(self->lookup_iter_cache);
 	g_hash_table_unref(self->possible_keys);
 	g_ptr_array_unref(self->invalid_keys);
+	g_rec_mutex_clear(&self->lookup_mutex);
 	G_OBJECT_CLASS(fu_quirks_parent_class)->finalize(obj);
 }
 
@@ -61,6 +61,8 @@ fu_quirks_lookup_by_id_iter(FuQuirks *self,
 			    gpointer user_data) G_GNUC_NON_NULL(1, 2);
 void
 fu_quirks_add_possible_key(FuQuirks *self, const gchar *possible_key) G_GNUC_NON_NULL(1, 2);
+gchar *
+fu_quirks_get_lookup_profile(FuQuirks *self) G_GNUC_NON_NULL(1);
 
 /**
  * FU_QUIRKS_PLUGIN:
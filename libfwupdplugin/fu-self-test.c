@@ -10,15 +10,18 @@
 
 #include <fwupdplugin.h>
 
+#include <fcntl.h>
 #include <glib/gstdio.h>
 #include <string.h>
 
 #include "fwupd-security-attr-private.h"
 
 #include "fu-bios-settings-private.h"
+#include "fu-cab-folder-input-stream.h"
 #include "fu-common-private.h"
 #include "fu-config-private.h"
 #include "fu-context-private.h"
+#include "fu-crc-private.h"
 #include "fu-coswid-firmware.h"
 #include "fu-device-event-private.h"
 #include "fu-device-private.h"
@@ -227,6 +230,29 @@ fu_common_align_up_func(void)
 	g_assert_cmpint(fu_common_align_up(G_MAXSIZE - 1, 10), ==, G_MAXSIZE);
 }
 
+static void
+fu_common_dump_enabled_func(void)
+{
+	g_autofree gchar *verbose = g_strdup(g_getenv("FWUPD_VERBOSE"));
+
+	/* same as the default log writer */
+	g_unsetenv("FWUPD_VERBOSE");
+	g_assert_cmpint(fu_dump_is_enabled("FuEngine"),
+			==,
+			!g_log_writer_default_would_drop(G_LOG_LEVEL_DEBUG, "FuEngine"));
+
+	/* takes priority */
+	(void)g_setenv("FWUPD_VERBOSE", "1", TRUE);
+	g_assert_true(fu_dump_is_enabled("FuPlugin"));
+	g_assert_true(fu_dump_is_enabled(NULL));
+
+	/* restore */
+	if (verbose != NULL)
+		(void)g_setenv("FWUPD_VERBOSE", verbose, TRUE);
+	else
+		g_unsetenv("FWUPD_VERBOSE");
+}
+
 static void
 fu_common_byte_array_func(void)
 {
@@ -284,6 +310,55 @@ fu_common_crc_func(void)
 	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_Q, buf, sizeof(buf)), ==, 0xE955C875);
 }
 
+static void
+fu_common_crc_tables_func(void)
+{
+	guint8 buf[1024];
+	guint32 crc = 0xFFFFFFFF;
+
+	/* larger than the slice size, verified using the bitwise implementation */
+	for (guint i = 0; i < sizeof(buf); i++)
+		buf[i] = (guint8)(i * 7);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_STANDARD, buf, sizeof(buf)), ==, 0x28D29E67);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_BZIP2, buf, sizeof(buf)), ==, 0x0654AC08);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_JAMCRC, buf, sizeof(buf)), ==, 0xD72D6198);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_MPEG2, buf, sizeof(buf)), ==, 0xF9AB53F7);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_POSIX, buf, sizeof(buf)), ==, 0x8D5EFE00);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_SATA, buf, sizeof(buf)), ==, 0x62E53107);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_XFER, buf, sizeof(buf)), ==, 0xCCF26EF6);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_C, buf, sizeof(buf)), ==, 0x7E5A7A0B);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_D, buf, sizeof(buf)), ==, 0x68BC81E9);
+	g_assert_cmpint(fu_crc32(FU_CRC32_KIND_Q, buf, sizeof(buf)), ==, 0x40332245);
+	g_assert_cmpint(fu_crc16_full(buf, sizeof(buf), 0xFFFF, 0xA001), ==, 0x83EA);
+
+	/* chained in odd-sized chunks */
+	crc = fu_crc32_step(FU_CRC32_KIND_STANDARD, buf, 13, crc);
+	crc = fu_crc32_step(FU_CRC32_KIND_STANDARD, buf + 13, sizeof(buf) - 13, crc);
+	g_assert_cmpint(fu_crc32_done(FU_CRC32_KIND_STANDARD, crc), ==, 0x28D29E67);
+}
+
+static void
+fu_common_crc_speed_func(void)
+{
+	gsize bufsz = 16 * 1024 * 1024;
+	g_autofree guint8 *buf = g_malloc0(bufsz);
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	for (gsize i = 0; i < bufsz; i++)
+		buf[i] = (guint8)g_random_int();
+	for (guint i = 1; i < FU_CRC32_KIND_LAST; i++) {
+		gdouble elapsed;
+		g_timer_reset(timer);
+		(void)fu_crc32(i, buf, bufsz);
+		elapsed = g_timer_elapsed(timer, NULL);
+		g_test_message("CRC32 kind %u: %.1f MB/s", i, (bufsz / 1024.f / 1024.f) / elapsed);
+	}
+	g_timer_reset(timer);
+	(void)fu_crc16(buf, bufsz);
+	g_test_message("CRC16: %.1f MB/s",
+		       (bufsz / 1024.f / 1024.f) / g_timer_elapsed(timer, NULL));
+}
+
 static void
 fu_string_append_func(void)
 {
@@ -1253,6 +1328,64 @@ fu_plugin_quirks_performance_func(void)
 	g_print("lookup=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
 }
 
+static void
+fu_quirks_lookup_cache_iter_cb(FuQuirks *quirks,
+			       const gchar *key,
+			       const gchar *value,
+			       gpointer user_data)
+{
+	guint *cnt = (guint *)user_data;
+	g_assert_cmpstr(key, ==, "Name");
+	g_assert_cmpstr(value, ==, "Hub");
+	(*cnt)++;
+}
+
+static void
+fu_quirks_lookup_cache_func(void)
+{
+	gboolean ret;
+	guint cnt = 0;
+	const gchar *tmp1;
+	const gchar *tmp2;
+	g_autofree gchar *str = NULL;
+	g_autoptr(FuQuirks) quirks = fu_quirks_new();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GString) str_expected = g_string_new(NULL);
+
+	ret = fu_quirks_load(quirks, FU_QUIRKS_LOAD_FLAG_NO_CACHE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* hit, then from the cache */
+	tmp1 = fu_quirks_lookup_by_id(quirks, "bb9ec3e2-77b3-53bc-a1f1-b05916715627", "Flags");
+	g_assert_cmpstr(tmp1, ==, "clever");
+	tmp2 = fu_quirks_lookup_by_id(quirks, "bb9ec3e2-77b3-53bc-a1f1-b05916715627", "Flags");
+	g_assert_true(tmp1 == tmp2);
+
+	/* misses are remembered too */
+	tmp1 = fu_quirks_lookup_by_id(quirks, "8ff2ed23-b37e-5f61-b409-b7fe9563be36", "unfound");
+	g_assert_null(tmp1);
+	tmp1 = fu_quirks_lookup_by_id(quirks, "8ff2ed23-b37e-5f61-b409-b7fe9563be36", "unfound");
+	g_assert_null(tmp1);
+
+	/* all the keys for the GUID are cached for the iter */
+	for (guint i = 0; i < 2; i++) {
+		ret = fu_quirks_lookup_by_id_iter(quirks,
+						  "bb9ec3e2-77b3-53bc-a1f1-b05916715627",
+						  "Name",
+						  fu_quirks_lookup_cache_iter_cb,
+						  &cnt);
+		g_assert_true(ret);
+	}
+	g_assert_cmpint(cnt, ==, 2);
+
+	str = fu_quirks_get_lookup_profile(quirks);
+	g_debug("%s", str);
+	fwupd_codec_string_append_int(str_expected, 0, "QuirkLookups", 6);
+	fwupd_codec_string_append_int(str_expected, 0, "QuirkCacheHits", 3);
+	g_assert_true(g_str_has_prefix(str, str_expected->str));
+}
+
 typedef struct {
 	gboolean seen_one;
 	gboolean seen_two;
@@ -1751,12 +1884,71 @@ fu_device_func(void)
 	g_assert_cmpint(possible_plugins->len, ==, 1);
 }
 
+static void
+fu_device_event_replay_func(void)
+{
+	FuDeviceEvent *event;
+	guint8 buf[100] = {0x0};
+	g_autofree gchar *buf_base64 = g_base64_encode(buf, sizeof(buf));
+	g_autofree gchar *id_large =
+	    g_strdup_printf("BulkTransfer:Endpoint=0x01,Data=%s,Length=0x64", buf_base64);
+	g_autofree gchar *id_normalized = fu_device_event_normalize_id(id_large);
+	g_autoptr(FuDevice) device = fu_device_new(NULL);
+	g_autoptr(GError) error = NULL;
+
+	/* large payloads are saved as a hash */
+	g_assert_cmpstr(id_normalized,
+			==,
+			"BulkTransfer:Endpoint=0x01,Data=#146f3758d0ef25210af6a1e979a18615a7a8e6e8,"
+			"Length=0x64");
+	g_free(id_normalized);
+
+	/* small payloads are not changed */
+	id_normalized = fu_device_event_normalize_id("Ioctl:Request=0x1234,Data=AAAA,Length=0x3");
+	g_assert_cmpstr(id_normalized, ==, "Ioctl:Request=0x1234,Data=AAAA,Length=0x3");
+
+	/* save */
+	fu_device_save_event(device, "Foo");
+	fu_device_save_event(device, "Bar");
+	fu_device_save_event(device, "Foo");
+	event = fu_device_save_event(device, id_large);
+	g_assert_true(g_str_has_suffix(fu_device_event_get_id(event), "e6e8,Length=0x64"));
+
+	/* in order */
+	event = fu_device_load_event(device, "Foo", &error);
+	g_assert_no_error(error);
+	g_assert_true(event == g_ptr_array_index(fu_device_get_events(device), 0));
+	event = fu_device_load_event(device, "Foo", &error);
+	g_assert_no_error(error);
+	g_assert_true(event == g_ptr_array_index(fu_device_get_events(device), 2));
+
+	/* out of order */
+	event = fu_device_load_event(device, "Bar", &error);
+	g_assert_no_error(error);
+	g_assert_true(event == g_ptr_array_index(fu_device_get_events(device), 1));
+
+	/* back in order */
+	event = fu_device_load_event(device, "Foo", &error);
+	g_assert_no_error(error);
+	g_assert_true(event == g_ptr_array_index(fu_device_get_events(device), 2));
+	event = fu_device_load_event(device, id_large, &error);
+	g_assert_no_error(error);
+	g_assert_true(event == g_ptr_array_index(fu_device_get_events(device), 3));
+
+	/* not found */
+	event = fu_device_load_event(device, "Baz", &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL);
+	g_assert_null(event);
+}
+
 static void
 fu_device_event_func(void)
 {
 	gboolean ret;
-	const gchar *str;
 	g_autofree gchar *json = NULL;
+	g_autofree gchar *str = NULL;
+	g_autofree gchar *str_blob = NULL;
+	g_autofree gchar *str_name = NULL;
 	g_autoptr(FuDeviceEvent) event1 = fu_device_event_new("foo:bar:baz");
 	g_autoptr(FuDeviceEvent) event2 = fu_device_event_new(NULL);
 	g_autoptr(GBytes) blob1 = g_bytes_new_static("hello", 6);
@@ -1783,11 +1975,21 @@ fu_device_event_func(void)
 	g_assert_true(ret);
 	g_assert_cmpstr(fu_device_event_get_id(event2), ==, "foo:bar:baz");
 	g_assert_cmpint(fu_device_event_get_i64(event2, "Age", NULL), ==, 123);
-	g_assert_cmpstr(fu_device_event_get_str(event2, "Name", NULL), ==, "Richard");
+	str_name = fu_device_event_get_str(event2, "Name", NULL);
+	g_assert_cmpstr(str_name, ==, "Richard");
 	blob2 = fu_device_event_get_bytes(event2, "Blob", &error);
 	g_assert_nonnull(blob2);
 	g_assert_cmpstr(g_bytes_get_data(blob2, NULL), ==, "hello");
 
+	/* reading as a string does not change the stored value */
+	str_blob = fu_device_event_get_str(event2, "Blob", &error);
+	g_assert_no_error(error);
+	g_assert_cmpstr(str_blob, ==, "aGVsbG8A");
+	g_clear_pointer(&blob2, g_bytes_unref);
+	blob2 = fu_device_event_get_bytes(event2, "Blob", &error);
+	g_assert_no_error(error);
+	g_assert_cmpstr(g_bytes_get_data(blob2, NULL), ==, "hello");
+
 	/* invalid type */
 	str = fu_device_event_get_str(event2, "Age", &error);
 	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA);
@@ -3319,6 +3521,7 @@ fu_firmware_new_from_gtypes_func(void)
 	g_autoptr(FuFirmware) firmware1 = NULL;
 	g_autoptr(FuFirmware) firmware2 = NULL;
 	g_autoptr(FuFirmware) firmware3 = NULL;
+	g_autoptr(FuFirmware) firmware4 = NULL;
 	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(GInputStream) stream = NULL;
 	g_autoptr(GError) error = NULL;
@@ -3368,6 +3571,23 @@ fu_firmware_new_from_gtypes_func(void)
 						G_TYPE_INVALID);
 	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
 	g_assert_null(firmware3);
+	g_clear_error(&error);
+
+	/* types where the magic cannot match are never parsed */
+	g_test_expect_message("FuFirmware", G_LOG_LEVEL_DEBUG, "FuDfuseFirmware magic not found");
+	g_test_expect_message("FuFirmware", G_LOG_LEVEL_DEBUG, "FuIfwiCpdFirmware magic not found");
+	firmware4 = fu_firmware_new_from_gtypes(stream,
+						0x0,
+						FWUPD_INSTALL_FLAG_NONE,
+						&error,
+						FU_TYPE_DFUSE_FIRMWARE,
+						FU_TYPE_IFWI_CPD_FIRMWARE,
+						FU_TYPE_DFU_FIRMWARE,
+						G_TYPE_INVALID);
+	g_test_assert_expected_messages();
+	g_assert_no_error(error);
+	g_assert_nonnull(firmware4);
+	g_assert_cmpstr(G_OBJECT_TYPE_NAME(firmware4), ==, "FuDfuFirmware");
 }
 
 static void
@@ -3464,6 +3684,159 @@ fu_firmware_archive_func(void)
 	g_assert_null(img_both);
 }
 
+static void
+fu_firmware_efi_signature_list_func(void)
+{
+	gboolean ret;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuFirmware) firmware = fu_efi_signature_list_new();
+	g_autoptr(FuFirmware) img = NULL;
+	g_autoptr(FuFirmware) img2 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	filename =
+	    g_test_build_filename(G_TEST_DIST, "tests", "efi-signature-list.builder.xml", NULL);
+	ret = fu_firmware_build_from_filename(firmware, filename, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* uses the index */
+	ret = fu_efi_signature_list_has_checksum(
+	    FU_EFI_SIGNATURE_LIST(firmware),
+	    "819ebd0aeb8f0b73d237a02d9344ad1fd6fae6ad763cacf1694a6d13c1986cde",
+	    &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_efi_signature_list_has_checksum(
+	    FU_EFI_SIGNATURE_LIST(firmware),
+	    "0000000000000000000000000000000000000000000000000000000000000000",
+	    &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_false(ret);
+	g_clear_error(&error);
+
+	/* the index is rebuilt when a signature is removed */
+	img = fu_firmware_get_image_by_checksum(
+	    firmware,
+	    "819ebd0aeb8f0b73d237a02d9344ad1fd6fae6ad763cacf1694a6d13c1986cde",
+	    &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img);
+	ret = fu_firmware_remove_image(firmware, img, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_efi_signature_list_has_checksum(
+	    FU_EFI_SIGNATURE_LIST(firmware),
+	    "819ebd0aeb8f0b73d237a02d9344ad1fd6fae6ad763cacf1694a6d13c1986cde",
+	    &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_false(ret);
+	g_clear_error(&error);
+
+	/* and when one signature is replaced by another */
+	ret = fu_firmware_add_image_full(firmware, img, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	img2 = fu_firmware_get_image_by_checksum(
+	    firmware,
+	    "418ad44c79e3fddd6a0574b24fcf0fb8fee4b3ff2be635d21a5c0852bdea635c",
+	    &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img2);
+	ret = fu_firmware_remove_image(firmware, img2, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_efi_signature_list_has_checksum(
+	    FU_EFI_SIGNATURE_LIST(firmware),
+	    "819ebd0aeb8f0b73d237a02d9344ad1fd6fae6ad763cacf1694a6d13c1986cde",
+	    &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* not SHA256, so uses the fallback */
+	ret = fu_efi_signature_list_has_checksum(FU_EFI_SIGNATURE_LIST(firmware),
+						 "0000000000000000000000000000000000000000",
+						 &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_false(ret);
+}
+
+static void
+fu_firmware_cab_compressed_func(void)
+{
+	gboolean ret;
+	gsize bufsz = 0x8000 * 4 + 0x123;
+	guint8 value = 0;
+	g_autofree guint8 *buf = g_malloc(bufsz);
+	g_autoptr(FuCabFirmware) cab_firmware1 = fu_cab_firmware_new();
+	g_autoptr(FuCabFirmware) cab_firmware2 = fu_cab_firmware_new();
+	g_autoptr(FuCabFirmware) cab_firmware3 = fu_cab_firmware_new();
+	g_autoptr(FuCabImage) img1 = fu_cab_image_new();
+	g_autoptr(FuFirmware) img2 = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob_img = NULL;
+	g_autoptr(GBytes) blob_payload = NULL;
+	g_autoptr(GBytes) blob_truncated = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	FuCabFolderInputStream *folder;
+
+	/* build an archive with several CFDATA blocks */
+	for (gsize i = 0; i < bufsz; i++)
+		buf[i] = (guint8)((i / 7) ^ i);
+	blob_payload = g_bytes_new(buf, bufsz);
+	fu_firmware_set_id(FU_FIRMWARE(img1), "firmware.bin");
+	fu_firmware_set_bytes(FU_FIRMWARE(img1), blob_payload);
+	fu_firmware_add_image(FU_FIRMWARE(cab_firmware1), FU_FIRMWARE(img1));
+	fu_cab_firmware_set_compressed(cab_firmware1, TRUE);
+	blob = fu_firmware_write(FU_FIRMWARE(cab_firmware1), &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob);
+
+	/* parsing does not inflate anything */
+	ret = fu_firmware_parse(FU_FIRMWARE(cab_firmware2), blob, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_true(fu_cab_firmware_get_compressed(cab_firmware2));
+	img2 = fu_firmware_get_image_by_id(FU_FIRMWARE(cab_firmware2), "firmware.bin", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img2);
+	stream = fu_firmware_get_stream(img2, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream);
+	g_assert_true(FU_IS_PARTIAL_INPUT_STREAM(stream));
+	folder = FU_CAB_FOLDER_INPUT_STREAM(
+	    fu_partial_input_stream_get_base_stream(FU_PARTIAL_INPUT_STREAM(stream)));
+	g_assert_cmpint(fu_cab_folder_input_stream_get_inflate_count(folder), ==, 0);
+
+	/* random access to the last block inflates from the start */
+	ret = fu_input_stream_read_u8(stream, bufsz - 1, &value, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(value, ==, buf[bufsz - 1]);
+	g_assert_cmpint(fu_cab_folder_input_stream_get_inflate_count(folder), ==, 5);
+	ret = fu_input_stream_read_u8(stream, 0x8001, &value, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(value, ==, buf[0x8001]);
+
+	/* sequential, all from the cache */
+	blob_img = fu_input_stream_read_bytes(stream, 0x0, G_MAXSIZE, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob_img);
+	g_assert_cmpint(g_bytes_compare(blob_img, blob_payload), ==, 0);
+	g_assert_cmpint(fu_cab_folder_input_stream_get_inflate_count(folder), ==, 5);
+
+	/* truncated CFDATA is rejected when parsing, not when reading */
+	blob_truncated = g_bytes_new_from_bytes(blob, 0x0, g_bytes_get_size(blob) - 0x10);
+	ret = fu_firmware_parse(FU_FIRMWARE(cab_firmware3),
+				blob_truncated,
+				FWUPD_INSTALL_FLAG_NONE,
+				&error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA);
+	g_assert_false(ret);
+}
+
 static void
 fu_firmware_linear_func(void)
 {
@@ -5244,6 +5617,186 @@ fu_partial_input_stream_func(void)
 	g_assert_null(stream_error);
 }
 
+static void
+fu_mapped_input_stream_func(void)
+{
+	gboolean ret;
+	gint fd;
+	gssize rc;
+	guint8 buf[2] = {0x0};
+	guint8 value = 0;
+	g_autofree gchar *fn = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob_partial = NULL;
+	g_autoptr(GBytes) blob_copy = NULL;
+	g_autoptr(FuChunk) chk = NULL;
+	g_autoptr(FuChunkArray) chunks = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GInputStream) stream_fd = NULL;
+	g_autoptr(GInputStream) stream_file = NULL;
+	g_autoptr(GInputStream) stream_partial = NULL;
+
+	/* mapping is opt-in */
+	fn = g_test_build_filename(G_TEST_DIST, "tests", "dfu.builder.xml", NULL);
+	g_assert_nonnull(fn);
+	stream_file = fu_input_stream_from_path(fn, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream_file);
+	g_assert_false(FU_IS_MAPPED_INPUT_STREAM(stream_file));
+	stream = fu_mapped_input_stream_new_from_path(fn, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream);
+	g_assert_true(FU_IS_MAPPED_INPUT_STREAM(stream));
+
+	/* file descriptors that are not sealed are never mapped */
+	fd = g_open(fn, O_RDONLY, 0);
+	g_assert_cmpint(fd, >=, 0);
+	stream_fd = fu_mapped_input_stream_new_from_fd(fd, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED);
+	g_assert_null(stream_fd);
+	g_clear_error(&error);
+	g_close(fd, NULL);
+
+	/* seeks and reads behave like GFileInputStream */
+	ret = g_seekable_seek(G_SEEKABLE(stream), 0x0, G_SEEK_END, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(g_seekable_tell(G_SEEKABLE(stream)), ==, 216);
+	rc = g_input_stream_read(stream, buf, 2, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_cmpint(rc, ==, 0);
+	ret = g_seekable_seek(G_SEEKABLE(stream), -0x1, G_SEEK_END, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	rc = g_input_stream_read(stream, buf, 2, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_cmpint(rc, ==, 1);
+	g_assert_cmpint(buf[0], ==, 10);
+
+	/* safe reads */
+	ret = fu_input_stream_read_u8(stream, 215, &value, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(value, ==, 10);
+	g_assert_cmpint(g_seekable_tell(G_SEEKABLE(stream)), ==, 216);
+	ret = fu_input_stream_read_u8(stream, 216, &value, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_READ);
+	g_assert_false(ret);
+	g_clear_error(&error);
+
+	/* only borrowed reads reference the mapping */
+	blob = fu_input_stream_read_bytes_borrowed(stream, 0x0, G_MAXSIZE, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob);
+	g_assert_cmpint(g_bytes_get_size(blob), ==, 216);
+	blob_copy = fu_input_stream_read_bytes(stream, 0x0, G_MAXSIZE, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob_copy);
+	g_assert_true(g_bytes_get_data(blob_copy, NULL) != g_bytes_get_data(blob, NULL));
+	g_assert_true(g_bytes_equal(blob_copy, blob));
+
+	/* partial streams borrow the same memory */
+	stream_partial = fu_partial_input_stream_new(stream, 0x10, 0x20, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream_partial);
+	blob_partial = fu_input_stream_read_bytes_borrowed(stream_partial, 0x8, G_MAXSIZE, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob_partial);
+	g_assert_cmpint(g_bytes_get_size(blob_partial), ==, 0x18);
+	g_assert_true((const guint8 *)g_bytes_get_data(blob_partial, NULL) ==
+		      (const guint8 *)g_bytes_get_data(blob, NULL) + 0x18);
+	g_assert_cmpint(g_seekable_tell(G_SEEKABLE(stream_partial)), ==, 0x20);
+	ret = fu_input_stream_read_u8(stream_partial, 0x20, &value, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_READ);
+	g_assert_false(ret);
+	g_clear_error(&error);
+
+	/* and so do chunks */
+	chunks = fu_chunk_array_new_from_stream(stream, 0x0, 0x40, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(chunks);
+	chk = fu_chunk_array_index(chunks, 1, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(chk);
+	g_assert_cmpint(fu_chunk_get_data_sz(chk), ==, 0x40);
+	g_assert_true(fu_chunk_get_data(chk) == (const guint8 *)g_bytes_get_data(blob, NULL) + 0x40);
+}
+
+static void
+fu_buffered_input_stream_func(void)
+{
+	gboolean ret;
+	guint8 value = 0;
+	guint16 value16 = 0;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GBytes) blob = g_bytes_new_static("0123456789abcdef", 16);
+	g_autoptr(GBytes) blob2 = NULL;
+	g_autoptr(GInputStream) base_stream = g_memory_input_stream_new_from_bytes(blob);
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GInputStream) stream_partial = NULL;
+	g_autoptr(FuFirmware) firmware = fu_firmware_new();
+	FuBufferedInputStream *buffered;
+
+	stream = fu_buffered_input_stream_new(base_stream, 4, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream);
+	buffered = FU_BUFFERED_INPUT_STREAM(stream);
+
+	/* first read fills the buffer, nearby reads use it */
+	ret = fu_input_stream_read_u8(stream, 0x0, &value, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(value, ==, '0');
+	ret = fu_input_stream_read_u16(stream, 0x2, &value16, G_BIG_ENDIAN, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(value16, ==, 0x3233);
+	g_assert_cmpint(fu_buffered_input_stream_get_hits(buffered), ==, 1);
+	g_assert_cmpint(fu_buffered_input_stream_get_misses(buffered), ==, 1);
+
+	/* spanning the end of the buffer refills it */
+	ret = fu_input_stream_read_u16(stream, 0x3, &value16, G_BIG_ENDIAN, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(value16, ==, 0x3334);
+	g_assert_cmpint(fu_buffered_input_stream_get_misses(buffered), ==, 2);
+
+	/* seeking backwards outside the buffer */
+	ret = fu_input_stream_read_u8(stream, 0x1, &value, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(value, ==, '1');
+	g_assert_cmpint(fu_buffered_input_stream_get_misses(buffered), ==, 3);
+
+	/* large reads bypass the buffer */
+	blob2 = fu_input_stream_read_bytes(stream, 0x0, G_MAXSIZE, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob2);
+	g_assert_cmpint(g_bytes_compare(blob, blob2), ==, 0);
+
+	/* reading past the end */
+	g_assert_cmpint(g_seekable_tell(G_SEEKABLE(stream)), ==, 16);
+	ret = fu_input_stream_read_u8(stream, 0x10, &value, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_READ);
+	g_assert_false(ret);
+	g_clear_error(&error);
+
+	/* partial streams of a buffered stream */
+	stream_partial = fu_partial_input_stream_new(stream, 0xA, 0x4, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream_partial);
+	ret = fu_input_stream_read_u8(stream_partial, 0x3, &value, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(value, ==, 'd');
+
+	/* the read-ahead used when parsing can be changed or disabled */
+	g_assert_cmpint(fu_firmware_get_stream_buffer_window(firmware), ==, 0x1000);
+	fu_firmware_set_stream_buffer_window(firmware, 0x0);
+	g_assert_cmpint(fu_firmware_get_stream_buffer_window(firmware), ==, 0x0);
+}
+
 static void
 fu_composite_input_stream_func(void)
 {
@@ -5380,6 +5933,49 @@ fu_composite_input_stream_func(void)
 	g_assert_cmpint(memcmp(g_bytes_get_data(blob4, NULL), "abcdefg", 7), ==, 0);
 }
 
+static void
+fu_composite_input_stream_many_func(void)
+{
+	const guint8 *buf;
+	gsize bufsz = 0;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) composite_stream = fu_composite_input_stream_new();
+
+	/* one byte per item, including some empty items */
+	for (guint i = 0; i < 256; i++) {
+		guint8 value = i;
+		g_autoptr(GBytes) blob_tmp = g_bytes_new(&value, sizeof(value));
+		fu_composite_input_stream_add_bytes(FU_COMPOSITE_INPUT_STREAM(composite_stream),
+						    blob_tmp);
+		if (i % 16 == 0) {
+			g_autoptr(GBytes) blob_empty = g_bytes_new(NULL, 0);
+			fu_composite_input_stream_add_bytes(
+			    FU_COMPOSITE_INPUT_STREAM(composite_stream),
+			    blob_empty);
+		}
+	}
+
+	/* random access, backwards */
+	for (guint i = 256; i > 0; i--) {
+		gboolean ret;
+		guint8 value = 0;
+		ret = fu_input_stream_read_u8(composite_stream, i - 1, &value, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		g_assert_cmpint(value, ==, i - 1);
+	}
+
+	/* sequential, across items */
+	blob = fu_input_stream_read_bytes(composite_stream, 0x0, G_MAXSIZE, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob);
+	buf = g_bytes_get_data(blob, &bufsz);
+	g_assert_cmpint(bufsz, ==, 256);
+	for (guint i = 0; i < bufsz; i++)
+		g_assert_cmpint(buf[i], ==, i);
+}
+
 static gboolean
 fu_strsplit_stream_cb(GString *token, guint token_idx, gpointer user_data, GError **error)
 {
@@ -5677,6 +6273,7 @@ fu_plugin_struct_func(void)
 	g_autofree gchar *str1 = NULL;
 	g_autofree gchar *str2 = NULL;
 	g_autofree gchar *oem_table_id = NULL;
+	FuStructSelfTestView st_view = {0};
 
 	/* size */
 	g_assert_cmpint(st->len, ==, 51);
@@ -5706,6 +6303,18 @@ fu_plugin_struct_func(void)
 	oem_table_id = fu_struct_self_test_get_oem_table_id(st2);
 	g_assert_cmpstr(oem_table_id, ==, "X");
 
+	/* parse without copying */
+	ret = fu_struct_self_test_parse_view(&st_view, st->data, st->len, 0x0, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_true(st_view.data == st->data);
+	g_assert_cmpint(st_view.len, ==, st->len);
+	g_assert_cmpint(fu_struct_self_test_view_get_length(&st_view), ==, 0xDEAD);
+	ret = fu_struct_self_test_parse_view(&st_view, st->data, st->len, 0x1, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_READ);
+	g_assert_false(ret);
+	g_clear_error(&error);
+
 	/* to string */
 	str2 = fu_struct_self_test_to_string(st);
 	g_assert_cmpstr(str2,
@@ -5743,6 +6352,8 @@ fu_plugin_struct_wrapped_func(void)
 	g_autoptr(GByteArray) st_base = fu_struct_self_test_new();
 	g_autoptr(GByteArray) st = fu_struct_self_test_wrapped_new();
 	g_autoptr(GError) error = NULL;
+	FuStructSelfTestWrappedView st_view = {0};
+	FuStructSelfTestView st_base_view = {0};
 
 	/* size */
 	g_assert_cmpint(st->len, ==, 53);
@@ -5776,6 +6387,16 @@ fu_plugin_struct_wrapped_func(void)
 	st_base2 = fu_struct_self_test_wrapped_get_base(st);
 	g_assert_cmpint(fu_struct_self_test_get_revision(st_base2), ==, 0xFE);
 
+	/* parse without copying, including the nested struct */
+	ret = fu_struct_self_test_wrapped_parse_view(&st_view, st->data, st->len, 0x0, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_struct_self_test_wrapped_view_get_more(&st_view), ==, 0x12);
+	st_base_view = fu_struct_self_test_wrapped_view_get_base(&st_view);
+	g_assert_true(st_base_view.data == st->data + FU_STRUCT_SELF_TEST_WRAPPED_OFFSET_BASE);
+	g_assert_cmpint(st_base_view.len, ==, FU_STRUCT_SELF_TEST_SIZE);
+	g_assert_cmpint(fu_struct_self_test_view_get_revision(&st_base_view), ==, 0xFE);
+
 	/* to string */
 	str2 = fu_struct_self_test_wrapped_to_string(st);
 	g_assert_cmpstr(str2,
@@ -5800,6 +6421,10 @@ fu_plugin_struct_wrapped_func(void)
 	ret = fu_struct_self_test_wrapped_validate(st->data, st->len, 0x0, &error);
 	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA);
 	g_assert_false(ret);
+	g_clear_error(&error);
+	ret = fu_struct_self_test_wrapped_parse_view(&st_view, st->data, st->len, 0x0, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA);
+	g_assert_false(ret);
 }
 
 static void
@@ -5861,12 +6486,16 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/input-stream", fu_input_stream_func);
 	g_test_add_func("/fwupd/input-stream{chunkify}", fu_input_stream_chunkify_func);
 	g_test_add_func("/fwupd/partial-input-stream", fu_partial_input_stream_func);
+	g_test_add_func("/fwupd/mapped-input-stream", fu_mapped_input_stream_func);
+	g_test_add_func("/fwupd/buffered-input-stream", fu_buffered_input_stream_func);
 	g_test_add_func("/fwupd/composite-input-stream", fu_composite_input_stream_func);
+	g_test_add_func("/fwupd/composite-input-stream{many}", fu_composite_input_stream_many_func);
 	g_test_add_func("/fwupd/struct", fu_plugin_struct_func);
 	g_test_add_func("/fwupd/struct{bits}", fu_plugin_struct_bits_func);
 	g_test_add_func("/fwupd/struct{wrapped}", fu_plugin_struct_wrapped_func);
 	g_test_add_func("/fwupd/plugin{quirks-append}", fu_plugin_quirks_append_func);
 	g_test_add_func("/fwupd/quirks{vendor-ids}", fu_quirks_vendor_ids_func);
+	g_test_add_func("/fwupd/quirks{lookup-cache}", fu_quirks_lookup_cache_func);
 	g_test_add_func("/fwupd/string{password-mask}", fu_strpassmask_func);
 	g_test_add_func("/fwupd/string{strsplit-stream}", fu_strsplit_stream_func);
 	g_test_add_func("/fwupd/lzma", fu_lzma_func);
@@ -5904,9 +6533,13 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/chunk", fu_chunk_func);
 	g_test_add_func("/fwupd/chunks", fu_chunk_array_func);
 	g_test_add_func("/fwupd/common{align-up}", fu_common_align_up_func);
+	g_test_add_func("/fwupd/common{dump-enabled}", fu_common_dump_enabled_func);
 	g_test_add_func("/fwupd/volume{gpt-type}", fu_volume_gpt_type_func);
 	g_test_add_func("/fwupd/common{byte-array}", fu_common_byte_array_func);
 	g_test_add_func("/fwupd/common{crc}", fu_common_crc_func);
+	g_test_add_func("/fwupd/common{crc-tables}", fu_common_crc_tables_func);
+	if (g_test_perf())
+		g_test_add_func("/fwupd/common{crc-speed}", fu_common_crc_speed_func);
 	g_test_add_func("/fwupd/common{string-append-kv}", fu_string_append_func);
 	g_test_add_func("/fwupd/common{version-guess-format}", fu_version_guess_format_func);
 	g_test_add_func("/fwupd/common{strtoull}", fu_strtoull_func);
@@ -5939,7 +6572,10 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/firmware{common}", fu_firmware_common_func);
 	g_test_add_func("/fwupd/firmware{csv}", fu_firmware_csv_func);
 	g_test_add_func("/fwupd/firmware{archive}", fu_firmware_archive_func);
+	g_test_add_func("/fwupd/firmware{efi-signature-list}",
+			fu_firmware_efi_signature_list_func);
 	g_test_add_func("/fwupd/firmware{linear}", fu_firmware_linear_func);
+	g_test_add_func("/fwupd/firmware{cab-compressed}", fu_firmware_cab_compressed_func);
 	g_test_add_func("/fwupd/firmware{dedupe}", fu_firmware_dedupe_func);
 	g_test_add_func("/fwupd/firmware{build}", fu_firmware_build_func);
 	g_test_add_func("/fwupd/firmware{raw-aligned}", fu_firmware_raw_aligned_func);
@@ -5963,6 +6599,7 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/archive{cab}", fu_archive_cab_func);
 	g_test_add_func("/fwupd/device", fu_device_func);
 	g_test_add_func("/fwupd/device{event}", fu_device_event_func);
+	g_test_add_func("/fwupd/device{event-replay}", fu_device_event_replay_func);
 	g_test_add_func("/fwupd/device{vfuncs}", fu_device_vfuncs_func);
 	g_test_add_func("/fwupd/device{instance-ids}", fu_device_instance_ids_func);
 	g_test_add_func("/fwupd/device{composite-id}", fu_device_composite_id_func);
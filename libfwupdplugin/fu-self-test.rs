@@ -7,7 +7,7 @@ enum FuSelfTestRevision {
     All	= 0xF_F,
 }
 
-#[derive(New, Validate, Parse, ToString)]
+#[derive(New, Validate, Parse, ParseView, ToString)]
 struct FuStructSelfTest {
     signature: u32be == 0x1234_5678,
     length: u32le = $struct_size, // bytes
@@ -20,7 +20,7 @@ struct FuStructSelfTest {
     asl_compiler_revision: u32le,
 }
 
-#[derive(New, Validate, Parse, ToString)]
+#[derive(New, Validate, Parse, ParseView, ToString)]
 struct FuStructSelfTestWrapped {
     less: u8,
     base: FuStructSelfTest,
@@ -8,6 +8,14 @@
 
 #include "fu-udev-device.h"
 
+GRecMutexLocker *
+fu_udev_device_locker_new(void) G_GNUC_WARN_UNUSED_RESULT;
+void
+fu_udev_device_gudev_unref(GUdevDevice *udev_device) G_GNUC_NON_NULL(1);
+
+typedef GUdevDevice FuGUdevDevice;
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuGUdevDevice, fu_udev_device_gudev_unref)
+
 void
 fu_udev_device_emit_changed(FuUdevDevice *self) G_GNUC_NON_NULL(1);
 void
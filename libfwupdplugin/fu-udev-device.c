@@ -84,6 +84,32 @@ static guint signals[SIGNAL_LAST] = {0};
 
 #define GET_PRIVATE(o) (fu_udev_device_get_instance_private(o))
 
+/* libudev is not thread-safe, and devices may be probed from the coldplug worker pool */
+static GRecMutex fu_udev_device_mutex;
+
+/**
+ * fu_udev_device_locker_new:
+ *
+ * Locks the process-wide mutex that serializes all access to GUdev and libudev.
+ *
+ * Returns: (transfer full): a #GRecMutexLocker
+ *
+ * Since: 2.0.1
+ **/
+GRecMutexLocker *
+fu_udev_device_locker_new(void)
+{
+	return g_rec_mutex_locker_new(&fu_udev_device_mutex);
+}
+
+/* private: parents share the libudev object with the child, and its refcount is not atomic */
+void
+fu_udev_device_gudev_unref(GUdevDevice *udev_device)
+{
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
+	g_object_unref(udev_device);
+}
+
 /**
  * fu_udev_device_emit_changed:
  * @self: a #FuUdevDevice
@@ -104,14 +130,38 @@ fu_udev_device_emit_changed(FuUdevDevice *self)
 }
 
 #ifdef HAVE_GUDEV
+/* the lock is only held for the libudev call itself, so that probe I/O can overlap */
+static gchar *
+fu_udev_device_dup_udev_property(GUdevDevice *udev_device, const gchar *key)
+{
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
+	return g_strdup(g_udev_device_get_property(udev_device, key)); /* nocheck */
+}
+
+static gchar *
+fu_udev_device_dup_udev_sysfs_attr(GUdevDevice *udev_device, const gchar *name)
+{
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
+	return g_strdup(g_udev_device_get_sysfs_attr(udev_device, name)); /* nocheck */
+}
+
+static GUdevDevice *
+fu_udev_device_get_udev_parent(GUdevDevice *udev_device, const gchar *subsystem)
+{
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
+	if (subsystem != NULL)
+		return g_udev_device_get_parent_with_subsystem(udev_device, subsystem, NULL);
+	return g_udev_device_get_parent(udev_device);
+}
+
 static guint32
 fu_udev_device_get_sysfs_attr_as_uint32(GUdevDevice *udev_device, const gchar *name)
 {
-	const gchar *tmp;
 	guint64 tmp64 = 0;
+	g_autofree gchar *tmp = NULL;
 	g_autoptr(GError) error_local = NULL;
 
-	tmp = g_udev_device_get_sysfs_attr(udev_device, name); /* nocheck */
+	tmp = fu_udev_device_dup_udev_sysfs_attr(udev_device, name);
 	if (tmp == NULL)
 		return 0x0;
 	if (!fu_strtoull(tmp, &tmp64, 0, G_MAXUINT32, FU_INTEGER_BASE_AUTO, &error_local)) {
@@ -124,11 +174,11 @@ fu_udev_device_get_sysfs_attr_as_uint32(GUdevDevice *udev_device, const gchar *n
 static guint16
 fu_udev_device_get_sysfs_attr_as_uint16(GUdevDevice *udev_device, const gchar *name)
 {
-	const gchar *tmp;
 	guint64 tmp64 = 0;
+	g_autofree gchar *tmp = NULL;
 	g_autoptr(GError) error_local = NULL;
 
-	tmp = g_udev_device_get_sysfs_attr(udev_device, name); /* nocheck */
+	tmp = fu_udev_device_dup_udev_sysfs_attr(udev_device, name);
 	if (tmp == NULL)
 		return 0x0;
 	if (!fu_strtoull(tmp, &tmp64, 0, G_MAXUINT16, FU_INTEGER_BASE_AUTO, &error_local)) {
@@ -141,11 +191,11 @@ fu_udev_device_get_sysfs_attr_as_uint16(GUdevDevice *udev_device, const gchar *n
 static guint8
 fu_udev_device_get_sysfs_attr_as_uint8(GUdevDevice *udev_device, const gchar *name)
 {
-	const gchar *tmp;
 	guint64 tmp64 = 0;
+	g_autofree gchar *tmp = NULL;
 	g_autoptr(GError) error_local = NULL;
 
-	tmp = g_udev_device_get_sysfs_attr(udev_device, name); /* nocheck */
+	tmp = fu_udev_device_dup_udev_sysfs_attr(udev_device, name);
 	if (tmp == NULL)
 		return 0x0;
 	if (!fu_strtoull(tmp, &tmp64, 0, G_MAXUINT8, FU_INTEGER_BASE_AUTO, &error_local)) {
@@ -288,17 +338,14 @@ fu_udev_device_set_device_file(FuUdevDevice *self, const gchar *device_file)
 }
 
 #ifdef HAVE_GUDEV
-static const gchar *
+static gchar *
 fu_udev_device_get_vendor_fallback(GUdevDevice *udev_device)
 {
-	const gchar *tmp;
-	tmp = g_udev_device_get_property(udev_device, "ID_VENDOR_FROM_DATABASE"); /* nocheck */
-	if (tmp != NULL)
-		return tmp;
-	tmp = g_udev_device_get_property(udev_device, "ID_VENDOR"); /* nocheck */
+	gchar *tmp;
+	tmp = fu_udev_device_dup_udev_property(udev_device, "ID_VENDOR_FROM_DATABASE");
 	if (tmp != NULL)
 		return tmp;
-	return NULL;
+	return fu_udev_device_dup_udev_property(udev_device, "ID_VENDOR");
 }
 #endif
 
@@ -308,9 +355,11 @@ fu_udev_device_probe_serio(FuUdevDevice *self, GError **error)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	const gchar *tmp;
+	g_autofree gchar *firmware_id = NULL;
 
 	/* firmware ID */
-	tmp = g_udev_device_get_property(priv->udev_device, "SERIO_FIRMWARE_ID"); /* nocheck */
+	firmware_id = fu_udev_device_dup_udev_property(priv->udev_device, "SERIO_FIRMWARE_ID");
+	tmp = firmware_id;
 	if (tmp != NULL) {
 		/* this prefix is not useful */
 		if (g_str_has_prefix(tmp, "PNP: "))
@@ -332,9 +381,9 @@ fu_udev_device_probe_serio(FuUdevDevice *self, GError **error)
 static guint16
 fu_udev_device_get_property_as_uint16(GUdevDevice *udev_device, const gchar *key)
 {
-	const gchar *tmp = g_udev_device_get_property(udev_device, key); /* nocheck */
 	guint64 value = 0;
 	g_autofree gchar *str = NULL;
+	g_autofree gchar *tmp = fu_udev_device_dup_udev_property(udev_device, key);
 
 	if (tmp == NULL)
 		return 0x0;
@@ -370,15 +419,16 @@ static void
 fu_udev_device_set_vendor_from_parent(FuUdevDevice *self)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
-	g_autoptr(GUdevDevice) udev_device = g_object_ref(priv->udev_device);
+	g_autoptr(FuGUdevDevice) udev_device = g_object_ref(priv->udev_device);
 	while (TRUE) {
-		g_autoptr(GUdevDevice) parent = g_udev_device_get_parent(udev_device);
+		g_autoptr(FuGUdevDevice) parent = fu_udev_device_get_udev_parent(udev_device, NULL);
 		if (parent == NULL)
 			break;
 		fu_udev_device_set_vendor_from_udev_device(self, parent);
 		if (priv->vendor != 0x0 || priv->model != 0x0 || priv->revision != 0x0)
 			break;
-		g_set_object(&udev_device, parent);
+		fu_udev_device_gudev_unref(udev_device);
+		udev_device = g_steal_pointer(&parent);
 	}
 }
 #endif
@@ -509,8 +559,8 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 #ifdef HAVE_GUDEV
 	const gchar *tmp;
 	g_autofree gchar *subsystem = NULL;
-	g_autoptr(GUdevDevice) udev_parent = NULL;
-	g_autoptr(GUdevDevice) parent_i2c = NULL;
+	g_autoptr(FuGUdevDevice) udev_parent = NULL;
+	g_autoptr(FuGUdevDevice) parent_i2c = NULL;
 #endif
 
 	/* nothing to do */
@@ -520,16 +570,17 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 #ifdef HAVE_GUDEV
 	/* get IDs, but fallback to the parent, grandparent, great-grandparent, etc */
 	fu_udev_device_set_vendor_from_udev_device(self, priv->udev_device);
-	udev_parent = g_udev_device_get_parent(priv->udev_device);
+	udev_parent = fu_udev_device_get_udev_parent(priv->udev_device, NULL);
 	if (udev_parent != NULL && priv->flags & FU_UDEV_DEVICE_FLAG_VENDOR_FROM_PARENT)
 		fu_udev_device_set_vendor_from_parent(self);
 
 	/* hidraw helpfully encodes the information in a different place */
 	if (udev_parent != NULL && priv->vendor == 0x0 && priv->model == 0x0 &&
 	    priv->revision == 0x0 && g_strcmp0(priv->subsystem, "hidraw") == 0) {
-		tmp = g_udev_device_get_property(udev_parent, "HID_ID"); /* nocheck */
-		if (tmp != NULL) {
-			g_auto(GStrv) split = g_strsplit(tmp, ":", -1);
+		g_autofree gchar *hid_id = fu_udev_device_dup_udev_property(udev_parent, "HID_ID");
+		g_autofree gchar *hid_name = NULL;
+		if (hid_id != NULL) {
+			g_auto(GStrv) split = g_strsplit(hid_id, ":", -1);
 			if (g_strv_length(split) == 3) {
 				guint64 val = 0;
 				g_autoptr(GError) error_local = NULL;
@@ -542,7 +593,7 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 						 &error_local)) {
 					g_warning("reading %s for %s failed: %s",
 						  split[1],
-						  g_udev_device_get_sysfs_path(priv->udev_device),
+						  fu_udev_device_get_sysfs_path(self),
 						  error_local->message);
 				} else {
 					priv->vendor = val;
@@ -555,17 +606,17 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 						 &error_local)) {
 					g_warning("reading %s for %s failed: %s",
 						  split[2],
-						  g_udev_device_get_sysfs_path(priv->udev_device),
+						  fu_udev_device_get_sysfs_path(self),
 						  error_local->message);
 				} else {
 					priv->model = val;
 				}
 			}
 		}
-		tmp = g_udev_device_get_property(udev_parent, "HID_NAME"); /* nocheck */
-		if (tmp != NULL) {
+		hid_name = fu_udev_device_dup_udev_property(udev_parent, "HID_NAME");
+		if (hid_name != NULL) {
 			if (fu_device_get_name(device) == NULL)
-				fu_device_set_name(device, tmp);
+				fu_device_set_name(device, hid_name);
 		}
 	}
 
@@ -573,10 +624,8 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 	if (g_strcmp0(priv->subsystem, "pci") == 0 &&
 	    fu_udev_device_is_pci_base_cls(FU_UDEV_DEVICE(device), FU_PCI_BASE_CLS_DISPLAY) &&
 	    fu_device_get_version(device) == NULL) {
-		const gchar *version;
-
-		version =
-		    g_udev_device_get_sysfs_attr(priv->udev_device, "vbios_version"); /* nocheck */
+		g_autofree gchar *version =
+		    fu_udev_device_dup_udev_sysfs_attr(priv->udev_device, "vbios_version");
 		if (version != NULL) {
 			fu_device_set_version(device, version);
 			fu_device_set_version_format(device, FWUPD_VERSION_FORMAT_PLAIN);
@@ -596,23 +645,23 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 
 	/* set model */
 	if (fu_device_get_name(device) == NULL) {
-		tmp = g_udev_device_get_property(priv->udev_device, /* nocheck */
-						 "ID_MODEL_FROM_DATABASE");
-		if (tmp == NULL)
-			tmp =
-			    g_udev_device_get_property(priv->udev_device, "ID_MODEL"); /* nocheck */
-		if (tmp == NULL)
-			tmp = g_udev_device_get_property(priv->udev_device, /* nocheck */
-							 "ID_PCI_CLASS_FROM_DATABASE");
-		if (tmp != NULL)
-			fu_device_set_name(device, tmp);
+		g_autofree gchar *model =
+		    fu_udev_device_dup_udev_property(priv->udev_device, "ID_MODEL_FROM_DATABASE");
+		if (model == NULL)
+			model = fu_udev_device_dup_udev_property(priv->udev_device, "ID_MODEL");
+		if (model == NULL) {
+			model = fu_udev_device_dup_udev_property(priv->udev_device,
+								 "ID_PCI_CLASS_FROM_DATABASE");
+		}
+		if (model != NULL)
+			fu_device_set_name(device, model);
 	}
 
 	/* set vendor */
 	if (fu_device_get_vendor(device) == NULL) {
-		tmp = fu_udev_device_get_vendor_fallback(priv->udev_device);
-		if (tmp != NULL)
-			fu_device_set_vendor(device, tmp);
+		g_autofree gchar *vendor = fu_udev_device_get_vendor_fallback(priv->udev_device);
+		if (vendor != NULL)
+			fu_device_set_vendor(device, vendor);
 	}
 
 	/* set number */
@@ -625,18 +674,19 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 	/* try harder to find a vendor name the user will recognize */
 	if (priv->flags & FU_UDEV_DEVICE_FLAG_VENDOR_FROM_PARENT && udev_parent != NULL &&
 	    fu_device_get_vendor(device) == NULL) {
-		g_autoptr(GUdevDevice) device_tmp = g_object_ref(udev_parent);
+		g_autoptr(FuGUdevDevice) device_tmp = g_object_ref(udev_parent);
 		for (guint i = 0; i < 0xff; i++) {
-			g_autoptr(GUdevDevice) parent = NULL;
-			tmp = fu_udev_device_get_vendor_fallback(device_tmp);
-			if (tmp != NULL) {
-				fu_device_set_vendor(device, tmp);
+			g_autofree gchar *vendor = fu_udev_device_get_vendor_fallback(device_tmp);
+			g_autoptr(FuGUdevDevice) parent = NULL;
+			if (vendor != NULL) {
+				fu_device_set_vendor(device, vendor);
 				break;
 			}
-			parent = g_udev_device_get_parent(device_tmp);
+			parent = fu_udev_device_get_udev_parent(device_tmp, NULL);
 			if (parent == NULL)
 				break;
-			g_set_object(&device_tmp, parent);
+			fu_udev_device_gudev_unref(device_tmp);
+			device_tmp = g_steal_pointer(&parent);
 		}
 	}
 
@@ -738,7 +788,10 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 
 	/* add device class */
 	if (subsystem != NULL) {
-		tmp = g_udev_device_get_sysfs_attr(priv->udev_device, "class"); /* nocheck */
+		g_autofree gchar *cls = NULL;
+
+		cls = fu_udev_device_dup_udev_sysfs_attr(priv->udev_device, "class");
+		tmp = cls;
 		if (tmp != NULL && g_str_has_prefix(tmp, "0x"))
 			tmp += 2;
 		fu_device_add_instance_strup(device, "CLASS", tmp);
@@ -752,9 +805,7 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 						 NULL);
 
 		/* add devtype */
-		fu_device_add_instance_strup(device,
-					     "TYPE",
-					     g_udev_device_get_devtype(priv->udev_device));
+		fu_device_add_instance_strup(device, "TYPE", priv->devtype);
 		fu_device_build_instance_id_full(device,
 						 FU_DEVICE_INSTANCE_FLAG_GENERIC |
 						     FU_DEVICE_INSTANCE_FLAG_QUIRKS,
@@ -775,13 +826,13 @@ fu_udev_device_probe(FuDevice *device, GError **error)
 	}
 
 	/* add firmware_id */
-	if (g_strcmp0(g_udev_device_get_subsystem(priv->udev_device), "serio") == 0) {
+	if (g_strcmp0(priv->subsystem, "serio") == 0) {
 		if (!fu_udev_device_probe_serio(self, error))
 			return FALSE;
 	}
 
 	/* determine if we're wired internally */
-	parent_i2c = g_udev_device_get_parent_with_subsystem(priv->udev_device, "i2c", NULL);
+	parent_i2c = fu_udev_device_get_udev_parent(priv->udev_device, "i2c");
 	if (parent_i2c != NULL)
 		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_INTERNAL);
 #endif
@@ -833,6 +884,7 @@ void
 fu_udev_device_set_dev(FuUdevDevice *self, GUdevDevice *udev_device)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
 #ifdef HAVE_GUDEV
 	const gchar *summary;
 #endif
@@ -1428,6 +1480,7 @@ fu_udev_device_set_physical_id(FuUdevDevice *self, const gchar *subsystems, GErr
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	const gchar *tmp;
 	const gchar *subsystem = NULL;
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
 	g_autofree gchar *physical_id = NULL;
 	g_auto(GStrv) split = NULL;
 	g_autoptr(GUdevDevice) udev_device = NULL;
@@ -1557,6 +1610,7 @@ fu_udev_device_set_logical_id(FuUdevDevice *self, const gchar *subsystem, GError
 #ifdef HAVE_GUDEV
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	const gchar *tmp;
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
 	g_autofree gchar *logical_id = NULL;
 	g_autoptr(GUdevDevice) udev_device = NULL;
 
@@ -1779,6 +1833,7 @@ fu_udev_device_rescan(FuDevice *device, GError **error)
 	FuUdevDevice *self = FU_UDEV_DEVICE(device);
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	const gchar *sysfs_path;
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
 	g_autoptr(GUdevClient) udev_client = g_udev_client_new(NULL);
 	g_autoptr(GUdevDevice) udev_device = NULL;
 
@@ -2214,7 +2269,7 @@ fu_udev_device_read_sysfs(FuUdevDevice *self, const gchar *attr, guint timeout_m
 		event = fu_device_load_event(FU_DEVICE(self), event_id, error);
 		if (event == NULL)
 			return NULL;
-		return g_strdup(fu_device_event_get_str(event, "Data", error));
+		return fu_device_event_get_str(event, "Data", error);
 	}
 
 	/* save */
@@ -2426,6 +2481,7 @@ fu_udev_device_read_property(FuUdevDevice *self, const gchar *key, GError **erro
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	FuDeviceEvent *event = NULL;
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
 	g_autofree gchar *event_id = NULL;
 	g_autofree gchar *value = NULL;
 
@@ -2445,7 +2501,7 @@ fu_udev_device_read_property(FuUdevDevice *self, const gchar *key, GError **erro
 		event = fu_device_load_event(FU_DEVICE(self), event_id, error);
 		if (event == NULL)
 			return NULL;
-		return g_strdup(fu_device_event_get_str(event, "Data", error));
+		return fu_device_event_get_str(event, "Data", error);
 	}
 
 	/* save */
@@ -2707,6 +2763,7 @@ fu_udev_device_finalize(GObject *object)
 {
 	FuUdevDevice *self = FU_UDEV_DEVICE(object);
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
 
 	if (priv->uevent_lines != NULL)
 		g_strfreev(priv->uevent_lines);
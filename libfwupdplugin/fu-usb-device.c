@@ -1744,15 +1744,20 @@ fu_usb_device_parse_descriptor(FuUsbDevice *self, GInputStream *stream, GError *
 	offset += fu_usb_device_hdr_get_length(st);
 	while (offset < streamsz) {
 		FuUsbDescriptorKind descriptor_kind;
-		g_autoptr(FuUsbBaseHdr) st_base = NULL;
+		guint8 buf[FU_USB_BASE_HDR_SIZE] = {0x0};
+		FuUsbBaseHdrView st_base = {0};
 
 		/* this is common to all descriptor types */
-		st_base = fu_usb_base_hdr_parse_stream(stream, offset, error);
-		if (st_base == NULL)
+		if (!fu_usb_base_hdr_parse_stream_into(&st_base,
+						       buf,
+						       sizeof(buf),
+						       stream,
+						       offset,
+						       error))
 			return FALSE;
 
 		/* config, interface or endpoint */
-		descriptor_kind = fu_usb_base_hdr_get_descriptor_type(st_base);
+		descriptor_kind = fu_usb_base_hdr_view_get_descriptor_type(&st_base);
 		if (descriptor_kind == FU_USB_DESCRIPTOR_KIND_CONFIG) {
 			g_autoptr(FuUsbDescriptorHdr) st_desc = NULL;
 			st_desc = fu_usb_descriptor_hdr_parse_stream(stream, offset, error);
@@ -1788,7 +1793,7 @@ fu_usb_device_parse_descriptor(FuUsbDevice *self, GInputStream *stream, GError *
 				descriptor_kind,
 				str != NULL ? str : "unknown");
 		}
-		offset += fu_usb_base_hdr_get_length(st_base);
+		offset += fu_usb_base_hdr_view_get_length(&st_base);
 	}
 
 	/* success */
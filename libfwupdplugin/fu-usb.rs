@@ -70,7 +70,7 @@ enum FuUsbDescriptorKind {
     SsEndpointCompanion = 0x30,
 }
 
-#[derive(ParseStream, Parse)]
+#[derive(ParseStream, ParseStreamInto, Parse)]
 struct FuUsbBaseHdr {
     length: u8,
     descriptor_type: FuUsbDescriptorKind,
@@ -153,7 +153,12 @@ class StructObj:
             "Parse": Export.NONE,
             "ParseBytes": Export.NONE,
             "ParseStream": Export.NONE,
+            "ParseStreamInto": Export.NONE,
+            "ParseView": Export.NONE,
             "ParseInternal": Export.NONE,
+            "ParseViewInternal": Export.NONE,
+            "View": Export.NONE,
+            "ViewValidateInternal": Export.NONE,
             "New": Export.NONE,
             "ToString": Export.NONE,
         }
@@ -217,6 +222,8 @@ class StructObj:
             self.add_private_export("ParseInternal")
         elif derive == "ParseStream":
             self.add_private_export("ParseInternal")
+        elif derive in ["ParseStreamInto", "ParseView"]:
+            self.add_private_export("ParseViewInternal")
         elif derive == "ParseBytes":
             self.add_private_export("Parse")
         elif derive == "ParseInternal":
@@ -231,6 +238,20 @@ class StructObj:
                     item.add_private_export("Getters")
                 if item.struct_obj:
                     item.struct_obj.add_private_export("ValidateInternal")
+        elif derive == "ParseViewInternal":
+            self.add_private_export("ToString")
+            self.add_private_export("ViewValidateInternal")
+        elif derive == "ViewValidateInternal":
+            self.add_private_export("View")
+            for item in self.items:
+                if (
+                    item.constant
+                    and item.type != Type.STRING
+                    and not (item.type == Type.U8 and item.multiplier)
+                ):
+                    item.add_private_export("ViewGetters")
+                if item.struct_obj:
+                    item.struct_obj.add_private_export("ViewValidateInternal")
         elif derive == "New":
             for item in self.items:
                 if item.constant and not (item.type == Type.U8 and item.multiplier):
@@ -238,10 +259,12 @@ class StructObj:
 
     def add_public_export(self, derive: str) -> None:
         # Getters and Setters are special as we do not want public exports of const
-        if derive in ["Getters", "Setters"]:
+        if derive in ["Getters", "ViewGetters", "Setters"]:
             for item in self.items:
                 if not item.constant:
                     item.add_public_export(derive)
+                if derive == "ViewGetters" and item.struct_obj:
+                    item.struct_obj.add_public_export("View")
         else:
             self.add_private_export(derive)
             self._exports[derive] = Export.PUBLIC
@@ -249,6 +272,9 @@ class StructObj:
         # for convenience
         if derive in ["Parse", "ParseBytes", "ParseStream"]:
             self.add_public_export("Getters")
+        if derive in ["ParseStreamInto", "ParseView"]:
+            self.add_public_export("View")
+            self.add_public_export("ViewGetters")
         if derive == "New":
             self.add_public_export("Setters")
 
@@ -276,6 +302,7 @@ class StructItem:
         self.offset: int = 0
         self._exports: Dict[str, Export] = {
             "Getters": Export.NONE,
+            "ViewGetters": Export.NONE,
             "Setters": Export.NONE,
         }
 
@@ -346,6 +373,10 @@ class StructItem:
     def c_getter(self):
         return self.obj.c_method("get_" + self.element_id)
 
+    @property
+    def c_view_getter(self):
+        return self.obj.c_method("view_get_" + self.element_id)
+
     @property
     def c_setter(self):
         return self.obj.c_method("set_" + self.element_id)
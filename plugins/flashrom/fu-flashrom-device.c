@@ -7,7 +7,9 @@
 
 #include "config.h"
 
+#include <glib/gstdio.h>
 #include <libflashrom.h>
+#include <string.h>
 
 #include "fu-flashrom-cmos.h"
 #include "fu-flashrom-device.h"
@@ -15,11 +17,16 @@
 #define FU_FLASHROM_DEVICE_FLAG_RESET_CMOS     "reset-cmos"
 #define FU_FLASHROM_DEVICE_FLAG_FN_M_ME_UNLOCK "fn-m-me-unlock"
 
+/* largest erase block used by SPI flash, so every block flashrom rewrote is read back */
+#define FU_FLASHROM_DEVICE_VERIFY_BLOCK_SIZE 0x10000
+
 struct _FuFlashromDevice {
 	FuUdevDevice parent_instance;
 	FuIfdRegion region;
 	struct flashrom_flashctx *flashctx;
 	struct flashrom_layout *layout;
+	GBytes *refbuf;		/* (nullable): flash contents loaded in ->prepare() */
+	gchar *refbuf_checksum; /* (nullable): SHA256 of @refbuf */
 };
 
 G_DEFINE_TYPE(FuFlashromDevice, fu_flashrom_device, FU_TYPE_UDEV_DEVICE)
@@ -142,33 +149,355 @@ fu_flashrom_device_dump_firmware(FuDevice *device, FuProgress *progress, GError
 	return g_bytes_new_take(g_steal_pointer(&buf), bufsz);
 }
 
+static void
+fu_flashrom_device_refbuf_clear(FuFlashromDevice *self)
+{
+	g_clear_pointer(&self->refbuf, g_bytes_unref);
+	g_clear_pointer(&self->refbuf_checksum, g_free);
+}
+
+static gchar *
+fu_flashrom_device_get_cache_filename(FuFlashromDevice *self, const gchar *ext)
+{
+	g_autofree gchar *cachedir = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
+	g_autofree gchar *basename = NULL;
+
+	basename = g_strdup_printf("%s.%s", fu_device_get_id(FU_DEVICE(self)), ext);
+	return g_build_filename(cachedir, "flashrom", basename, NULL);
+}
+
+/* the cached contents are only used if the tag matches both the data and the device version */
+static GBytes *
+fu_flashrom_device_cache_load(FuFlashromDevice *self, GError **error)
+{
+	const gchar *version = fu_device_get_version(FU_DEVICE(self));
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *checksum_tag = NULL;
+	g_autofree gchar *fn_blob = fu_flashrom_device_get_cache_filename(self, "bin");
+	g_autofree gchar *fn_tag = fu_flashrom_device_get_cache_filename(self, "ini");
+	g_autofree gchar *version_tag = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new();
+
+	if (!g_key_file_load_from_file(kf, fn_tag, G_KEY_FILE_NONE, error))
+		return NULL;
+	version_tag = g_key_file_get_string(kf, "flashrom", "Version", error);
+	if (version_tag == NULL)
+		return NULL;
+	if (g_strcmp0(version_tag, version) != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_FOUND,
+			    "cached contents are for version %s, current version %s",
+			    version_tag,
+			    version);
+		return NULL;
+	}
+	checksum_tag = g_key_file_get_string(kf, "flashrom", "Checksum", error);
+	if (checksum_tag == NULL)
+		return NULL;
+	blob = fu_bytes_get_contents(fn_blob, error);
+	if (blob == NULL)
+		return NULL;
+	if (g_bytes_get_size(blob) != fu_device_get_firmware_size_max(FU_DEVICE(self))) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "cached contents size 0x%x, expected 0x%x",
+			    (guint)g_bytes_get_size(blob),
+			    (guint)fu_device_get_firmware_size_max(FU_DEVICE(self)));
+		return NULL;
+	}
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, blob);
+	if (g_strcmp0(checksum, checksum_tag) != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "cached contents checksum %s, expected %s",
+			    checksum,
+			    checksum_tag);
+		return NULL;
+	}
+	return g_steal_pointer(&blob);
+}
+
+static void
+fu_flashrom_device_cache_invalidate(FuFlashromDevice *self)
+{
+	g_autofree gchar *fn_tag = fu_flashrom_device_get_cache_filename(self, "ini");
+	if (g_file_test(fn_tag, G_FILE_TEST_EXISTS) && g_unlink(fn_tag) != 0)
+		g_debug("failed to delete %s", fn_tag);
+}
+
+static void
+fu_flashrom_device_cache_save(FuFlashromDevice *self, GBytes *blob, const gchar *version)
+{
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *fn_blob = fu_flashrom_device_get_cache_filename(self, "bin");
+	g_autofree gchar *fn_tag = fu_flashrom_device_get_cache_filename(self, "ini");
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new();
+
+	/* the tag is written last so that a partial write is never trusted */
+	fu_flashrom_device_cache_invalidate(self);
+	if (version == NULL) {
+		g_debug("not caching contents with no version");
+		return;
+	}
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, blob);
+	g_key_file_set_string(kf, "flashrom", "Checksum", checksum);
+	g_key_file_set_string(kf, "flashrom", "Version", version);
+
+	/* not fatal, we just have to read the flash again next time */
+	if (!fu_path_mkdir_parent(fn_blob, &error_local) ||
+	    !fu_bytes_set_contents(fn_blob, blob, &error_local) ||
+	    !g_key_file_save_to_file(kf, fn_tag, &error_local))
+		g_debug("failed to save %s: %s", fn_blob, error_local->message);
+}
+
 static gboolean
 fu_flashrom_device_prepare(FuDevice *device,
 			   FuProgress *progress,
 			   FwupdInstallFlags flags,
 			   GError **error)
 {
+	FuFlashromDevice *self = FU_FLASHROM_DEVICE(device);
 	g_autofree gchar *firmware_orig = NULL;
 	g_autofree gchar *localstatedir = NULL;
 	g_autofree gchar *basename = NULL;
+	g_autoptr(GBytes) buf = NULL;
 
-	/* if the original firmware doesn't exist, grab it now */
 	basename = g_strdup_printf("flashrom-%s.bin", fu_device_get_id(device));
 	localstatedir = fu_path_from_kind(FU_PATH_KIND_LOCALSTATEDIR_PKG);
 	firmware_orig = g_build_filename(localstatedir, "builder", basename, NULL);
 	if (!fu_path_mkdir_parent(firmware_orig, error))
 		return FALSE;
-	if (!g_file_test(firmware_orig, G_FILE_TEST_EXISTS)) {
-		g_autoptr(GBytes) buf = NULL;
+
+	/* reading the whole flash is slow, so use the cached contents if they can be trusted */
+	fu_flashrom_device_refbuf_clear(self);
+	if (g_file_test(firmware_orig, G_FILE_TEST_EXISTS)) {
+		g_autoptr(GError) error_local = NULL;
+		buf = fu_flashrom_device_cache_load(self, &error_local);
+		if (buf == NULL)
+			g_debug("reading flash: %s", error_local->message);
+	}
+	if (buf == NULL) {
 		buf = fu_flashrom_device_dump_firmware(device, progress, error);
 		if (buf == NULL) {
-			g_prefix_error(error, "failed to back up original firmware: ");
+			g_prefix_error(error, "failed to read current firmware: ");
 			return FALSE;
 		}
-		if (!fu_bytes_set_contents(firmware_orig, buf, error))
-			return FALSE;
+
+		/* if the original firmware doesn't exist, save it now */
+		if (!g_file_test(firmware_orig, G_FILE_TEST_EXISTS)) {
+			if (!fu_bytes_set_contents(firmware_orig, buf, error))
+				return FALSE;
+		}
+		fu_flashrom_device_cache_save(self, buf, fu_device_get_version(device));
+	}
+
+	/* success */
+	self->refbuf_checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, buf);
+	self->refbuf = g_steal_pointer(&buf);
+	return TRUE;
+}
+
+static gboolean
+fu_flashrom_device_cleanup(FuDevice *device,
+			   FuProgress *progress,
+			   FwupdInstallFlags flags,
+			   GError **error)
+{
+	FuFlashromDevice *self = FU_FLASHROM_DEVICE(device);
+	fu_flashrom_device_refbuf_clear(self);
+	return TRUE;
+}
+
+/* returns a private copy as flashrom does not promise to leave the reference buffer untouched */
+static guint8 *
+fu_flashrom_device_get_refbuf(FuFlashromDevice *self, gsize bufsz)
+{
+	g_autofree gchar *checksum = NULL;
+
+	if (self->refbuf == NULL)
+		return NULL;
+	if (g_bytes_get_size(self->refbuf) != bufsz) {
+		g_debug("ignoring reference buffer of size 0x%x, expected 0x%x",
+			(guint)g_bytes_get_size(self->refbuf),
+			(guint)bufsz);
+		return NULL;
+	}
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, self->refbuf);
+	if (g_strcmp0(checksum, self->refbuf_checksum) != 0) {
+		g_warning("ignoring reference buffer with checksum %s, expected %s",
+			  checksum,
+			  self->refbuf_checksum);
+		return NULL;
+	}
+	return g_memdup2(g_bytes_get_data(self->refbuf, NULL), bufsz);
+}
+
+#ifdef HAVE_FLASHROM_LAYOUT_ADD_REGION
+/* the part of the image flashrom actually reads and writes */
+static gboolean
+fu_flashrom_device_get_range(FuFlashromDevice *self, gsize bufsz, gsize *offset, gsize *size)
+{
+	unsigned int start = 0;
+	unsigned int len = 0;
+
+	if (self->layout == NULL) {
+		*offset = 0;
+		*size = bufsz;
+		return TRUE;
+	}
+	if (flashrom_layout_get_region_range(self->layout,
+					     fu_ifd_region_to_string(self->region),
+					     &start,
+					     &len) != 0)
+		return FALSE;
+	if ((gsize)start + len > bufsz)
+		return FALSE;
+	*offset = start;
+	*size = len;
+	return TRUE;
+}
+
+static gboolean
+fu_flashrom_device_layout_add_changed(struct flashrom_layout *layout,
+				      gsize start,
+				      gsize end,
+				      guint *cnt,
+				      GError **error)
+{
+	g_autofree gchar *name = g_strdup_printf("changed-%u", (*cnt)++);
+	if (flashrom_layout_add_region(layout, start, end, name) != 0 ||
+	    flashrom_layout_include_region(layout, name) != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "failed to add region 0x%x:0x%x",
+			    (guint)start,
+			    (guint)end);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* build a layout that only includes the blocks that differ from the reference buffer */
+static struct flashrom_layout *
+fu_flashrom_device_build_changed_layout(FuFlashromDevice *self,
+					const guint8 *buf,
+					const guint8 *refbuf,
+					gsize bufsz,
+					guint *cnt,
+					GError **error)
+{
+	gsize offset = 0;
+	gsize size = 0;
+	gsize run_start = G_MAXSIZE;
+	struct flashrom_layout *layout = NULL;
+
+	if (!fu_flashrom_device_get_range(self, bufsz, &offset, &size)) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "failed to get region range");
+		return NULL;
 	}
+	if (flashrom_layout_new(&layout) != 0) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INTERNAL,
+				    "failed to create layout");
+		return NULL;
+	}
+	for (gsize i = offset - (offset % FU_FLASHROM_DEVICE_VERIFY_BLOCK_SIZE); i < offset + size;
+	     i += FU_FLASHROM_DEVICE_VERIFY_BLOCK_SIZE) {
+		gsize start = MAX(i, offset);
+		gsize end = MIN(i + FU_FLASHROM_DEVICE_VERIFY_BLOCK_SIZE, offset + size);
+
+		/* extend the current run of changed blocks */
+		if (memcmp(buf + start, refbuf + start, end - start) != 0) {
+			if (run_start == G_MAXSIZE)
+				run_start = start;
+			continue;
+		}
+		if (run_start == G_MAXSIZE)
+			continue;
+
+		/* the run has ended */
+		if (!fu_flashrom_device_layout_add_changed(layout,
+							   run_start,
+							   start - 1,
+							   cnt,
+							   error)) {
+			flashrom_layout_release(layout);
+			return NULL;
+		}
+		run_start = G_MAXSIZE;
+	}
+	if (run_start != G_MAXSIZE) {
+		if (!fu_flashrom_device_layout_add_changed(layout,
+							   run_start,
+							   offset + size - 1,
+							   cnt,
+							   error)) {
+			flashrom_layout_release(layout);
+			return NULL;
+		}
+	}
+	return layout;
+}
+#endif
 
+static gboolean
+fu_flashrom_device_verify(FuFlashromDevice *self,
+			  const guint8 *buf,
+			  const guint8 *refbuf,
+			  gsize bufsz,
+			  GError **error)
+{
+#ifdef HAVE_FLASHROM_LAYOUT_ADD_REGION
+	/* only read back the blocks that were changed by the write */
+	if (refbuf != NULL) {
+		gint rc;
+		guint cnt = 0;
+		struct flashrom_layout *layout = NULL;
+		g_autoptr(GError) error_local = NULL;
+
+		layout = fu_flashrom_device_build_changed_layout(self,
+								 buf,
+								 refbuf,
+								 bufsz,
+								 &cnt,
+								 &error_local);
+		if (layout == NULL) {
+			g_debug("verifying everything: %s", error_local->message);
+		} else if (cnt == 0) {
+			flashrom_layout_release(layout);
+			g_debug("no blocks changed, nothing to verify");
+			return TRUE;
+		} else {
+			g_debug("verifying %u changed ranges", cnt);
+			flashrom_layout_set(self->flashctx, layout);
+			rc = flashrom_image_verify(self->flashctx, (void *)buf, bufsz);
+			flashrom_layout_set(self->flashctx, self->layout);
+			flashrom_layout_release(layout);
+			if (rc != 0) {
+				g_set_error_literal(error,
+						    FWUPD_ERROR,
+						    FWUPD_ERROR_WRITE,
+						    "image verify failed");
+				return FALSE;
+			}
+			return TRUE;
+		}
+	}
+#endif
+	if (flashrom_image_verify(self->flashctx, (void *)buf, bufsz)) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_WRITE, "image verify failed");
+		return FALSE;
+	}
 	return TRUE;
 }
 
@@ -183,6 +512,8 @@ fu_flashrom_device_write_firmware(FuDevice *device,
 	gsize sz = 0;
 	gint rc;
 	const guint8 *buf;
+	const guint8 *refbuf_orig = NULL;
+	g_autofree guint8 *refbuf = NULL;
 	g_autoptr(GBytes) blob_fw = NULL;
 
 	/* progress */
@@ -207,8 +538,14 @@ fu_flashrom_device_write_firmware(FuDevice *device,
 			    (guint)fu_device_get_firmware_size_max(device));
 		return FALSE;
 	}
-	rc = flashrom_image_write(self->flashctx, (void *)buf, sz, NULL /* refbuffer */);
+
+	/* flashrom skips the readback and any unchanged erase blocks if given the contents */
+	refbuf = fu_flashrom_device_get_refbuf(self, sz);
+	if (refbuf != NULL)
+		refbuf_orig = g_bytes_get_data(self->refbuf, NULL);
+	rc = flashrom_image_write(self->flashctx, (void *)buf, sz, refbuf);
 	if (rc != 0) {
+		fu_flashrom_device_cache_invalidate(self);
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_WRITE,
@@ -218,12 +555,16 @@ fu_flashrom_device_write_firmware(FuDevice *device,
 	}
 	fu_progress_step_done(progress);
 
-	if (flashrom_image_verify(self->flashctx, (void *)buf, sz)) {
-		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_WRITE, "image verify failed");
+	/* compare against the unmodified reference buffer to find the written ranges */
+	if (!fu_flashrom_device_verify(self, buf, refbuf_orig, sz, error)) {
+		fu_flashrom_device_cache_invalidate(self);
 		return FALSE;
 	}
 	fu_progress_step_done(progress);
 
+	/* the flash now contains the image, which is what the new version will read back */
+	fu_flashrom_device_cache_save(self, blob_fw, fu_firmware_get_version(firmware));
+
 	/* Check if CMOS needs a reset */
 	if (fu_device_has_private_flag(device, FU_FLASHROM_DEVICE_FLAG_RESET_CMOS)) {
 		g_debug("attempting CMOS reset");
@@ -312,6 +653,7 @@ fu_flashrom_device_finalize(GObject *object)
 	FuFlashromDevice *self = FU_FLASHROM_DEVICE(object);
 	if (self->layout != NULL)
 		flashrom_layout_release(self->layout);
+	fu_flashrom_device_refbuf_clear(self);
 
 	G_OBJECT_CLASS(fu_flashrom_device_parent_class)->finalize(object);
 }
@@ -359,6 +701,7 @@ fu_flashrom_device_class_init(FuFlashromDeviceClass *klass)
 	device_class->close = fu_flashrom_device_close;
 	device_class->set_progress = fu_flashrom_device_set_progress;
 	device_class->prepare = fu_flashrom_device_prepare;
+	device_class->cleanup = fu_flashrom_device_cleanup;
 	device_class->dump_firmware = fu_flashrom_device_dump_firmware;
 	device_class->write_firmware = fu_flashrom_device_write_firmware;
 }
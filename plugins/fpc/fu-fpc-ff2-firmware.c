@@ -60,6 +60,7 @@ fu_fpc_ff2_firmware_get_blocks_num(FuFpcFf2Firmware *self)
 static void
 fu_fpc_ff2_firmware_init(FuFpcFf2Firmware *self)
 {
+	fu_firmware_add_magic(FU_FIRMWARE(self), (const guint8 *)"FPC0001", 7, 0x0);
 }
 
 static void
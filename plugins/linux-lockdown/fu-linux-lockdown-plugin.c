@@ -194,6 +194,7 @@ fu_linux_lockdown_plugin_to_string(FuPlugin *plugin, guint idt, GString *str)
 static void
 fu_linux_lockdown_plugin_init(FuLinuxLockdownPlugin *self)
 {
+	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE);
 }
 
 static void
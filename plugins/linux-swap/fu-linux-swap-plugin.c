@@ -111,6 +111,7 @@ fu_linux_swap_plugin_add_security_attrs(FuPlugin *plugin, FuSecurityAttrs *attrs
 static void
 fu_linux_swap_plugin_init(FuLinuxSwapPlugin *self)
 {
+	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE);
 }
 
 static void
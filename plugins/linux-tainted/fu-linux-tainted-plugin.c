@@ -128,6 +128,7 @@ fu_linux_tainted_plugin_add_security_attrs(FuPlugin *plugin, FuSecurityAttrs *at
 static void
 fu_linux_tainted_plugin_init(FuLinuxTaintedPlugin *self)
 {
+	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE);
 }
 
 static void
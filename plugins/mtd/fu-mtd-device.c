@@ -6,6 +6,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #ifdef HAVE_MTD_USER_H
 #include <mtd/mtd-user.h>
 #endif
@@ -18,12 +20,17 @@ struct _FuMtdDevice {
 	guint64 erasesize;
 	guint64 metadata_offset;
 	guint64 metadata_size;
+	guint erase_blocks_total;
+	guint erase_blocks_written;
+	guint write_duration; /* ms */
 };
 
 G_DEFINE_TYPE(FuMtdDevice, fu_mtd_device, FU_TYPE_UDEV_DEVICE)
 
 #define FU_MTD_DEVICE_IOCTL_TIMEOUT 5000 /* ms */
 
+#define FU_MTD_DEVICE_FLAG_INCREMENTAL "incremental"
+
 static void
 fu_mtd_device_to_string(FuDevice *device, guint idt, GString *str)
 {
@@ -31,6 +38,9 @@ fu_mtd_device_to_string(FuDevice *device, guint idt, GString *str)
 	fwupd_codec_string_append_hex(str, idt, "EraseSize", self->erasesize);
 	fwupd_codec_string_append_hex(str, idt, "MetadataOffset", self->metadata_offset);
 	fwupd_codec_string_append_hex(str, idt, "MetadataSize", self->metadata_size);
+	fwupd_codec_string_append_int(str, idt, "EraseBlocksTotal", self->erase_blocks_total);
+	fwupd_codec_string_append_int(str, idt, "EraseBlocksWritten", self->erase_blocks_written);
+	fwupd_codec_string_append_int(str, idt, "WriteDuration", self->write_duration);
 }
 
 static FuFirmware *
@@ -276,9 +286,39 @@ fu_mtd_device_probe(FuDevice *device, GError **error)
 }
 
 static gboolean
-fu_mtd_device_erase(FuMtdDevice *self, GInputStream *stream, FuProgress *progress, GError **error)
+fu_mtd_device_erase_chunk(FuMtdDevice *self, FuChunk *chk, GError **error)
 {
 #ifdef HAVE_MTD_USER_H
+	struct erase_info_user erase = {
+	    .start = fu_chunk_get_address(chk),
+	    .length = fu_chunk_get_data_sz(chk),
+	};
+	if (!fu_udev_device_ioctl(FU_UDEV_DEVICE(self),
+				  2,
+				  (guint8 *)&erase,
+				  sizeof(erase),
+				  NULL,
+				  FU_MTD_DEVICE_IOCTL_TIMEOUT,
+				  FU_UDEV_DEVICE_IOCTL_FLAG_NONE,
+				  error)) {
+		g_prefix_error(error, "failed to erase @0x%x: ", (guint)erase.start);
+		return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+#else
+	g_set_error_literal(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "Not supported as mtd-user.h is unavailable");
+	return FALSE;
+#endif
+}
+
+static gboolean
+fu_mtd_device_erase(FuMtdDevice *self, GInputStream *stream, FuProgress *progress, GError **error)
+{
 	g_autoptr(FuChunkArray) chunks = NULL;
 
 	chunks = fu_chunk_array_new_from_stream(stream, 0x0, self->erasesize, error);
@@ -291,38 +331,19 @@ fu_mtd_device_erase(FuMtdDevice *self, GInputStream *stream, FuProgress *progres
 
 	/* erase each chunk */
 	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
-		struct erase_info_user erase = {0x0};
 		g_autoptr(FuChunk) chk = NULL;
 
 		/* prepare chunk */
 		chk = fu_chunk_array_index(chunks, i, error);
 		if (chk == NULL)
 			return FALSE;
-		erase.start = fu_chunk_get_address(chk);
-		erase.length = fu_chunk_get_data_sz(chk);
-		if (!fu_udev_device_ioctl(FU_UDEV_DEVICE(self),
-					  2,
-					  (guint8 *)&erase,
-					  sizeof(erase),
-					  NULL,
-					  FU_MTD_DEVICE_IOCTL_TIMEOUT,
-					  FU_UDEV_DEVICE_IOCTL_FLAG_NONE,
-					  error)) {
-			g_prefix_error(error, "failed to erase @0x%x: ", (guint)erase.start);
+		if (!fu_mtd_device_erase_chunk(self, chk, error))
 			return FALSE;
-		}
 		fu_progress_step_done(progress);
 	}
 
 	/* success */
 	return TRUE;
-#else
-	g_set_error_literal(error,
-			    FWUPD_ERROR,
-			    FWUPD_ERROR_NOT_SUPPORTED,
-			    "Not supported as mtd-user.h is unavailable");
-	return FALSE;
-#endif
 }
 
 static gboolean
@@ -363,6 +384,32 @@ fu_mtd_device_write(FuMtdDevice *self, FuChunkArray *chunks, FuProgress *progres
 	return TRUE;
 }
 
+static gboolean
+fu_mtd_device_verify_chunk(FuMtdDevice *self, FuChunk *chk, GError **error)
+{
+	g_autofree guint8 *buf = g_malloc0(fu_chunk_get_data_sz(chk));
+	g_autoptr(GBytes) blob1 = NULL;
+	g_autoptr(GBytes) blob2 = NULL;
+
+	if (!fu_udev_device_pread(FU_UDEV_DEVICE(self),
+				  fu_chunk_get_address(chk),
+				  buf,
+				  fu_chunk_get_data_sz(chk),
+				  error)) {
+		g_prefix_error(error, "failed to read @0x%x: ", (guint)fu_chunk_get_address(chk));
+		return FALSE;
+	}
+	blob1 = fu_chunk_get_bytes(chk);
+	blob2 = g_bytes_new_static(buf, fu_chunk_get_data_sz(chk));
+	if (!fu_bytes_compare(blob1, blob2, error)) {
+		g_prefix_error(error, "failed to verify @0x%x: ", (guint)fu_chunk_get_address(chk));
+		return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+}
+
 static gboolean
 fu_mtd_device_verify(FuMtdDevice *self, FuChunkArray *chunks, FuProgress *progress, GError **error)
 {
@@ -372,34 +419,14 @@ fu_mtd_device_verify(FuMtdDevice *self, FuChunkArray *chunks, FuProgress *progre
 
 	/* verify each chunk */
 	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
-		g_autofree guint8 *buf = NULL;
 		g_autoptr(FuChunk) chk = NULL;
-		g_autoptr(GBytes) blob1 = NULL;
-		g_autoptr(GBytes) blob2 = NULL;
 
 		/* prepare chunk */
 		chk = fu_chunk_array_index(chunks, i, error);
 		if (chk == NULL)
 			return FALSE;
-		buf = g_malloc0(fu_chunk_get_data_sz(chk));
-		if (!fu_udev_device_pread(FU_UDEV_DEVICE(self),
-					  fu_chunk_get_address(chk),
-					  buf,
-					  fu_chunk_get_data_sz(chk),
-					  error)) {
-			g_prefix_error(error,
-				       "failed to read @0x%x: ",
-				       (guint)fu_chunk_get_address(chk));
-			return FALSE;
-		}
-		blob1 = fu_chunk_get_bytes(chk);
-		blob2 = g_bytes_new_static(buf, fu_chunk_get_data_sz(chk));
-		if (!fu_bytes_compare(blob1, blob2, error)) {
-			g_prefix_error(error,
-				       "failed to verify @0x%x: ",
-				       (guint)fu_chunk_get_address(chk));
+		if (!fu_mtd_device_verify_chunk(self, chk, error))
 			return FALSE;
-		}
 		fu_progress_step_done(progress);
 	}
 
@@ -439,6 +466,74 @@ fu_mtd_device_write_verify(FuMtdDevice *self,
 	return TRUE;
 }
 
+/* only erase, write and verify the erase blocks that are different */
+static gboolean
+fu_mtd_device_write_incremental(FuMtdDevice *self,
+				GInputStream *stream,
+				FuProgress *progress,
+				GError **error)
+{
+	g_autoptr(FuChunkArray) chunks = NULL;
+
+	chunks = fu_chunk_array_new_from_stream(stream, 0x0, self->erasesize, error);
+	if (chunks == NULL)
+		return FALSE;
+
+	/* progress */
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_set_steps(progress, fu_chunk_array_length(chunks));
+
+	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
+		g_autofree guint8 *buf = NULL;
+		g_autoptr(FuChunk) chk = NULL;
+
+		/* compare with the current contents */
+		chk = fu_chunk_array_index(chunks, i, error);
+		if (chk == NULL)
+			return FALSE;
+		buf = g_malloc0(fu_chunk_get_data_sz(chk));
+		if (!fu_udev_device_pread(FU_UDEV_DEVICE(self),
+					  fu_chunk_get_address(chk),
+					  buf,
+					  fu_chunk_get_data_sz(chk),
+					  error)) {
+			g_prefix_error(error,
+				       "failed to read @0x%x: ",
+				       (guint)fu_chunk_get_address(chk));
+			return FALSE;
+		}
+		self->erase_blocks_total++;
+		if (memcmp(buf, fu_chunk_get_data(chk), fu_chunk_get_data_sz(chk)) == 0) {
+			fu_progress_step_done(progress);
+			continue;
+		}
+
+		/* different */
+		fu_progress_set_status(progress, FWUPD_STATUS_DEVICE_ERASE);
+		if (!fu_mtd_device_erase_chunk(self, chk, error))
+			return FALSE;
+		fu_progress_set_status(progress, FWUPD_STATUS_DEVICE_WRITE);
+		if (!fu_udev_device_pwrite(FU_UDEV_DEVICE(self),
+					   fu_chunk_get_address(chk),
+					   fu_chunk_get_data(chk),
+					   fu_chunk_get_data_sz(chk),
+					   error)) {
+			g_prefix_error(error,
+				       "failed to write @0x%x: ",
+				       (guint)fu_chunk_get_address(chk));
+			return FALSE;
+		}
+		fu_progress_set_status(progress, FWUPD_STATUS_DEVICE_VERIFY);
+		if (!fu_mtd_device_verify_chunk(self, chk, error))
+			return FALSE;
+		self->erase_blocks_written++;
+		fu_progress_step_done(progress);
+	}
+
+	/* success */
+	return TRUE;
+}
+
 static GBytes *
 fu_mtd_device_dump_firmware(FuDevice *device, FuProgress *progress, GError **error)
 {
@@ -504,6 +599,21 @@ fu_mtd_device_write_firmware(FuDevice *device,
 	if (self->erasesize == 0)
 		return fu_mtd_device_write_verify(self, stream, progress, error);
 
+	/* skip any erase blocks that are unchanged */
+	if (fu_device_has_private_flag(device, FU_MTD_DEVICE_FLAG_INCREMENTAL)) {
+		g_autoptr(GTimer) timer = g_timer_new();
+		self->erase_blocks_total = 0;
+		self->erase_blocks_written = 0;
+		if (!fu_mtd_device_write_incremental(self, stream, progress, error))
+			return FALSE;
+		self->write_duration = g_timer_elapsed(timer, NULL) * 1000.f;
+		g_info("erased and wrote %u of %u blocks in %ums",
+		       self->erase_blocks_written,
+		       self->erase_blocks_total,
+		       self->write_duration);
+		return TRUE;
+	}
+
 	/* progress */
 	fu_progress_set_id(progress, G_STRLOC);
 	fu_progress_add_flag(progress, FU_PROGRESS_FLAG_GUESSED);
@@ -524,6 +634,25 @@ fu_mtd_device_write_firmware(FuDevice *device,
 	return TRUE;
 }
 
+static void
+fu_mtd_device_report_metadata_post(FuDevice *device, GHashTable *metadata)
+{
+	FuMtdDevice *self = FU_MTD_DEVICE(device);
+
+	/* only set when using an incremental write */
+	if (self->erase_blocks_total == 0)
+		return;
+	g_hash_table_insert(metadata,
+			    g_strdup("MtdEraseBlocksTotal"),
+			    g_strdup_printf("%u", self->erase_blocks_total));
+	g_hash_table_insert(metadata,
+			    g_strdup("MtdEraseBlocksWritten"),
+			    g_strdup_printf("%u", self->erase_blocks_written));
+	g_hash_table_insert(metadata,
+			    g_strdup("MtdWriteDuration"),
+			    g_strdup_printf("%u", self->write_duration));
+}
+
 static gboolean
 fu_mtd_device_set_quirk_kv(FuDevice *device, const gchar *key, const gchar *value, GError **error)
 {
@@ -568,6 +697,7 @@ fu_mtd_device_init(FuMtdDevice *self)
 	fu_device_add_icon(FU_DEVICE(self), "drive-harddisk-solidstate");
 	fu_udev_device_add_open_flag(FU_UDEV_DEVICE(self), FU_IO_CHANNEL_OPEN_FLAG_READ);
 	fu_udev_device_add_open_flag(FU_UDEV_DEVICE(self), FU_IO_CHANNEL_OPEN_FLAG_SYNC);
+	fu_device_register_private_flag(FU_DEVICE(self), FU_MTD_DEVICE_FLAG_INCREMENTAL);
 }
 
 static void
@@ -582,4 +712,5 @@ fu_mtd_device_class_init(FuMtdDeviceClass *klass)
 	device_class->read_firmware = fu_mtd_device_read_firmware;
 	device_class->write_firmware = fu_mtd_device_write_firmware;
 	device_class->set_quirk_kv = fu_mtd_device_set_quirk_kv;
+	device_class->report_metadata_post = fu_mtd_device_report_metadata_post;
 }
@@ -21,9 +21,15 @@ fu_test_mtd_device_func(void)
 	g_autoptr(FuProgress) progress = fu_progress_new(NULL);
 	g_autoptr(GByteArray) buf = g_byte_array_new();
 	g_autoptr(GBytes) fw2 = NULL;
+	g_autoptr(GBytes) fw3 = NULL;
+	g_autoptr(GBytes) fw4 = NULL;
 	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) metadata = NULL;
+	g_autoptr(GHashTable) metadata2 = NULL;
 	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GInputStream) stream3 = NULL;
+	g_autoptr(GInputStream) stream5 = NULL;
 	g_autoptr(GRand) rand = g_rand_new_with_seed(0);
 	g_autoptr(GUdevClient) udev_client = g_udev_client_new(NULL);
 	g_autoptr(GUdevDevice) udev_device = NULL;
@@ -93,6 +99,36 @@ fu_test_mtd_device_func(void)
 	ret = fu_bytes_compare(fw, fw2, &error);
 	g_assert_no_error(error);
 	g_assert_true(ret);
+
+	/* change one byte and only write what changed */
+	buf->data[0x1234] ^= 0xFF;
+	fw3 = g_bytes_new(buf->data, buf->len);
+	stream3 = g_memory_input_stream_new_from_bytes(fw3);
+	fu_device_add_private_flag(device, "incremental");
+	fu_progress_reset(progress);
+	ret = fu_device_write_firmware(device, stream3, progress, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_progress_reset(progress);
+	fw4 = fu_device_dump_firmware(device, progress, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(fw4);
+	ret = fu_bytes_compare(fw3, fw4, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	metadata = fu_device_report_metadata_post(device);
+	g_assert_nonnull(metadata);
+	g_assert_cmpstr(g_hash_table_lookup(metadata, "MtdEraseBlocksWritten"), ==, "1");
+
+	/* write the same image again, which should not need any erase blocks writing */
+	stream5 = g_memory_input_stream_new_from_bytes(fw3);
+	fu_progress_reset(progress);
+	ret = fu_device_write_firmware(device, stream5, progress, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	metadata2 = fu_device_report_metadata_post(device);
+	g_assert_nonnull(metadata2);
+	g_assert_cmpstr(g_hash_table_lookup(metadata2, "MtdEraseBlocksWritten"), ==, "0");
 #else
 	g_test_skip("no GUdev support");
 #endif
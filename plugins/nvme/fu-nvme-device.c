@@ -7,17 +7,28 @@
 #include "config.h"
 
 #include <linux/nvme_ioctl.h>
+#include <stdlib.h>
 #include <sys/ioctl.h>
+#include <unistd.h>
 
 #include "fu-nvme-common.h"
 #include "fu-nvme-device.h"
 
 #define FU_NVME_ID_CTRL_SIZE 0x1000
 
+/* the smallest memory page size a controller can use, used as the MDTS unit */
+#define FU_NVME_PAGE_SIZE_MIN 0x1000
+
+/* larger transfers do not make the update noticeably faster, and some kernels limit
+ * the passthrough transfer size to this when using the default PRP list */
+#define FU_NVME_DEVICE_WRITE_BLOCK_SIZE_MAX 0x20000
+
 struct _FuNvmeDevice {
 	FuUdevDevice parent_instance;
 	guint pci_depth;
-	guint64 write_block_size;
+	guint64 write_block_size;  /* from the NvmeBlockSize quirk */
+	guint8 fwug;		   /* firmware update granularity, in 4KiB units */
+	guint64 max_transfer_size; /* from MDTS, or 0 if unlimited */
 };
 
 #define FU_NVME_COMMIT_ACTION_CA0 0b000 /* replace only */
@@ -37,6 +48,40 @@ fu_nvme_device_to_string(FuDevice *device, guint idt, GString *str)
 {
 	FuNvmeDevice *self = FU_NVME_DEVICE(device);
 	fwupd_codec_string_append_int(str, idt, "PciDepth", self->pci_depth);
+	fwupd_codec_string_append_hex(str, idt, "WriteBlockSize", self->write_block_size);
+	fwupd_codec_string_append_hex(str, idt, "Fwug", self->fwug);
+	fwupd_codec_string_append_hex(str, idt, "MaxTransferSize", self->max_transfer_size);
+}
+
+/* the largest multiple of the update granularity that fits in one data transfer */
+guint64
+fu_nvme_device_get_write_block_size(FuNvmeDevice *self)
+{
+	guint64 block_size;
+	guint64 granularity = 0x1000;
+
+	g_return_val_if_fail(FU_IS_NVME_DEVICE(self), 0);
+
+	/* set from a quirk */
+	if (self->write_block_size > 0)
+		return self->write_block_size;
+
+	/* 0x00 is no information provided, and 0xff is no restriction */
+	if (self->fwug != 0x00 && self->fwug != 0xff)
+		granularity = ((guint64)self->fwug) * 0x1000;
+
+	/* the image is padded to the block size for force-align devices, and without any
+	 * granularity information it is not safe to assume larger blocks will be accepted */
+	if (fu_device_has_private_flag(FU_DEVICE(self), FU_NVME_DEVICE_FLAG_FORCE_ALIGN) ||
+	    self->fwug == 0x00)
+		return granularity;
+
+	/* as many granularity-sized blocks as fit in one transfer */
+	block_size = FU_NVME_DEVICE_WRITE_BLOCK_SIZE_MAX;
+	if (self->max_transfer_size > 0)
+		block_size = MIN(block_size, self->max_transfer_size);
+	block_size -= block_size % granularity;
+	return MAX(block_size, granularity);
 }
 
 /* @addr_start and @addr_end are *inclusive* to match the NMVe specification */
@@ -196,7 +241,7 @@ static gboolean
 fu_nvme_device_parse_cns(FuNvmeDevice *self, const guint8 *buf, gsize sz, GError **error)
 {
 	guint8 fawr;
-	guint8 fwug;
+	guint8 mdts;
 	guint8 nfws;
 	guint8 s1ro;
 	g_autofree gchar *gu = NULL;
@@ -226,10 +271,13 @@ fu_nvme_device_parse_cns(FuNvmeDevice *self, const guint8 *buf, gsize sz, GError
 	if (sr != NULL)
 		fu_device_set_version(FU_DEVICE(self), sr);
 
+	/* maximum data transfer size (MDTS), in units of the minimum page size */
+	mdts = buf[77];
+	if (mdts != 0x00 && mdts < 32)
+		self->max_transfer_size = ((guint64)FU_NVME_PAGE_SIZE_MIN) << mdts;
+
 	/* firmware update granularity (FWUG) */
-	fwug = buf[319];
-	if (fwug != 0x00 && fwug != 0xff)
-		self->write_block_size = ((guint64)fwug) * 0x1000;
+	self->fwug = buf[319];
 
 	/* firmware slot information */
 	fawr = (buf[260] & 0x10) >> 4;
@@ -350,11 +398,14 @@ fu_nvme_device_write_firmware(FuDevice *device,
 			      GError **error)
 {
 	FuNvmeDevice *self = FU_NVME_DEVICE(device);
+	const guint8 *buf;
+	gsize bufsz = 0;
+	gint rc;
+	guint64 block_size = fu_nvme_device_get_write_block_size(self);
+	guint8 commit_action = FU_NVME_COMMIT_ACTION_CA1;
+	g_autofree guint8 *dmabuf = NULL;
 	g_autoptr(GBytes) fw2 = NULL;
 	g_autoptr(GBytes) fw = NULL;
-	g_autoptr(FuChunkArray) chunks = NULL;
-	guint64 block_size = self->write_block_size > 0 ? self->write_block_size : 0x1000;
-	guint8 commit_action = FU_NVME_COMMIT_ACTION_CA1;
 
 	/* progress */
 	fu_progress_set_id(progress, G_STRLOC);
@@ -375,26 +426,32 @@ fu_nvme_device_write_firmware(FuDevice *device,
 		fw2 = g_bytes_ref(fw);
 	}
 
-	/* write each block */
-	chunks = fu_chunk_array_new_from_bytes(fw2, 0x00, block_size);
-	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
-		g_autoptr(FuChunk) chk = NULL;
+	/* use the same page-aligned buffer for every block so the kernel can map it directly
+	 * rather than allocating and copying to a bounce buffer for each command */
+	rc = posix_memalign((void **)&dmabuf, sysconf(_SC_PAGESIZE), block_size);
+	if (rc != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "failed to allocate 0x%x bytes: %s",
+			    (guint)block_size,
+			    g_strerror(rc));
+		return FALSE;
+	}
 
-		/* prepare chunk */
-		chk = fu_chunk_array_index(chunks, i, error);
-		if (chk == NULL)
-			return FALSE;
-		if (!fu_nvme_device_fw_download(self,
-						fu_chunk_get_address(chk),
-						fu_chunk_get_data(chk),
-						fu_chunk_get_data_sz(chk),
-						error)) {
-			g_prefix_error(error, "failed to write chunk %u: ", i);
+	/* write each block, where progress is only emitted when the percentage changes */
+	buf = g_bytes_get_data(fw2, &bufsz);
+	g_debug("writing 0x%x bytes using blocks of 0x%x", (guint)bufsz, (guint)block_size);
+	for (gsize offset = 0; offset < bufsz; offset += block_size) {
+		gsize data_sz = MIN(block_size, bufsz - offset);
+		memcpy(dmabuf, buf + offset, data_sz);
+		if (!fu_nvme_device_fw_download(self, offset, dmabuf, data_sz, error)) {
+			g_prefix_error(error, "failed to write block at 0x%x: ", (guint)offset);
 			return FALSE;
 		}
 		fu_progress_set_percentage_full(fu_progress_get_child(progress),
-						(gsize)i + 1,
-						(gsize)fu_chunk_array_length(chunks));
+						offset + data_sz,
+						bufsz);
 	}
 	fu_progress_step_done(progress);
 
@@ -13,3 +13,5 @@ G_DECLARE_FINAL_TYPE(FuNvmeDevice, fu_nvme_device, FU, NVME_DEVICE, FuUdevDevice
 
 FuNvmeDevice *
 fu_nvme_device_new_from_blob(FuContext *ctx, const guint8 *buf, gsize sz, GError **error);
+guint64
+fu_nvme_device_get_write_block_size(FuNvmeDevice *self);
@@ -6,6 +6,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "fu-context-private.h"
 #include "fu-device-private.h"
 #include "fu-nvme-device.h"
@@ -47,6 +49,60 @@ fu_nvme_cns_func(void)
 			"e1409b09-50cf-5aef-8ad8-760b9022f88d");
 }
 
+static void
+fu_nvme_write_block_size_func(void)
+{
+	guint8 buf[0x1000] = {0x0};
+	g_autoptr(FuContext) ctx = fu_context_new();
+	g_autoptr(GError) error = NULL;
+
+	/* model number */
+	memcpy(buf + 24, "FWUPD", 5);
+
+	/* no granularity provided */
+	{
+		g_autoptr(FuNvmeDevice) dev = NULL;
+		buf[77] = 5;
+		dev = fu_nvme_device_new_from_blob(ctx, buf, sizeof(buf), &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(dev);
+		g_assert_cmpint(fu_nvme_device_get_write_block_size(dev), ==, 0x1000);
+	}
+
+	/* limited by MDTS, rounded down to the granularity */
+	{
+		g_autoptr(FuNvmeDevice) dev = NULL;
+		buf[77] = 4;
+		buf[319] = 0x03;
+		dev = fu_nvme_device_new_from_blob(ctx, buf, sizeof(buf), &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(dev);
+		g_assert_cmpint(fu_nvme_device_get_write_block_size(dev), ==, 0xf000);
+	}
+
+	/* limited by MDTS, which is already a multiple of the granularity */
+	{
+		g_autoptr(FuNvmeDevice) dev = NULL;
+		buf[77] = 4;
+		buf[319] = 0x04;
+		dev = fu_nvme_device_new_from_blob(ctx, buf, sizeof(buf), &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(dev);
+		g_assert_cmpint(fu_nvme_device_get_write_block_size(dev), ==, 0x10000);
+	}
+
+	/* no restriction, and no MDTS limit */
+	{
+		g_autoptr(FuNvmeDevice) dev = NULL;
+		buf[77] = 0;
+		buf[319] = 0xff;
+		dev = fu_nvme_device_new_from_blob(ctx, buf, sizeof(buf), &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(dev);
+		g_assert_cmpint(fu_nvme_device_get_write_block_size(dev), ==, 0x20000);
+	}
+}
+
 static void
 fu_nvme_cns_all_func(void)
 {
@@ -101,5 +157,6 @@ main(int argc, char **argv)
 	/* tests go here */
 	g_test_add_func("/fwupd/cns", fu_nvme_cns_func);
 	g_test_add_func("/fwupd/cns{all}", fu_nvme_cns_all_func);
+	g_test_add_func("/fwupd/write-block-size", fu_nvme_write_block_size_func);
 	return g_test_run();
 }
@@ -377,10 +377,26 @@ fu_test_plugin_composite_cleanup(FuPlugin *plugin, GPtrArray *devices, GError **
 	return TRUE;
 }
 
+static void
+fu_test_plugin_add_security_attrs(FuPlugin *plugin, FuSecurityAttrs *attrs)
+{
+	const gchar *result = fu_plugin_get_config_value(plugin, "SecurityAttrResult");
+	g_autoptr(FwupdSecurityAttr) attr = NULL;
+
+	/* only used by the self tests */
+	if (result == NULL || result[0] == '\0')
+		return;
+	attr = fu_plugin_security_attr_new(plugin, FWUPD_SECURITY_ATTR_ID_ENCRYPTED_RAM);
+	fwupd_security_attr_set_result(attr, fwupd_security_attr_result_from_string(result));
+	fu_security_attrs_append(attrs, attr);
+}
+
 static void
 fu_test_plugin_init(FuTestPlugin *self)
 {
 	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_TEST_ONLY);
+	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL);
+	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE);
 }
 
 static void
@@ -395,6 +411,7 @@ fu_test_plugin_constructed(GObject *obj)
 	fu_plugin_set_config_default(plugin, "RegistrationSupported", "false");
 	fu_plugin_set_config_default(plugin, "RequestDelay", "10"); /* ms */
 	fu_plugin_set_config_default(plugin, "RequestSupported", "false");
+	fu_plugin_set_config_default(plugin, "SecurityAttrResult", "");
 	fu_plugin_set_config_default(plugin, "VerifyDelay", "0");
 	fu_plugin_set_config_default(plugin, "WriteDelay", "0");
 	fu_plugin_set_config_default(plugin, "WriteSupported", "true");
@@ -424,4 +441,5 @@ fu_test_plugin_class_init(FuTestPluginClass *klass)
 	plugin_class->coldplug = fu_test_plugin_coldplug;
 	plugin_class->device_registered = fu_test_plugin_device_registered;
 	plugin_class->modify_config = fu_test_plugin_modify_config;
+	plugin_class->add_security_attrs = fu_test_plugin_add_security_attrs;
 }
@@ -155,6 +155,121 @@ fu_tpm_eventlog_parse_v1_func(void)
 	g_assert_cmpstr(tmp, ==, "543ae96e57b6fc4003531cd0dab1d9ba7f8166e0");
 }
 
+/* the per-PCR replay from before all PCRs were extended in one pass, without locality */
+static gchar *
+fu_tpm_eventlog_calc_checksum_reference(GPtrArray *items, guint8 pcr, GChecksumType kind)
+{
+	guint cnt = 0;
+	gsize digestsz = g_checksum_type_get_length(kind);
+	g_autofree guint8 *digest = g_malloc0(digestsz);
+	g_autoptr(GBytes) blob_digest = NULL;
+
+	for (guint i = 0; i < items->len; i++) {
+		FuTpmEventlogItem *item = g_ptr_array_index(items, i);
+		GBytes *blob = NULL;
+		g_autoptr(GChecksum) csum = g_checksum_new(kind);
+
+		if (item->pcr != pcr)
+			continue;
+		if (kind == G_CHECKSUM_SHA1)
+			blob = item->checksum_sha1;
+		else if (kind == G_CHECKSUM_SHA256)
+			blob = item->checksum_sha256;
+		else if (kind == G_CHECKSUM_SHA384)
+			blob = item->checksum_sha384;
+		if (blob == NULL)
+			continue;
+		g_checksum_update(csum, digest, digestsz);
+		g_checksum_update(csum, g_bytes_get_data(blob, NULL), g_bytes_get_size(blob));
+		g_checksum_get_digest(csum, digest, &digestsz);
+		cnt++;
+	}
+	if (cnt == 0)
+		return NULL;
+	blob_digest = g_bytes_new(digest, digestsz);
+	return fu_tpm_eventlog_strhex(blob_digest);
+}
+
+static void
+fu_tpm_eventlog_replay_item_free(FuTpmEventlogItem *item)
+{
+	if (item->checksum_sha1 != NULL)
+		g_bytes_unref(item->checksum_sha1);
+	if (item->checksum_sha256 != NULL)
+		g_bytes_unref(item->checksum_sha256);
+	g_free(item);
+}
+
+static GBytes *
+fu_tpm_eventlog_replay_digest_new(guint8 value, gsize digestsz)
+{
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+	fu_byte_array_set_size(buf, digestsz, value);
+	return g_byte_array_free_to_bytes(g_steal_pointer(&buf)); /* nocheck */
+}
+
+static void
+fu_tpm_eventlog_replay_func(void)
+{
+	g_autoptr(FuTpmEventlogReplay) replay = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) pcr0s = NULL;
+	g_autoptr(GPtrArray) pcr7s = NULL;
+	g_autoptr(GPtrArray) items =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_tpm_eventlog_replay_item_free);
+	const struct {
+		guint8 pcr;
+		guint8 sha1; /* digest filled with this value, or 0x0 for none */
+		guint8 sha256;
+	} events[] = {
+	    {0, 0x10, 0x20},
+	    {7, 0x11, 0x21},
+	    {7, 0x12, 0x22},
+	    {0, 0x00, 0x23},
+	    {7, 0x00, 0x24},
+	};
+
+	/* interleave the PCRs, and leave the SHA1 bank out of some events */
+	for (guint i = 0; i < G_N_ELEMENTS(events); i++) {
+		FuTpmEventlogItem *item = g_new0(FuTpmEventlogItem, 1);
+		item->pcr = events[i].pcr;
+		item->kind = FU_TPM_EVENTLOG_ITEM_KIND_EV_EFI_VARIABLE_DRIVER_CONFIG;
+		if (events[i].sha1 != 0x0) {
+			item->checksum_sha1 =
+			    fu_tpm_eventlog_replay_digest_new(events[i].sha1,
+							      TPM2_SHA1_DIGEST_SIZE);
+		}
+		item->checksum_sha256 =
+		    fu_tpm_eventlog_replay_digest_new(events[i].sha256, TPM2_SHA256_DIGEST_SIZE);
+		g_ptr_array_add(items, item);
+	}
+
+	/* digests from the old per-PCR replay */
+	replay = fu_tpm_eventlog_replay_new(items, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(replay);
+	pcr0s = fu_tpm_eventlog_replay_get_checksums(replay, 0, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(pcr0s);
+	g_assert_cmpint(pcr0s->len, ==, 2);
+	g_assert_cmpstr(g_ptr_array_index(pcr0s, 0), ==, "e0b1e69aa052e9b0a77d685f9288ef8162a6e9c2");
+	g_assert_cmpstr(g_ptr_array_index(pcr0s, 1),
+			==,
+			"a9060dc06a8b08cfd5e33b6b079bb24883064851e033f0b75fbd9c4b93e18329");
+	pcr7s = fu_tpm_eventlog_replay_get_checksums(replay, 7, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(pcr7s);
+	g_assert_cmpint(pcr7s->len, ==, 2);
+	g_assert_cmpstr(g_ptr_array_index(pcr7s, 0), ==, "be06881b8c8c0d81698775c2023bb0171ddb3f19");
+	g_assert_cmpstr(g_ptr_array_index(pcr7s, 1),
+			==,
+			"b7e118845f0613d33577c98a122f6f93390c7fd4f3f79ae9bec7f1235be68cda");
+
+	/* nothing was measured */
+	g_assert_null(fu_tpm_eventlog_replay_get_checksums(replay, 1, &error));
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA);
+}
+
 static void
 fu_tpm_eventlog_parse_v2_func(void)
 {
@@ -165,8 +280,11 @@ fu_tpm_eventlog_parse_v2_func(void)
 	g_autofree gchar *fn = NULL;
 	g_autofree guint8 *buf = NULL;
 	g_autoptr(GPtrArray) items = NULL;
+	g_autoptr(FuTpmEventlogReplay) replay = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) pcr0s = NULL;
+	g_autoptr(GPtrArray) pcr0s_replay = NULL;
+	g_autoptr(GPtrArray) pcr7s = NULL;
 
 	fn = g_test_build_filename(G_TEST_DIST, "tests", "binary_bios_measurements-v2", NULL);
 	if (!g_file_test(fn, G_FILE_TEST_EXISTS) && ci == NULL) {
@@ -191,6 +309,32 @@ fu_tpm_eventlog_parse_v2_func(void)
 	g_assert_cmpstr(tmp,
 			==,
 			"6d9fed68092cfb91c9552bcb7879e75e1df36efd407af67690dc3389a5722fab");
+
+	/* all PCRs in one pass */
+	replay = fu_tpm_eventlog_replay_new(items, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(replay);
+	pcr0s_replay = fu_tpm_eventlog_replay_get_checksums(replay, 0, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(pcr0s_replay);
+	g_assert_cmpint(pcr0s_replay->len, ==, pcr0s->len);
+	for (guint i = 0; i < pcr0s->len; i++) {
+		g_assert_cmpstr(g_ptr_array_index(pcr0s_replay, i),
+				==,
+				g_ptr_array_index(pcr0s, i));
+	}
+	g_assert_null(fu_tpm_eventlog_replay_get_checksums(replay, FU_TPM_EVENTLOG_PCR_MAX, NULL));
+
+	/* PCR7 matches the old per-PCR replay in every bank */
+	pcr7s = fu_tpm_eventlog_replay_get_checksums(replay, 7, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(pcr7s);
+	g_assert_cmpint(pcr7s->len, ==, 2);
+	for (guint i = 0; i < pcr7s->len; i++) {
+		GChecksumType kind = i == 0 ? G_CHECKSUM_SHA1 : G_CHECKSUM_SHA256;
+		g_autofree gchar *csum = fu_tpm_eventlog_calc_checksum_reference(items, 7, kind);
+		g_assert_cmpstr(g_ptr_array_index(pcr7s, i), ==, csum);
+	}
 }
 
 static void
@@ -263,5 +407,6 @@ main(int argc, char **argv)
 	g_test_add_func("/tpm/empty-pcr", fu_tpm_empty_pcr_func);
 	g_test_add_func("/tpm/eventlog-parse{v1}", fu_tpm_eventlog_parse_v1_func);
 	g_test_add_func("/tpm/eventlog-parse{v2}", fu_tpm_eventlog_parse_v2_func);
+	g_test_add_func("/tpm/eventlog-replay", fu_tpm_eventlog_replay_func);
 	return g_test_run();
 }
@@ -75,19 +75,33 @@ fu_tpm_eventlog_blobstr(GBytes *blob)
 			       g_bytes_get_size(blob));
 }
 
-GPtrArray *
-fu_tpm_eventlog_calc_checksums(GPtrArray *items, guint8 pcr, GError **error)
+/* take existing PCR hash, append new measurement to that, hash that with the same algorithm */
+static void
+fu_tpm_eventlog_replay_extend(GChecksum *csum, guint8 *digest, gsize digestsz, GBytes *blob)
 {
-	guint cnt_sha1 = 0;
-	guint cnt_sha256 = 0;
-	guint cnt_sha384 = 0;
-	guint8 digest_sha1[TPM2_SHA1_DIGEST_SIZE] = {0x0};
-	guint8 digest_sha256[TPM2_SHA256_DIGEST_SIZE] = {0x0};
-	guint8 digest_sha384[TPM2_SHA384_DIGEST_SIZE] = {0x0};
-	gsize digest_sha1_len = sizeof(digest_sha1);
-	gsize digest_sha256_len = sizeof(digest_sha256);
-	gsize digest_sha384_len = sizeof(digest_sha384);
-	g_autoptr(GPtrArray) csums = g_ptr_array_new_with_free_func(g_free);
+	gsize digest_len = digestsz;
+	g_checksum_reset(csum);
+	g_checksum_update(csum, (const guchar *)digest, digestsz);
+	g_checksum_update(csum,
+			  (const guchar *)g_bytes_get_data(blob, NULL),
+			  g_bytes_get_size(blob));
+	g_checksum_get_digest(csum, digest, &digest_len);
+}
+
+void
+fu_tpm_eventlog_replay_free(FuTpmEventlogReplay *self)
+{
+	g_free(self);
+}
+
+/* walks the event log once, extending every PCR in every bank */
+FuTpmEventlogReplay *
+fu_tpm_eventlog_replay_new(GPtrArray *items, GError **error)
+{
+	g_autoptr(FuTpmEventlogReplay) self = g_new0(FuTpmEventlogReplay, 1);
+	g_autoptr(GChecksum) csum_sha1 = g_checksum_new(G_CHECKSUM_SHA1);
+	g_autoptr(GChecksum) csum_sha256 = g_checksum_new(G_CHECKSUM_SHA256);
+	g_autoptr(GChecksum) csum_sha384 = g_checksum_new(G_CHECKSUM_SHA384);
 
 	/* sanity check */
 	if (items->len == 0) {
@@ -98,15 +112,17 @@ fu_tpm_eventlog_calc_checksums(GPtrArray *items, guint8 pcr, GError **error)
 		return NULL;
 	}
 
-	/* take existing PCR hash, append new measurement to that,
-	 * hash that with the same algorithm */
 	for (guint i = 0; i < items->len; i++) {
 		FuTpmEventlogItem *item = g_ptr_array_index(items, i);
-		if (item->pcr != pcr)
+		guint8 pcr = item->pcr;
+
+		if (pcr >= FU_TPM_EVENTLOG_PCR_MAX) {
+			g_debug("ignoring event for invalid PCR %u", pcr);
 			continue;
+		}
 
 		/* if TXT is enabled then the first event for PCR0 should be a StartupLocality */
-		if (item->kind == FU_TPM_EVENTLOG_ITEM_KIND_EV_NO_ACTION && item->pcr == 0 &&
+		if (item->kind == FU_TPM_EVENTLOG_ITEM_KIND_EV_NO_ACTION && pcr == 0 &&
 		    item->blob != NULL && i == 0) {
 			g_autoptr(GByteArray) st_loc = NULL;
 			st_loc = fu_struct_tpm_efi_startup_locality_event_parse_bytes(item->blob,
@@ -115,69 +131,84 @@ fu_tpm_eventlog_calc_checksums(GPtrArray *items, guint8 pcr, GError **error)
 			if (st_loc != NULL) {
 				guint8 locality =
 				    fu_struct_tpm_efi_startup_locality_event_get_locality(st_loc);
-				digest_sha384[TPM2_SHA384_DIGEST_SIZE - 1] = locality;
-				digest_sha256[TPM2_SHA256_DIGEST_SIZE - 1] = locality;
-				digest_sha1[TPM2_SHA1_DIGEST_SIZE - 1] = locality;
+				self->sha384[pcr][TPM2_SHA384_DIGEST_SIZE - 1] = locality;
+				self->sha256[pcr][TPM2_SHA256_DIGEST_SIZE - 1] = locality;
+				self->sha1[pcr][TPM2_SHA1_DIGEST_SIZE - 1] = locality;
 				continue;
 			}
 		}
 
 		if (item->checksum_sha1 != NULL) {
-			g_autoptr(GChecksum) csum_sha1 = g_checksum_new(G_CHECKSUM_SHA1);
-			g_checksum_update(csum_sha1, (const guchar *)digest_sha1, digest_sha1_len);
-			g_checksum_update(
-			    csum_sha1,
-			    (const guchar *)g_bytes_get_data(item->checksum_sha1, NULL),
-			    g_bytes_get_size(item->checksum_sha1));
-			g_checksum_get_digest(csum_sha1, digest_sha1, &digest_sha1_len);
-			cnt_sha1++;
+			fu_tpm_eventlog_replay_extend(csum_sha1,
+						      self->sha1[pcr],
+						      TPM2_SHA1_DIGEST_SIZE,
+						      item->checksum_sha1);
+			self->cnt_sha1[pcr]++;
 		}
 		if (item->checksum_sha256 != NULL) {
-			g_autoptr(GChecksum) csum_sha256 = g_checksum_new(G_CHECKSUM_SHA256);
-			g_checksum_update(csum_sha256,
-					  (const guchar *)digest_sha256,
-					  digest_sha256_len);
-			g_checksum_update(
-			    csum_sha256,
-			    (const guchar *)g_bytes_get_data(item->checksum_sha256, NULL),
-			    g_bytes_get_size(item->checksum_sha256));
-			g_checksum_get_digest(csum_sha256, digest_sha256, &digest_sha256_len);
-			cnt_sha256++;
+			fu_tpm_eventlog_replay_extend(csum_sha256,
+						      self->sha256[pcr],
+						      TPM2_SHA256_DIGEST_SIZE,
+						      item->checksum_sha256);
+			self->cnt_sha256[pcr]++;
 		}
 		if (item->checksum_sha384 != NULL) {
-			g_autoptr(GChecksum) csum_sha384 = g_checksum_new(G_CHECKSUM_SHA384);
-			g_checksum_update(csum_sha384,
-					  (const guchar *)digest_sha384,
-					  digest_sha384_len);
-			g_checksum_update(
-			    csum_sha384,
-			    (const guchar *)g_bytes_get_data(item->checksum_sha384, NULL),
-			    g_bytes_get_size(item->checksum_sha384));
-			g_checksum_get_digest(csum_sha384, digest_sha384, &digest_sha384_len);
-			cnt_sha384++;
+			fu_tpm_eventlog_replay_extend(csum_sha384,
+						      self->sha384[pcr],
+						      TPM2_SHA384_DIGEST_SIZE,
+						      item->checksum_sha384);
+			self->cnt_sha384[pcr]++;
 		}
 	}
-	if (cnt_sha1 == 0 && cnt_sha256 == 0 && cnt_sha384 == 0) {
+
+	/* success */
+	return g_steal_pointer(&self);
+}
+
+GPtrArray *
+fu_tpm_eventlog_replay_get_checksums(FuTpmEventlogReplay *self, guint8 pcr, GError **error)
+{
+	g_autoptr(GPtrArray) csums = g_ptr_array_new_with_free_func(g_free);
+
+	if (pcr >= FU_TPM_EVENTLOG_PCR_MAX) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "invalid PCR %u",
+			    pcr);
+		return NULL;
+	}
+	if (self->cnt_sha1[pcr] == 0 && self->cnt_sha256[pcr] == 0 &&
+	    self->cnt_sha384[pcr] == 0) {
 		g_set_error_literal(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INVALID_DATA,
 				    "no SHA1, SHA256, or SHA384 data");
 		return NULL;
 	}
-	if (cnt_sha1 > 0) {
+	if (self->cnt_sha1[pcr] > 0) {
 		g_autoptr(GBytes) blob_sha1 = NULL;
-		blob_sha1 = g_bytes_new_static(digest_sha1, sizeof(digest_sha1));
+		blob_sha1 = g_bytes_new_static(self->sha1[pcr], TPM2_SHA1_DIGEST_SIZE);
 		g_ptr_array_add(csums, fu_tpm_eventlog_strhex(blob_sha1));
 	}
-	if (cnt_sha256 > 0) {
+	if (self->cnt_sha256[pcr] > 0) {
 		g_autoptr(GBytes) blob_sha256 = NULL;
-		blob_sha256 = g_bytes_new_static(digest_sha256, sizeof(digest_sha256));
+		blob_sha256 = g_bytes_new_static(self->sha256[pcr], TPM2_SHA256_DIGEST_SIZE);
 		g_ptr_array_add(csums, fu_tpm_eventlog_strhex(blob_sha256));
 	}
-	if (cnt_sha384 > 0) {
+	if (self->cnt_sha384[pcr] > 0) {
 		g_autoptr(GBytes) blob_sha384 = NULL;
-		blob_sha384 = g_bytes_new_static(digest_sha384, sizeof(digest_sha384));
+		blob_sha384 = g_bytes_new_static(self->sha384[pcr], TPM2_SHA384_DIGEST_SIZE);
 		g_ptr_array_add(csums, fu_tpm_eventlog_strhex(blob_sha384));
 	}
 	return g_steal_pointer(&csums);
 }
+
+GPtrArray *
+fu_tpm_eventlog_calc_checksums(GPtrArray *items, guint8 pcr, GError **error)
+{
+	g_autoptr(FuTpmEventlogReplay) replay = fu_tpm_eventlog_replay_new(items, error);
+	if (replay == NULL)
+		return NULL;
+	return fu_tpm_eventlog_replay_get_checksums(replay, pcr, error);
+}
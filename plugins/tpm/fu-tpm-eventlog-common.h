@@ -21,6 +21,17 @@ typedef struct {
 	GBytes *blob;
 } FuTpmEventlogItem;
 
+#define FU_TPM_EVENTLOG_PCR_MAX 24
+
+typedef struct {
+	guint8 sha1[FU_TPM_EVENTLOG_PCR_MAX][TPM2_SHA1_DIGEST_SIZE];
+	guint8 sha256[FU_TPM_EVENTLOG_PCR_MAX][TPM2_SHA256_DIGEST_SIZE];
+	guint8 sha384[FU_TPM_EVENTLOG_PCR_MAX][TPM2_SHA384_DIGEST_SIZE];
+	guint cnt_sha1[FU_TPM_EVENTLOG_PCR_MAX];
+	guint cnt_sha256[FU_TPM_EVENTLOG_PCR_MAX];
+	guint cnt_sha384[FU_TPM_EVENTLOG_PCR_MAX];
+} FuTpmEventlogReplay;
+
 const gchar *
 fu_tpm_eventlog_pcr_to_string(gint pcr);
 guint32
@@ -31,3 +42,11 @@ gchar *
 fu_tpm_eventlog_blobstr(GBytes *blob);
 GPtrArray *
 fu_tpm_eventlog_calc_checksums(GPtrArray *items, guint8 pcr, GError **error);
+FuTpmEventlogReplay *
+fu_tpm_eventlog_replay_new(GPtrArray *items, GError **error);
+GPtrArray *
+fu_tpm_eventlog_replay_get_checksums(FuTpmEventlogReplay *self, guint8 pcr, GError **error);
+void
+fu_tpm_eventlog_replay_free(FuTpmEventlogReplay *self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuTpmEventlogReplay, fu_tpm_eventlog_replay_free)
@@ -35,6 +35,7 @@ fu_tmp_eventlog_process(const gchar *fn, gint pcr, GError **error)
 	g_autofree guint8 *buf = NULL;
 	g_autoptr(GPtrArray) items = NULL;
 	g_autoptr(GString) str = g_string_new(NULL);
+	g_autoptr(FuTpmEventlogReplay) replay = NULL;
 	gint max_pcr = 0;
 
 	/* parse this */
@@ -63,8 +64,9 @@ fu_tmp_eventlog_process(const gchar *fn, gint pcr, GError **error)
 		return FALSE;
 	}
 	fwupd_codec_string_append(str, 0, "Reconstructed PCRs", "");
-	for (guint8 i = 0; i <= max_pcr; i++) {
-		g_autoptr(GPtrArray) pcrs = fu_tpm_eventlog_calc_checksums(items, i, NULL);
+	replay = fu_tpm_eventlog_replay_new(items, NULL);
+	for (guint8 i = 0; replay != NULL && i <= max_pcr; i++) {
+		g_autoptr(GPtrArray) pcrs = fu_tpm_eventlog_replay_get_checksums(replay, i, NULL);
 		if (pcrs == NULL)
 			continue;
 		for (guint j = 0; j < pcrs->len; j++) {
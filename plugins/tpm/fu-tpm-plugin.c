@@ -16,6 +16,7 @@ struct _FuTpmPlugin {
 	FuTpmDevice *tpm_device;
 	FuDevice *bios_device;
 	GPtrArray *ev_items; /* of FuTpmEventlogItem */
+	FuTpmEventlogReplay *ev_replay;
 };
 
 G_DEFINE_TYPE(FuTpmPlugin, fu_tpm_plugin, FU_TYPE_PLUGIN)
@@ -156,8 +157,13 @@ fu_tpm_plugin_add_security_attr_eventlog(FuPlugin *plugin, FuSecurityAttrs *attr
 		return;
 	}
 
-	/* calculate from the eventlog */
-	pcr0s_calc = fu_tpm_eventlog_calc_checksums(self->ev_items, 0, &error);
+	/* calculate from the eventlog, where replay failures were already logged in coldplug */
+	if (self->ev_replay == NULL) {
+		fwupd_security_attr_set_result(attr, FWUPD_SECURITY_ATTR_RESULT_NOT_VALID);
+		fwupd_security_attr_add_flag(attr, FWUPD_SECURITY_ATTR_FLAG_ACTION_CONTACT_OEM);
+		return;
+	}
+	pcr0s_calc = fu_tpm_eventlog_replay_get_checksums(self->ev_replay, 0, &error);
 	if (pcr0s_calc == NULL) {
 		g_warning("failed to get eventlog reconstruction: %s", error->message);
 		fwupd_security_attr_set_result(attr, FWUPD_SECURITY_ATTR_RESULT_NOT_VALID);
@@ -276,7 +282,8 @@ fu_tpm_plugin_eventlog_report_metadata(FuPlugin *plugin)
 			g_string_append_printf(str, " [%s]", blobstr);
 		g_string_append(str, "\n");
 	}
-	pcrs = fu_tpm_eventlog_calc_checksums(self->ev_items, 0, NULL);
+	if (self->ev_replay != NULL)
+		pcrs = fu_tpm_eventlog_replay_get_checksums(self->ev_replay, 0, NULL);
 	if (pcrs != NULL) {
 		for (guint j = 0; j < pcrs->len; j++) {
 			const gchar *csum = g_ptr_array_index(pcrs, j);
@@ -316,6 +323,9 @@ fu_tpm_plugin_coldplug_eventlog(FuPlugin *plugin, GError **error)
 	    fu_tpm_eventlog_parser_new(buf, bufsz, FU_TPM_EVENTLOG_PARSER_FLAG_NONE, error);
 	if (self->ev_items == NULL)
 		return FALSE;
+	self->ev_replay = fu_tpm_eventlog_replay_new(self->ev_items, error);
+	if (self->ev_replay == NULL)
+		return FALSE;
 
 	/* add optional report metadata */
 	str = fu_tpm_plugin_eventlog_report_metadata(plugin);
@@ -385,6 +395,8 @@ fu_tpm_finalize(GObject *obj)
 		g_object_unref(self->bios_device);
 	if (self->ev_items != NULL)
 		g_ptr_array_unref(self->ev_items);
+	if (self->ev_replay != NULL)
+		fu_tpm_eventlog_replay_free(self->ev_replay);
 	G_OBJECT_CLASS(fu_tpm_plugin_parent_class)->finalize(obj);
 }
 
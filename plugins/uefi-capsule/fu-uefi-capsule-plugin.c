@@ -272,7 +272,7 @@ fu_uefi_capsule_plugin_get_splash_data(guint width, guint height, GError **error
 	/* load archive */
 	datadir_pkg = fu_path_from_kind(FU_PATH_KIND_DATADIR_PKG);
 	filename_archive = g_build_filename(datadir_pkg, "uefi-capsule-ux.tar.xz", NULL);
-	stream_archive = fu_input_stream_from_path(filename_archive, error);
+	stream_archive = fu_mapped_input_stream_new_from_path(filename_archive, error);
 	if (stream_archive == NULL)
 		return NULL;
 	archive = fu_archive_new_stream(stream_archive, FU_ARCHIVE_FLAG_NONE, error);
@@ -18,19 +18,73 @@ fu_uefi_dbx_get_authenticode_hash(const gchar *fn, GError **error)
 	return fu_firmware_get_checksum(firmware, G_CHECKSUM_SHA256, error);
 }
 
+/* the Authenticode hash is only computed again if the file size or mtime has changed */
+static gchar *
+fu_uefi_dbx_get_authenticode_hash_cached(GKeyFile *kf, const gchar *fn, GError **error)
+{
+	guint64 mtime;
+	guint64 size;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *key = NULL;
+	g_autofree gchar *key_old = NULL;
+	g_autoptr(GFile) file = g_file_new_for_path(fn);
+	g_autoptr(GFileInfo) info = NULL;
+
+	info = g_file_query_info(file,
+				 G_FILE_ATTRIBUTE_STANDARD_SIZE
+				 "," G_FILE_ATTRIBUTE_TIME_MODIFIED
+				 "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+				 G_FILE_QUERY_INFO_NONE,
+				 NULL,
+				 error);
+	if (info == NULL)
+		return NULL;
+	size = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+	mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * 1000000 +
+		g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+	key = g_strdup_printf("%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT, size, mtime);
+	key_old = g_key_file_get_string(kf, fn, "SizeMtime", NULL);
+	if (g_strcmp0(key_old, key) == 0) {
+		checksum = g_key_file_get_string(kf, fn, "Authenticode", NULL);
+		if (checksum != NULL)
+			return g_steal_pointer(&checksum);
+	}
+
+	/* not cached, or out of date */
+	checksum = fu_uefi_dbx_get_authenticode_hash(fn, error);
+	if (checksum == NULL)
+		return NULL;
+	g_key_file_set_string(kf, fn, "SizeMtime", key);
+	g_key_file_set_string(kf, fn, "Authenticode", checksum);
+	return g_steal_pointer(&checksum);
+}
+
+/* forget about any ESP binaries that have since been deleted */
+static void
+fu_uefi_dbx_authenticode_cache_prune(GKeyFile *kf)
+{
+	g_auto(GStrv) groups = g_key_file_get_groups(kf, NULL);
+	for (guint i = 0; groups[i] != NULL; i++) {
+		if (g_file_test(groups[i], G_FILE_TEST_EXISTS))
+			continue;
+		g_debug("removing %s from cache", groups[i]);
+		g_key_file_remove_group(kf, groups[i], NULL);
+	}
+}
+
 static gboolean
 fu_uefi_dbx_signature_list_validate_filename(FuContext *ctx,
 					     FuEfiSignatureList *siglist,
+					     GKeyFile *kf,
 					     const gchar *fn,
 					     FwupdInstallFlags flags,
 					     GError **error)
 {
 	g_autofree gchar *checksum = NULL;
-	g_autoptr(FuFirmware) img = NULL;
 	g_autoptr(GError) error_local = NULL;
 
 	/* get checksum of file */
-	checksum = fu_uefi_dbx_get_authenticode_hash(fn, &error_local);
+	checksum = fu_uefi_dbx_get_authenticode_hash_cached(kf, fn, &error_local);
 	if (checksum == NULL) {
 		g_debug("failed to get checksum for %s: %s", fn, error_local->message);
 		return TRUE;
@@ -38,8 +92,7 @@ fu_uefi_dbx_signature_list_validate_filename(FuContext *ctx,
 
 	/* Authenticode signature is present in dbx! */
 	g_debug("fn=%s, checksum=%s", fn, checksum);
-	img = fu_firmware_get_image_by_checksum(FU_FIRMWARE(siglist), checksum, NULL);
-	if (img != NULL) {
+	if (fu_efi_signature_list_has_checksum(siglist, checksum, NULL)) {
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_NEEDS_USER_ACTION,
@@ -59,8 +112,20 @@ fu_uefi_dbx_signature_list_validate(FuContext *ctx,
 				    FwupdInstallFlags flags,
 				    GError **error)
 {
+	g_autofree gchar *cachedir = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
+	g_autofree gchar *fn_cache = NULL;
+	g_autoptr(GError) error_cache = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new();
 	g_autoptr(GPtrArray) files = NULL;
 
+	/* hashes of the ESP binaries from the last time we checked */
+	fn_cache = g_build_filename(cachedir, "uefi-dbx", "authenticode.ini", NULL);
+	if (g_file_test(fn_cache, G_FILE_TEST_EXISTS) &&
+	    !g_key_file_load_from_file(kf, fn_cache, G_KEY_FILE_NONE, &error_cache)) {
+		g_debug("ignoring %s: %s", fn_cache, error_cache->message);
+		g_clear_error(&error_cache);
+	}
+
 	files = fu_context_get_esp_files(ctx,
 					 FU_CONTEXT_ESP_FILE_FLAG_INCLUDE_FIRST_STAGE |
 					     FU_CONTEXT_ESP_FILE_FLAG_INCLUDE_SECOND_STAGE,
@@ -72,10 +137,17 @@ fu_uefi_dbx_signature_list_validate(FuContext *ctx,
 		if (!fu_uefi_dbx_signature_list_validate_filename(
 			ctx,
 			siglist,
+			kf,
 			fu_firmware_get_filename(firmware),
 			flags,
 			error))
 			return FALSE;
 	}
+
+	/* not fatal, we just have to compute the hashes again next time */
+	fu_uefi_dbx_authenticode_cache_prune(kf);
+	if (!fu_path_mkdir_parent(fn_cache, &error_cache) ||
+	    !g_key_file_save_to_file(kf, fn_cache, &error_cache))
+		g_debug("failed to save %s: %s", fn_cache, error_cache->message);
 	return TRUE;
 }
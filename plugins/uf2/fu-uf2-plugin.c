@@ -19,6 +19,8 @@ G_DEFINE_TYPE(FuUf2Plugin, fu_uf2_plugin, FU_TYPE_PLUGIN)
 static void
 fu_uf2_plugin_init(FuUf2Plugin *self)
 {
+	/* write-firmware only copies a file onto the device volume */
+	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL);
 }
 
 static void
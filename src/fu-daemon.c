@@ -208,8 +208,11 @@ fu_daemon_setup(FuDaemon *self, const gchar *socket_address, GError **error)
 	/* a good place to do the traceback */
 	if (fu_progress_get_profile(progress)) {
 		g_autofree gchar *str = fu_progress_traceback(progress);
+		g_autofree gchar *str_quirks =
+		    fu_context_get_quirks_profile(fu_engine_get_context(engine));
 		if (str != NULL)
 			g_print("\n%s\n", str);
+		g_print("%s\n", str_quirks);
 	}
 
 	/* success */
@@ -47,6 +47,9 @@ struct _FuDbusDaemon {
 	guint percentage;   /* last emitted */
 	guint owner_id;
 	GPtrArray *system_inhibits;
+	GPtrArray *device_changed_pending; /* (element-type FuDevice), emitted on idle */
+	guint device_changed_id;
+	GHashTable *device_changed_last; /* (element-type str GVariant), last a{sv} emitted */
 };
 
 G_DEFINE_TYPE(FuDbusDaemon, fu_dbus_daemon, FU_TYPE_DAEMON)
@@ -73,6 +76,93 @@ fu_dbus_daemon_engine_changed_cb(FuEngine *engine, FuDbusDaemon *self)
 	fu_daemon_schedule_housekeeping(FU_DAEMON(self));
 }
 
+static void
+fu_dbus_daemon_emit_device_changed_delta(FuDbusDaemon *self,
+					 const gchar *device_id,
+					 GVariant *val_old,
+					 GVariant *val_new)
+{
+	GVariantBuilder builder;
+	GVariantBuilder removed_builder;
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_init(&removed_builder, G_VARIANT_TYPE("as"));
+	if (fwupd_device_variant_diff(val_old, val_new, &builder, &removed_builder)) {
+		g_dbus_connection_emit_signal(
+		    self->connection,
+		    NULL,
+		    FWUPD_DBUS_PATH,
+		    FWUPD_DBUS_INTERFACE,
+		    "DeviceChangedDelta",
+		    g_variant_new("(sa{sv}as)", device_id, &builder, &removed_builder),
+		    NULL);
+	}
+	g_variant_builder_clear(&builder);
+	g_variant_builder_clear(&removed_builder);
+}
+
+/* DeviceChanged is always emitted for listeners that have not opted in, and the bus only sends
+ * DeviceChangedDelta or DeviceChanged to the clients that subscribed to that signal */
+static gboolean
+fu_dbus_daemon_device_changed_delta_wanted(FuDbusDaemon *self)
+{
+	g_autoptr(GPtrArray) clients = fu_client_list_get_all(self->client_list);
+	for (guint i = 0; i < clients->len; i++) {
+		FuClient *client = g_ptr_array_index(clients, i);
+		if (fu_client_get_feature_flags(client) & FWUPD_FEATURE_FLAG_DEVICE_CHANGED_DELTA)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+fu_dbus_daemon_device_changed_flush(FuDbusDaemon *self)
+{
+	gboolean emit_delta;
+
+	if (self->device_changed_id != 0) {
+		g_source_remove(self->device_changed_id);
+		self->device_changed_id = 0;
+	}
+	if (self->device_changed_pending->len == 0)
+		return;
+
+	emit_delta = fu_dbus_daemon_device_changed_delta_wanted(self);
+	for (guint i = 0; i < self->device_changed_pending->len; i++) {
+		FuDevice *device = g_ptr_array_index(self->device_changed_pending, i);
+		const gchar *device_id = fu_device_get_id(device);
+		GVariant *val;
+
+		val = g_variant_ref_sink(
+		    fwupd_codec_to_variant(FWUPD_CODEC(device), FWUPD_CODEC_FLAG_NONE));
+		if (emit_delta) {
+			fu_dbus_daemon_emit_device_changed_delta(
+			    self,
+			    device_id,
+			    g_hash_table_lookup(self->device_changed_last, device_id),
+			    val);
+		}
+		g_dbus_connection_emit_signal(self->connection,
+					      NULL,
+					      FWUPD_DBUS_PATH,
+					      FWUPD_DBUS_INTERFACE,
+					      "DeviceChanged",
+					      g_variant_new_tuple(&val, 1),
+					      NULL);
+		g_hash_table_insert(self->device_changed_last, g_strdup(device_id), val);
+	}
+	g_ptr_array_set_size(self->device_changed_pending, 0);
+}
+
+static gboolean
+fu_dbus_daemon_device_changed_idle_cb(gpointer user_data)
+{
+	FuDbusDaemon *self = FU_DBUS_DAEMON(user_data);
+	self->device_changed_id = 0;
+	fu_dbus_daemon_device_changed_flush(self);
+	return G_SOURCE_REMOVE;
+}
+
 static void
 fu_dbus_daemon_engine_device_added_cb(FuEngine *engine, FuDevice *device, FuDbusDaemon *self)
 {
@@ -81,7 +171,12 @@ fu_dbus_daemon_engine_device_added_cb(FuEngine *engine, FuDevice *device, FuDbus
 	/* not yet connected */
 	if (self->connection == NULL)
 		return;
-	val = fwupd_codec_to_variant(FWUPD_CODEC(device), FWUPD_CODEC_FLAG_NONE);
+
+	/* keep the signals in order */
+	fu_dbus_daemon_device_changed_flush(self);
+
+	val = g_variant_ref_sink(
+	    fwupd_codec_to_variant(FWUPD_CODEC(device), FWUPD_CODEC_FLAG_NONE));
 	g_dbus_connection_emit_signal(self->connection,
 				      NULL,
 				      FWUPD_DBUS_PATH,
@@ -89,6 +184,7 @@ fu_dbus_daemon_engine_device_added_cb(FuEngine *engine, FuDevice *device, FuDbus
 				      "DeviceAdded",
 				      g_variant_new_tuple(&val, 1),
 				      NULL);
+	g_hash_table_insert(self->device_changed_last, g_strdup(fu_device_get_id(device)), val);
 	fu_daemon_schedule_housekeeping(FU_DAEMON(self));
 }
 
@@ -100,6 +196,11 @@ fu_dbus_daemon_engine_device_removed_cb(FuEngine *engine, FuDevice *device, FuDb
 	/* not yet connected */
 	if (self->connection == NULL)
 		return;
+
+	/* keep the signals in order */
+	fu_dbus_daemon_device_changed_flush(self);
+	g_hash_table_remove(self->device_changed_last, fu_device_get_id(device));
+
 	val = fwupd_codec_to_variant(FWUPD_CODEC(device), FWUPD_CODEC_FLAG_NONE);
 	g_dbus_connection_emit_signal(self->connection,
 				      NULL,
@@ -114,19 +215,23 @@ fu_dbus_daemon_engine_device_removed_cb(FuEngine *engine, FuDevice *device, FuDb
 static void
 fu_dbus_daemon_engine_device_changed_cb(FuEngine *engine, FuDevice *device, FuDbusDaemon *self)
 {
-	GVariant *val;
-
 	/* not yet connected */
 	if (self->connection == NULL)
 		return;
-	val = fwupd_codec_to_variant(FWUPD_CODEC(device), FWUPD_CODEC_FLAG_NONE);
-	g_dbus_connection_emit_signal(self->connection,
-				      NULL,
-				      FWUPD_DBUS_PATH,
-				      FWUPD_DBUS_INTERFACE,
-				      "DeviceChanged",
-				      g_variant_new_tuple(&val, 1),
-				      NULL);
+
+	/* the status and percentage can change many times before the client can process them */
+	for (guint i = 0; i < self->device_changed_pending->len; i++) {
+		FuDevice *device_tmp = g_ptr_array_index(self->device_changed_pending, i);
+		if (g_strcmp0(fu_device_get_id(device_tmp), fu_device_get_id(device)) == 0) {
+			g_ptr_array_index(self->device_changed_pending, i) = g_object_ref(device);
+			g_object_unref(device_tmp);
+			break;
+		}
+	}
+	if (!g_ptr_array_find(self->device_changed_pending, device, NULL))
+		g_ptr_array_add(self->device_changed_pending, g_object_ref(device));
+	if (self->device_changed_id == 0)
+		self->device_changed_id = g_idle_add(fu_dbus_daemon_device_changed_idle_cb, self);
 	fu_daemon_schedule_housekeeping(FU_DAEMON(self));
 }
 
@@ -1046,6 +1151,7 @@ fu_dbus_daemon_invocation_get_stream(GDBusMethodInvocation *invocation, GError *
 	GUnixFDList *fd_list;
 	gint fd;
 	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GError) error_local = NULL;
 
 	/* get the fd */
 	message = g_dbus_method_invocation_get_message(invocation);
@@ -1058,6 +1164,14 @@ fu_dbus_daemon_invocation_get_stream(GDBusMethodInvocation *invocation, GError *
 	if (fd < 0)
 		return NULL;
 
+	/* a sealed memfd cannot be truncated or modified by the client, so it is safe to map */
+	stream = fu_mapped_input_stream_new_from_fd(fd, &error_local);
+	if (stream != NULL) {
+		g_close(fd, NULL);
+		return g_steal_pointer(&stream);
+	}
+	g_debug("cannot map fd, so reading: %s", error_local->message);
+
 	/* get details about the file (will close the fd when done) */
 	stream = fu_unix_seekable_input_stream_new(fd, TRUE);
 	if (stream == NULL) {
@@ -1366,6 +1480,18 @@ fu_dbus_daemon_daemon_method_call(GDBusConnection *connection,
 		g_dbus_method_invocation_return_value(invocation, val);
 		return;
 	}
+	if (g_strcmp0(method_name, "GetUpgradesForAll") == 0) {
+		g_autoptr(GPtrArray) devices = NULL;
+		g_debug("Called %s()", method_name);
+		devices = fu_engine_get_upgrades_all(engine, request, &error);
+		if (devices == NULL) {
+			fu_dbus_daemon_method_invocation_return_gerror(invocation, error);
+			return;
+		}
+		val = fwupd_codec_array_to_variant(devices, FWUPD_CODEC_FLAG_NONE);
+		g_dbus_method_invocation_return_value(invocation, val);
+		return;
+	}
 	if (g_strcmp0(method_name, "GetRemotes") == 0) {
 		g_autoptr(GPtrArray) remotes = NULL;
 		g_debug("Called %s()", method_name);
@@ -2439,6 +2565,9 @@ fu_dbus_daemon_init(FuDbusDaemon *self)
 	self->status = FWUPD_STATUS_IDLE;
 	self->system_inhibits =
 	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_dbus_daemon_system_inhibit_free);
+	self->device_changed_pending = g_ptr_array_new_with_free_func(g_object_unref);
+	self->device_changed_last =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
 }
 
 static void
@@ -2446,6 +2575,10 @@ fu_dbus_daemon_finalize(GObject *obj)
 {
 	FuDbusDaemon *self = FU_DBUS_DAEMON(obj);
 
+	if (self->device_changed_id != 0)
+		g_source_remove(self->device_changed_id);
+	g_ptr_array_unref(self->device_changed_pending);
+	g_hash_table_unref(self->device_changed_last);
 	g_ptr_array_unref(self->system_inhibits);
 	if (self->client_list != NULL)
 		g_object_unref(self->client_list);
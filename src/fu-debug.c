@@ -286,6 +286,12 @@ fu_debug_post_parse_hook(GOptionContext *context,
 	if (self->log_level == G_LOG_LEVEL_DEBUG)
 		(void)g_setenv("FWUPD_VERBOSE", "1", FALSE);
 
+	/* so that fu_dump_is_enabled() builds the debug strings for these domains */
+	if (self->daemon_verbose != NULL) {
+		g_autofree gchar *domains = g_strjoinv(" ", self->daemon_verbose);
+		(void)g_setenv("G_MESSAGES_DEBUG", domains, FALSE);
+	}
+
 	/* redirect all domains */
 	g_log_set_default_handler(fu_debug_handler_cb, self);
 
@@ -12,6 +12,7 @@
 
 #include "fu-device-list.h"
 #include "fu-device-private.h"
+#include "fu-dump.h"
 #include "fu-engine.h"
 
 /**
@@ -30,10 +31,23 @@
 static void
 fu_device_list_finalize(GObject *obj);
 
+/* abbreviated device IDs shorter than this are matched with a linear search */
+#define FU_DEVICE_LIST_ID_PREFIX_LEN 4
+
+typedef struct {
+	GHashTable *device;	/* FuDevice (no ref) : GPtrArray of FuDeviceItem */
+	GHashTable *guid;	/* utf8 : GPtrArray of FuDeviceItem */
+	GHashTable *connection; /* utf8 : GPtrArray of FuDeviceItem */
+	GHashTable *id_prefix;	/* utf8 : GPtrArray of FuDeviceItem */
+} FuDeviceListIndex;
+
 struct _FuDeviceList {
 	GObject parent_instance;
 	GPtrArray *devices; /* of FuDeviceItem */
 	GRWLock devices_mutex;
+	guint64 item_seq;
+	FuDeviceListIndex index;     /* of item->device */
+	FuDeviceListIndex index_old; /* of item->device_old */
 };
 
 enum { SIGNAL_ADDED, SIGNAL_REMOVED, SIGNAL_CHANGED, SIGNAL_LAST };
@@ -45,8 +59,22 @@ typedef struct {
 	FuDevice *device_old;
 	FuDeviceList *self; /* no ref */
 	guint remove_id;
+	guint64 seq;		      /* insertion order */
+	GPtrArray *index_keys;	      /* of FuDeviceListIndexKey */
+	FuDevice *indexed_device;     /* ref */
+	FuDevice *indexed_device_old; /* ref */
+	gulong indexed_device_notify_id;
+	gulong indexed_device_guid_id;
+	gulong indexed_device_old_notify_id;
+	gulong indexed_device_old_guid_id;
 } FuDeviceItem;
 
+typedef struct {
+	GHashTable *table; /* no ref */
+	gpointer key;
+	gboolean key_is_str;
+} FuDeviceListIndexKey;
+
 static void
 fu_device_list_codec_iface_init(FwupdCodecInterface *iface);
 
@@ -77,6 +105,216 @@ fu_device_list_emit_device_changed(FuDeviceList *self, FuDevice *device)
 	g_signal_emit(self, signals[SIGNAL_CHANGED], 0, device);
 }
 
+static void
+fu_device_list_index_key_free(FuDeviceListIndexKey *ikey)
+{
+	if (ikey->key_is_str)
+		g_free(ikey->key);
+	g_free(ikey);
+}
+
+static GHashTable *
+fu_device_list_index_table_new(GHashFunc hash_func,
+			       GEqualFunc key_equal_func,
+			       GDestroyNotify key_free)
+{
+	return g_hash_table_new_full(hash_func,
+				     key_equal_func,
+				     key_free,
+				     (GDestroyNotify)g_ptr_array_unref);
+}
+
+static void
+fu_device_list_index_init(FuDeviceListIndex *index)
+{
+	index->device = fu_device_list_index_table_new(g_direct_hash, g_direct_equal, NULL);
+	index->guid = fu_device_list_index_table_new(g_str_hash, g_str_equal, g_free);
+	index->connection = fu_device_list_index_table_new(g_str_hash, g_str_equal, g_free);
+	index->id_prefix = fu_device_list_index_table_new(g_str_hash, g_str_equal, g_free);
+}
+
+static void
+fu_device_list_index_clear(FuDeviceListIndex *index)
+{
+	g_hash_table_unref(index->device);
+	g_hash_table_unref(index->guid);
+	g_hash_table_unref(index->connection);
+	g_hash_table_unref(index->id_prefix);
+}
+
+/* any candidates returned by the index always have to be verified by the caller */
+static GPtrArray *
+fu_device_list_index_lookup(GHashTable *table, gconstpointer key)
+{
+	return g_hash_table_lookup(table, key);
+}
+
+static gchar *
+fu_device_list_build_connection_key(const gchar *physical_id, const gchar *logical_id)
+{
+	if (logical_id == NULL)
+		return g_strdup(physical_id);
+	return g_strdup_printf("%s\n%s", physical_id, logical_id);
+}
+
+/* devices_mutex must be held for writing */
+static void
+fu_device_list_item_index_insert(FuDeviceItem *item,
+				 GHashTable *table,
+				 gconstpointer key,
+				 gboolean key_is_str)
+{
+	GPtrArray *items = g_hash_table_lookup(table, key);
+	FuDeviceListIndexKey *ikey;
+
+	if (items == NULL) {
+		items = g_ptr_array_new();
+		g_hash_table_insert(table,
+				    key_is_str ? g_strdup(key) : (gpointer)key,
+				    items);
+	} else if (g_ptr_array_find(items, item, NULL)) {
+		return;
+	}
+	g_ptr_array_add(items, item);
+
+	/* so we can remove it again if the device changes */
+	ikey = g_new0(FuDeviceListIndexKey, 1);
+	ikey->table = table;
+	ikey->key = key_is_str ? g_strdup(key) : (gpointer)key;
+	ikey->key_is_str = key_is_str;
+	g_ptr_array_add(item->index_keys, ikey);
+}
+
+/* devices_mutex must be held for writing */
+static void
+fu_device_list_item_index_device(FuDeviceItem *item, FuDeviceListIndex *index, FuDevice *device)
+{
+	GPtrArray *guids = fu_device_get_guids(device);
+	const gchar *physical_id = fu_device_get_physical_id(device);
+	const gchar *ids[] = {fu_device_get_id(device), fu_device_get_equivalent_id(device)};
+
+	fu_device_list_item_index_insert(item, index->device, device, FALSE);
+	for (guint i = 0; i < guids->len; i++) {
+		const gchar *guid = g_ptr_array_index(guids, i);
+		fu_device_list_item_index_insert(item, index->guid, guid, TRUE);
+	}
+	if (physical_id != NULL) {
+		g_autofree gchar *key =
+		    fu_device_list_build_connection_key(physical_id,
+							fu_device_get_logical_id(device));
+		fu_device_list_item_index_insert(item, index->connection, key, TRUE);
+	}
+	for (guint i = 0; i < G_N_ELEMENTS(ids); i++) {
+		g_autofree gchar *key = NULL;
+		if (ids[i] == NULL)
+			continue;
+		key = g_strndup(ids[i], FU_DEVICE_LIST_ID_PREFIX_LEN);
+		fu_device_list_item_index_insert(item, index->id_prefix, key, TRUE);
+	}
+}
+
+/* devices_mutex must be held for writing */
+static void
+fu_device_list_item_unindex(FuDeviceItem *item)
+{
+	for (guint i = 0; i < item->index_keys->len; i++) {
+		FuDeviceListIndexKey *ikey = g_ptr_array_index(item->index_keys, i);
+		GPtrArray *items = g_hash_table_lookup(ikey->table, ikey->key);
+		if (items == NULL)
+			continue;
+		g_ptr_array_remove_fast(items, item);
+		if (items->len == 0)
+			g_hash_table_remove(ikey->table, ikey->key);
+	}
+	g_ptr_array_set_size(item->index_keys, 0);
+}
+
+static void
+fu_device_list_item_notify_cb(FuDevice *device, GParamSpec *pspec, gpointer user_data);
+static void
+fu_device_list_item_guid_added_cb(FuDevice *device, const gchar *guid, gpointer user_data);
+
+/* track the properties used as index keys, without touching the signal handlers if the
+ * device has not changed as we might be called from inside the ::notify emission */
+static void
+fu_device_list_item_watch_device(FuDeviceItem *item,
+				 FuDevice **indexed_device,
+				 gulong *notify_id,
+				 gulong *guid_id,
+				 FuDevice *device)
+{
+	if (*indexed_device == device)
+		return;
+	if (*indexed_device != NULL) {
+		g_signal_handler_disconnect(*indexed_device, *notify_id);
+		g_signal_handler_disconnect(*indexed_device, *guid_id);
+		*notify_id = 0;
+		*guid_id = 0;
+		g_clear_object(indexed_device);
+	}
+	if (device != NULL) {
+		*indexed_device = g_object_ref(device);
+		*notify_id = g_signal_connect(FU_DEVICE(device),
+					      "notify",
+					      G_CALLBACK(fu_device_list_item_notify_cb),
+					      item);
+		*guid_id = g_signal_connect(FU_DEVICE(device),
+					    "guid-added",
+					    G_CALLBACK(fu_device_list_item_guid_added_cb),
+					    item);
+	}
+}
+
+/* devices_mutex must be held for writing */
+static void
+fu_device_list_item_reindex(FuDeviceItem *item)
+{
+	FuDeviceList *self = item->self;
+
+	fu_device_list_item_unindex(item);
+	if (item->device != NULL)
+		fu_device_list_item_index_device(item, &self->index, item->device);
+	if (item->device_old != NULL)
+		fu_device_list_item_index_device(item, &self->index_old, item->device_old);
+	fu_device_list_item_watch_device(item,
+					 &item->indexed_device,
+					 &item->indexed_device_notify_id,
+					 &item->indexed_device_guid_id,
+					 item->device);
+	fu_device_list_item_watch_device(item,
+					 &item->indexed_device_old,
+					 &item->indexed_device_old_notify_id,
+					 &item->indexed_device_old_guid_id,
+					 item->device_old);
+}
+
+static void
+fu_device_list_item_notify_cb(FuDevice *device, GParamSpec *pspec, gpointer user_data)
+{
+	FuDeviceItem *item = (FuDeviceItem *)user_data;
+	FuDeviceList *self = item->self;
+	const gchar *name = g_param_spec_get_name(pspec);
+
+	if (g_strcmp0(name, "id") != 0 && g_strcmp0(name, "equivalent-id") != 0 &&
+	    g_strcmp0(name, "physical-id") != 0 && g_strcmp0(name, "logical-id") != 0)
+		return;
+	g_rw_lock_writer_lock(&self->devices_mutex);
+	fu_device_list_item_reindex(item);
+	g_rw_lock_writer_unlock(&self->devices_mutex);
+}
+
+static void
+fu_device_list_item_guid_added_cb(FuDevice *device, const gchar *guid, gpointer user_data)
+{
+	FuDeviceItem *item = (FuDeviceItem *)user_data;
+	FuDeviceList *self = item->self;
+	FuDeviceListIndex *index = device == item->device ? &self->index : &self->index_old;
+
+	g_rw_lock_writer_lock(&self->devices_mutex);
+	fu_device_list_item_index_insert(item, index->guid, guid, TRUE);
+	g_rw_lock_writer_unlock(&self->devices_mutex);
+}
+
 static void
 fu_device_list_add_string(FwupdCodec *codec, guint idt, GString *str)
 {
@@ -236,39 +474,57 @@ fu_device_list_get_active(FuDeviceList *self)
 static FuDeviceItem *
 fu_device_list_find_by_device(FuDeviceList *self, FuDevice *device)
 {
+	FuDeviceItem *item = NULL;
+	GPtrArray *items;
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new(&self->devices_mutex);
 	g_return_val_if_fail(locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index(self->devices, i);
-		if (item->device == device)
-			return item;
+	items = fu_device_list_index_lookup(self->index.device, device);
+	for (guint i = 0; items != NULL && i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
+		if (item_tmp->device != device)
+			continue;
+		if (item == NULL || item_tmp->seq < item->seq)
+			item = item_tmp;
 	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index(self->devices, i);
-		if (item->device_old == device)
-			return item;
+	if (item != NULL)
+		return item;
+	items = fu_device_list_index_lookup(self->index_old.device, device);
+	for (guint i = 0; items != NULL && i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
+		if (item_tmp->device_old != device)
+			continue;
+		if (item == NULL || item_tmp->seq < item->seq)
+			item = item_tmp;
 	}
-	return NULL;
+	return item;
 }
 
 static FuDeviceItem *
 fu_device_list_find_by_guid(FuDeviceList *self, const gchar *guid)
 {
+	FuDeviceItem *item = NULL;
+	GPtrArray *items;
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new(&self->devices_mutex);
 	g_return_val_if_fail(locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index(self->devices, i);
-		if (fu_device_has_guid(item->device, guid))
-			return item;
+	items = fu_device_list_index_lookup(self->index.guid, guid);
+	for (guint i = 0; items != NULL && i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
+		if (!fu_device_has_guid(item_tmp->device, guid))
+			continue;
+		if (item == NULL || item_tmp->seq < item->seq)
+			item = item_tmp;
 	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index(self->devices, i);
-		if (item->device_old == NULL)
+	if (item != NULL)
+		return item;
+	items = fu_device_list_index_lookup(self->index_old.guid, guid);
+	for (guint i = 0; items != NULL && i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
+		if (item_tmp->device_old == NULL || !fu_device_has_guid(item_tmp->device_old, guid))
 			continue;
-		if (fu_device_has_guid(item->device_old, guid))
-			return item;
+		if (item == NULL || item_tmp->seq < item->seq)
+			item = item_tmp;
 	}
-	return NULL;
+	return item;
 }
 
 static FuDeviceItem *
@@ -276,35 +532,49 @@ fu_device_list_find_by_connection(FuDeviceList *self,
 				  const gchar *physical_id,
 				  const gchar *logical_id)
 {
+	FuDeviceItem *item = NULL;
+	GPtrArray *items;
+	g_autofree gchar *key = NULL;
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 	if (physical_id == NULL)
 		return NULL;
+	key = fu_device_list_build_connection_key(physical_id, logical_id);
 	locker = g_rw_lock_reader_locker_new(&self->devices_mutex);
 	g_return_val_if_fail(locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index(self->devices, i);
+	items = fu_device_list_index_lookup(self->index.connection, key);
+	for (guint i = 0; items != NULL && i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
 		FuDevice *device = item_tmp->device;
 		if (device != NULL &&
 		    g_strcmp0(fu_device_get_physical_id(device), physical_id) == 0 &&
-		    g_strcmp0(fu_device_get_logical_id(device), logical_id) == 0)
-			return item_tmp;
+		    g_strcmp0(fu_device_get_logical_id(device), logical_id) == 0) {
+			if (item == NULL || item_tmp->seq < item->seq)
+				item = item_tmp;
+		}
 	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index(self->devices, i);
+	if (item != NULL)
+		return item;
+	items = fu_device_list_index_lookup(self->index_old.connection, key);
+	for (guint i = 0; items != NULL && i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
 		FuDevice *device = item_tmp->device_old;
 		if (device != NULL &&
 		    g_strcmp0(fu_device_get_physical_id(device), physical_id) == 0 &&
-		    g_strcmp0(fu_device_get_logical_id(device), logical_id) == 0)
-			return item_tmp;
+		    g_strcmp0(fu_device_get_logical_id(device), logical_id) == 0) {
+			if (item == NULL || item_tmp->seq < item->seq)
+				item = item_tmp;
+		}
 	}
-	return NULL;
+	return item;
 }
 
 static FuDeviceItem *
 fu_device_list_find_by_id(FuDeviceList *self, const gchar *device_id, gboolean *multiple_matches)
 {
 	FuDeviceItem *item = NULL;
+	GPtrArray *items;
 	gsize device_id_len;
+	g_autofree gchar *key = NULL;
 
 	/* sanity check */
 	if (device_id == NULL) {
@@ -312,11 +582,15 @@ fu_device_list_find_by_id(FuDeviceList *self, const gchar *device_id, gboolean *
 		return NULL;
 	}
 
-	/* support abbreviated hashes */
+	/* support abbreviated hashes, using the index when the prefix is long enough */
 	device_id_len = strlen(device_id);
+	if (device_id_len >= FU_DEVICE_LIST_ID_PREFIX_LEN)
+		key = g_strndup(device_id, FU_DEVICE_LIST_ID_PREFIX_LEN);
 	g_rw_lock_reader_lock(&self->devices_mutex);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index(self->devices, i);
+	items = key != NULL ? fu_device_list_index_lookup(self->index.id_prefix, key)
+			    : self->devices;
+	for (guint i = 0; items != NULL && i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
 		const gchar *ids[] = {fu_device_get_id(item_tmp->device),
 				      fu_device_get_equivalent_id(item_tmp->device),
 				      NULL};
@@ -324,7 +598,8 @@ fu_device_list_find_by_id(FuDeviceList *self, const gchar *device_id, gboolean *
 			if (strncmp(ids[j], device_id, device_id_len) == 0) {
 				if (item != NULL && multiple_matches != NULL)
 					*multiple_matches = TRUE;
-				item = item_tmp;
+				if (item == NULL || item_tmp->seq > item->seq)
+					item = item_tmp;
 			}
 		}
 	}
@@ -334,8 +609,10 @@ fu_device_list_find_by_id(FuDeviceList *self, const gchar *device_id, gboolean *
 
 	/* only search old devices if we didn't find the active device */
 	g_rw_lock_reader_lock(&self->devices_mutex);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index(self->devices, i);
+	items = key != NULL ? fu_device_list_index_lookup(self->index_old.id_prefix, key)
+			    : self->devices;
+	for (guint i = 0; items != NULL && i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
 		const gchar *ids[3] = {NULL};
 		if (item_tmp->device_old == NULL)
 			continue;
@@ -345,7 +622,8 @@ fu_device_list_find_by_id(FuDeviceList *self, const gchar *device_id, gboolean *
 			if (strncmp(ids[j], device_id, device_id_len) == 0) {
 				if (item != NULL && multiple_matches != NULL)
 					*multiple_matches = TRUE;
-				item = item_tmp;
+				if (item == NULL || item_tmp->seq > item->seq)
+					item = item_tmp;
 			}
 		}
 	}
@@ -615,8 +893,10 @@ fu_device_list_clear_wait_for_replug(FuDeviceList *self, FuDeviceItem *item)
 	fu_device_remove_private_flag(item->device, FU_DEVICE_PRIVATE_FLAG_UNCONNECTED);
 
 	/* debug */
-	str = fwupd_codec_to_string(FWUPD_CODEC(self));
-	g_debug("\n%s", str);
+	if (fu_dump_is_enabled(G_LOG_DOMAIN)) {
+		str = fwupd_codec_to_string(FWUPD_CODEC(self));
+		g_debug("\n%s", str);
+	}
 }
 
 static void
@@ -729,11 +1009,16 @@ fu_device_list_replace(FuDeviceList *self, FuDeviceItem *item, FuDevice *device)
 	/* assign the new device */
 	g_set_object(&item->device_old, item->device);
 	fu_device_list_item_set_device(item, device);
+	g_rw_lock_writer_lock(&self->devices_mutex);
+	fu_device_list_item_reindex(item);
+	g_rw_lock_writer_unlock(&self->devices_mutex);
 	fu_device_list_emit_device_changed(self, device);
 
 	/* debug */
-	str = fwupd_codec_to_string(FWUPD_CODEC(self));
-	g_debug("\n%s", str);
+	if (fu_dump_is_enabled(G_LOG_DOMAIN)) {
+		str = fwupd_codec_to_string(FWUPD_CODEC(self));
+		g_debug("\n%s", str);
+	}
 
 	/* we were waiting for this... */
 	fu_device_list_clear_wait_for_replug(self, item);
@@ -789,6 +1074,9 @@ fu_device_list_add(FuDeviceList *self, FuDevice *device)
 			fu_device_incorporate_update_state(device, item->device);
 			g_set_object(&item->device_old, item->device);
 			fu_device_list_item_set_device(item, device);
+			g_rw_lock_writer_lock(&self->devices_mutex);
+			fu_device_list_item_reindex(item);
+			g_rw_lock_writer_unlock(&self->devices_mutex);
 			fu_device_list_clear_wait_for_replug(self, item);
 			fu_device_list_emit_device_changed(self, device);
 			return;
@@ -841,9 +1129,13 @@ fu_device_list_add(FuDeviceList *self, FuDevice *device)
 	/* add helper */
 	item = g_new0(FuDeviceItem, 1);
 	item->self = self; /* no ref */
+	item->index_keys =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_device_list_index_key_free);
 	fu_device_list_item_set_device(item, device);
 	g_rw_lock_writer_lock(&self->devices_mutex);
+	item->seq = self->item_seq++;
 	g_ptr_array_add(self->devices, item);
+	fu_device_list_item_reindex(item);
 	g_rw_lock_writer_unlock(&self->devices_mutex);
 	fu_device_list_emit_device_added(self, device);
 }
@@ -953,8 +1245,10 @@ fu_device_list_wait_for_replug(FuDeviceList *self, GError **error)
 		g_autofree gchar *str = NULL;
 
 		/* dump to console */
-		str = fwupd_codec_to_string(FWUPD_CODEC(self));
-		g_debug("\n%s", str);
+		if (fu_dump_is_enabled(G_LOG_DOMAIN)) {
+			str = fwupd_codec_to_string(FWUPD_CODEC(self));
+			g_debug("\n%s", str);
+		}
 
 		/* unset and build error string */
 		for (guint i = 0; i < devices_wfr2->len; i++) {
@@ -1024,14 +1318,27 @@ fu_device_list_get_by_id(FuDeviceList *self, const gchar *device_id, GError **er
 	return g_object_ref(item->device);
 }
 
+/* devices_mutex must be held for writing */
 static void
 fu_device_list_item_free(FuDeviceItem *item)
 {
 	if (item->remove_id != 0)
 		g_source_remove(item->remove_id);
+	fu_device_list_item_unindex(item);
+	fu_device_list_item_watch_device(item,
+					 &item->indexed_device,
+					 &item->indexed_device_notify_id,
+					 &item->indexed_device_guid_id,
+					 NULL);
+	fu_device_list_item_watch_device(item,
+					 &item->indexed_device_old,
+					 &item->indexed_device_old_notify_id,
+					 &item->indexed_device_old_guid_id,
+					 NULL);
 	if (item->device_old != NULL)
 		g_object_unref(item->device_old);
 	fu_device_list_item_set_device(item, NULL);
+	g_ptr_array_unref(item->index_keys);
 	g_free(item);
 }
 
@@ -1116,6 +1423,8 @@ static void
 fu_device_list_init(FuDeviceList *self)
 {
 	self->devices = g_ptr_array_new_with_free_func((GDestroyNotify)fu_device_list_item_free);
+	fu_device_list_index_init(&self->index);
+	fu_device_list_index_init(&self->index_old);
 	g_rw_lock_init(&self->devices_mutex);
 }
 
@@ -1126,6 +1435,8 @@ fu_device_list_finalize(GObject *obj)
 
 	g_rw_lock_clear(&self->devices_mutex);
 	g_ptr_array_unref(self->devices);
+	fu_device_list_index_clear(&self->index);
+	fu_device_list_index_clear(&self->index_old);
 
 	G_OBJECT_CLASS(fu_device_list_parent_class)->finalize(obj);
 }
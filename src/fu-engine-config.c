@@ -237,6 +237,24 @@ fu_engine_config_get_idle_timeout(FuEngineConfig *self)
 	return fu_config_get_value_u64(FU_CONFIG(self), "fwupd", "IdleTimeout");
 }
 
+guint
+fu_engine_config_get_coldplug_threads(FuEngineConfig *self)
+{
+	return fu_config_get_value_u64(FU_CONFIG(self), "fwupd", "ColdplugThreads");
+}
+
+guint
+fu_engine_config_get_devices_file_delay(FuEngineConfig *self)
+{
+	return fu_config_get_value_u64(FU_CONFIG(self), "fwupd", "DevicesFileDelay");
+}
+
+guint
+fu_engine_config_get_install_threads(FuEngineConfig *self)
+{
+	return fu_config_get_value_u64(FU_CONFIG(self), "fwupd", "InstallThreads");
+}
+
 GPtrArray *
 fu_engine_config_get_disabled_devices(FuEngineConfig *self)
 {
@@ -417,6 +435,8 @@ fu_engine_config_init(FuEngineConfig *self)
 	fu_engine_set_config_default(self, "ApprovedFirmware", NULL);
 	fu_engine_set_config_default(self, "ArchiveSizeMax", archive_size_max_default);
 	fu_engine_set_config_default(self, "BlockedFirmware", NULL);
+	fu_engine_set_config_default(self, "ColdplugThreads", "1");
+	fu_engine_set_config_default(self, "DevicesFileDelay", "500"); /* ms */
 	fu_engine_set_config_default(self, "DisabledDevices", NULL);
 	fu_engine_set_config_default(self, "DisabledPlugins", "");
 	fu_engine_set_config_default(self, "EnumerateAllDevices", "false");
@@ -426,6 +446,7 @@ fu_engine_config_init(FuEngineConfig *self)
 	fu_engine_set_config_default(self, "IdleInhibitStartupThreshold", "500"); /* ms */
 	fu_engine_set_config_default(self, "IgnorePower", "false");
 	fu_engine_set_config_default(self, "IgnoreRequirements", "false");
+	fu_engine_set_config_default(self, "InstallThreads", "1");
 	fu_engine_set_config_default(self, "OnlyTrusted", "true");
 	fu_engine_set_config_default(self, "P2pPolicy", FU_DEFAULT_P2P_POLICY);
 	fu_engine_set_config_default(self, "ReleaseDedupe", "true");
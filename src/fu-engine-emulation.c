@@ -0,0 +1,540 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuEngine"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "fu-engine-emulation.h"
+
+/* BASE-64 strings in events longer than this are moved to the binary payload section */
+#define FU_ENGINE_EMULATION_INLINE_MAX 64
+
+typedef gboolean (*FuEngineEmulationEventFunc)(JsonObject *json_event,
+					       const gchar *member_name,
+					       gpointer user_data,
+					       GError **error);
+
+/**
+ * fu_engine_emulation_format_from_stream:
+ * @stream: a #GInputStream
+ *
+ * Detects the emulation archive format. Anything without the binary header is assumed to be a
+ * ZIP archive of JSON files.
+ *
+ * Returns: a #FuEngineEmulationFormat
+ **/
+FuEngineEmulationFormat
+fu_engine_emulation_format_from_stream(GInputStream *stream)
+{
+	if (fu_struct_engine_emulation_hdr_validate_stream(stream, 0x0, NULL))
+		return FU_ENGINE_EMULATION_FORMAT_BINARY;
+	return FU_ENGINE_EMULATION_FORMAT_ZIP;
+}
+
+/**
+ * fu_engine_emulation_map_stream:
+ * @stream: a #GInputStream
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets the entire emulation archive. If @stream is a #FuMappedInputStream, e.g. a sealed memfd
+ * passed to the daemon, then this is a reference to the mapped memory rather than a copy.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for failure
+ **/
+GBytes *
+fu_engine_emulation_map_stream(GInputStream *stream, GError **error)
+{
+	return fu_input_stream_read_bytes_borrowed(stream, 0x0, G_MAXSIZE, error);
+}
+
+static gboolean
+fu_engine_emulation_json_walk_event(JsonObject *json_event,
+				    FuEngineEmulationEventFunc func,
+				    gpointer user_data,
+				    GError **error)
+{
+	g_autoptr(GList) members = json_object_get_members(json_event);
+	for (GList *l = members; l != NULL; l = l->next) {
+		const gchar *member_name = (const gchar *)l->data;
+		if (g_strcmp0(member_name, "Id") == 0)
+			continue;
+		if (!func(json_event, member_name, user_data, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* calls @func for each member of each object in any array called `*Events` */
+static gboolean
+fu_engine_emulation_json_walk(JsonNode *json_node,
+			      const gchar *member_name,
+			      FuEngineEmulationEventFunc func,
+			      gpointer user_data,
+			      GError **error)
+{
+	if (JSON_NODE_HOLDS_ARRAY(json_node)) {
+		JsonArray *json_array = json_node_get_array(json_node);
+		gboolean is_events = member_name != NULL && g_str_has_suffix(member_name, "Events");
+		for (guint i = 0; i < json_array_get_length(json_array); i++) {
+			JsonNode *node_tmp = json_array_get_element(json_array, i);
+			if (is_events && JSON_NODE_HOLDS_OBJECT(node_tmp)) {
+				if (!fu_engine_emulation_json_walk_event(
+					json_node_get_object(node_tmp),
+					func,
+					user_data,
+					error))
+					return FALSE;
+				continue;
+			}
+			if (!fu_engine_emulation_json_walk(node_tmp, NULL, func, user_data, error))
+				return FALSE;
+		}
+		return TRUE;
+	}
+	if (JSON_NODE_HOLDS_OBJECT(json_node)) {
+		JsonObject *json_object = json_node_get_object(json_node);
+		g_autoptr(GList) members = json_object_get_members(json_object);
+		for (GList *l = members; l != NULL; l = l->next) {
+			const gchar *name = (const gchar *)l->data;
+			JsonNode *node_tmp = json_object_get_member(json_object, name);
+			if (!fu_engine_emulation_json_walk(node_tmp, name, func, user_data, error))
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static GBytes *
+fu_engine_emulation_json_transform(GBytes *json_blob,
+				   FuEngineEmulationEventFunc func,
+				   gpointer user_data,
+				   gboolean pretty,
+				   GError **error)
+{
+	gchar *data;
+	gsize datasz = 0;
+	g_autoptr(JsonGenerator) json_generator = json_generator_new();
+	g_autoptr(JsonParser) parser = json_parser_new();
+
+	if (!json_parser_load_from_data(parser,
+					g_bytes_get_data(json_blob, NULL),
+					g_bytes_get_size(json_blob),
+					error))
+		return NULL;
+	if (!fu_engine_emulation_json_walk(json_parser_get_root(parser),
+					   NULL,
+					   func,
+					   user_data,
+					   error))
+		return NULL;
+	json_generator_set_pretty(json_generator, pretty);
+	json_generator_set_root(json_generator, json_parser_get_root(parser));
+	data = json_generator_to_data(json_generator, &datasz);
+	return g_bytes_new_take(data, datasz);
+}
+
+static gboolean
+fu_engine_emulation_json_externalize_cb(JsonObject *json_event,
+					const gchar *member_name,
+					gpointer user_data,
+					GError **error)
+{
+	GByteArray *payload = (GByteArray *)user_data;
+	JsonNode *member_node = json_object_get_member(json_event, member_name);
+	JsonObject *json_ref;
+	const gchar *str;
+	gsize bufsz = 0;
+	g_autofree guchar *buf = NULL;
+	g_autofree gchar *str_roundtrip = NULL;
+
+	if (!JSON_NODE_HOLDS_VALUE(member_node) ||
+	    json_node_get_value_type(member_node) != G_TYPE_STRING)
+		return TRUE;
+	str = json_node_get_string(member_node);
+	if (strlen(str) <= FU_ENGINE_EMULATION_INLINE_MAX)
+		return TRUE;
+
+	/* only if the conversion back to JSON is lossless */
+	buf = g_base64_decode(str, &bufsz);
+	str_roundtrip = g_base64_encode(buf, bufsz);
+	if (g_strcmp0(str, str_roundtrip) != 0)
+		return TRUE;
+
+	json_ref = json_object_new();
+	json_object_set_int_member(json_ref, "Offset", payload->len);
+	json_object_set_int_member(json_ref, "Size", bufsz);
+	json_object_set_object_member(json_event, member_name, json_ref);
+	g_byte_array_append(payload, buf, bufsz);
+	return TRUE;
+}
+
+static gboolean
+fu_engine_emulation_json_inline_cb(JsonObject *json_event,
+				   const gchar *member_name,
+				   gpointer user_data,
+				   GError **error)
+{
+	GBytes *payload = (GBytes *)user_data;
+	JsonNode *member_node = json_object_get_member(json_event, member_name);
+	JsonObject *json_ref;
+	gint64 offset;
+	gint64 size;
+	g_autofree gchar *str = NULL;
+
+	if (!JSON_NODE_HOLDS_OBJECT(member_node))
+		return TRUE;
+	json_ref = json_node_get_object(member_node);
+	offset = json_object_get_int_member_with_default(json_ref, "Offset", -1);
+	size = json_object_get_int_member_with_default(json_ref, "Size", -1);
+	if (offset < 0 || size < 0 || (guint64)offset > g_bytes_get_size(payload) ||
+	    (guint64)size > g_bytes_get_size(payload) - offset) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "invalid payload reference for key %s",
+			    member_name);
+		return FALSE;
+	}
+	str = g_base64_encode((const guchar *)g_bytes_get_data(payload, NULL) + offset, size);
+	json_object_set_string_member(json_event, member_name, str);
+	return TRUE;
+}
+
+/**
+ * fu_engine_emulation_json_inline_payload:
+ * @json_blob: a #GBytes of JSON from a binary emulation archive
+ * @payload: a #GBytes of the matching payload section
+ * @error: (nullable): optional return location for an error
+ *
+ * Replaces all the payload references in the JSON with the BASE-64 encoded payload, so that the
+ * JSON can be used without the binary payload section.
+ *
+ * Returns: (transfer full): a #GBytes of JSON, or %NULL for failure
+ **/
+GBytes *
+fu_engine_emulation_json_inline_payload(GBytes *json_blob, GBytes *payload, GError **error)
+{
+	return fu_engine_emulation_json_transform(json_blob,
+						  fu_engine_emulation_json_inline_cb,
+						  payload,
+						  TRUE,
+						  error);
+}
+
+/**
+ * fu_engine_emulation_parse_zip:
+ * @stream: a #GInputStream
+ * @phases: a #GHashTable of #FuEngineInstallPhase to #GBytes
+ * @error: (nullable): optional return location for an error
+ *
+ * Loads the JSON for each phase from a ZIP emulation archive.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_emulation_parse_zip(GInputStream *stream, GHashTable *phases, GError **error)
+{
+	g_autoptr(FuArchive) archive = NULL;
+
+	archive = fu_archive_new_stream(stream, FU_ARCHIVE_FLAG_NONE, error);
+	if (archive == NULL)
+		return FALSE;
+	for (guint phase = FU_ENGINE_INSTALL_PHASE_SETUP; phase < FU_ENGINE_INSTALL_PHASE_LAST;
+	     phase++) {
+		g_autofree gchar *fn =
+		    g_strdup_printf("%s.json", fu_engine_install_phase_to_string(phase));
+		g_autoptr(GBytes) blob = NULL;
+
+		/* not found */
+		blob = fu_archive_lookup_by_fn(archive, fn, NULL);
+		if (blob == NULL)
+			continue;
+		g_hash_table_insert(phases, GINT_TO_POINTER(phase), g_steal_pointer(&blob));
+	}
+	if (g_hash_table_size(phases) == 0) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "no emulation data found in archive");
+		return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+}
+
+/**
+ * fu_engine_emulation_parse_binary:
+ * @blob: a #GBytes, typically memory mapped
+ * @phases: a #GHashTable of #FuEngineInstallPhase to #GBytes
+ * @payloads: a #GHashTable of #FuEngineInstallPhase to #GBytes
+ * @error: (nullable): optional return location for an error
+ *
+ * Loads the JSON and payload section for each phase from a binary emulation archive. The
+ * sections are added as sub-slices of @blob and no data is copied.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_emulation_parse_binary(GBytes *blob,
+				 GHashTable *phases,
+				 GHashTable *payloads,
+				 GError **error)
+{
+	gsize blobsz = g_bytes_get_size(blob);
+	g_autoptr(FuStructEngineEmulationHdr) st_hdr = NULL;
+
+	st_hdr = fu_struct_engine_emulation_hdr_parse_bytes(blob, 0x0, error);
+	if (st_hdr == NULL)
+		return FALSE;
+	for (guint i = 0; i < fu_struct_engine_emulation_hdr_get_nr_sections(st_hdr); i++) {
+		FuEngineEmulationSectionKind kind;
+		gsize offset_sect = st_hdr->len + (i * FU_STRUCT_ENGINE_EMULATION_SECTION_SIZE);
+		guint16 phase;
+		guint64 offset;
+		guint64 size;
+		g_autoptr(FuStructEngineEmulationSection) st_sect = NULL;
+
+		st_sect = fu_struct_engine_emulation_section_parse_bytes(blob, offset_sect, error);
+		if (st_sect == NULL)
+			return FALSE;
+		kind = fu_struct_engine_emulation_section_get_kind(st_sect);
+		phase = fu_struct_engine_emulation_section_get_phase(st_sect);
+		offset = fu_struct_engine_emulation_section_get_offset(st_sect);
+		size = fu_struct_engine_emulation_section_get_size(st_sect);
+		if (phase >= FU_ENGINE_INSTALL_PHASE_LAST) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_DATA,
+				    "invalid phase 0x%x for section %u",
+				    phase,
+				    i);
+			return FALSE;
+		}
+		if (offset > blobsz || size > blobsz - offset) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_DATA,
+				    "section %u of 0x%x bytes @0x%x outside of 0x%x",
+				    i,
+				    (guint)size,
+				    (guint)offset,
+				    (guint)blobsz);
+			return FALSE;
+		}
+		if (kind == FU_ENGINE_EMULATION_SECTION_KIND_JSON) {
+			g_hash_table_insert(phases,
+					    GINT_TO_POINTER(phase),
+					    g_bytes_new_from_bytes(blob, offset, size));
+		} else if (kind == FU_ENGINE_EMULATION_SECTION_KIND_PAYLOAD) {
+			g_hash_table_insert(payloads,
+					    GINT_TO_POINTER(phase),
+					    g_bytes_new_from_bytes(blob, offset, size));
+		} else {
+			g_debug("ignoring section kind 0x%x", kind);
+		}
+	}
+	if (g_hash_table_size(phases) == 0) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "no emulation data found in archive");
+		return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+}
+
+/**
+ * fu_engine_emulation_write_zip:
+ * @phases: a #GHashTable of #FuEngineInstallPhase to #GBytes
+ * @payloads: (nullable): a #GHashTable of #FuEngineInstallPhase to #GBytes
+ * @error: (nullable): optional return location for an error
+ *
+ * Writes a ZIP emulation archive of JSON files. Any payloads loaded from a binary emulation
+ * archive are converted back to BASE-64 strings.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for failure
+ **/
+GBytes *
+fu_engine_emulation_write_zip(GHashTable *phases, GHashTable *payloads, GError **error)
+{
+	g_autoptr(GByteArray) buf = NULL;
+	g_autoptr(FuArchive) archive = fu_archive_new(NULL, FU_ARCHIVE_FLAG_NONE, NULL);
+
+	for (guint phase = FU_ENGINE_INSTALL_PHASE_SETUP; phase < FU_ENGINE_INSTALL_PHASE_LAST;
+	     phase++) {
+		GBytes *json_blob = g_hash_table_lookup(phases, GINT_TO_POINTER(phase));
+		GBytes *payload = NULL;
+		g_autofree gchar *fn =
+		    g_strdup_printf("%s.json", fu_engine_install_phase_to_string(phase));
+
+		/* nothing set */
+		if (json_blob == NULL)
+			continue;
+		if (payloads != NULL)
+			payload = g_hash_table_lookup(payloads, GINT_TO_POINTER(phase));
+		if (payload != NULL) {
+			g_autoptr(GBytes) json_new = NULL;
+
+			json_new =
+			    fu_engine_emulation_json_inline_payload(json_blob, payload, error);
+			if (json_new == NULL)
+				return NULL;
+			fu_archive_add_entry(archive, fn, json_new);
+		} else {
+			fu_archive_add_entry(archive, fn, json_blob);
+		}
+	}
+	buf = fu_archive_write(archive, FU_ARCHIVE_FORMAT_ZIP, FU_ARCHIVE_COMPRESSION_GZIP, error);
+	if (buf == NULL)
+		return NULL;
+	return g_bytes_new(buf->data, buf->len);
+}
+
+static void
+fu_engine_emulation_add_section(GPtrArray *sections,
+				GPtrArray *blobs,
+				FuEngineEmulationSectionKind kind,
+				FuEngineInstallPhase phase,
+				GBytes *blob)
+{
+	g_autoptr(FuStructEngineEmulationSection) st_sect =
+	    fu_struct_engine_emulation_section_new();
+	fu_struct_engine_emulation_section_set_kind(st_sect, kind);
+	fu_struct_engine_emulation_section_set_phase(st_sect, phase);
+	fu_struct_engine_emulation_section_set_size(st_sect, g_bytes_get_size(blob));
+	g_ptr_array_add(sections, g_steal_pointer(&st_sect));
+	g_ptr_array_add(blobs, g_bytes_ref(blob));
+}
+
+/**
+ * fu_engine_emulation_write_binary:
+ * @phases: a #GHashTable of #FuEngineInstallPhase to #GBytes
+ * @payloads: (nullable): a #GHashTable of #FuEngineInstallPhase to #GBytes
+ * @error: (nullable): optional return location for an error
+ *
+ * Writes a binary emulation archive. Any large BASE-64 event payloads are moved out of the JSON
+ * and appended to the raw payload section for each phase.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for failure
+ **/
+GBytes *
+fu_engine_emulation_write_binary(GHashTable *phases, GHashTable *payloads, GError **error)
+{
+	gsize offset;
+	g_autoptr(FuStructEngineEmulationHdr) st_hdr = fu_struct_engine_emulation_hdr_new();
+	g_autoptr(GPtrArray) sections =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_byte_array_unref);
+	g_autoptr(GPtrArray) blobs = g_ptr_array_new_with_free_func((GDestroyNotify)g_bytes_unref);
+
+	for (guint phase = FU_ENGINE_INSTALL_PHASE_SETUP; phase < FU_ENGINE_INSTALL_PHASE_LAST;
+	     phase++) {
+		GBytes *json_blob = g_hash_table_lookup(phases, GINT_TO_POINTER(phase));
+		g_autoptr(GByteArray) payload = g_byte_array_new();
+		g_autoptr(GBytes) json_new = NULL;
+
+		/* nothing set */
+		if (json_blob == NULL)
+			continue;
+
+		/* any existing references stay valid */
+		if (payloads != NULL) {
+			GBytes *payload_old = g_hash_table_lookup(payloads, GINT_TO_POINTER(phase));
+			if (payload_old != NULL)
+				fu_byte_array_append_bytes(payload, payload_old);
+		}
+		json_new = fu_engine_emulation_json_transform(
+		    json_blob,
+		    fu_engine_emulation_json_externalize_cb,
+		    payload,
+		    FALSE,
+		    error);
+		if (json_new == NULL)
+			return NULL;
+		fu_engine_emulation_add_section(sections,
+						blobs,
+						FU_ENGINE_EMULATION_SECTION_KIND_JSON,
+						phase,
+						json_new);
+		if (payload->len > 0) {
+			g_autoptr(GBytes) blob = g_bytes_new(payload->data, payload->len);
+			fu_engine_emulation_add_section(sections,
+							blobs,
+							FU_ENGINE_EMULATION_SECTION_KIND_PAYLOAD,
+							phase,
+							blob);
+		}
+	}
+	if (sections->len == 0) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "no emulation data");
+		return NULL;
+	}
+
+	/* header, section table, then the sections themselves */
+	fu_struct_engine_emulation_hdr_set_nr_sections(st_hdr, sections->len);
+	offset = st_hdr->len + (sections->len * FU_STRUCT_ENGINE_EMULATION_SECTION_SIZE);
+	for (guint i = 0; i < sections->len; i++) {
+		FuStructEngineEmulationSection *st_sect = g_ptr_array_index(sections, i);
+		GBytes *blob = g_ptr_array_index(blobs, i);
+		fu_struct_engine_emulation_section_set_offset(st_sect, offset);
+		g_byte_array_append(st_hdr, st_sect->data, st_sect->len);
+		offset += g_bytes_get_size(blob);
+	}
+	for (guint i = 0; i < blobs->len; i++) {
+		GBytes *blob = g_ptr_array_index(blobs, i);
+		fu_byte_array_append_bytes(st_hdr, blob);
+	}
+	return g_bytes_new(st_hdr->data, st_hdr->len);
+}
+
+/**
+ * fu_engine_emulation_convert:
+ * @stream: a #GInputStream of a ZIP or binary emulation archive
+ * @format: the destination #FuEngineEmulationFormat
+ * @error: (nullable): optional return location for an error
+ *
+ * Converts an emulation archive to a different format. No data is lost in the conversion.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for failure
+ **/
+GBytes *
+fu_engine_emulation_convert(GInputStream *stream, FuEngineEmulationFormat format, GError **error)
+{
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GHashTable) phases = g_hash_table_new_full(g_direct_hash,
+							     g_direct_equal,
+							     NULL,
+							     (GDestroyNotify)g_bytes_unref);
+	g_autoptr(GHashTable) payloads = g_hash_table_new_full(g_direct_hash,
+							       g_direct_equal,
+							       NULL,
+							       (GDestroyNotify)g_bytes_unref);
+
+	/* load either format */
+	if (fu_engine_emulation_format_from_stream(stream) == FU_ENGINE_EMULATION_FORMAT_BINARY) {
+		blob = fu_engine_emulation_map_stream(stream, error);
+		if (blob == NULL)
+			return NULL;
+		if (!fu_engine_emulation_parse_binary(blob, phases, payloads, error))
+			return NULL;
+	} else {
+		if (!fu_engine_emulation_parse_zip(stream, phases, error))
+			return NULL;
+	}
+
+	/* write in the new format */
+	if (format == FU_ENGINE_EMULATION_FORMAT_BINARY)
+		return fu_engine_emulation_write_binary(phases, payloads, error);
+	return fu_engine_emulation_write_zip(phases, payloads, error);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <fwupdplugin.h>
+
+#include "fu-engine-struct.h"
+
+typedef enum {
+	FU_ENGINE_EMULATION_FORMAT_ZIP,
+	FU_ENGINE_EMULATION_FORMAT_BINARY,
+} FuEngineEmulationFormat;
+
+FuEngineEmulationFormat
+fu_engine_emulation_format_from_stream(GInputStream *stream) G_GNUC_NON_NULL(1);
+GBytes *
+fu_engine_emulation_map_stream(GInputStream *stream, GError **error) G_GNUC_NON_NULL(1);
+
+gboolean
+fu_engine_emulation_parse_zip(GInputStream *stream, GHashTable *phases, GError **error)
+    G_GNUC_NON_NULL(1, 2);
+gboolean
+fu_engine_emulation_parse_binary(GBytes *blob,
+				 GHashTable *phases,
+				 GHashTable *payloads,
+				 GError **error) G_GNUC_NON_NULL(1, 2, 3);
+GBytes *
+fu_engine_emulation_write_zip(GHashTable *phases, GHashTable *payloads, GError **error)
+    G_GNUC_NON_NULL(1);
+GBytes *
+fu_engine_emulation_write_binary(GHashTable *phases, GHashTable *payloads, GError **error)
+    G_GNUC_NON_NULL(1);
+
+GBytes *
+fu_engine_emulation_json_inline_payload(GBytes *json_blob, GBytes *payload, GError **error)
+    G_GNUC_NON_NULL(1, 2);
+GBytes *
+fu_engine_emulation_convert(GInputStream *stream, FuEngineEmulationFormat format, GError **error)
+    G_GNUC_NON_NULL(1);
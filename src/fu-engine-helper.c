@@ -146,8 +146,8 @@ fu_engine_update_motd(FuEngine *self, GError **error)
 	return g_file_set_contents(target, str->str, str->len, error);
 }
 
-gboolean
-fu_engine_update_devices_file(FuEngine *self, GError **error)
+GBytes *
+fu_engine_build_devices_file(FuEngine *self, GError **error)
 {
 	FwupdCodecFlags flags = FWUPD_CODEC_FLAG_NONE;
 	gsize len;
@@ -155,9 +155,7 @@ fu_engine_update_devices_file(FuEngine *self, GError **error)
 	g_autoptr(JsonGenerator) generator = NULL;
 	g_autoptr(JsonNode) root = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
-	g_autofree gchar *data = NULL;
-	g_autofree gchar *directory = NULL;
-	g_autofree gchar *target = NULL;
+	gchar *data;
 
 	if (fu_engine_config_get_show_device_private(fu_engine_get_config(self)))
 		flags |= FWUPD_CODEC_FLAG_TRUSTED;
@@ -179,12 +177,9 @@ fu_engine_update_devices_file(FuEngine *self, GError **error)
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INTERNAL,
 				    "Failed to convert to JSON string");
-		return FALSE;
+		return NULL;
 	}
-
-	directory = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
-	target = g_build_filename(directory, "devices.json", NULL);
-	return g_file_set_contents(target, data, (gssize)len, error);
+	return g_bytes_new_take(data, len);
 }
 
 static void
@@ -476,3 +471,31 @@ fu_engine_build_machine_id(const gchar *salt, GError **error)
 	g_checksum_update(csum, (const guchar *)buf, (gssize)bufsz);
 	return g_strdup(g_checksum_get_string(csum));
 }
+
+/* devices can only be updated at the same time when nothing links them together */
+gboolean
+fu_engine_install_release_devices_are_independent(FuDevice *device1, FuDevice *device2)
+{
+	FuDevice *proxy1 = fu_device_get_proxy(device1);
+	FuDevice *proxy2 = fu_device_get_proxy(device2);
+	const gchar *composite_id1 = fu_device_get_composite_id(device1);
+	const gchar *physical_id1 = fu_device_get_physical_id(device1);
+	g_autoptr(FuDevice) root1 = fu_device_get_root(device1);
+	g_autoptr(FuDevice) root2 = fu_device_get_root(device2);
+
+	if (fu_device_get_order(device1) != fu_device_get_order(device2))
+		return FALSE;
+	if (root1 == root2)
+		return FALSE;
+	if (proxy1 != NULL && (proxy1 == proxy2 || proxy1 == device2))
+		return FALSE;
+	if (proxy2 != NULL && proxy2 == device1)
+		return FALSE;
+	if (composite_id1 != NULL &&
+	    g_strcmp0(composite_id1, fu_device_get_composite_id(device2)) == 0)
+		return FALSE;
+	if (physical_id1 != NULL &&
+	    g_strcmp0(physical_id1, fu_device_get_physical_id(device2)) == 0)
+		return FALSE;
+	return TRUE;
+}
@@ -10,8 +10,8 @@
 
 gboolean
 fu_engine_update_motd(FuEngine *self, GError **error) G_GNUC_NON_NULL(1);
-gboolean
-fu_engine_update_devices_file(FuEngine *self, GError **error) G_GNUC_NON_NULL(1);
+GBytes *
+fu_engine_build_devices_file(FuEngine *self, GError **error) G_GNUC_NON_NULL(1);
 
 GHashTable *
 fu_engine_integrity_new(FuContext *ctx, GError **error);
@@ -22,3 +22,6 @@ GError *
 fu_engine_error_array_get_best(GPtrArray *errors);
 gchar *
 fu_engine_build_machine_id(const gchar *salt, GError **error);
+gboolean
+fu_engine_install_release_devices_are_independent(FuDevice *device1, FuDevice *device2)
+    G_GNUC_NON_NULL(1, 2);
@@ -47,6 +47,8 @@
 #include "fu-device-list.h"
 #include "fu-device-private.h"
 #include "fu-device-progress.h"
+#include "fu-dump.h"
+#include "fu-engine-emulation.h"
 #include "fu-engine-helper.h"
 #include "fu-engine-request.h"
 #include "fu-engine-requirements.h"
@@ -91,6 +93,8 @@
 #define FU_ENGINE_MAX_METADATA_SIZE  0x2000000 /* 32MB */
 #define FU_ENGINE_MAX_SIGNATURE_SIZE 0x100000  /* 1MB */
 
+#define FU_ENGINE_COLDPLUG_THREADS_MAX 8
+
 static void
 fu_engine_constructed(GObject *obj);
 static void
@@ -101,6 +105,14 @@ static gboolean
 fu_engine_backends_save_phase(FuEngine *self, GError **error);
 static gboolean
 fu_engine_emulation_load_phase(FuEngine *self, GError **error);
+static gboolean
+fu_engine_install_releases_batch(FuEngine *self,
+				 GPtrArray *releases,
+				 guint idx,
+				 guint batch_len,
+				 FuProgress *progress,
+				 FwupdInstallFlags flags,
+				 GError **error);
 
 struct _FuEngine {
 	GObject parent_instance;
@@ -109,16 +121,13 @@ struct _FuEngine {
 	FuRemoteList *remote_list;
 	FuDeviceList *device_list;
 	gboolean only_trusted;
-	gboolean write_history;
+	GHashTable *write_history; /* (element-type str) device-id */
 	gboolean host_emulation;
 	guint percentage;
 	FuHistory *history;
 	FuIdle *idle;
-	XbSilo *silo;
-	XbQuery *query_component_by_guid;
-	XbQuery *query_container_checksum1; /* container checksum -> release */
-	XbQuery *query_container_checksum2; /* artifact checksum -> release */
-	XbQuery *query_tag_by_guid_version;
+	GPtrArray *silos; /* (element-type FuEngineSilo), in remote priority order */
+	GHashTable *components_by_guid; /* (nullable) (element-type str GPtrArray) */
 	guint coldplug_id;
 	FuPluginList *plugin_list;
 	GPtrArray *plugin_filter;
@@ -126,19 +135,35 @@ struct _FuEngine {
 	GHashTable *approved_firmware;	      /* (nullable) */
 	GHashTable *blocked_firmware;	      /* (nullable) */
 	GHashTable *emulation_phases;	      /* (element-type int GBytes) */
+	GHashTable *emulation_payloads;	      /* (element-type int GBytes) */
 	GHashTable *emulation_ids;	      /* (element-type str int) */
 	GHashTable *device_changed_allowlist; /* (element-type str int) */
 	gchar *host_machine_id;
 	JcatContext *jcat_context;
 	gboolean loaded;
 	gchar *host_security_id;
+	gboolean host_security_attrs_valid;
 	FuSecurityAttrs *host_security_attrs;
+	FuSecurityAttrs *host_security_attrs_raw; /* (nullable), before depsolve */
+	GHashTable *security_attrs_by_device;	  /* (element-type str FuSecurityAttrs) */
+	GHashTable *security_attrs_by_plugin;	  /* (element-type str FuSecurityAttrs) */
 	GPtrArray *local_monitors; /* (element-type GFileMonitor) */
 	GMainLoop *acquiesce_loop;
 	guint acquiesce_id;
 	guint acquiesce_delay;
+	guint coldplug_probe_threads;
+	gdouble coldplug_probe_serial; /* s, sum of all per-device probe times */
+	gdouble coldplug_probe_wall;   /* s, as measured when using the worker pool */
 	guint update_motd_id;
+	guint devices_file_id;
+	GMutex devices_file_mutex;    /* for devices_file_checksum and devices_file_writes */
+	gchar *devices_file_checksum; /* (nullable), SHA256 of the last devices.json written */
+	guint devices_file_writes;
+	guint devices_file_writes_suppressed;
+	GThreadPool *devices_file_pool; /* one thread, so that writes are never reordered */
 	FuEngineInstallPhase install_phase;
+	GThread *main_thread; /* noref, devices may be installed using a worker pool */
+	GPtrArray *backend_events; /* (nullable) (element-type FuEngineBackendEvent) */
 #ifdef HAVE_PASSIM
 	PassimClient *passim_client;
 #endif
@@ -194,11 +219,151 @@ fu_engine_update_motd_reset(FuEngine *self)
 						     self);
 }
 
+typedef struct {
+	gchar *filename;
+	gchar *checksum;
+	GBytes *blob;
+} FuEngineDevicesFileHelper;
+
+static void
+fu_engine_devices_file_helper_free(FuEngineDevicesFileHelper *helper)
+{
+	g_free(helper->filename);
+	g_free(helper->checksum);
+	g_bytes_unref(helper->blob);
+	g_free(helper);
+}
+
+/* the pool is drained in finalize, so @user_data is always valid */
 static void
-fu_engine_emit_changed(FuEngine *self)
+fu_engine_devices_file_worker_cb(gpointer data, gpointer user_data)
 {
-	g_autoptr(GError) error = NULL;
+	FuEngine *self = FU_ENGINE(user_data);
+	FuEngineDevicesFileHelper *helper = (FuEngineDevicesFileHelper *)data;
+	g_autoptr(GError) error_local = NULL;
+
+	/* this writes to a temporary file and then renames it */
+	if (!g_file_set_contents(helper->filename,
+				 g_bytes_get_data(helper->blob, NULL),
+				 (gssize)g_bytes_get_size(helper->blob),
+				 &error_local)) {
+		g_info("failed to update list of devices: %s", error_local->message);
+	} else {
+		/* only skip identical contents when they are actually on disk */
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->devices_file_mutex);
+		g_free(self->devices_file_checksum);
+		self->devices_file_checksum = g_steal_pointer(&helper->checksum);
+		self->devices_file_writes++;
+	}
+	fu_engine_devices_file_helper_free(helper);
+}
+
+static gboolean
+fu_engine_devices_file_flush(FuEngine *self, GError **error)
+{
+	FuEngineDevicesFileHelper *helper;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *directory = NULL;
+	g_autoptr(GBytes) blob = NULL;
+
+	if (self->devices_file_id != 0) {
+		g_source_remove(self->devices_file_id);
+		self->devices_file_id = 0;
+	}
+
+	/* the devices can only be serialized from the main thread */
+	blob = fu_engine_build_devices_file(self, error);
+	if (blob == NULL)
+		return FALSE;
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, blob);
+	{
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->devices_file_mutex);
+		if (g_strcmp0(checksum, self->devices_file_checksum) == 0) {
+			self->devices_file_writes_suppressed++;
+			g_debug("devices.json unchanged, %u writes suppressed",
+				self->devices_file_writes_suppressed);
+			return TRUE;
+		}
+	}
+
+	/* write in the worker thread, which sets the checksum on success */
+	directory = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
+	helper = g_new0(FuEngineDevicesFileHelper, 1);
+	helper->filename = g_build_filename(directory, "devices.json", NULL);
+	helper->checksum = g_steal_pointer(&checksum);
+	helper->blob = g_steal_pointer(&blob);
+	return g_thread_pool_push(self->devices_file_pool, helper, error);
+}
+
+static gboolean
+fu_engine_devices_file_timeout_cb(gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE(user_data);
+	g_autoptr(GError) error_local = NULL;
+
+	self->devices_file_id = 0;
+	if (!fu_engine_devices_file_flush(self, &error_local))
+		g_info("failed to update list of devices: %s", error_local->message);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_engine_devices_file_reset(FuEngine *self)
+{
+	guint delay = fu_engine_config_get_devices_file_delay(self->config);
+
+	/* write now */
+	if (delay == 0) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_engine_devices_file_flush(self, &error_local))
+			g_info("failed to update list of devices: %s", error_local->message);
+		return;
+	}
+
+	/* the timeout is not moved, so that a stream of changes cannot delay the write forever */
+	if (self->devices_file_id != 0) {
+		self->devices_file_writes_suppressed++;
+		return;
+	}
+	self->devices_file_id = g_timeout_add(delay, fu_engine_devices_file_timeout_cb, self);
+}
+
+/**
+ * fu_engine_get_devices_file_writes:
+ * @self: a #FuEngine
+ *
+ * Gets the number of times `devices.json` has been successfully written.
+ *
+ * Returns: integer
+ **/
+guint
+fu_engine_get_devices_file_writes(FuEngine *self)
+{
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_return_val_if_fail(FU_IS_ENGINE(self), G_MAXUINT);
+	locker = g_mutex_locker_new(&self->devices_file_mutex);
+	return self->devices_file_writes;
+}
+
+/**
+ * fu_engine_get_devices_file_writes_suppressed:
+ * @self: a #FuEngine
+ *
+ * Gets the number of device changes that did not cause `devices.json` to be rewritten, either
+ * because they were batched with another change or because the contents did not change.
+ *
+ * Returns: integer
+ **/
+guint
+fu_engine_get_devices_file_writes_suppressed(FuEngine *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE(self), G_MAXUINT);
+	return self->devices_file_writes_suppressed;
+}
 
+static void
+fu_engine_emit_changed(FuEngine *self)
+{
 	/* do nothing */
 	if (!self->loaded)
 		return;
@@ -211,8 +376,65 @@ fu_engine_emit_changed(FuEngine *self)
 		fu_engine_update_motd_reset(self);
 
 	/* update the list of devices */
-	if (!fu_engine_update_devices_file(self, &error))
-		g_info("failed to update list of devices: %s", error->message);
+	fu_engine_devices_file_reset(self);
+}
+
+typedef struct {
+	FuEngine *self;
+	FuDevice *device;
+	FwupdRequest *request; /* nullable */
+} FuEngineIdleHelper;
+
+static void
+fu_engine_idle_helper_free(FuEngineIdleHelper *helper)
+{
+	g_object_unref(helper->self);
+	g_object_unref(helper->device);
+	if (helper->request != NULL)
+		g_object_unref(helper->request);
+	g_free(helper);
+}
+
+static FuEngineIdleHelper *
+fu_engine_idle_helper_new(FuEngine *self, FuDevice *device, FwupdRequest *request)
+{
+	FuEngineIdleHelper *helper = g_new0(FuEngineIdleHelper, 1);
+	helper->self = g_object_ref(self);
+	helper->device = g_object_ref(device);
+	if (request != NULL)
+		helper->request = g_object_ref(request);
+	return helper;
+}
+
+static void
+fu_engine_emit_device_changed_safe(FuEngine *self, FuDevice *device);
+
+/* everything is queried again, e.g. when the plugins signal a security change */
+static void
+fu_engine_invalidate_security_attrs(FuEngine *self)
+{
+	g_hash_table_remove_all(self->security_attrs_by_device);
+	g_hash_table_remove_all(self->security_attrs_by_plugin);
+	self->host_security_attrs_valid = FALSE;
+}
+
+/* only the device, and the plugin that owns it, are queried again */
+static void
+fu_engine_invalidate_security_attrs_for_device(FuEngine *self, FuDevice *device)
+{
+	if (fu_device_get_id(device) != NULL)
+		g_hash_table_remove(self->security_attrs_by_device, fu_device_get_id(device));
+	if (fu_device_get_plugin(device) != NULL)
+		g_hash_table_remove(self->security_attrs_by_plugin, fu_device_get_plugin(device));
+	self->host_security_attrs_valid = FALSE;
+}
+
+static gboolean
+fu_engine_emit_device_changed_idle_cb(gpointer user_data)
+{
+	FuEngineIdleHelper *helper = (FuEngineIdleHelper *)user_data;
+	fu_engine_emit_device_changed_safe(helper->self, helper->device);
+	return G_SOURCE_REMOVE;
 }
 
 static void
@@ -222,8 +444,17 @@ fu_engine_emit_device_changed_safe(FuEngine *self, FuDevice *device)
 	if (!self->loaded)
 		return;
 
+	/* signal handlers expect to be run in the main thread */
+	if (g_thread_self() != self->main_thread) {
+		g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+				fu_engine_emit_device_changed_idle_cb,
+				fu_engine_idle_helper_new(self, device, NULL),
+				(GDestroyNotify)fu_engine_idle_helper_free);
+		return;
+	}
+
 	/* invalidate host security attributes */
-	g_clear_pointer(&self->host_security_id, g_free);
+	fu_engine_invalidate_security_attrs_for_device(self, device);
 	g_signal_emit(self, signals[SIGNAL_DEVICE_CHANGED], 0, device);
 }
 
@@ -269,9 +500,9 @@ fu_engine_generic_notify_cb(FuDevice *device, GParamSpec *pspec, FuEngine *self)
 }
 
 static void
-fu_engine_history_notify_cb(FuDevice *device, GParamSpec *pspec, FuEngine *self)
+fu_engine_history_modify_device(FuEngine *self, FuDevice *device)
 {
-	if (self->write_history) {
+	if (g_hash_table_contains(self->write_history, fu_device_get_id(device))) {
 		g_autoptr(GError) error_local = NULL;
 		if (!fu_history_modify_device(self->history, device, &error_local)) {
 			if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND)) {
@@ -286,9 +517,49 @@ fu_engine_history_notify_cb(FuDevice *device, GParamSpec *pspec, FuEngine *self)
 	fu_engine_emit_device_changed(self, fu_device_get_id(device));
 }
 
+static gboolean
+fu_engine_history_notify_idle_cb(gpointer user_data)
+{
+	FuEngineIdleHelper *helper = (FuEngineIdleHelper *)user_data;
+	fu_engine_history_modify_device(helper->self, helper->device);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_engine_history_notify_cb(FuDevice *device, GParamSpec *pspec, FuEngine *self)
+{
+	/* the history database is only ever written from the main thread */
+	if (g_thread_self() != self->main_thread) {
+		g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+				fu_engine_history_notify_idle_cb,
+				fu_engine_idle_helper_new(self, device, NULL),
+				(GDestroyNotify)fu_engine_idle_helper_free);
+		return;
+	}
+	fu_engine_history_modify_device(self, device);
+}
+
+static gboolean
+fu_engine_device_request_idle_cb(gpointer user_data)
+{
+	FuEngineIdleHelper *helper = (FuEngineIdleHelper *)user_data;
+	g_info("Emitting DeviceRequest('Message'='%s')",
+	       fwupd_request_get_message(helper->request));
+	g_signal_emit(helper->self, signals[SIGNAL_DEVICE_REQUEST], 0, helper->request);
+	return G_SOURCE_REMOVE;
+}
+
 static void
 fu_engine_device_request_cb(FuDevice *device, FwupdRequest *request, FuEngine *self)
 {
+	/* signal handlers expect to be run in the main thread */
+	if (g_thread_self() != self->main_thread) {
+		g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+				fu_engine_device_request_idle_cb,
+				fu_engine_idle_helper_new(self, device, request),
+				(GDestroyNotify)fu_engine_idle_helper_free);
+		return;
+	}
 	g_info("Emitting DeviceRequest('Message'='%s')", fwupd_request_get_message(request));
 	g_signal_emit(self, signals[SIGNAL_DEVICE_REQUEST], 0, request);
 }
@@ -455,6 +726,7 @@ static void
 fu_engine_device_removed_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
 	fu_engine_device_runner_device_removed(self, device);
+	fu_engine_invalidate_security_attrs_for_device(self, device);
 	fu_engine_acquiesce_reset(self);
 	g_signal_handlers_disconnect_by_data(device, self);
 	g_signal_emit(self, signals[SIGNAL_DEVICE_REMOVED], 0, device);
@@ -468,6 +740,34 @@ fu_engine_device_changed_cb(FuDeviceList *device_list, FuDevice *device, FuEngin
 	fu_engine_acquiesce_reset(self);
 }
 
+/* one compiled silo for each remote, and one for the client-side metadata */
+typedef struct {
+	gchar *id;
+	XbSilo *silo;
+	XbQuery *query_component_by_guid;
+	XbQuery *query_container_checksum1; /* container checksum -> release */
+	XbQuery *query_container_checksum2; /* artifact checksum -> release */
+	XbQuery *query_tag_by_guid_version;
+} FuEngineSilo;
+
+static void
+fu_engine_silo_free(FuEngineSilo *shard)
+{
+	g_free(shard->id);
+	g_object_unref(shard->silo);
+	if (shard->query_component_by_guid != NULL)
+		g_object_unref(shard->query_component_by_guid);
+	if (shard->query_container_checksum1 != NULL)
+		g_object_unref(shard->query_container_checksum1);
+	if (shard->query_container_checksum2 != NULL)
+		g_object_unref(shard->query_container_checksum2);
+	if (shard->query_tag_by_guid_version != NULL)
+		g_object_unref(shard->query_tag_by_guid_version);
+	g_free(shard);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuEngineSilo, fu_engine_silo_free)
+
 /* add any client-side BKC tags */
 static gboolean
 fu_engine_add_local_release_metadata(FuEngine *self, FuRelease *release, GError **error)
@@ -479,38 +779,48 @@ fu_engine_add_local_release_metadata(FuEngine *self, FuRelease *release, GError
 	if (dev == NULL)
 		return TRUE;
 
-	/* not set up */
-	if (self->query_tag_by_guid_version == NULL)
-		return TRUE;
-
 	/* use prepared query for each GUID */
 	guids = fu_device_get_guids(dev);
-	for (guint i = 0; i < guids->len; i++) {
-		const gchar *guid = g_ptr_array_index(guids, i);
-		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GPtrArray) tags = NULL;
-		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	for (guint k = 0; k < self->silos->len; k++) {
+		FuEngineSilo *shard = g_ptr_array_index(self->silos, k);
 
-		/* bind GUID and then query */
-		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
-		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
-					   1,
-					   fu_release_get_version(release),
-					   NULL);
-		tags = xb_silo_query_with_context(self->silo,
-						  self->query_tag_by_guid_version,
-						  &context,
-						  &error_local);
-		if (tags == NULL) {
-			if (g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
-			    g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-				continue;
-			g_propagate_error(error, g_steal_pointer(&error_local));
-			return FALSE;
-		}
-		for (guint j = 0; j < tags->len; j++) {
-			XbNode *tag = g_ptr_array_index(tags, j);
-			fu_release_add_tag(release, xb_node_get_text(tag));
+		/* not set up */
+		if (shard->query_tag_by_guid_version == NULL)
+			continue;
+		for (guint i = 0; i < guids->len; i++) {
+			const gchar *guid = g_ptr_array_index(guids, i);
+			g_autoptr(GError) error_local = NULL;
+			g_autoptr(GPtrArray) tags = NULL;
+			g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+
+			/* bind GUID and then query */
+			xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
+						   0,
+						   guid,
+						   NULL);
+			xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
+						   1,
+						   fu_release_get_version(release),
+						   NULL);
+			tags = xb_silo_query_with_context(shard->silo,
+							  shard->query_tag_by_guid_version,
+							  &context,
+							  &error_local);
+			if (tags == NULL) {
+				if (g_error_matches(error_local,
+						    G_IO_ERROR,
+						    G_IO_ERROR_NOT_FOUND) ||
+				    g_error_matches(error_local,
+						    G_IO_ERROR,
+						    G_IO_ERROR_INVALID_ARGUMENT))
+					continue;
+				g_propagate_error(error, g_steal_pointer(&error_local));
+				return FALSE;
+			}
+			for (guint j = 0; j < tags->len; j++) {
+				XbNode *tag = g_ptr_array_index(tags, j);
+				fu_release_add_tag(release, xb_node_get_text(tag));
+			}
 		}
 	}
 
@@ -654,23 +964,26 @@ fu_engine_get_release_for_checksum(FuEngine *self, const gchar *csum)
 {
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
 	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, csum, NULL);
-	if (self->query_container_checksum1 != NULL) {
-		g_autoptr(XbNode) rel =
-		    xb_silo_query_first_with_context(self->silo,
-						     self->query_container_checksum1,
-						     &context,
-						     NULL);
-		if (rel != NULL)
-			return g_steal_pointer(&rel);
-	}
-	if (self->query_container_checksum2 != NULL) {
-		g_autoptr(XbNode) rel =
-		    xb_silo_query_first_with_context(self->silo,
-						     self->query_container_checksum2,
-						     &context,
-						     NULL);
-		if (rel != NULL)
-			return g_steal_pointer(&rel);
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *shard = g_ptr_array_index(self->silos, i);
+		if (shard->query_container_checksum1 != NULL) {
+			g_autoptr(XbNode) rel =
+			    xb_silo_query_first_with_context(shard->silo,
+							     shard->query_container_checksum1,
+							     &context,
+							     NULL);
+			if (rel != NULL)
+				return g_steal_pointer(&rel);
+		}
+		if (shard->query_container_checksum2 != NULL) {
+			g_autoptr(XbNode) rel =
+			    xb_silo_query_first_with_context(shard->silo,
+							     shard->query_container_checksum2,
+							     &context,
+							     NULL);
+			if (rel != NULL)
+				return g_steal_pointer(&rel);
+		}
 	}
 
 	/* failed */
@@ -1264,27 +1577,31 @@ fu_engine_verify_update(FuEngine *self,
 static XbNode *
 fu_engine_get_component_by_guid(FuEngine *self, const gchar *guid)
 {
-	g_autoptr(GError) error_local = NULL;
-	g_autoptr(XbNode) component = NULL;
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
 
-	/* no components in silo */
-	if (self->query_component_by_guid == NULL)
-		return NULL;
-
 	xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
 	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
-	component = xb_silo_query_first_with_context(self->silo,
-						     self->query_component_by_guid,
-						     &context,
-						     &error_local);
-	if (component == NULL) {
-		if (!g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
-		    !g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			g_warning("ignoring: %s", error_local->message);
-		return NULL;
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *shard = g_ptr_array_index(self->silos, i);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(XbNode) component = NULL;
+
+		/* no components in silo */
+		if (shard->query_component_by_guid == NULL)
+			continue;
+		component = xb_silo_query_first_with_context(shard->silo,
+							     shard->query_component_by_guid,
+							     &context,
+							     &error_local);
+		if (component == NULL) {
+			if (!g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
+			    !g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
+				g_warning("ignoring: %s", error_local->message);
+			continue;
+		}
+		return g_steal_pointer(&component);
 	}
-	return g_object_ref(component);
+	return NULL;
 }
 
 XbNode *
@@ -1342,14 +1659,17 @@ fu_engine_verify_from_local_metadata(FuEngine *self, FuDevice *device, GError **
 }
 
 static XbNode *
-fu_engine_verify_from_system_metadata(FuEngine *self, FuDevice *device, GError **error)
+fu_engine_verify_from_system_metadata_silo(FuEngine *self,
+					   FuDevice *device,
+					   XbSilo *silo,
+					   GError **error)
 {
 	FwupdVersionFormat fmt = fu_device_get_version_format(device);
 	GPtrArray *guids = fu_device_get_guids(device);
 	g_autoptr(XbQuery) query = NULL;
 
 	/* prepare query with bound GUID parameter */
-	query = xb_query_new_full(self->silo,
+	query = xb_query_new_full(silo,
 				  "components/component[@type='firmware']/"
 				  "provides/firmware[@type='flashed'][text()=?]/"
 				  "../../releases/release",
@@ -1369,7 +1689,7 @@ fu_engine_verify_from_system_metadata(FuEngine *self, FuDevice *device, GError *
 
 		/* bind GUID and then query */
 		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
-		releases = xb_silo_query_with_context(self->silo, query, &context, &error_local);
+		releases = xb_silo_query_with_context(silo, query, &context, &error_local);
 		if (releases == NULL) {
 			if (g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
 			    g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
@@ -1393,6 +1713,34 @@ fu_engine_verify_from_system_metadata(FuEngine *self, FuDevice *device, GError *
 	return NULL;
 }
 
+static XbNode *
+fu_engine_verify_from_system_metadata(FuEngine *self, FuDevice *device, GError **error)
+{
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *shard = g_ptr_array_index(self->silos, i);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(XbNode) rel = NULL;
+
+		/* no components in silo */
+		if (shard->query_component_by_guid == NULL)
+			continue;
+		rel = fu_engine_verify_from_system_metadata_silo(self,
+								 device,
+								 shard->silo,
+								 &error_local);
+		if (rel != NULL)
+			return g_steal_pointer(&rel);
+		if (!g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND)) {
+			g_propagate_error(error, g_steal_pointer(&error_local));
+			return NULL;
+		}
+	}
+
+	/* not found */
+	g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND, "failed to find release");
+	return NULL;
+}
+
 /**
  * fu_engine_verify:
  * @self: a #FuEngine
@@ -1748,6 +2096,11 @@ fu_engine_get_report_metadata(FuEngine *self, GError **error)
 #endif
 #endif
 
+	/* this is useful to know if batching the devices.json writes is saving disk I/O */
+	g_hash_table_insert(hash,
+			    g_strdup("DevicesFileWritesSuppressed"),
+			    g_strdup_printf("%u", fu_engine_get_devices_file_writes_suppressed(self)));
+
 	/* DMI data */
 	if (fu_context_has_flag(self->ctx, FU_CONTEXT_FLAG_LOADED_HWINFO)) {
 		struct {
@@ -1990,6 +2343,76 @@ fu_engine_install_release_version_check(FuEngine *self,
 	return TRUE;
 }
 
+static gboolean
+fu_engine_install_release_can_use_worker(FuEngine *self, FuRelease *release)
+{
+	FuDevice *device = fu_release_get_device(release);
+	FuPlugin *plugin;
+
+	/* emulation uses the engine-wide install phase */
+	if (fu_context_has_flag(self->ctx, FU_CONTEXT_FLAG_SAVE_EVENTS) ||
+	    fu_device_has_flag(device, FWUPD_DEVICE_FLAG_EMULATED) ||
+	    fu_device_has_flag(device, FWUPD_DEVICE_FLAG_EMULATION_TAG))
+		return FALSE;
+	if (fu_release_get_stream(release) == NULL)
+		return FALSE;
+
+	/* the plugin has to opt-in to having write-firmware called from a worker thread */
+	plugin = fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), NULL);
+	return plugin != NULL && fu_plugin_has_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL);
+}
+
+/* the number of sorted releases starting at @idx that can be installed at the same time */
+static guint
+fu_engine_install_releases_get_batch_len(FuEngine *self, GPtrArray *releases, guint idx)
+{
+	guint batch_len = 1;
+
+	if (!fu_engine_install_release_can_use_worker(self, g_ptr_array_index(releases, idx)))
+		return 1;
+	for (guint j = idx + 1; j < releases->len; j++) {
+		FuRelease *release = g_ptr_array_index(releases, j);
+		FuDevice *device = fu_release_get_device(release);
+
+		if (!fu_engine_install_release_can_use_worker(self, release))
+			break;
+		for (guint k = idx; k < j; k++) {
+			FuRelease *release_tmp = g_ptr_array_index(releases, k);
+			FuDevice *device_tmp = fu_release_get_device(release_tmp);
+			if (!fu_engine_install_release_devices_are_independent(device, device_tmp))
+				return batch_len;
+		}
+		batch_len++;
+	}
+	return batch_len;
+}
+
+/**
+ * fu_engine_install_releases_get_batches:
+ * @self: a #FuEngine
+ * @releases: (element-type FuRelease): sorted releases
+ * @flags: install flags, e.g. %FWUPD_INSTALL_FLAG_OFFLINE
+ *
+ * Splits the sorted releases into batches of devices that can be written at the same time.
+ *
+ * Returns: (transfer full) (element-type guint): the length of each batch
+ **/
+GArray *
+fu_engine_install_releases_get_batches(FuEngine *self, GPtrArray *releases, FwupdInstallFlags flags)
+{
+	GArray *batches = g_array_new(FALSE, FALSE, sizeof(guint));
+	guint max_threads = fu_engine_config_get_install_threads(self->config);
+
+	for (guint i = 0; i < releases->len;) {
+		guint batch_len = 1;
+		if (max_threads > 1 && (flags & FWUPD_INSTALL_FLAG_OFFLINE) == 0)
+			batch_len = fu_engine_install_releases_get_batch_len(self, releases, i);
+		g_array_append_val(batches, batch_len);
+		i += batch_len;
+	}
+	return batches;
+}
+
 /**
  * fu_engine_install_releases:
  * @self: a #FuEngine
@@ -2017,6 +2440,7 @@ fu_engine_install_releases(FuEngine *self,
 			   GError **error)
 {
 	g_autoptr(FuIdleLocker) locker = NULL;
+	g_autoptr(GArray) batches = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
 	g_autoptr(GPtrArray) devices_new = NULL;
 
@@ -2061,12 +2485,19 @@ fu_engine_install_releases(FuEngine *self,
 		return FALSE;
 	}
 
-	/* all authenticated, so install all the things */
+	/* all authenticated, so install all the things, optionally at the same time */
+	batches = fu_engine_install_releases_get_batches(self, releases, flags);
 	fu_progress_set_id(progress, G_STRLOC);
-	fu_progress_set_steps(progress, releases->len);
-	for (guint i = 0; i < releases->len; i++) {
-		FuRelease *release = g_ptr_array_index(releases, i);
+	for (guint i = 0; i < batches->len; i++) {
+		guint batch_len = g_array_index(batches, guint, i);
+		fu_progress_add_step(progress, fu_progress_get_status(progress), batch_len, NULL);
+	}
+	for (guint i = 0, idx = 0; i < batches->len; i++) {
+		guint batch_len = g_array_index(batches, guint, i);
+		FuRelease *release = g_ptr_array_index(releases, idx);
 		GInputStream *stream = fu_release_get_stream(release);
+		gboolean ret;
+
 		if (stream == NULL) {
 			g_set_error_literal(error,
 					    FWUPD_ERROR,
@@ -2074,12 +2505,23 @@ fu_engine_install_releases(FuEngine *self,
 					    "no stream for release");
 			return FALSE;
 		}
-		if (!fu_engine_install_release(self,
-					       release,
-					       stream,
-					       fu_progress_get_child(progress),
-					       flags,
-					       error)) {
+		if (batch_len > 1) {
+			ret = fu_engine_install_releases_batch(self,
+							       releases,
+							       idx,
+							       batch_len,
+							       fu_progress_get_child(progress),
+							       flags,
+							       error);
+		} else {
+			ret = fu_engine_install_release(self,
+							release,
+							stream,
+							fu_progress_get_child(progress),
+							flags,
+							error);
+		}
+		if (!ret) {
 			g_autoptr(GError) error_local = NULL;
 			if (!fu_engine_composite_cleanup(self, devices, &error_local)) {
 				g_warning("failed to cleanup failed composite action: %s",
@@ -2088,6 +2530,7 @@ fu_engine_install_releases(FuEngine *self,
 			return FALSE;
 		}
 		fu_progress_step_done(progress);
+		idx += batch_len;
 	}
 
 	/* set all the device statuses back to unknown */
@@ -2437,50 +2880,14 @@ fu_engine_save_into_backup_remote(FuEngine *self, GBytes *fw, GError **error)
 	return fwupd_remote_save_to_filename(remote, remotes_fn, NULL, error);
 }
 
-/**
- * fu_engine_install_release:
- * @self: a #FuEngine
- * @release: a #FuRelease
- * @stream: the #GInputStream of the .cab file
- * @progress: a #FuProgress
- * @flags: install flags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_OLDER
- * @error: (nullable): optional return location for an error
- *
- * Installs a specific release on a device.
- *
- * By this point all the requirements and tests should have been done in
- * fu_engine_requirements_check() so this should not fail before running
- * the plugin loader.
- *
- * Returns: %TRUE for success
- **/
-gboolean
-fu_engine_install_release(FuEngine *self,
-			  FuRelease *release,
-			  GInputStream *stream,
-			  FuProgress *progress,
-			  FwupdInstallFlags flags,
-			  GError **error)
+static gboolean
+fu_engine_install_release_prepare(FuEngine *self,
+				  FuRelease *release,
+				  GInputStream *stream,
+				  GError **error)
 {
-	FuDevice *device_orig = fu_release_get_device(release);
-	FuEngineRequest *request = fu_release_get_request(release);
-	FuPlugin *plugin;
-	FwupdFeatureFlags feature_flags = FWUPD_FEATURE_FLAG_NONE;
-	GInputStream *stream_fw;
+	FuDevice *device = fu_release_get_device(release);
 	const gchar *tmp;
-	g_autoptr(FuDevice) device = NULL;
-	g_autoptr(FuDevice) device_tmp = NULL;
-	g_autoptr(GError) error_local = NULL;
-
-	g_return_val_if_fail(FU_IS_ENGINE(self), FALSE);
-	g_return_val_if_fail(FU_IS_RELEASE(release), FALSE);
-	g_return_val_if_fail(FU_IS_PROGRESS(progress), FALSE);
-	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), FALSE);
-	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
-
-	/* optional for tests */
-	if (request != NULL)
-		feature_flags = fu_engine_request_get_feature_flags(request);
 
 	/* add the checksum of the container blob if not already set */
 	if (fwupd_release_get_checksums(FWUPD_RELEASE(release))->len == 0) {
@@ -2495,7 +2902,6 @@ fu_engine_install_release(FuEngine *self,
 	}
 
 	/* not in bootloader mode */
-	device = g_object_ref(fu_release_get_device(release));
 	if (!fu_device_has_flag(device, FWUPD_DEVICE_FLAG_IS_BOOTLOADER)) {
 		/* both optional; the plugin can specify a fallback */
 		tmp = fwupd_release_get_detach_caption(FWUPD_RELEASE(release));
@@ -2516,6 +2922,143 @@ fu_engine_install_release(FuEngine *self,
 			return FALSE;
 	}
 
+	/* success */
+	return TRUE;
+}
+
+/* the history database is not thread safe, so this is always called from the main thread */
+static gboolean
+fu_engine_install_release_add_history(FuEngine *self,
+				      FuRelease *release,
+				      FwupdInstallFlags flags,
+				      GError **error)
+{
+	FuDevice *device = fu_release_get_device(release);
+	FuPlugin *plugin;
+
+	/* set this for the callback */
+	if ((flags & FWUPD_INSTALL_FLAG_NO_HISTORY) > 0)
+		g_hash_table_remove(self->write_history, fu_device_get_id(device));
+	else
+		g_hash_table_add(self->write_history, g_strdup(fu_device_get_id(device)));
+
+	/* get the plugin */
+	plugin =
+	    fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), error);
+	if (plugin == NULL)
+		return FALSE;
+
+	/* add device to database */
+	if ((flags & FWUPD_INSTALL_FLAG_NO_HISTORY) == 0) {
+		if (!fu_engine_add_release_metadata(self, release, error))
+			return FALSE;
+		if (!fu_engine_add_release_plugin_metadata(self, release, plugin, error))
+			return FALSE;
+		if (!fu_history_add_device(self->history, device, release, error))
+			return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+}
+
+static void
+fu_engine_install_release_failed(FuRelease *release, const GError *error)
+{
+	FuDevice *device = fu_release_get_device(release);
+	FwupdUpdateState state = fu_device_get_update_state(device);
+
+	if (state != FWUPD_UPDATE_STATE_FAILED && state != FWUPD_UPDATE_STATE_FAILED_TRANSIENT)
+		fu_device_set_update_state(device, FWUPD_UPDATE_STATE_FAILED);
+	else
+		fu_device_set_update_state(device, state);
+	fu_device_set_update_error(device, error->message);
+}
+
+static gboolean
+fu_engine_install_release_finish(FuEngine *self,
+				 FuRelease *release,
+				 FuProgress *progress,
+				 GError **error)
+{
+	FuDevice *device_orig = fu_release_get_device(release);
+	g_autoptr(FuDevice) device = NULL;
+
+	/* the device may have changed */
+	device =
+	    fu_device_list_get_by_id(self->device_list, fu_device_get_id(device_orig), error);
+	if (device == NULL) {
+		g_prefix_error(error, "failed to get device after install: ");
+		return FALSE;
+	}
+
+	/* update state (which updates the database if required) */
+	if (fu_device_has_flag(device, FWUPD_DEVICE_FLAG_NEEDS_REBOOT) ||
+	    fu_device_has_flag(device, FWUPD_DEVICE_FLAG_NEEDS_SHUTDOWN)) {
+		fu_device_set_update_state(device_orig, FWUPD_UPDATE_STATE_NEEDS_REBOOT);
+		return TRUE;
+	}
+
+	/* mark success unless needs a reboot */
+	if (fu_device_get_update_state(device) != FWUPD_UPDATE_STATE_NEEDS_REBOOT)
+		fu_device_set_update_state(device, FWUPD_UPDATE_STATE_SUCCESS);
+
+	/* wait for the system to acquiesce if required */
+	if (fu_device_get_acquiesce_delay(device_orig) > 0 &&
+	    !fu_device_has_flag(device, FWUPD_DEVICE_FLAG_EMULATED)) {
+		fu_progress_set_status(progress, FWUPD_STATUS_DEVICE_BUSY);
+		fu_engine_wait_for_acquiesce(self, fu_device_get_acquiesce_delay(device_orig));
+	}
+
+	/* success */
+	return TRUE;
+}
+
+/**
+ * fu_engine_install_release:
+ * @self: a #FuEngine
+ * @release: a #FuRelease
+ * @stream: the #GInputStream of the .cab file
+ * @progress: a #FuProgress
+ * @flags: install flags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_OLDER
+ * @error: (nullable): optional return location for an error
+ *
+ * Installs a specific release on a device.
+ *
+ * By this point all the requirements and tests should have been done in
+ * fu_engine_requirements_check() so this should not fail before running
+ * the plugin loader.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_install_release(FuEngine *self,
+			  FuRelease *release,
+			  GInputStream *stream,
+			  FuProgress *progress,
+			  FwupdInstallFlags flags,
+			  GError **error)
+{
+	FuDevice *device = fu_release_get_device(release);
+	FuEngineRequest *request = fu_release_get_request(release);
+	FwupdFeatureFlags feature_flags = FWUPD_FEATURE_FLAG_NONE;
+	GInputStream *stream_fw;
+	g_autoptr(GError) error_local = NULL;
+
+	g_return_val_if_fail(FU_IS_ENGINE(self), FALSE);
+	g_return_val_if_fail(FU_IS_RELEASE(release), FALSE);
+	g_return_val_if_fail(FU_IS_PROGRESS(progress), FALSE);
+	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* optional for tests */
+	if (request != NULL)
+		feature_flags = fu_engine_request_get_feature_flags(request);
+
+	/* checksums, detach caption and backup */
+	if (!fu_engine_install_release_prepare(self, release, stream, error))
+		return FALSE;
+
 	/* schedule this for the next reboot if not in system-update.target,
 	 * but first check if allowed on battery power */
 	if ((flags & FWUPD_INSTALL_FLAG_OFFLINE) > 0 && !fu_engine_is_running_offline(self)) {
@@ -2540,9 +3083,6 @@ fu_engine_install_release(FuEngine *self,
 		return fu_engine_schedule_update(self, device, release, blob_cab, flags, error);
 	}
 
-	/* set this for the callback */
-	self->write_history = (flags & FWUPD_INSTALL_FLAG_NO_HISTORY) == 0;
-
 	/* get per-release firmware blob */
 	stream_fw = fu_release_get_stream(release);
 	if (stream_fw == NULL) {
@@ -2553,21 +3093,9 @@ fu_engine_install_release(FuEngine *self,
 		return FALSE;
 	}
 
-	/* get the plugin */
-	plugin =
-	    fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), error);
-	if (plugin == NULL)
-		return FALSE;
-
 	/* add device to database */
-	if ((flags & FWUPD_INSTALL_FLAG_NO_HISTORY) == 0) {
-		if (!fu_engine_add_release_metadata(self, release, error))
-			return FALSE;
-		if (!fu_engine_add_release_plugin_metadata(self, release, plugin, error))
-			return FALSE;
-		if (!fu_history_add_device(self->history, device, release, error))
-			return FALSE;
-	}
+	if (!fu_engine_install_release_add_history(self, release, flags, error))
+		return FALSE;
 
 	/* install firmware blob */
 	if (!fu_engine_install_blob(self,
@@ -2577,45 +3105,11 @@ fu_engine_install_release(FuEngine *self,
 				    flags,
 				    feature_flags,
 				    &error_local)) {
-		FwupdUpdateState state = fu_device_get_update_state(device);
-		if (state != FWUPD_UPDATE_STATE_FAILED &&
-		    state != FWUPD_UPDATE_STATE_FAILED_TRANSIENT)
-			fu_device_set_update_state(device_orig, FWUPD_UPDATE_STATE_FAILED);
-		else
-			fu_device_set_update_state(device_orig, state);
-		fu_device_set_update_error(device_orig, error_local->message);
+		fu_engine_install_release_failed(release, error_local);
 		g_propagate_error(error, g_steal_pointer(&error_local));
 		return FALSE;
 	}
-
-	/* the device may have changed */
-	device_tmp = fu_device_list_get_by_id(self->device_list, fu_device_get_id(device), error);
-	if (device_tmp == NULL) {
-		g_prefix_error(error, "failed to get device after install: ");
-		return FALSE;
-	}
-	g_set_object(&device, device_tmp);
-
-	/* update state (which updates the database if required) */
-	if (fu_device_has_flag(device, FWUPD_DEVICE_FLAG_NEEDS_REBOOT) ||
-	    fu_device_has_flag(device, FWUPD_DEVICE_FLAG_NEEDS_SHUTDOWN)) {
-		fu_device_set_update_state(device_orig, FWUPD_UPDATE_STATE_NEEDS_REBOOT);
-		return TRUE;
-	}
-
-	/* mark success unless needs a reboot */
-	if (fu_device_get_update_state(device) != FWUPD_UPDATE_STATE_NEEDS_REBOOT)
-		fu_device_set_update_state(device, FWUPD_UPDATE_STATE_SUCCESS);
-
-	/* wait for the system to acquiesce if required */
-	if (fu_device_get_acquiesce_delay(device_orig) > 0 &&
-	    !fu_device_has_flag(device, FWUPD_DEVICE_FLAG_EMULATED)) {
-		fu_progress_set_status(progress, FWUPD_STATUS_DEVICE_BUSY);
-		fu_engine_wait_for_acquiesce(self, fu_device_get_acquiesce_delay(device_orig));
-	}
-
-	/* success */
-	return TRUE;
+	return fu_engine_install_release_finish(self, release, progress, error);
 }
 
 /**
@@ -2655,7 +3149,29 @@ fu_engine_get_plugin_by_name(FuEngine *self, const gchar *name, GError **error)
 }
 
 static gboolean
-fu_engine_emulation_load_json_blob(FuEngine *self, GBytes *json_blob, GError **error)
+fu_engine_emulation_resolve_payload(FuEngine *self, GBytes *payload, GError **error)
+{
+	for (guint i = 0; i < self->backends->len; i++) {
+		FuBackend *backend = g_ptr_array_index(self->backends, i);
+		g_autoptr(GPtrArray) devices = fu_backend_get_devices(backend);
+		for (guint j = 0; j < devices->len; j++) {
+			FuDevice *device = g_ptr_array_index(devices, j);
+			GPtrArray *events = fu_device_get_events(device);
+			for (guint k = 0; k < events->len; k++) {
+				FuDeviceEvent *event = g_ptr_array_index(events, k);
+				if (!fu_device_event_resolve_payload(event, payload, error))
+					return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_engine_emulation_load_json_blob(FuEngine *self,
+				   GBytes *json_blob,
+				   GBytes *payload,
+				   GError **error)
 {
 	JsonNode *root;
 	g_autoptr(JsonParser) parser = json_parser_new();
@@ -2675,6 +3191,12 @@ fu_engine_emulation_load_json_blob(FuEngine *self, GBytes *json_blob, GError **e
 			return FALSE;
 	}
 
+	/* event data stored in the binary payload section, without copying */
+	if (payload != NULL) {
+		if (!fu_engine_emulation_resolve_payload(self, payload, error))
+			return FALSE;
+	}
+
 	/* success */
 	return TRUE;
 }
@@ -2683,6 +3205,7 @@ static gboolean
 fu_engine_emulation_load_phase(FuEngine *self, GError **error)
 {
 	GBytes *json_blob;
+	GBytes *payload;
 	const guint8 *buf;
 	gsize bufsz = 0;
 
@@ -2690,6 +3213,8 @@ fu_engine_emulation_load_phase(FuEngine *self, GError **error)
 	    g_hash_table_lookup(self->emulation_phases, GINT_TO_POINTER(self->install_phase));
 	if (json_blob == NULL)
 		return TRUE;
+	payload =
+	    g_hash_table_lookup(self->emulation_payloads, GINT_TO_POINTER(self->install_phase));
 
 	/* show a truncated version to the console */
 	buf = g_bytes_get_data(json_blob, &bufsz);
@@ -2701,15 +3226,14 @@ fu_engine_emulation_load_phase(FuEngine *self, GError **error)
 		       json_truncated);
 	}
 
-	return fu_engine_emulation_load_json_blob(self, json_blob, error);
+	return fu_engine_emulation_load_json_blob(self, json_blob, payload, error);
 }
 
 gboolean
 fu_engine_emulation_load(FuEngine *self, GInputStream *stream, GError **error)
 {
-	gboolean got_json = FALSE;
 	const gchar *json_empty = "{\"UsbDevices\":[]}";
-	g_autoptr(FuArchive) archive = NULL;
+	GBytes *json_setup;
 	g_autoptr(GBytes) json_blob = g_bytes_new_static(json_empty, strlen(json_empty));
 
 	g_return_val_if_fail(FU_IS_ENGINE(self), FALSE);
@@ -2726,43 +3250,39 @@ fu_engine_emulation_load(FuEngine *self, GInputStream *stream, GError **error)
 	}
 
 	/* unload any existing devices */
-	if (!fu_engine_emulation_load_json_blob(self, json_blob, error))
-		return FALSE;
-
-	/* load archive */
-	archive = fu_archive_new_stream(stream, FU_ARCHIVE_FLAG_NONE, error);
-	if (archive == NULL)
+	if (!fu_engine_emulation_load_json_blob(self, json_blob, NULL, error))
 		return FALSE;
 
-	/* load JSON files from archive */
+	/* load JSON for each phase, and the optional payloads */
 	g_hash_table_remove_all(self->emulation_phases);
-	for (guint phase = FU_ENGINE_INSTALL_PHASE_SETUP; phase < FU_ENGINE_INSTALL_PHASE_LAST;
-	     phase++) {
-		g_autofree gchar *fn =
-		    g_strdup_printf("%s.json", fu_engine_install_phase_to_string(phase));
-		g_autoptr(GBytes) blob = NULL;
-
-		/* not found */
-		blob = fu_archive_lookup_by_fn(archive, fn, NULL);
+	g_hash_table_remove_all(self->emulation_payloads);
+	if (fu_engine_emulation_format_from_stream(stream) == FU_ENGINE_EMULATION_FORMAT_BINARY) {
+		g_autoptr(GBytes) blob = fu_engine_emulation_map_stream(stream, error);
 		if (blob == NULL)
-			continue;
-		got_json = TRUE;
-		g_info("got emulation for phase %s", fu_engine_install_phase_to_string(phase));
-		if (phase == FU_ENGINE_INSTALL_PHASE_SETUP) {
-			if (!fu_engine_emulation_load_json_blob(self, blob, error))
-				return FALSE;
-		} else {
-			g_hash_table_insert(self->emulation_phases,
-					    GINT_TO_POINTER(phase),
-					    g_steal_pointer(&blob));
-		}
+			return FALSE;
+		if (!fu_engine_emulation_parse_binary(blob,
+						      self->emulation_phases,
+						      self->emulation_payloads,
+						      error))
+			return FALSE;
+	} else {
+		if (!fu_engine_emulation_parse_zip(stream, self->emulation_phases, error))
+			return FALSE;
 	}
-	if (!got_json) {
-		g_set_error_literal(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "no emulation data found in archive");
-		return FALSE;
+
+	/* the setup phase is loaded now */
+	json_setup = g_hash_table_lookup(self->emulation_phases,
+					 GINT_TO_POINTER(FU_ENGINE_INSTALL_PHASE_SETUP));
+	if (json_setup != NULL) {
+		GBytes *payload =
+		    g_hash_table_lookup(self->emulation_payloads,
+					GINT_TO_POINTER(FU_ENGINE_INSTALL_PHASE_SETUP));
+		if (!fu_engine_emulation_load_json_blob(self, json_setup, payload, error))
+			return FALSE;
+		g_hash_table_remove(self->emulation_phases,
+				    GINT_TO_POINTER(FU_ENGINE_INSTALL_PHASE_SETUP));
+		g_hash_table_remove(self->emulation_payloads,
+				    GINT_TO_POINTER(FU_ENGINE_INSTALL_PHASE_SETUP));
 	}
 
 	/* success */
@@ -2772,9 +3292,7 @@ fu_engine_emulation_load(FuEngine *self, GInputStream *stream, GError **error)
 GBytes *
 fu_engine_emulation_save(FuEngine *self, GError **error)
 {
-	gboolean got_json = FALSE;
-	g_autoptr(GByteArray) buf = NULL;
-	g_autoptr(FuArchive) archive = fu_archive_new(NULL, FU_ARCHIVE_FLAG_NONE, NULL);
+	g_autoptr(GBytes) blob = NULL;
 
 	g_return_val_if_fail(FU_IS_ENGINE(self), NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
@@ -2789,22 +3307,7 @@ fu_engine_emulation_save(FuEngine *self, GError **error)
 	}
 
 	/* sanity check */
-	for (guint phase = FU_ENGINE_INSTALL_PHASE_SETUP; phase < FU_ENGINE_INSTALL_PHASE_LAST;
-	     phase++) {
-		const gchar *json =
-		    g_hash_table_lookup(self->emulation_phases, GINT_TO_POINTER(phase));
-		g_autofree gchar *fn =
-		    g_strdup_printf("%s.json", fu_engine_install_phase_to_string(phase));
-		g_autoptr(GBytes) blob = NULL;
-
-		/* nothing set */
-		if (json == NULL)
-			continue;
-		got_json = TRUE;
-		blob = g_bytes_new_static(json, strlen(json));
-		fu_archive_add_entry(archive, fn, blob);
-	}
-	if (!got_json) {
+	if (g_hash_table_size(self->emulation_phases) == 0) {
 		g_set_error_literal(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_NOT_SUPPORTED,
@@ -2813,13 +3316,16 @@ fu_engine_emulation_save(FuEngine *self, GError **error)
 	}
 
 	/* write  */
-	buf = fu_archive_write(archive, FU_ARCHIVE_FORMAT_ZIP, FU_ARCHIVE_COMPRESSION_GZIP, error);
-	if (buf == NULL)
+	blob = fu_engine_emulation_write_zip(self->emulation_phases,
+					     self->emulation_payloads,
+					     error);
+	if (blob == NULL)
 		return NULL;
 
 	/* success */
 	g_hash_table_remove_all(self->emulation_phases);
-	return g_bytes_new(buf->data, buf->len);
+	g_hash_table_remove_all(self->emulation_payloads);
+	return g_steal_pointer(&blob);
 }
 
 static void
@@ -2881,7 +3387,8 @@ fu_engine_backends_to_json(FuEngine *self, JsonBuilder *json_builder)
 static gboolean
 fu_engine_backends_save_phase(FuEngine *self, GError **error)
 {
-	const gchar *data_old;
+	GBytes *blob_old;
+	gsize data_newsz;
 	g_autofree gchar *data_new = NULL;
 	g_autofree gchar *data_new_safe = NULL;
 	g_autoptr(JsonBuilder) json_builder = json_builder_new();
@@ -2896,27 +3403,28 @@ fu_engine_backends_save_phase(FuEngine *self, GError **error)
 	json_generator_set_pretty(json_generator, TRUE);
 	json_generator_set_root(json_generator, json_root);
 
-	data_old =
+	blob_old =
 	    g_hash_table_lookup(self->emulation_phases, GINT_TO_POINTER(self->install_phase));
-	data_new = json_generator_to_data(json_generator, NULL);
+	data_new = json_generator_to_data(json_generator, &data_newsz);
 	if (g_strcmp0(data_new, "") == 0) {
 		g_info("no data for phase %s",
 		       fu_engine_install_phase_to_string(self->install_phase));
 		return TRUE;
 	}
-	if (g_strcmp0(data_old, data_new) == 0) {
+	if (blob_old != NULL && g_bytes_get_size(blob_old) == data_newsz &&
+	    memcmp(g_bytes_get_data(blob_old, NULL), data_new, data_newsz) == 0) {
 		g_info("JSON unchanged for phase %s",
 		       fu_engine_install_phase_to_string(self->install_phase));
 		return TRUE;
 	}
 	data_new_safe = g_strndup(data_new, 8000);
 	g_info("JSON %s for phase %s: %s...",
-	       data_old == NULL ? "added" : "changed",
+	       blob_old == NULL ? "added" : "changed",
 	       fu_engine_install_phase_to_string(self->install_phase),
 	       data_new_safe);
 	g_hash_table_insert(self->emulation_phases,
 			    GINT_TO_POINTER(self->install_phase),
-			    g_steal_pointer(&data_new));
+			    g_bytes_new_take(g_steal_pointer(&data_new), data_newsz));
 
 	/* success */
 	return TRUE;
@@ -3061,7 +3569,6 @@ fu_engine_prepare(FuEngine *self,
 		  GError **error)
 {
 	GPtrArray *plugins = fu_plugin_list_get_all(self->plugin_list);
-	g_autofree gchar *str = NULL;
 	g_autoptr(FuDevice) device = NULL;
 
 	/* the device and plugin both may have changed */
@@ -3075,8 +3582,8 @@ fu_engine_prepare(FuEngine *self,
 	if (!fu_engine_device_check_power(self, device, flags, error))
 		return FALSE;
 
-	str = fu_device_to_string(device);
-	g_info("prepare -> %s", str);
+	g_info("prepare -> %s", fu_device_get_id(device));
+	fu_device_dump(device, G_LOG_DOMAIN, "prepare ->");
 	if (!fu_engine_device_prepare(self, device, progress, flags, error))
 		return FALSE;
 	for (guint j = 0; j < plugins->len; j++) {
@@ -3110,7 +3617,6 @@ fu_engine_cleanup(FuEngine *self,
 		  GError **error)
 {
 	GPtrArray *plugins = fu_plugin_list_get_all(self->plugin_list);
-	g_autofree gchar *str = NULL;
 	g_autoptr(FuDevice) device = NULL;
 
 	/* the device and plugin both may have changed */
@@ -3120,8 +3626,8 @@ fu_engine_cleanup(FuEngine *self,
 		return FALSE;
 	}
 	fu_device_remove_problem(device, FWUPD_DEVICE_PROBLEM_UPDATE_IN_PROGRESS);
-	str = fu_device_to_string(device);
-	g_info("cleanup -> %s", str);
+	g_info("cleanup -> %s", fu_device_get_id(device));
+	fu_device_dump(device, G_LOG_DOMAIN, "cleanup ->");
 	if (!fu_engine_device_cleanup(self, device, progress, flags, error))
 		return FALSE;
 	for (guint j = 0; j < plugins->len; j++) {
@@ -3155,7 +3661,6 @@ fu_engine_detach(FuEngine *self,
 		 GError **error)
 {
 	FuPlugin *plugin;
-	g_autofree gchar *str = NULL;
 	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(FuDeviceLocker) poll_locker = NULL;
 	g_autoptr(FuDeviceProgress) device_progress = NULL;
@@ -3174,8 +3679,8 @@ fu_engine_detach(FuEngine *self,
 	if (poll_locker == NULL)
 		return FALSE;
 
-	str = fu_device_to_string(device);
-	g_info("detach -> %s", str);
+	g_info("detach -> %s", fu_device_get_id(device));
+	fu_device_dump(device, G_LOG_DOMAIN, "detach ->");
 	plugin =
 	    fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), error);
 	if (plugin == NULL)
@@ -3224,7 +3729,6 @@ static gboolean
 fu_engine_attach(FuEngine *self, const gchar *device_id, FuProgress *progress, GError **error)
 {
 	FuPlugin *plugin;
-	g_autofree gchar *str = NULL;
 	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(FuDeviceLocker) poll_locker = NULL;
 	g_autoptr(FuDeviceProgress) device_progress = NULL;
@@ -3238,8 +3742,8 @@ fu_engine_attach(FuEngine *self, const gchar *device_id, FuProgress *progress, G
 	device_progress = fu_device_progress_new(device, progress);
 	g_return_val_if_fail(device_progress != NULL, FALSE);
 
-	str = fu_device_to_string(device);
-	g_info("attach -> %s", str);
+	g_info("attach -> %s", fu_device_get_id(device));
+	fu_device_dump(device, G_LOG_DOMAIN, "attach ->");
 	plugin =
 	    fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), error);
 	if (plugin == NULL)
@@ -3289,7 +3793,6 @@ gboolean
 fu_engine_activate(FuEngine *self, const gchar *device_id, FuProgress *progress, GError **error)
 {
 	FuPlugin *plugin;
-	g_autofree gchar *str = NULL;
 	g_autoptr(FuDevice) device = NULL;
 
 	g_return_val_if_fail(FU_IS_ENGINE(self), FALSE);
@@ -3300,8 +3803,8 @@ fu_engine_activate(FuEngine *self, const gchar *device_id, FuProgress *progress,
 	device = fu_device_list_get_by_id(self->device_list, device_id, error);
 	if (device == NULL)
 		return FALSE;
-	str = fu_device_to_string(device);
-	g_info("activate -> %s", str);
+	g_info("activate -> %s", fu_device_get_id(device));
+	fu_device_dump(device, G_LOG_DOMAIN, "activate ->");
 	plugin =
 	    fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), error);
 	if (plugin == NULL)
@@ -3319,7 +3822,6 @@ static gboolean
 fu_engine_reload(FuEngine *self, const gchar *device_id, GError **error)
 {
 	FuPlugin *plugin;
-	g_autofree gchar *str = NULL;
 	g_autoptr(FuDevice) device = NULL;
 
 	/* the device and plugin both may have changed */
@@ -3328,8 +3830,8 @@ fu_engine_reload(FuEngine *self, const gchar *device_id, GError **error)
 		g_prefix_error(error, "failed to get device before update reload: ");
 		return FALSE;
 	}
-	str = fu_device_to_string(device);
-	g_info("reload -> %s", str);
+	g_info("reload -> %s", fu_device_get_id(device));
+	fu_device_dump(device, G_LOG_DOMAIN, "reload ->");
 	plugin =
 	    fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), error);
 	if (plugin == NULL)
@@ -3362,93 +3864,179 @@ fu_engine_reload(FuEngine *self, const gchar *device_id, GError **error)
 	return TRUE;
 }
 
+typedef struct {
+	FuRelease *release; /* noref, nullable */
+	FuDevice *device;
+	gchar *device_id;
+	GInputStream *stream_fw;
+	FuProgress *progress;
+	FuDeviceProgress *device_progress;
+	FwupdInstallFlags flags;
+	FwupdFeatureFlags feature_flags;
+	guint retries;
+	gboolean installing;
+	gchar *filename_to_delete;
+	GTimer *timer;
+	GError *error;
+	/* only valid for the duration of write-firmware */
+	FuDevice *device_write;
+	FuPlugin *plugin_write;	    /* noref */
+	FuProgress *progress_write; /* noref */
+	FuDeviceProgress *device_progress_write;
+	FuDeviceLocker *poll_locker;
+	GInputStream *stream_write;
+	GError *error_write;
+} FuEngineInstallItem;
+
+static FuEngineInstallItem *
+fu_engine_install_item_new(FuDevice *device,
+			   GInputStream *stream_fw,
+			   FuProgress *progress,
+			   FwupdInstallFlags flags,
+			   FwupdFeatureFlags feature_flags)
+{
+	FuEngineInstallItem *item = g_new0(FuEngineInstallItem, 1);
+	item->device = g_object_ref(device);
+	item->device_id = g_strdup(fu_device_get_id(device));
+	item->stream_fw = g_object_ref(stream_fw);
+	item->progress = g_object_ref(progress);
+	item->device_progress = fu_device_progress_new(device, progress);
+	item->flags = flags;
+	item->feature_flags = feature_flags;
+	item->timer = g_timer_new();
+	return item;
+}
+
+static void
+fu_engine_install_item_write_clear(FuEngineInstallItem *item)
+{
+	g_clear_object(&item->poll_locker);
+	g_clear_object(&item->device_progress_write);
+	g_clear_object(&item->device_write);
+	g_clear_object(&item->stream_write);
+	g_clear_error(&item->error_write);
+	item->plugin_write = NULL;
+	item->progress_write = NULL;
+}
+
+static void
+fu_engine_install_item_free(FuEngineInstallItem *item)
+{
+	fu_engine_install_item_write_clear(item);
+	g_clear_object(&item->device_progress);
+	g_object_unref(item->progress);
+	g_object_unref(item->stream_fw);
+	g_object_unref(item->device);
+	g_timer_destroy(item->timer);
+	g_free(item->device_id);
+	g_free(item->filename_to_delete);
+	if (item->error != NULL)
+		g_error_free(item->error);
+	g_free(item);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuEngineInstallItem, fu_engine_install_item_free)
+
+/* the device and plugin both may have changed, so find them again before each write */
 static gboolean
-fu_engine_write_firmware(FuEngine *self,
-			 const gchar *device_id,
-			 GInputStream *stream_fw,
-			 FuProgress *progress,
-			 FwupdInstallFlags flags,
-			 GError **error)
+fu_engine_write_firmware_setup(FuEngine *self, FuEngineInstallItem *item, GError **error)
 {
-	FuPlugin *plugin;
-	g_autofree gchar *str = NULL;
-	g_autoptr(FuDevice) device = NULL;
-	g_autoptr(FuDeviceLocker) poll_locker = NULL;
-	g_autoptr(FuDeviceProgress) device_progress = NULL;
-	g_autoptr(GError) error_write = NULL;
+	FuProgress *progress_local = fu_progress_get_child(item->progress);
 
 	/* cancel the pending action */
+	fu_engine_install_item_write_clear(item);
 	if (!fu_engine_offline_invalidate(error))
 		return FALSE;
 
-	/* the device and plugin both may have changed */
-	device = fu_engine_get_device(self, device_id, error);
-	if (device == NULL) {
+	item->device_write = fu_engine_get_device(self, item->device_id, error);
+	if (item->device_write == NULL) {
 		g_prefix_error(error, "failed to get device before update: ");
 		return FALSE;
 	}
-	device_progress = fu_device_progress_new(device, progress);
-	g_return_val_if_fail(device_progress != NULL, FALSE);
+	item->progress_write = fu_progress_get_child(progress_local);
+	item->device_progress_write =
+	    fu_device_progress_new(item->device_write, item->progress_write);
+	g_return_val_if_fail(item->device_progress_write != NULL, FALSE);
 
 	/* pause the polling */
-	poll_locker = fu_device_poll_locker_new(device, error);
-	if (poll_locker == NULL)
+	item->poll_locker = fu_device_poll_locker_new(item->device_write, error);
+	if (item->poll_locker == NULL)
 		return FALSE;
 
-	str = fu_device_to_string(device);
-	g_info("update -> %s", str);
-	plugin =
-	    fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), error);
-	if (plugin == NULL)
-		return FALSE;
-	if (!fu_plugin_runner_write_firmware(plugin,
-					     device,
-					     stream_fw,
-					     progress,
-					     flags,
-					     &error_write)) {
-		g_autofree gchar *str_write = NULL;
-		g_autoptr(GError) error_attach = NULL;
-		g_autoptr(GError) error_cleanup = NULL;
-
-		if (g_error_matches(error_write, FWUPD_ERROR, FWUPD_ERROR_AC_POWER_REQUIRED) ||
-		    g_error_matches(error_write, FWUPD_ERROR, FWUPD_ERROR_BATTERY_LEVEL_TOO_LOW) ||
-		    g_error_matches(error_write, FWUPD_ERROR, FWUPD_ERROR_NEEDS_USER_ACTION) ||
-		    g_error_matches(error_write, FWUPD_ERROR, FWUPD_ERROR_BROKEN_SYSTEM)) {
-			fu_device_set_update_state(device, FWUPD_UPDATE_STATE_FAILED_TRANSIENT);
-		} else {
-			fu_device_set_update_state(device, FWUPD_UPDATE_STATE_FAILED);
-		}
+	g_info("update -> %s", fu_device_get_id(item->device_write));
+	fu_device_dump(item->device_write, G_LOG_DOMAIN, "update ->");
+	item->plugin_write = fu_plugin_list_find_by_name(self->plugin_list,
+							 fu_device_get_plugin(item->device_write),
+							 error);
+	return item->plugin_write != NULL;
+}
 
-		/* this is really helpful for debugging, as we want to dump the device *before*
-		 * we run cleanup */
-		str_write = fu_device_to_string(device);
-		g_debug("failed write-firmware '%s': %s", error_write->message, str_write);
+/* the plugin failed to write the firmware, so try to get back to runtime mode */
+static void
+fu_engine_write_firmware_failed(FuEngine *self, FuEngineInstallItem *item)
+{
+	FuDevice *device = item->device_write;
+	FuProgress *progress = item->progress_write;
+	const GError *error_write = item->error_write;
+	g_autoptr(GError) error_attach = NULL;
+	g_autoptr(GError) error_cleanup = NULL;
+
+	if (g_error_matches(error_write, FWUPD_ERROR, FWUPD_ERROR_AC_POWER_REQUIRED) ||
+	    g_error_matches(error_write, FWUPD_ERROR, FWUPD_ERROR_BATTERY_LEVEL_TOO_LOW) ||
+	    g_error_matches(error_write, FWUPD_ERROR, FWUPD_ERROR_NEEDS_USER_ACTION) ||
+	    g_error_matches(error_write, FWUPD_ERROR, FWUPD_ERROR_BROKEN_SYSTEM)) {
+		fu_device_set_update_state(device, FWUPD_UPDATE_STATE_FAILED_TRANSIENT);
+	} else {
+		fu_device_set_update_state(device, FWUPD_UPDATE_STATE_FAILED);
+	}
 
-		/* attach back into runtime then cleanup */
-		if (!fu_device_has_flag(device, FWUPD_DEVICE_FLAG_EMULATED)) {
-			fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_ATTACH);
-			fu_progress_reset(progress);
-			if (!fu_plugin_runner_attach(plugin, device, progress, &error_attach)) {
-				g_warning("failed to attach device after failed update: %s",
-					  error_attach->message);
-			}
-			fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_CLEANUP);
-			fu_progress_reset(progress);
-			if (!fu_engine_cleanup(self, device_id, progress, flags, &error_cleanup)) {
-				g_warning("failed to update-cleanup after failed update: %s",
-					  error_cleanup->message);
-			}
+	/* this is really helpful for debugging, as we want to dump the device *before*
+	 * we run cleanup */
+	g_debug("failed write-firmware '%s'", error_write->message);
+	fu_device_dump(device, G_LOG_DOMAIN, "failed write-firmware ->");
+
+	/* attach back into runtime then cleanup */
+	if (!fu_device_has_flag(device, FWUPD_DEVICE_FLAG_EMULATED)) {
+		fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_ATTACH);
+		fu_progress_reset(progress);
+		if (!fu_plugin_runner_attach(item->plugin_write, device, progress, &error_attach)) {
+			g_warning("failed to attach device after failed update: %s",
+				  error_attach->message);
+		}
+		fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_CLEANUP);
+		fu_progress_reset(progress);
+		if (!fu_engine_cleanup(self,
+				       item->device_id,
+				       progress,
+				       item->flags,
+				       &error_cleanup)) {
+			g_warning("failed to update-cleanup after failed update: %s",
+				  error_cleanup->message);
 		}
+	}
+}
+
+static gboolean
+fu_engine_write_firmware(FuEngine *self, FuEngineInstallItem *item, GError **error)
+{
+	if (!fu_engine_write_firmware_setup(self, item, error))
+		return FALSE;
+	if (!fu_plugin_runner_write_firmware(item->plugin_write,
+					     item->device_write,
+					     item->stream_fw,
+					     item->progress_write,
+					     item->flags,
+					     &item->error_write)) {
+		fu_engine_write_firmware_failed(self, item);
 
 		/* return error to client */
-		g_propagate_error(error, g_steal_pointer(&error_write));
+		g_propagate_error(error, g_steal_pointer(&item->error_write));
 		return FALSE;
 	}
 
 	/* save to emulated phase */
 	if (fu_context_has_flag(self->ctx, FU_CONTEXT_FLAG_SAVE_EVENTS) &&
-	    !fu_device_has_flag(device, FWUPD_DEVICE_FLAG_EMULATED)) {
+	    !fu_device_has_flag(item->device_write, FWUPD_DEVICE_FLAG_EMULATED)) {
 		if (!fu_engine_backends_save_phase(self, error))
 			return FALSE;
 	}
@@ -3511,33 +4099,20 @@ fu_engine_firmware_read(FuEngine *self,
 	return fu_device_read_firmware(device, progress, error);
 }
 
-gboolean
-fu_engine_install_blob(FuEngine *self,
-		       FuDevice *device,
-		       GInputStream *stream_fw,
-		       FuProgress *progress,
-		       FwupdInstallFlags flags,
-		       FwupdFeatureFlags feature_flags,
-		       GError **error)
+static gboolean
+fu_engine_install_blob_begin(FuEngine *self, FuEngineInstallItem *item, GError **error)
 {
-	guint retries = 0;
 	gsize streamsz = 0;
-	g_autofree gchar *device_id = NULL;
-	g_autofree gchar *filename_to_delete = NULL;
-	g_autoptr(GTimer) timer = g_timer_new();
-	g_autoptr(FuDeviceProgress) device_progress = fu_device_progress_new(device, progress);
-
-	g_return_val_if_fail(device_progress != NULL, FALSE);
 
 	/* progress */
-	fu_progress_set_id(progress, G_STRLOC);
-	fu_progress_add_flag(progress, FU_PROGRESS_FLAG_NO_PROFILE);
-	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_BUSY, 1, "prepare");
-	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_WRITE, 98, NULL);
-	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_BUSY, 1, "cleanup");
+	fu_progress_set_id(item->progress, G_STRLOC);
+	fu_progress_add_flag(item->progress, FU_PROGRESS_FLAG_NO_PROFILE);
+	fu_progress_add_step(item->progress, FWUPD_STATUS_DEVICE_BUSY, 1, "prepare");
+	fu_progress_add_step(item->progress, FWUPD_STATUS_DEVICE_WRITE, 98, NULL);
+	fu_progress_add_step(item->progress, FWUPD_STATUS_DEVICE_BUSY, 1, "cleanup");
 
 	/* test the firmware is not an empty blob */
-	if (!fu_input_stream_size(stream_fw, &streamsz, error))
+	if (!fu_input_stream_size(item->stream_fw, &streamsz, error))
 		return FALSE;
 	if (streamsz == 0) {
 		g_set_error(error,
@@ -3548,133 +4123,162 @@ fu_engine_install_blob(FuEngine *self,
 	}
 
 	/* mark this as modified even if we actually fail to do the update */
-	fu_device_set_modified_usec(device, g_get_real_time());
+	fu_device_set_modified_usec(item->device, g_get_real_time());
 
 	/* signal to all the plugins the update is about to happen */
-	device_id = g_strdup(fu_device_get_id(device));
 	fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_PREPARE);
-	if (!fu_engine_prepare(self, device_id, fu_progress_get_child(progress), flags, error))
+	if (!fu_engine_prepare(self,
+			       item->device_id,
+			       fu_progress_get_child(item->progress),
+			       item->flags,
+			       error))
 		return FALSE;
-	fu_progress_step_done(progress);
+	fu_progress_step_done(item->progress);
 
 	/* we saved this so we could do the offline update */
-	if (fu_device_get_update_state(device) == FWUPD_UPDATE_STATE_PENDING) {
+	if (fu_device_get_update_state(item->device) == FWUPD_UPDATE_STATE_PENDING) {
 		g_autoptr(FuDevice) device_pending =
-		    fu_history_get_device_by_id(self->history, device_id, NULL);
+		    fu_history_get_device_by_id(self->history, item->device_id, NULL);
 		if (device_pending != NULL) {
 			FwupdRelease *release = fu_device_get_release_default(device_pending);
-			filename_to_delete = g_strdup(fwupd_release_get_filename(release));
+			item->filename_to_delete = g_strdup(fwupd_release_get_filename(release));
 		}
 	}
 
-	/* plugins can set FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED to run again, but they
-	 * must return TRUE rather than an error */
-	do {
-		g_autoptr(FuDevice) device_tmp = NULL;
-		FuProgress *progress_local = fu_progress_get_child(progress);
+	/* success */
+	return TRUE;
+}
 
-		/* check for a loop */
-		if (++retries > 5) {
-			g_set_error_literal(error,
-					    FWUPD_ERROR,
-					    FWUPD_ERROR_INTERNAL,
-					    "aborting device write loop, limit 5");
-			return FALSE;
-		}
+static gboolean
+fu_engine_install_blob_detach(FuEngine *self, FuEngineInstallItem *item, GError **error)
+{
+	FuProgress *progress_local = fu_progress_get_child(item->progress);
 
-		/* progress */
-		if (!fu_engine_set_progress(self, device_id, progress_local, error))
-			return FALSE;
-		if (fu_progress_get_steps(progress_local) == 0) {
-			fu_progress_set_id(progress_local, G_STRLOC);
-			fu_progress_add_flag(progress_local, FU_PROGRESS_FLAG_GUESSED);
-			fu_progress_add_step(progress_local, FWUPD_STATUS_DEVICE_RESTART, 2, NULL);
-			fu_progress_add_step(progress_local, FWUPD_STATUS_DEVICE_WRITE, 94, NULL);
-			fu_progress_add_step(progress_local, FWUPD_STATUS_DEVICE_RESTART, 2, NULL);
-			fu_progress_add_step(progress_local, FWUPD_STATUS_DEVICE_BUSY, 2, NULL);
-		} else if (fu_progress_get_steps(progress_local) != 4) {
-			g_set_error_literal(error,
-					    FWUPD_ERROR,
-					    FWUPD_ERROR_INTERNAL,
-					    "FuDevice->set_progress did not set "
-					    "detach,write,attach,reload steps");
-			return FALSE;
-		}
+	/* check for a loop */
+	if (++item->retries > 5) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INTERNAL,
+				    "aborting device write loop, limit 5");
+		return FALSE;
+	}
 
-		/* detach to bootloader mode */
-		fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_DETACH);
-		if (!fu_engine_detach(self,
-				      device_id,
-				      fu_progress_get_child(progress_local),
-				      feature_flags,
-				      error)) {
-			g_prefix_error(error, "failed to detach: ");
-			return FALSE;
-		}
-		fu_progress_step_done(progress_local);
+	/* progress */
+	if (!fu_engine_set_progress(self, item->device_id, progress_local, error))
+		return FALSE;
+	if (fu_progress_get_steps(progress_local) == 0) {
+		fu_progress_set_id(progress_local, G_STRLOC);
+		fu_progress_add_flag(progress_local, FU_PROGRESS_FLAG_GUESSED);
+		fu_progress_add_step(progress_local, FWUPD_STATUS_DEVICE_RESTART, 2, NULL);
+		fu_progress_add_step(progress_local, FWUPD_STATUS_DEVICE_WRITE, 94, NULL);
+		fu_progress_add_step(progress_local, FWUPD_STATUS_DEVICE_RESTART, 2, NULL);
+		fu_progress_add_step(progress_local, FWUPD_STATUS_DEVICE_BUSY, 2, NULL);
+	} else if (fu_progress_get_steps(progress_local) != 4) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INTERNAL,
+				    "FuDevice->set_progress did not set "
+				    "detach,write,attach,reload steps");
+		return FALSE;
+	}
 
-		/* install */
-		fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_INSTALL);
-		if (!fu_engine_write_firmware(self,
-					      device_id,
-					      stream_fw,
-					      fu_progress_get_child(progress_local),
-					      flags,
-					      error)) {
-			g_prefix_error(error, "failed to write-firmware: ");
-			return FALSE;
-		}
-		fu_progress_step_done(progress_local);
+	/* detach to bootloader mode */
+	fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_DETACH);
+	if (!fu_engine_detach(self,
+			      item->device_id,
+			      fu_progress_get_child(progress_local),
+			      item->feature_flags,
+			      error)) {
+		g_prefix_error(error, "failed to detach: ");
+		return FALSE;
+	}
+	fu_progress_step_done(progress_local);
 
-		/* attach into runtime mode */
-		fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_ATTACH);
-		if (!fu_engine_attach(self,
-				      device_id,
-				      fu_progress_get_child(progress_local),
-				      error)) {
-			g_prefix_error(error, "failed to attach: ");
-			return FALSE;
-		}
-		fu_progress_step_done(progress_local);
+	/* success */
+	return TRUE;
+}
 
-		/* get the new version number */
-		fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_RELOAD);
-		if (!fu_engine_reload(self, device_id, error)) {
-			g_prefix_error(error, "failed to reload: ");
-			return FALSE;
-		}
-		fu_progress_step_done(progress_local);
+static gboolean
+fu_engine_install_blob_write(FuEngine *self, FuEngineInstallItem *item, GError **error)
+{
+	gboolean ret;
 
-		/* the device and plugin both may have changed */
-		device_tmp = fu_engine_get_device(self, device_id, error);
-		if (device_tmp == NULL) {
-			g_prefix_error(error, "failed to get device after install blob: ");
-			return FALSE;
-		}
-		if (!fu_device_has_flag(device_tmp, FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED))
-			break;
+	fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_INSTALL);
+	ret = fu_engine_write_firmware(self, item, error);
+
+	/* resume the polling */
+	fu_engine_install_item_write_clear(item);
+	if (!ret) {
+		g_prefix_error(error, "failed to write-firmware: ");
+		return FALSE;
+	}
+	fu_progress_step_done(fu_progress_get_child(item->progress));
+	return TRUE;
+}
+
+/* plugins can set FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED to run again, but they
+ * must return TRUE rather than an error */
+static gboolean
+fu_engine_install_blob_attach(FuEngine *self,
+			      FuEngineInstallItem *item,
+			      gboolean *another_write,
+			      GError **error)
+{
+	FuProgress *progress_local = fu_progress_get_child(item->progress);
+	g_autoptr(FuDevice) device_tmp = NULL;
 
+	/* attach into runtime mode */
+	fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_ATTACH);
+	if (!fu_engine_attach(self, item->device_id, fu_progress_get_child(progress_local), error)) {
+		g_prefix_error(error, "failed to attach: ");
+		return FALSE;
+	}
+	fu_progress_step_done(progress_local);
+
+	/* get the new version number */
+	fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_RELOAD);
+	if (!fu_engine_reload(self, item->device_id, error)) {
+		g_prefix_error(error, "failed to reload: ");
+		return FALSE;
+	}
+	fu_progress_step_done(progress_local);
+
+	/* the device and plugin both may have changed */
+	device_tmp = fu_engine_get_device(self, item->device_id, error);
+	if (device_tmp == NULL) {
+		g_prefix_error(error, "failed to get device after install blob: ");
+		return FALSE;
+	}
+	*another_write = fu_device_has_flag(device_tmp, FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED);
+	if (*another_write) {
 		/* don't rely on a plugin clearing this */
 		fu_device_remove_flag(device_tmp, FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED);
 		fu_progress_reset(progress_local);
+	}
 
-	} while (TRUE);
-	fu_progress_step_done(progress);
+	/* success */
+	return TRUE;
+}
+
+static gboolean
+fu_engine_install_blob_finish(FuEngine *self, FuEngineInstallItem *item, GError **error)
+{
+	fu_progress_step_done(item->progress);
 
 	/* delete offline-update cab archive */
-	if (filename_to_delete != NULL) {
-		g_autoptr(GFile) file = g_file_new_for_path(filename_to_delete);
+	if (item->filename_to_delete != NULL) {
+		g_autoptr(GFile) file = g_file_new_for_path(item->filename_to_delete);
 		if (!g_file_delete(file, NULL, error)) {
-			g_prefix_error(error, "failed to delete %s: ", filename_to_delete);
+			g_prefix_error(error, "failed to delete %s: ", item->filename_to_delete);
 			return FALSE;
 		}
 	}
 
 	/* update history database */
-	fu_device_set_update_state(device, FWUPD_UPDATE_STATE_SUCCESS);
-	fu_device_set_install_duration(device, g_timer_elapsed(timer, NULL));
-	if ((flags & FWUPD_INSTALL_FLAG_NO_HISTORY) == 0) {
-		if (!fu_history_modify_device(self->history, device, error)) {
+	fu_device_set_update_state(item->device, FWUPD_UPDATE_STATE_SUCCESS);
+	fu_device_set_install_duration(item->device, g_timer_elapsed(item->timer, NULL));
+	if ((item->flags & FWUPD_INSTALL_FLAG_NO_HISTORY) == 0) {
+		if (!fu_history_modify_device(self->history, item->device, error)) {
 			g_prefix_error(error, "failed to set success: ");
 			return FALSE;
 		}
@@ -3682,18 +4286,282 @@ fu_engine_install_blob(FuEngine *self,
 
 	/* signal to all the plugins the update has happened */
 	fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_CLEANUP);
-	if (!fu_engine_cleanup(self, device_id, fu_progress_get_child(progress), flags, error))
+	if (!fu_engine_cleanup(self,
+			       item->device_id,
+			       fu_progress_get_child(item->progress),
+			       item->flags,
+			       error))
 		return FALSE;
-	fu_progress_step_done(progress);
+	fu_progress_step_done(item->progress);
 
 	/* make the UI update */
-	fu_engine_emit_device_changed(self, device_id);
+	fu_engine_emit_device_changed(self, item->device_id);
 	g_info("Updating %s took %f seconds",
-	       fu_device_get_name(device),
-	       g_timer_elapsed(timer, NULL));
+	       fu_device_get_name(item->device),
+	       g_timer_elapsed(item->timer, NULL));
 	return TRUE;
 }
 
+gboolean
+fu_engine_install_blob(FuEngine *self,
+		       FuDevice *device,
+		       GInputStream *stream_fw,
+		       FuProgress *progress,
+		       FwupdInstallFlags flags,
+		       FwupdFeatureFlags feature_flags,
+		       GError **error)
+{
+	gboolean another_write = FALSE;
+	g_autoptr(FuEngineInstallItem) item =
+	    fu_engine_install_item_new(device, stream_fw, progress, flags, feature_flags);
+
+	if (!fu_engine_install_blob_begin(self, item, error))
+		return FALSE;
+	do {
+		if (!fu_engine_install_blob_detach(self, item, error))
+			return FALSE;
+		if (!fu_engine_install_blob_write(self, item, error))
+			return FALSE;
+		if (!fu_engine_install_blob_attach(self, item, &another_write, error))
+			return FALSE;
+	} while (another_write);
+	return fu_engine_install_blob_finish(self, item, error);
+}
+
+/* runs in a worker thread, but only for plugins with FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL */
+static void
+fu_engine_install_write_worker_cb(gpointer data, gpointer user_data)
+{
+	FuEngineInstallItem *item = (FuEngineInstallItem *)data;
+	gint *done = (gint *)user_data;
+	(void)fu_plugin_runner_write_firmware(item->plugin_write,
+					      item->device_write,
+					      item->stream_write,
+					      item->progress_write,
+					      item->flags,
+					      &item->error_write);
+	g_atomic_int_inc(done);
+	g_main_context_wakeup(NULL);
+}
+
+static gboolean
+fu_engine_install_write_poll_cb(gpointer user_data)
+{
+	/* just wake up the main context to update the aggregate progress */
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+fu_engine_install_items_set_percentage(GPtrArray *items, FuProgress *progress)
+{
+	guint percentage = 0;
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineInstallItem *item = g_ptr_array_index(items, i);
+		guint percentage_item = fu_progress_get_percentage(item->progress);
+		if (percentage_item <= 100)
+			percentage += percentage_item;
+	}
+	fu_progress_set_percentage(progress, percentage / items->len);
+}
+
+/* only the plugin write-firmware vfunc is run in the pool, everything else including waiting
+ * for the devices to replug is done in the main thread */
+static void
+fu_engine_install_items_write(FuEngine *self, GPtrArray *items, FuProgress *progress)
+{
+	GThreadPool *pool;
+	guint max_threads = fu_engine_config_get_install_threads(self->config);
+	guint poll_id;
+	guint todo = 0;
+	gint done = 0;
+	g_autoptr(GError) error_pool = NULL;
+	g_autoptr(GError) error_replug = NULL;
+
+	pool = g_thread_pool_new(fu_engine_install_write_worker_cb,
+				 &done,
+				 MIN(max_threads, items->len),
+				 FALSE,
+				 &error_pool);
+	if (pool == NULL)
+		g_warning("failed to create install pool: %s", error_pool->message);
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineInstallItem *item = g_ptr_array_index(items, i);
+		g_autoptr(GBytes) blob = NULL;
+		g_autoptr(GError) error_local = NULL;
+
+		if (item->error != NULL)
+			continue;
+		fu_engine_set_install_phase(self, FU_ENGINE_INSTALL_PHASE_INSTALL);
+		if (!fu_engine_write_firmware_setup(self, item, &item->error)) {
+			fu_engine_install_item_write_clear(item);
+			g_prefix_error(&item->error, "failed to write-firmware: ");
+			continue;
+		}
+
+		/* the firmware streams may share a seekable base stream, so each worker gets its
+		 * own view -- which is only a copy if the archive was not mapped */
+		blob = fu_input_stream_read_bytes_borrowed(item->stream_fw,
+							   0,
+							   G_MAXSIZE,
+							   &item->error);
+		if (blob == NULL) {
+			fu_engine_install_item_write_clear(item);
+			continue;
+		}
+		item->stream_write = g_memory_input_stream_new_from_bytes(blob);
+		todo++;
+
+		/* the plugin may have changed when the device was detached */
+		if (pool == NULL ||
+		    !fu_plugin_has_flag(item->plugin_write, FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL)) {
+			fu_engine_install_write_worker_cb(item, &done);
+			continue;
+		}
+		if (!g_thread_pool_push(pool, item, &error_local)) {
+			g_warning("failed to push install item: %s", error_local->message);
+			fu_engine_install_write_worker_cb(item, &done);
+		}
+	}
+
+	/* the main context has to keep running for device signals, but the backends must not
+	 * change the devices that are being written */
+	fu_engine_backend_events_defer_begin(self);
+	poll_id = g_timeout_add(100, fu_engine_install_write_poll_cb, NULL);
+	while ((guint)g_atomic_int_get(&done) < todo) {
+		g_main_context_iteration(NULL, TRUE);
+		fu_engine_install_items_set_percentage(items, progress);
+	}
+	g_source_remove(poll_id);
+	if (pool != NULL)
+		g_thread_pool_free(pool, FALSE, TRUE);
+	fu_engine_backend_events_defer_end(self);
+
+	/* attach back into runtime any device that failed */
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineInstallItem *item = g_ptr_array_index(items, i);
+		if (item->error != NULL || item->error_write == NULL)
+			continue;
+		fu_engine_write_firmware_failed(self, item);
+		item->error = g_steal_pointer(&item->error_write);
+		g_prefix_error(&item->error, "failed to write-firmware: ");
+		fu_engine_install_item_write_clear(item);
+	}
+
+	/* wait for all the devices to disconnect and reconnect */
+	if (!fu_device_list_wait_for_replug(self->device_list, &error_replug))
+		g_prefix_error(&error_replug, "failed to wait for write-firmware replug: ");
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineInstallItem *item = g_ptr_array_index(items, i);
+		if (item->error != NULL)
+			continue;
+
+		/* resume the polling */
+		fu_engine_install_item_write_clear(item);
+		if (error_replug != NULL) {
+			item->error = g_error_copy(error_replug);
+			g_prefix_error(&item->error, "failed to write-firmware: ");
+			continue;
+		}
+		fu_progress_step_done(fu_progress_get_child(item->progress));
+	}
+}
+
+/* install a batch of independent devices, with only write-firmware done at the same time */
+static gboolean
+fu_engine_install_releases_batch(FuEngine *self,
+				 GPtrArray *releases,
+				 guint idx,
+				 guint batch_len,
+				 FuProgress *progress,
+				 FwupdInstallFlags flags,
+				 GError **error)
+{
+	gboolean ret = TRUE;
+	g_autoptr(GPtrArray) items =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_install_item_free);
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	/* prepare and detach each device in turn */
+	for (guint i = idx; i < idx + batch_len; i++) {
+		FuRelease *release = g_ptr_array_index(releases, i);
+		FuEngineRequest *request = fu_release_get_request(release);
+		FwupdFeatureFlags feature_flags = FWUPD_FEATURE_FLAG_NONE;
+		FuEngineInstallItem *item;
+		g_autoptr(FuProgress) progress_item = fu_progress_new(G_STRLOC);
+
+		/* optional for tests */
+		if (request != NULL)
+			feature_flags = fu_engine_request_get_feature_flags(request);
+		item = fu_engine_install_item_new(fu_release_get_device(release),
+						  fu_release_get_stream(release),
+						  progress_item,
+						  flags,
+						  feature_flags);
+		item->release = release;
+		g_ptr_array_add(items, item);
+		if (!fu_engine_install_release_prepare(self, release, item->stream_fw, &item->error))
+			continue;
+		if (!fu_engine_install_release_add_history(self, release, flags, &item->error))
+			continue;
+		item->installing = TRUE;
+		if (!fu_engine_install_blob_begin(self, item, &item->error))
+			continue;
+		if (!fu_engine_install_blob_detach(self, item, &item->error))
+			continue;
+	}
+
+	/* write all the firmware at the same time */
+	fu_engine_install_items_write(self, items, progress);
+
+	/* attach, reload and cleanup each device in turn */
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineInstallItem *item = g_ptr_array_index(items, i);
+		gboolean another_write = FALSE;
+
+		if (item->error != NULL)
+			continue;
+		if (!fu_engine_install_blob_attach(self, item, &another_write, &item->error))
+			continue;
+
+		/* any extra writes are done one device at a time */
+		while (another_write) {
+			if (!fu_engine_install_blob_detach(self, item, &item->error) ||
+			    !fu_engine_install_blob_write(self, item, &item->error) ||
+			    !fu_engine_install_blob_attach(self, item, &another_write, &item->error))
+				break;
+		}
+		if (item->error != NULL)
+			continue;
+		if (!fu_engine_install_blob_finish(self, item, &item->error))
+			continue;
+		item->installing = FALSE;
+		(void)fu_engine_install_release_finish(self,
+						       item->release,
+						       item->progress,
+						       &item->error);
+	}
+	g_info("installed %u devices using %u threads in %.2fms",
+	       items->len,
+	       MIN(fu_engine_config_get_install_threads(self->config), items->len),
+	       g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* report the first failure, but show them all */
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineInstallItem *item = g_ptr_array_index(items, i);
+		if (item->error == NULL)
+			continue;
+		if (item->installing)
+			fu_engine_install_release_failed(item->release, item->error);
+		if (ret) {
+			g_propagate_error(error, g_steal_pointer(&item->error));
+			ret = FALSE;
+			continue;
+		}
+		g_warning("failed to install %s: %s", item->device_id, item->error->message);
+	}
+	return ret;
+}
+
 static FuDevice *
 fu_engine_get_item_by_id_fallback_history(FuEngine *self, const gchar *id, GError **error)
 {
@@ -3750,101 +4618,109 @@ fu_engine_get_item_by_id_fallback_history(FuEngine *self, const gchar *id, GErro
 	return NULL;
 }
 
-static gboolean
-fu_engine_create_silo_index(FuEngine *self, GError **error)
+static FuEngineSilo *
+fu_engine_silo_new(const gchar *id, XbSilo *silo, GError **error)
 {
+	g_autoptr(FuEngineSilo) shard = g_new0(FuEngineSilo, 1);
 	g_autoptr(GPtrArray) components = NULL;
 	g_autoptr(GError) error_container_checksum1 = NULL;
 	g_autoptr(GError) error_container_checksum2 = NULL;
 	g_autoptr(GError) error_tag_by_guid_version = NULL;
 
+	shard->id = g_strdup(id);
+	shard->silo = g_object_ref(silo);
+
 	/* print what we've got */
-	components = xb_silo_query(self->silo, "components/component[@type='firmware']", 0, NULL);
-	if (components == NULL)
-		return TRUE;
-	g_info("%u components now in silo", components->len);
-
-	/* clear old prepared queries */
-	g_clear_object(&self->query_component_by_guid);
-	g_clear_object(&self->query_container_checksum1);
-	g_clear_object(&self->query_container_checksum2);
-	g_clear_object(&self->query_tag_by_guid_version);
-
-	/* build the index */
-	if (!xb_silo_query_build_index(self->silo, "components/component", "type", error))
-		return FALSE;
-	if (!xb_silo_query_build_index(self->silo,
-				       "components/component[@type='firmware']/provides/firmware",
-				       "type",
-				       error))
-		return FALSE;
-	if (!xb_silo_query_build_index(self->silo,
-				       "components/component/provides/firmware",
-				       NULL,
-				       error))
-		return FALSE;
-	if (!xb_silo_query_build_index(self->silo,
-				       "components/component[@type='firmware']/tags/tag",
-				       "namespace",
-				       error))
-		return FALSE;
-
-	/* create prepared queries to save time later */
-	self->query_component_by_guid =
-	    xb_query_new_full(self->silo,
-			      "components/component/provides/firmware[@type=$'flashed'][text()=?]/"
-			      "../..",
-			      XB_QUERY_FLAG_OPTIMIZE,
-			      error);
-	if (self->query_component_by_guid == NULL) {
-		g_prefix_error(error, "failed to prepare query: ");
-		return FALSE;
-	}
+	components = xb_silo_query(silo, "components/component[@type='firmware']", 0, NULL);
+	if (components != NULL) {
+		g_info("%u components now in silo %s", components->len, id);
 
-	/* old-style <checksum target="container"> and new-style <artifact> */
-	self->query_container_checksum1 =
-	    xb_query_new_full(self->silo,
-			      "components/component[@type='firmware']/releases/release/"
-			      "checksum[@target='container'][text()=?]/..",
-			      XB_QUERY_FLAG_OPTIMIZE,
-			      &error_container_checksum1);
-	if (self->query_container_checksum1 == NULL)
-		g_debug("ignoring prepared query: %s", error_container_checksum1->message);
-	self->query_container_checksum2 =
-	    xb_query_new_full(self->silo,
-			      "components/component[@type='firmware']/releases/release/"
-			      "artifacts/artifact[@type='binary']/checksum[text()=?]/"
-			      "../../..",
-			      XB_QUERY_FLAG_OPTIMIZE,
-			      &error_container_checksum2);
-	if (self->query_container_checksum2 == NULL)
-		g_debug("ignoring prepared query: %s", error_container_checksum2->message);
+		/* build the index */
+		if (!xb_silo_query_build_index(silo, "components/component", "type", error))
+			return NULL;
+		if (!xb_silo_query_build_index(silo,
+					       "components/component[@type='firmware']/"
+					       "provides/firmware",
+					       "type",
+					       error))
+			return NULL;
+		if (!xb_silo_query_build_index(silo,
+					       "components/component/provides/firmware",
+					       NULL,
+					       error))
+			return NULL;
+		if (!xb_silo_query_build_index(silo,
+					       "components/component[@type='firmware']/tags/tag",
+					       "namespace",
+					       error))
+			return NULL;
+
+		/* create prepared queries to save time later */
+		shard->query_component_by_guid =
+		    xb_query_new_full(silo,
+				      "components/component/provides/"
+				      "firmware[@type=$'flashed'][text()=?]/../..",
+				      XB_QUERY_FLAG_OPTIMIZE,
+				      error);
+		if (shard->query_component_by_guid == NULL) {
+			g_prefix_error(error, "failed to prepare query: ");
+			return NULL;
+		}
+
+		/* old-style <checksum target="container"> and new-style <artifact> */
+		shard->query_container_checksum1 =
+		    xb_query_new_full(silo,
+				      "components/component[@type='firmware']/releases/release/"
+				      "checksum[@target='container'][text()=?]/..",
+				      XB_QUERY_FLAG_OPTIMIZE,
+				      &error_container_checksum1);
+		if (shard->query_container_checksum1 == NULL) {
+			g_debug("ignoring prepared query: %s",
+				error_container_checksum1->message);
+		}
+		shard->query_container_checksum2 =
+		    xb_query_new_full(silo,
+				      "components/component[@type='firmware']/releases/release/"
+				      "artifacts/artifact[@type='binary']/checksum[text()=?]/"
+				      "../../..",
+				      XB_QUERY_FLAG_OPTIMIZE,
+				      &error_container_checksum2);
+		if (shard->query_container_checksum2 == NULL) {
+			g_debug("ignoring prepared query: %s",
+				error_container_checksum2->message);
+		}
+	}
 
 	/* prepare tag query with bound GUID parameter */
-	self->query_tag_by_guid_version =
-	    xb_query_new_full(self->silo,
+	shard->query_tag_by_guid_version =
+	    xb_query_new_full(silo,
 			      "local/components/component[@merge='append']/provides/"
 			      "firmware[text()=?]/../../releases/release[@version=?]/../../"
 			      "tags/tag",
 			      XB_QUERY_FLAG_OPTIMIZE,
 			      &error_tag_by_guid_version);
-	if (self->query_tag_by_guid_version == NULL)
+	if (shard->query_tag_by_guid_version == NULL)
 		g_debug("ignoring prepared query: %s", error_tag_by_guid_version->message);
 
 	/* success */
-	return TRUE;
+	return g_steal_pointer(&shard);
 }
 
 /* for the self tests */
 void
 fu_engine_set_silo(FuEngine *self, XbSilo *silo)
 {
+	FuEngineSilo *shard;
 	g_autoptr(GError) error_local = NULL;
 	g_return_if_fail(FU_IS_ENGINE(self));
 	g_return_if_fail(XB_IS_SILO(silo));
-	g_set_object(&self->silo, silo);
-	if (!fu_engine_create_silo_index(self, &error_local))
+	g_ptr_array_set_size(self->silos, 0);
+	shard = fu_engine_silo_new("self-test", silo, &error_local);
+	if (shard == NULL) {
 		g_warning("failed to create indexes: %s", error_local->message);
+		return;
+	}
+	g_ptr_array_add(self->silos, shard);
 }
 
 static gboolean
@@ -4081,16 +4957,67 @@ fu_engine_load_metadata_store_local(FuEngine *self,
 	return TRUE;
 }
 
+/* import the metadata for one remote */
 static gboolean
-fu_engine_load_metadata_store(FuEngine *self, FuEngineLoadFlags flags, GError **error)
+fu_engine_load_metadata_store_remote(FuEngine *self,
+				     XbBuilder *builder,
+				     FwupdRemote *remote,
+				     GError **error)
+{
+	const gchar *path = fwupd_remote_get_filename_cache(remote);
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(XbBuilderFixup) fixup = NULL;
+	g_autoptr(XbBuilderNode) custom = NULL;
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+
+	/* generate all metadata on demand */
+	if (fwupd_remote_get_kind(remote) == FWUPD_REMOTE_KIND_DIRECTORY) {
+		g_info("loading metadata for remote '%s'", fwupd_remote_get_id(remote));
+		return fu_engine_create_metadata(self, builder, remote, error);
+	}
+
+	/* save the remote-id in the custom metadata space */
+	file = g_file_new_for_path(path);
+	if (!xb_builder_source_load_file(source, file, XB_BUILDER_SOURCE_FLAG_NONE, NULL, error))
+		return FALSE;
+
+	/* fix up any legacy installed files */
+	fixup = xb_builder_fixup_new("AppStreamUpgrade",
+				     fu_engine_appstream_upgrade_cb,
+				     self,
+				     NULL);
+	xb_builder_fixup_set_max_depth(fixup, 3);
+	xb_builder_source_add_fixup(source, fixup);
+
+	/* add metadata */
+	custom = xb_builder_node_new("custom");
+	xb_builder_node_insert_text(custom, "value", path, "key", "fwupd::FilenameCache", NULL);
+	xb_builder_node_insert_text(custom,
+				    "value",
+				    fwupd_remote_get_id(remote),
+				    "key",
+				    "fwupd::RemoteId",
+				    NULL);
+	xb_builder_source_set_info(source, custom);
+
+	/* we need to watch for changes? */
+	xb_builder_import_source(builder, source);
+	return TRUE;
+}
+
+/* compile the silo only if the sources changed, and reuse the indexes if the silo is unchanged */
+static FuEngineSilo *
+fu_engine_load_metadata_silo(FuEngine *self,
+			     const gchar *id,
+			     XbBuilder *builder,
+			     FuEngineLoadFlags flags,
+			     GPtrArray *silos_old,
+			     GError **error)
 {
-	GPtrArray *remotes;
 	XbBuilderCompileFlags compile_flags = XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID;
+	g_autofree gchar *basename = g_strdup_printf("metadata-%s.xmlb", id);
 	g_autoptr(GFile) xmlb = NULL;
-	g_autoptr(XbBuilder) builder = xb_builder_new();
-
-	/* clear existing silo */
-	g_clear_object(&self->silo);
+	g_autoptr(XbSilo) silo = NULL;
 
 	/* invalidate the cache if the fwupd version changes */
 	xb_builder_append_guid(builder, SOURCE_VERSION);
@@ -4102,107 +5029,132 @@ fu_engine_load_metadata_store(FuEngine *self, FuEngineLoadFlags flags, GError **
 						 XB_SILO_PROFILE_FLAG_DEBUG);
 	}
 
-	/* load each enabled metadata file */
+	/* on a read-only filesystem don't care about the cache GUID */
+	if (flags & FU_ENGINE_LOAD_FLAG_READONLY)
+		compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
+
+	/* ensure silo is up to date */
+	if (flags & FU_ENGINE_LOAD_FLAG_NO_CACHE) {
+		g_autoptr(GFileIOStream) iostr = NULL;
+		xmlb = g_file_new_tmp(NULL, &iostr, error);
+		if (xmlb == NULL)
+			return NULL;
+	} else {
+		g_autofree gchar *cachedirpkg = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
+		g_autofree gchar *xmlbfn = g_build_filename(cachedirpkg, basename, NULL);
+		xmlb = g_file_new_for_path(xmlbfn);
+	}
+	silo = xb_builder_ensure(builder, xmlb, compile_flags, NULL, error);
+	if (silo == NULL) {
+		g_prefix_error(error, "cannot create %s: ", basename);
+		return NULL;
+	}
+
+	/* nothing changed */
+	for (guint i = 0; i < silos_old->len; i++) {
+		FuEngineSilo *shard = g_ptr_array_index(silos_old, i);
+		if (g_strcmp0(shard->id, id) == 0 &&
+		    g_strcmp0(xb_silo_get_guid(shard->silo), xb_silo_get_guid(silo)) == 0) {
+			g_debug("reusing unchanged silo %s", id);
+			return g_ptr_array_steal_index(silos_old, i);
+		}
+	}
+	return fu_engine_silo_new(id, silo, error);
+}
+
+/* delete the silos of remotes that have been removed or disabled, and the legacy silo */
+static void
+fu_engine_load_metadata_store_cleanup(GPtrArray *basenames)
+{
+	g_autofree gchar *cachedirpkg = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
+	g_autoptr(GPtrArray) fns = fu_path_glob(cachedirpkg, "metadata*.xmlb", NULL);
+
+	if (fns == NULL)
+		return;
+	for (guint i = 0; i < fns->len; i++) {
+		const gchar *fn = g_ptr_array_index(fns, i);
+		g_autofree gchar *basename = g_path_get_basename(fn);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GFile) file = NULL;
+
+		if (g_ptr_array_find_with_equal_func(basenames, basename, g_str_equal, NULL))
+			continue;
+		g_info("deleting unused %s", fn);
+		file = g_file_new_for_path(fn);
+		if (!g_file_delete(file, NULL, &error_local))
+			g_warning("failed to delete %s: %s", fn, error_local->message);
+	}
+}
+
+static gboolean
+fu_engine_load_metadata_store(FuEngine *self, FuEngineLoadFlags flags, GError **error)
+{
+	GPtrArray *remotes;
+	FuEngineSilo *shard;
+	g_autoptr(GPtrArray) basenames = g_ptr_array_new_with_free_func(g_free);
+	g_autoptr(GPtrArray) silos_old = g_steal_pointer(&self->silos);
+	g_autoptr(XbBuilder) builder_local = xb_builder_new();
+
+	/* each remote is compiled into its own silo so a refresh does not rebuild them all */
+	self->silos = g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_silo_free);
 	remotes = fu_remote_list_get_all(self->remote_list);
 	for (guint i = 0; i < remotes->len; i++) {
+		FwupdRemote *remote = g_ptr_array_index(remotes, i);
 		const gchar *path = NULL;
 		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GFile) file = NULL;
-		g_autoptr(XbBuilderFixup) fixup = NULL;
-		g_autoptr(XbBuilderNode) custom = NULL;
-		g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+		g_autoptr(XbBuilder) builder = xb_builder_new();
 
-		FwupdRemote *remote = g_ptr_array_index(remotes, i);
 		if (!fwupd_remote_has_flag(remote, FWUPD_REMOTE_FLAG_ENABLED))
 			continue;
+		g_ptr_array_add(basenames,
+				g_strdup_printf("metadata-%s.xmlb", fwupd_remote_get_id(remote)));
 		path = fwupd_remote_get_filename_cache(remote);
 		if (!g_file_test(path, G_FILE_TEST_EXISTS))
 			continue;
-
-		/* generate all metadata on demand */
-		if (fwupd_remote_get_kind(remote) == FWUPD_REMOTE_KIND_DIRECTORY) {
-			g_info("loading metadata for remote '%s'", fwupd_remote_get_id(remote));
-			if (!fu_engine_create_metadata(self, builder, remote, &error_local)) {
-				g_warning("failed to generate remote %s: %s",
-					  fwupd_remote_get_id(remote),
-					  error_local->message);
-			}
+		if (!fu_engine_load_metadata_store_remote(self, builder, remote, &error_local)) {
+			g_warning("failed to load remote %s: %s",
+				  fwupd_remote_get_id(remote),
+				  error_local->message);
 			continue;
 		}
-
-		/* save the remote-id in the custom metadata space */
-		file = g_file_new_for_path(path);
-		if (!xb_builder_source_load_file(source,
-						 file,
-						 XB_BUILDER_SOURCE_FLAG_NONE,
-						 NULL,
-						 &error_local)) {
+		shard = fu_engine_load_metadata_silo(self,
+						     fwupd_remote_get_id(remote),
+						     builder,
+						     flags,
+						     silos_old,
+						     &error_local);
+		if (shard == NULL) {
 			g_warning("failed to load remote %s: %s",
 				  fwupd_remote_get_id(remote),
 				  error_local->message);
 			continue;
 		}
-
-		/* fix up any legacy installed files */
-		fixup = xb_builder_fixup_new("AppStreamUpgrade",
-					     fu_engine_appstream_upgrade_cb,
-					     self,
-					     NULL);
-		xb_builder_fixup_set_max_depth(fixup, 3);
-		xb_builder_source_add_fixup(source, fixup);
-
-		/* add metadata */
-		custom = xb_builder_node_new("custom");
-		xb_builder_node_insert_text(custom,
-					    "value",
-					    path,
-					    "key",
-					    "fwupd::FilenameCache",
-					    NULL);
-		xb_builder_node_insert_text(custom,
-					    "value",
-					    fwupd_remote_get_id(remote),
-					    "key",
-					    "fwupd::RemoteId",
-					    NULL);
-		xb_builder_source_set_info(source, custom);
-
-		/* we need to watch for changes? */
-		xb_builder_import_source(builder, source);
+		g_ptr_array_add(self->silos, shard);
 	}
 
 	/* add any client-side data, e.g. BKC tags */
 	if (!fu_engine_load_metadata_store_local(self,
-						 builder,
+						 builder_local,
 						 FU_PATH_KIND_LOCALSTATEDIR_PKG,
 						 error))
 		return FALSE;
-	if (!fu_engine_load_metadata_store_local(self, builder, FU_PATH_KIND_DATADIR_PKG, error))
+	if (!fu_engine_load_metadata_store_local(self,
+						 builder_local,
+						 FU_PATH_KIND_DATADIR_PKG,
+						 error))
 		return FALSE;
-
-	/* on a read-only filesystem don't care about the cache GUID */
-	if (flags & FU_ENGINE_LOAD_FLAG_READONLY)
-		compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
-
-	/* ensure silo is up to date */
-	if (flags & FU_ENGINE_LOAD_FLAG_NO_CACHE) {
-		g_autoptr(GFileIOStream) iostr = NULL;
-		xmlb = g_file_new_tmp(NULL, &iostr, error);
-		if (xmlb == NULL)
-			return FALSE;
-	} else {
-		g_autofree gchar *cachedirpkg = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
-		g_autofree gchar *xmlbfn = g_build_filename(cachedirpkg, "metadata.xmlb", NULL);
-		xmlb = g_file_new_for_path(xmlbfn);
-	}
-	self->silo = xb_builder_ensure(builder, xmlb, compile_flags, NULL, error);
-	if (self->silo == NULL) {
-		g_prefix_error(error, "cannot create metadata.xmlb: ");
+	shard = fu_engine_load_metadata_silo(self, "local", builder_local, flags, silos_old, error);
+	if (shard == NULL)
 		return FALSE;
-	}
+	g_ptr_array_add(self->silos, shard);
+	g_ptr_array_add(basenames, g_strdup("metadata-local.xmlb"));
+
+	/* nothing else is going to use these */
+	if ((flags & (FU_ENGINE_LOAD_FLAG_NO_CACHE | FU_ENGINE_LOAD_FLAG_READONLY)) == 0)
+		fu_engine_load_metadata_store_cleanup(basenames);
 
 	/* success */
-	return fu_engine_create_silo_index(self, error);
+	return TRUE;
 }
 
 static void
@@ -4250,7 +5202,7 @@ fu_engine_metadata_changed(FuEngine *self)
 	fu_engine_md_refresh_devices(self);
 
 	/* invalidate host security attributes */
-	g_clear_pointer(&self->host_security_id, g_free);
+	fu_engine_invalidate_security_attrs(self);
 
 	/* make the UI update */
 	fu_engine_emit_changed(self);
@@ -4515,7 +5467,7 @@ fu_engine_update_metadata_bytes(FuEngine *self,
 	fu_engine_md_refresh_devices(self);
 
 	/* invalidate host security attributes */
-	g_clear_pointer(&self->host_security_id, g_free);
+	fu_engine_invalidate_security_attrs(self);
 
 	/* make the UI update */
 	fu_engine_emit_changed(self);
@@ -5269,14 +6221,18 @@ fu_engine_add_releases_for_device_component(FuEngine *self,
 		/* invalid */
 		locations = fwupd_release_get_locations(FWUPD_RELEASE(release));
 		if (locations->len == 0) {
-			g_autofree gchar *str = fwupd_codec_to_string(FWUPD_CODEC(release));
-			g_debug("no locations for %s", str);
+			if (fu_dump_is_enabled(G_LOG_DOMAIN)) {
+				g_autofree gchar *str = fwupd_codec_to_string(FWUPD_CODEC(release));
+				g_debug("no locations for %s", str);
+			}
 			continue;
 		}
 		checksums = fu_release_get_checksums(release);
 		if (checksums->len == 0) {
-			g_autofree gchar *str = fwupd_codec_to_string(FWUPD_CODEC(release));
-			g_debug("no locations for %s", str);
+			if (fu_dump_is_enabled(G_LOG_DOMAIN)) {
+				g_autofree gchar *str = fwupd_codec_to_string(FWUPD_CODEC(release));
+				g_debug("no locations for %s", str);
+			}
 			continue;
 		}
 
@@ -5362,6 +6318,56 @@ fu_engine_get_branch_fallback(const gchar *nullable_branch)
 	return nullable_branch;
 }
 
+/* all the components in every silo that provide the GUID */
+static GPtrArray *
+fu_engine_get_components_by_guid(FuEngine *self, const gchar *guid)
+{
+	GPtrArray *components_cached;
+	g_autoptr(GPtrArray) components =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+
+	/* shared between devices in fu_engine_get_upgrades_all() */
+	if (self->components_by_guid != NULL) {
+		components_cached = g_hash_table_lookup(self->components_by_guid, guid);
+		if (components_cached != NULL)
+			return g_ptr_array_ref(components_cached);
+	}
+
+	/* query each silo in priority order */
+	xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
+	for (guint k = 0; k < self->silos->len; k++) {
+		FuEngineSilo *shard = g_ptr_array_index(self->silos, k);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) components_tmp = NULL;
+
+		if (shard->query_component_by_guid == NULL)
+			continue;
+		components_tmp = xb_silo_query_with_context(shard->silo,
+							    shard->query_component_by_guid,
+							    &context,
+							    &error_local);
+		if (components_tmp == NULL) {
+			g_debug("%s was not found in %s: %s",
+				guid,
+				shard->id,
+				error_local->message);
+			continue;
+		}
+		for (guint i = 0; i < components_tmp->len; i++) {
+			XbNode *component = g_ptr_array_index(components_tmp, i);
+			g_ptr_array_add(components, g_object_ref(component));
+		}
+	}
+	if (self->components_by_guid != NULL) {
+		g_hash_table_insert(self->components_by_guid,
+				    g_strdup(guid),
+				    g_ptr_array_ref(components));
+	}
+	return g_steal_pointer(&components);
+}
+
 GPtrArray *
 fu_engine_get_releases_for_device(FuEngine *self,
 				  FuEngineRequest *request,
@@ -5369,11 +6375,19 @@ fu_engine_get_releases_for_device(FuEngine *self,
 				  GError **error)
 {
 	GPtrArray *device_guids;
+	gboolean has_components = FALSE;
 	g_autoptr(GPtrArray) branches = NULL;
 	g_autoptr(GPtrArray) releases = NULL;
 
-	/* no components in silo */
-	if (self->query_component_by_guid == NULL) {
+	/* no components in any silo */
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *shard = g_ptr_array_index(self->silos, i);
+		if (shard->query_component_by_guid != NULL) {
+			has_components = TRUE;
+			break;
+		}
+	}
+	if (!has_components) {
 		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "no components in silo");
 		return NULL;
 	}
@@ -5416,20 +6430,10 @@ fu_engine_get_releases_for_device(FuEngine *self,
 	releases = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 	for (guint j = 0; j < device_guids->len; j++) {
 		const gchar *guid = g_ptr_array_index(device_guids, j);
-		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GPtrArray) components = NULL;
-		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		g_autoptr(GPtrArray) components = fu_engine_get_components_by_guid(self, guid);
 
-		xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
-		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
-		components = xb_silo_query_with_context(self->silo,
-							self->query_component_by_guid,
-							&context,
-							&error_local);
-		if (components == NULL) {
-			g_debug("%s was not found: %s", guid, error_local->message);
+		if (components->len == 0)
 			continue;
-		}
 
 		/* find all the releases that pass all the requirements */
 		g_debug("%s matched %u components", guid, components->len);
@@ -5759,37 +6763,16 @@ fu_engine_self_sign(FuEngine *self, const gchar *value, JcatSignFlags flags, GEr
 	return jcat_blob_get_data_as_string(jcat_signature);
 }
 
-/**
- * fu_engine_get_upgrades:
- * @self: a #FuEngine
- * @request: a #FuEngineRequest
- * @device_id: a device ID
- * @error: (nullable): optional return location for an error
- *
- * Gets the upgrades available for a specific device.
- *
- * Returns: (transfer container) (element-type FwupdDevice): results
- **/
-GPtrArray *
-fu_engine_get_upgrades(FuEngine *self,
-		       FuEngineRequest *request,
-		       const gchar *device_id,
-		       GError **error)
+static GPtrArray *
+fu_engine_get_upgrades_for_device(FuEngine *self,
+				  FuEngineRequest *request,
+				  FuDevice *device,
+				  GError **error)
 {
-	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(GPtrArray) releases = NULL;
 	g_autoptr(GPtrArray) releases_tmp = NULL;
 	g_autoptr(GString) error_str = g_string_new(NULL);
 
-	g_return_val_if_fail(FU_IS_ENGINE(self), NULL);
-	g_return_val_if_fail(device_id != NULL, NULL);
-	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
-
-	/* find the device */
-	device = fu_device_list_get_by_id(self->device_list, device_id, error);
-	if (device == NULL)
-		return NULL;
-
 	/* there is no point checking each release */
 	if (!fu_device_is_updatable(device)) {
 		g_set_error_literal(error,
@@ -5848,49 +6831,137 @@ fu_engine_get_upgrades(FuEngine *self,
 			continue;
 		}
 
-		/* not approved */
-		if (fwupd_release_has_flag(rel_tmp, FWUPD_RELEASE_FLAG_BLOCKED_APPROVAL)) {
-			g_string_append_printf(error_str,
-					       "%s=not-approved, ",
-					       fwupd_release_get_version(rel_tmp));
-			g_debug("ignoring %s as not approved as required by %s",
-				fwupd_release_get_version(rel_tmp),
-				fwupd_release_get_remote_id(rel_tmp));
-			continue;
-		}
+		/* not approved */
+		if (fwupd_release_has_flag(rel_tmp, FWUPD_RELEASE_FLAG_BLOCKED_APPROVAL)) {
+			g_string_append_printf(error_str,
+					       "%s=not-approved, ",
+					       fwupd_release_get_version(rel_tmp));
+			g_debug("ignoring %s as not approved as required by %s",
+				fwupd_release_get_version(rel_tmp),
+				fwupd_release_get_remote_id(rel_tmp));
+			continue;
+		}
+
+		/* different branch */
+		if (fwupd_release_has_flag(rel_tmp, FWUPD_RELEASE_FLAG_IS_ALTERNATE_BRANCH)) {
+			g_info("ignoring release %s as branch %s, and device is %s",
+			       fwupd_release_get_version(rel_tmp),
+			       fwupd_release_get_branch(rel_tmp),
+			       fu_device_get_branch(device));
+			continue;
+		}
+
+		g_ptr_array_add(releases, g_object_ref(rel_tmp));
+	}
+	if (error_str->len > 2)
+		g_string_truncate(error_str, error_str->len - 2);
+	if (releases->len == 0) {
+		if (error_str->len > 0) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOTHING_TO_DO,
+				    "current version is %s: %s",
+				    fu_device_get_version(device),
+				    error_str->str);
+		} else {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOTHING_TO_DO,
+				    "current version is %s",
+				    fu_device_get_version(device));
+		}
+		return NULL;
+	}
+	g_ptr_array_sort_with_data(releases, fu_engine_sort_releases_cb, device);
+	return g_steal_pointer(&releases);
+}
+
+/**
+ * fu_engine_get_upgrades:
+ * @self: a #FuEngine
+ * @request: a #FuEngineRequest
+ * @device_id: a device ID
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets the upgrades available for a specific device.
+ *
+ * Returns: (transfer container) (element-type FwupdDevice): results
+ **/
+GPtrArray *
+fu_engine_get_upgrades(FuEngine *self,
+		       FuEngineRequest *request,
+		       const gchar *device_id,
+		       GError **error)
+{
+	g_autoptr(FuDevice) device = NULL;
+
+	g_return_val_if_fail(FU_IS_ENGINE(self), NULL);
+	g_return_val_if_fail(device_id != NULL, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	/* find the device */
+	device = fu_device_list_get_by_id(self->device_list, device_id, error);
+	if (device == NULL)
+		return NULL;
+	return fu_engine_get_upgrades_for_device(self, request, device, error);
+}
+
+/**
+ * fu_engine_get_upgrades_all:
+ * @self: a #FuEngine
+ * @request: a #FuEngineRequest
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets the upgrades available for all devices. The metadata lookups are shared between devices
+ * with the same GUIDs, and devices without any upgrades are not included.
+ *
+ * Returns: (transfer container) (element-type FwupdDevice): devices with only the ID and the
+ * upgrades set
+ **/
+GPtrArray *
+fu_engine_get_upgrades_all(FuEngine *self, FuEngineRequest *request, GError **error)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) results =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+
+	g_return_val_if_fail(FU_IS_ENGINE(self), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
-		/* different branch */
-		if (fwupd_release_has_flag(rel_tmp, FWUPD_RELEASE_FLAG_IS_ALTERNATE_BRANCH)) {
-			g_info("ignoring release %s as branch %s, and device is %s",
-			       fwupd_release_get_version(rel_tmp),
-			       fwupd_release_get_branch(rel_tmp),
-			       fu_device_get_branch(device));
+	devices = fu_device_list_get_active(self->device_list);
+	g_ptr_array_sort(devices, fu_engine_sort_devices_by_priority_name);
+	self->components_by_guid =
+	    g_hash_table_new_full(g_str_hash,
+				  g_str_equal,
+				  g_free,
+				  (GDestroyNotify)g_ptr_array_unref);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		g_autoptr(FwupdDevice) result = NULL;
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) releases = NULL;
+
+		/* not going to have results */
+		if (!fu_device_is_updatable(device) ||
+		    !fu_device_has_flag(device, FWUPD_DEVICE_FLAG_SUPPORTED))
+			continue;
+		releases = fu_engine_get_upgrades_for_device(self, request, device, &error_local);
+		if (releases == NULL) {
+			g_debug("no upgrades for %s: %s",
+				fu_device_get_id(device),
+				error_local->message);
 			continue;
 		}
-
-		g_ptr_array_add(releases, g_object_ref(rel_tmp));
-	}
-	if (error_str->len > 2)
-		g_string_truncate(error_str, error_str->len - 2);
-	if (releases->len == 0) {
-		if (error_str->len > 0) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOTHING_TO_DO,
-				    "current version is %s: %s",
-				    fu_device_get_version(device),
-				    error_str->str);
-		} else {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOTHING_TO_DO,
-				    "current version is %s",
-				    fu_device_get_version(device));
+		result = fwupd_device_new();
+		fwupd_device_set_id(result, fu_device_get_id(device));
+		for (guint j = 0; j < releases->len; j++) {
+			FwupdRelease *rel = g_ptr_array_index(releases, j);
+			fwupd_device_add_release(result, rel);
 		}
-		return NULL;
+		g_ptr_array_add(results, g_steal_pointer(&result));
 	}
-	g_ptr_array_sort_with_data(releases, fu_engine_sort_releases_cb, device);
-	return g_steal_pointer(&releases);
+	g_clear_pointer(&self->components_by_guid, g_hash_table_unref);
+	return g_steal_pointer(&results);
 }
 
 /**
@@ -6507,7 +7578,7 @@ fu_engine_context_security_changed_cb(FuContext *ctx, gpointer user_data)
 	FuEngine *self = FU_ENGINE(user_data);
 
 	/* invalidate host security attributes */
-	g_clear_pointer(&self->host_security_id, g_free);
+	fu_engine_invalidate_security_attrs(self);
 
 	/* make UI refresh */
 	fu_engine_emit_changed(self);
@@ -6614,7 +7685,6 @@ fu_engine_add_plugin_filter(FuEngine *self, const gchar *plugin_glob)
 static gboolean
 fu_engine_plugin_check_supported_cb(FuPlugin *plugin, const gchar *guid, FuEngine *self)
 {
-	g_autoptr(XbNode) n = NULL;
 	g_autofree gchar *xpath = NULL;
 
 	if (fu_engine_config_get_enumerate_all_devices(self->config))
@@ -6623,8 +7693,13 @@ fu_engine_plugin_check_supported_cb(FuPlugin *plugin, const gchar *guid, FuEngin
 	xpath = g_strdup_printf("components/component[@type='firmware']/"
 				"provides/firmware[@type='flashed'][text()='%s']",
 				guid);
-	n = xb_silo_query_first(self->silo, xpath, NULL);
-	return n != NULL;
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *shard = g_ptr_array_index(self->silos, i);
+		g_autoptr(XbNode) n = xb_silo_query_first(shard->silo, xpath, NULL);
+		if (n != NULL)
+			return TRUE;
+	}
+	return FALSE;
 }
 
 FuEngineConfig *
@@ -6670,7 +7745,7 @@ fu_engine_get_host_bkc(FuEngine *self)
 
 #ifdef HAVE_HSI
 static void
-fu_engine_ensure_security_attrs_supported_cpu(FuEngine *self)
+fu_engine_ensure_security_attrs_supported_cpu(FuEngine *self, FuSecurityAttrs *attrs)
 {
 	g_autoptr(FwupdSecurityAttr) attr =
 	    fwupd_security_attr_new(FWUPD_SECURITY_ATTR_ID_SUPPORTED_CPU);
@@ -6679,11 +7754,11 @@ fu_engine_ensure_security_attrs_supported_cpu(FuEngine *self)
 	fwupd_security_attr_add_flag(attr, FWUPD_SECURITY_ATTR_FLAG_ACTION_CONTACT_OEM);
 	fwupd_security_attr_add_flag(attr, FWUPD_SECURITY_ATTR_FLAG_MISSING_DATA);
 	fwupd_security_attr_set_result_success(attr, FWUPD_SECURITY_ATTR_RESULT_VALID);
-	fu_security_attrs_append(self->host_security_attrs, attr);
+	fu_security_attrs_append(attrs, attr);
 }
 
 static void
-fu_engine_ensure_security_attrs_tainted(FuEngine *self)
+fu_engine_ensure_security_attrs_tainted(FuEngine *self, FuSecurityAttrs *attrs)
 {
 	gboolean disabled_plugins = FALSE;
 	GPtrArray *disabled = fu_engine_config_get_disabled_plugins(self->config);
@@ -6693,7 +7768,7 @@ fu_engine_ensure_security_attrs_tainted(FuEngine *self)
 	fwupd_security_attr_set_result_success(attr, FWUPD_SECURITY_ATTR_RESULT_NOT_TAINTED);
 	fwupd_security_attr_add_flag(attr, FWUPD_SECURITY_ATTR_FLAG_RUNTIME_ISSUE);
 
-	fu_security_attrs_append(self->host_security_attrs, attr);
+	fu_security_attrs_append(attrs, attr);
 	for (guint i = 0; i < disabled->len; i++) {
 		const gchar *name_tmp = g_ptr_array_index(disabled, i);
 		if (!g_str_has_prefix(name_tmp, "test")) {
@@ -7153,36 +8228,216 @@ fu_engine_load_host_emulation(FuEngine *self, const gchar *fn, GError **error)
 	return TRUE;
 }
 
+#ifdef HAVE_HSI
+static gboolean
+fu_engine_security_attr_strv_equal(GPtrArray *array1, GPtrArray *array2)
+{
+	if (array1->len != array2->len)
+		return FALSE;
+	for (guint i = 0; i < array1->len; i++) {
+		if (g_strcmp0(g_ptr_array_index(array1, i), g_ptr_array_index(array2, i)) != 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* there is no getter for all the metadata, so compare the serialized a{ss} in any order */
+static gboolean
+fu_engine_security_attr_metadata_equal(FwupdSecurityAttr *attr1, FwupdSecurityAttr *attr2)
+{
+	const gchar *key = NULL;
+	const gchar *value = NULL;
+	GVariantIter iter;
+	g_autoptr(GVariant) val1 = NULL;
+	g_autoptr(GVariant) val2 = NULL;
+	g_autoptr(GVariant) metadata1 = NULL;
+	g_autoptr(GVariant) metadata2 = NULL;
+
+	val1 = g_variant_ref_sink(fwupd_codec_to_variant(FWUPD_CODEC(attr1), FWUPD_CODEC_FLAG_NONE));
+	val2 = g_variant_ref_sink(fwupd_codec_to_variant(FWUPD_CODEC(attr2), FWUPD_CODEC_FLAG_NONE));
+	metadata1 = g_variant_lookup_value(val1, FWUPD_RESULT_KEY_METADATA, G_VARIANT_TYPE("a{ss}"));
+	metadata2 = g_variant_lookup_value(val2, FWUPD_RESULT_KEY_METADATA, G_VARIANT_TYPE("a{ss}"));
+	if ((metadata1 != NULL ? g_variant_n_children(metadata1) : 0) !=
+	    (metadata2 != NULL ? g_variant_n_children(metadata2) : 0))
+		return FALSE;
+	if (metadata1 == NULL)
+		return TRUE;
+	g_variant_iter_init(&iter, metadata1);
+	while (g_variant_iter_next(&iter, "{&s&s}", &key, &value)) {
+		const gchar *value2 = NULL;
+		if (!g_variant_lookup(metadata2, key, "&s", &value2))
+			return FALSE;
+		if (g_strcmp0(value, value2) != 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* everything that gets serialized, apart from the creation time */
+static gboolean
+fu_engine_security_attr_equal(FwupdSecurityAttr *attr1, FwupdSecurityAttr *attr2)
+{
+	if (g_strcmp0(fwupd_security_attr_get_appstream_id(attr1),
+		      fwupd_security_attr_get_appstream_id(attr2)) != 0)
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_name(attr1), fwupd_security_attr_get_name(attr2)) !=
+	    0)
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_title(attr1), fwupd_security_attr_get_title(attr2)) !=
+	    0)
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_description(attr1),
+		      fwupd_security_attr_get_description(attr2)) != 0)
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_plugin(attr1),
+		      fwupd_security_attr_get_plugin(attr2)) != 0)
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_url(attr1), fwupd_security_attr_get_url(attr2)) != 0)
+		return FALSE;
+	if (fwupd_security_attr_get_level(attr1) != fwupd_security_attr_get_level(attr2))
+		return FALSE;
+	if (fwupd_security_attr_get_result(attr1) != fwupd_security_attr_get_result(attr2))
+		return FALSE;
+	if (fwupd_security_attr_get_result_fallback(attr1) !=
+	    fwupd_security_attr_get_result_fallback(attr2))
+		return FALSE;
+	if (fwupd_security_attr_get_result_success(attr1) !=
+	    fwupd_security_attr_get_result_success(attr2))
+		return FALSE;
+	if (fwupd_security_attr_get_flags(attr1) != fwupd_security_attr_get_flags(attr2))
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_bios_setting_id(attr1),
+		      fwupd_security_attr_get_bios_setting_id(attr2)) != 0)
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_bios_setting_target_value(attr1),
+		      fwupd_security_attr_get_bios_setting_target_value(attr2)) != 0)
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_bios_setting_current_value(attr1),
+		      fwupd_security_attr_get_bios_setting_current_value(attr2)) != 0)
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_kernel_current_value(attr1),
+		      fwupd_security_attr_get_kernel_current_value(attr2)) != 0)
+		return FALSE;
+	if (g_strcmp0(fwupd_security_attr_get_kernel_target_value(attr1),
+		      fwupd_security_attr_get_kernel_target_value(attr2)) != 0)
+		return FALSE;
+	if (!fu_engine_security_attr_strv_equal(fwupd_security_attr_get_obsoletes(attr1),
+						fwupd_security_attr_get_obsoletes(attr2)))
+		return FALSE;
+	if (!fu_engine_security_attr_strv_equal(fwupd_security_attr_get_guids(attr1),
+						fwupd_security_attr_get_guids(attr2)))
+		return FALSE;
+	return fu_engine_security_attr_metadata_equal(attr1, attr2);
+}
+
+static gboolean
+fu_engine_security_attrs_raw_equal(FuSecurityAttrs *attrs1, FuSecurityAttrs *attrs2)
+{
+	g_autoptr(GPtrArray) items1 = fu_security_attrs_get_all(attrs1);
+	g_autoptr(GPtrArray) items2 = fu_security_attrs_get_all(attrs2);
+	if (items1->len != items2->len)
+		return FALSE;
+	for (guint i = 0; i < items1->len; i++) {
+		if (!fu_engine_security_attr_equal(g_ptr_array_index(items1, i),
+						   g_ptr_array_index(items2, i)))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+fu_engine_security_attrs_append_all(FuSecurityAttrs *attrs, FuSecurityAttrs *donor)
+{
+	g_autoptr(GPtrArray) items = fu_security_attrs_get_all(donor);
+	for (guint i = 0; i < items->len; i++) {
+		FwupdSecurityAttr *attr = g_ptr_array_index(items, i);
+		fu_security_attrs_append(attrs, attr);
+	}
+}
+
+static FuSecurityAttrs *
+fu_engine_ensure_security_attrs_for_device(FuEngine *self, FuDevice *device)
+{
+	FuSecurityAttrs *attrs;
+	const gchar *device_id = fu_device_get_id(device);
+
+	attrs = g_hash_table_lookup(self->security_attrs_by_device, device_id);
+	if (attrs != NULL)
+		return attrs;
+	attrs = fu_security_attrs_new();
+	fu_device_add_security_attrs(device, attrs);
+	g_hash_table_insert(self->security_attrs_by_device, g_strdup(device_id), attrs);
+	return attrs;
+}
+
+static void
+fu_engine_add_security_attrs_for_plugin(FuEngine *self, FuPlugin *plugin, FuSecurityAttrs *attrs)
+{
+	FuSecurityAttrs *attrs_plugin;
+	const gchar *name = fu_plugin_get_name(plugin);
+
+	/* the plugin cannot tell us when the attrs change, so always ask again */
+	if (!fu_plugin_has_flag(plugin, FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE)) {
+		fu_plugin_runner_add_security_attrs(plugin, attrs);
+		return;
+	}
+	attrs_plugin = g_hash_table_lookup(self->security_attrs_by_plugin, name);
+	if (attrs_plugin == NULL) {
+		attrs_plugin = fu_security_attrs_new();
+		fu_plugin_runner_add_security_attrs(plugin, attrs_plugin);
+		g_hash_table_insert(self->security_attrs_by_plugin, g_strdup(name), attrs_plugin);
+	}
+	fu_engine_security_attrs_append_all(attrs, attrs_plugin);
+}
+#endif
+
 static void
 fu_engine_ensure_security_attrs(FuEngine *self)
 {
 #ifdef HAVE_HSI
 	GPtrArray *plugins = fu_plugin_list_get_all(self->plugin_list);
+	g_autoptr(FuSecurityAttrs) attrs_raw = fu_security_attrs_new();
 	g_autoptr(GPtrArray) devices = fu_device_list_get_active(self->device_list);
+	g_autoptr(GPtrArray) items = NULL;
 	g_autoptr(GPtrArray) vals = NULL;
 	g_autoptr(GError) error = NULL;
 
 	/* already valid */
-	if (self->host_security_id != NULL || self->host_emulation)
+	if (self->host_security_attrs_valid || self->host_emulation)
 		return;
-
-	/* clear old values */
-	fu_security_attrs_remove_all(self->host_security_attrs);
+	self->host_security_attrs_valid = TRUE;
 
 	/* built in */
-	fu_engine_ensure_security_attrs_supported_cpu(self);
-	fu_engine_ensure_security_attrs_tainted(self);
+	fu_engine_ensure_security_attrs_supported_cpu(self, attrs_raw);
+	fu_engine_ensure_security_attrs_tainted(self, attrs_raw);
 
-	/* call into devices */
+	/* call into devices and plugins, reusing the attrs from any that have not changed */
 	for (guint i = 0; i < devices->len; i++) {
 		FuDevice *device = g_ptr_array_index(devices, i);
-		fu_device_add_security_attrs(device, self->host_security_attrs);
+		fu_engine_security_attrs_append_all(
+		    attrs_raw,
+		    fu_engine_ensure_security_attrs_for_device(self, device));
 	}
-
-	/* call into plugins */
 	for (guint j = 0; j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index(plugins, j);
-		fu_plugin_runner_add_security_attrs(plugin_tmp, self->host_security_attrs);
+		fu_engine_add_security_attrs_for_plugin(self, plugin_tmp, attrs_raw);
+	}
+
+	/* the depsolved attrs and the HSI string are still correct */
+	if (self->host_security_id != NULL && self->host_security_attrs_raw != NULL &&
+	    fu_engine_security_attrs_raw_equal(self->host_security_attrs_raw, attrs_raw)) {
+		g_debug("HSI attributes unchanged, keeping %s", self->host_security_id);
+		return;
+	}
+	g_set_object(&self->host_security_attrs_raw, attrs_raw);
+
+	/* depsolve modifies the attrs, so use copies and keep the cached values unchanged */
+	fu_security_attrs_remove_all(self->host_security_attrs);
+	items = fu_security_attrs_get_all(attrs_raw);
+	for (guint i = 0; i < items->len; i++) {
+		FwupdSecurityAttr *attr = g_ptr_array_index(items, i);
+		g_autoptr(FwupdSecurityAttr) attr_copy = fwupd_security_attr_copy(attr);
+		fu_security_attrs_append(self->host_security_attrs, attr_copy);
 	}
 
 	/* sanity check */
@@ -7535,11 +8790,77 @@ fu_engine_check_firmware_attributes(FuEngine *self, FuDevice *device, gboolean a
 	}
 }
 
+typedef void (*FuEngineBackendEventFunc)(FuBackend *backend, FuDevice *device, FuEngine *self);
+
+typedef struct {
+	FuEngineBackendEventFunc func;
+	FuBackend *backend;
+	FuDevice *device;
+} FuEngineBackendEvent;
+
+static void
+fu_engine_backend_event_free(FuEngineBackendEvent *event)
+{
+	g_object_unref(event->backend);
+	g_object_unref(event->device);
+	g_free(event);
+}
+
+/* devices are written from worker threads, so any backend event that may change a device is
+ * processed afterwards -- just as it would be if write-firmware had blocked the main loop */
+static gboolean
+fu_engine_backend_event_defer(FuEngine *self,
+			      FuBackend *backend,
+			      FuDevice *device,
+			      FuEngineBackendEventFunc func)
+{
+	FuEngineBackendEvent *event;
+
+	if (self->backend_events == NULL)
+		return FALSE;
+	event = g_new0(FuEngineBackendEvent, 1);
+	event->func = func;
+	event->backend = g_object_ref(backend);
+	event->device = g_object_ref(device);
+	g_ptr_array_add(self->backend_events, event);
+	return TRUE;
+}
+
+static void
+fu_engine_backend_events_defer_begin(FuEngine *self)
+{
+	g_return_if_fail(self->backend_events == NULL);
+	self->backend_events =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_backend_event_free);
+}
+
+static void
+fu_engine_backend_events_defer_end(FuEngine *self)
+{
+	g_autoptr(GPtrArray) backend_events = g_steal_pointer(&self->backend_events);
+
+	if (backend_events == NULL)
+		return;
+	if (backend_events->len > 0)
+		g_debug("processing %u deferred backend events", backend_events->len);
+	for (guint i = 0; i < backend_events->len; i++) {
+		FuEngineBackendEvent *event = g_ptr_array_index(backend_events, i);
+		event->func(event->backend, event->device, self);
+	}
+}
+
 static void
 fu_engine_backend_device_removed_cb(FuBackend *backend, FuDevice *device, FuEngine *self)
 {
 	g_autoptr(GPtrArray) devices = NULL;
 
+	/* wait until the devices have been written */
+	if (fu_engine_backend_event_defer(self,
+					  backend,
+					  device,
+					  fu_engine_backend_device_removed_cb))
+		return;
+
 	/* if this is for firmware attributes, reload that part of the daemon */
 	fu_engine_check_firmware_attributes(self, device, FALSE);
 
@@ -7640,11 +8961,23 @@ fu_engine_backend_device_added_run_plugins(FuEngine *self, FuDevice *device, FuP
 	}
 }
 
+static void
+fu_engine_backend_device_probe_failed(FuDevice *device, const GError *error)
+{
+	if (!g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+		g_warning("failed to probe device %s: %s",
+			  fu_device_get_backend_id(device),
+			  error->message);
+	} else {
+		g_debug("failed to probe device %s : %s",
+			fu_device_get_backend_id(device),
+			error->message);
+	}
+}
+
 static void
 fu_engine_backend_device_added(FuEngine *self, FuDevice *device, FuProgress *progress)
 {
-	g_autofree gchar *str1 = NULL;
-	g_autofree gchar *str2 = NULL;
 	g_autoptr(GError) error_local = NULL;
 
 	/* progress */
@@ -7655,21 +8988,15 @@ fu_engine_backend_device_added(FuEngine *self, FuDevice *device, FuProgress *pro
 	fu_progress_add_step(progress, FWUPD_STATUS_LOADING, 50, "query-possible-plugins");
 
 	/* super useful for plugin development */
-	str1 = fu_device_to_string(FU_DEVICE(device));
-	g_debug("%s added %s", fu_device_get_backend_id(device), str1);
+	if (fu_dump_is_enabled(G_LOG_DOMAIN)) {
+		g_autofree gchar *str = fu_device_to_string(device);
+		g_debug("%s added %s", fu_device_get_backend_id(device), str);
+	}
 
-	/* add any extra quirks */
+	/* add any extra quirks, which is a no-op if already done by the coldplug worker pool */
 	fu_device_set_context(device, self->ctx);
 	if (!fu_device_probe(device, &error_local)) {
-		if (!g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
-			g_warning("failed to probe device %s: %s",
-				  fu_device_get_backend_id(device),
-				  error_local->message);
-		} else {
-			g_debug("failed to probe device %s : %s",
-				fu_device_get_backend_id(device),
-				error_local->message);
-		}
+		fu_engine_backend_device_probe_failed(device, error_local);
 		fu_progress_finished(progress);
 		return;
 	}
@@ -7679,8 +9006,10 @@ fu_engine_backend_device_added(FuEngine *self, FuDevice *device, FuProgress *pro
 	fu_engine_ensure_device_emulation_tag(self, device);
 
 	/* super useful for plugin development */
-	str2 = fu_device_to_string(FU_DEVICE(device));
-	g_debug("%s added %s", fu_device_get_backend_id(device), str2);
+	if (fu_dump_is_enabled(G_LOG_DOMAIN)) {
+		g_autofree gchar *str = fu_device_to_string(device);
+		g_debug("%s added %s", fu_device_get_backend_id(device), str);
+	}
 
 	/* if this is for firmware attributes, reload that part of the daemon */
 	fu_engine_check_firmware_attributes(self, device, TRUE);
@@ -7696,6 +9025,10 @@ fu_engine_backend_device_added_cb(FuBackend *backend, FuDevice *device, FuEngine
 	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
 	g_autoptr(GPtrArray) possible_plugins = NULL;
 
+	/* wait until the devices have been written */
+	if (fu_engine_backend_event_defer(self, backend, device, fu_engine_backend_device_added_cb))
+		return;
+
 	fu_engine_backend_device_added(self, device, progress);
 
 	/* there's no point keeping this in the cache */
@@ -7713,6 +9046,13 @@ fu_engine_backend_device_changed_cb(FuBackend *backend, FuDevice *device, FuEngi
 	GPtrArray *plugins = fu_plugin_list_get_all(self->plugin_list);
 	g_autoptr(GPtrArray) devices = NULL;
 
+	/* wait until the devices have been written */
+	if (fu_engine_backend_event_defer(self,
+					  backend,
+					  device,
+					  fu_engine_backend_device_changed_cb))
+		return;
+
 	/* debug */
 	g_debug("%s changed %s", fu_backend_get_name(backend), fu_device_get_physical_id(device));
 
@@ -8081,6 +9421,146 @@ fu_common_win32_registry_get_string(HKEY hkey,
 }
 #endif
 
+typedef struct {
+	FuDevice *device; /* ref */
+	GError *error;	  /* (nullable) */
+	gdouble elapsed;  /* s */
+} FuEngineColdplugItem;
+
+static void
+fu_engine_coldplug_item_free(FuEngineColdplugItem *item)
+{
+	g_object_unref(item->device);
+	if (item->error != NULL)
+		g_error_free(item->error);
+	g_free(item);
+}
+
+/* the backend ID of the outermost item that is a sysfs ancestor of this one, or itself */
+static const gchar *
+fu_engine_coldplug_item_get_root_key(GHashTable *backend_ids, FuEngineColdplugItem *item)
+{
+	const gchar *backend_id = fu_device_get_backend_id(item->device);
+	const gchar *root = backend_id;
+	g_autofree gchar *path = NULL;
+
+	if (backend_id == NULL)
+		return "";
+	path = g_strdup(backend_id);
+	while (TRUE) {
+		gchar *tmp = g_strrstr(path, "/");
+		const gchar *key;
+		if (tmp == NULL || tmp == path)
+			break;
+		*tmp = '\0';
+		key = g_hash_table_lookup(backend_ids, path);
+		if (key != NULL)
+			root = key;
+	}
+	return root;
+}
+
+/* runs in a worker thread, where notifications are frozen and GUdev access is serialized */
+static void
+fu_engine_coldplug_probe_worker_cb(gpointer data, gpointer user_data)
+{
+	GPtrArray *items = (GPtrArray *)data; /* (element-type FuEngineColdplugItem) */
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineColdplugItem *item = g_ptr_array_index(items, i);
+		g_autoptr(GTimer) timer = g_timer_new();
+		(void)fu_device_probe(item->device, &item->error);
+		item->elapsed = g_timer_elapsed(timer, NULL);
+	}
+}
+
+static guint
+fu_engine_coldplug_get_max_threads(FuEngine *self)
+{
+	guint max_threads = fu_engine_config_get_coldplug_threads(self->config);
+	if (max_threads == 0)
+		max_threads = MIN(g_get_num_processors(), FU_ENGINE_COLDPLUG_THREADS_MAX);
+	return max_threads;
+}
+
+static void
+fu_engine_backends_coldplug_backend_probe_devices(FuEngine *self, GPtrArray *items)
+{
+	GThreadPool *pool;
+	guint max_threads = fu_engine_coldplug_get_max_threads(self);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GHashTable) backend_ids = g_hash_table_new(g_str_hash, g_str_equal);
+	g_autoptr(GHashTable) groups = g_hash_table_new(g_str_hash, g_str_equal);
+	g_autoptr(GPtrArray) groups_ordered =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_ptr_array_unref);
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	/* nothing to be gained, so probe in the main thread as before */
+	if (max_threads <= 1 || items->len <= 1)
+		return;
+
+	/* a device and all its children are probed in order by the same worker */
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineColdplugItem *item = g_ptr_array_index(items, i);
+		const gchar *backend_id = fu_device_get_backend_id(item->device);
+		if (backend_id != NULL)
+			g_hash_table_insert(backend_ids, (gpointer)backend_id, (gpointer)backend_id);
+	}
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineColdplugItem *item = g_ptr_array_index(items, i);
+		const gchar *key = fu_engine_coldplug_item_get_root_key(backend_ids, item);
+		GPtrArray *group = g_hash_table_lookup(groups, key);
+		if (group == NULL) {
+			group = g_ptr_array_new();
+			g_hash_table_insert(groups, (gpointer)key, group);
+			g_ptr_array_add(groups_ordered, group);
+		}
+		g_ptr_array_add(group, item);
+	}
+
+	/* property notifications are emitted in the main thread once the pool is finished */
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineColdplugItem *item = g_ptr_array_index(items, i);
+		g_object_freeze_notify(G_OBJECT(item->device));
+	}
+
+	/* the engine-owned steps are all done later in the main thread */
+	pool = g_thread_pool_new(fu_engine_coldplug_probe_worker_cb,
+				 self,
+				 MIN(max_threads, groups_ordered->len),
+				 FALSE,
+				 &error_local);
+	if (pool == NULL) {
+		g_warning("failed to create coldplug worker pool: %s", error_local->message);
+		for (guint i = 0; i < items->len; i++) {
+			FuEngineColdplugItem *item = g_ptr_array_index(items, i);
+			g_object_thaw_notify(G_OBJECT(item->device));
+		}
+		return;
+	}
+	for (guint i = 0; i < groups_ordered->len; i++) {
+		GPtrArray *group = g_ptr_array_index(groups_ordered, i);
+		if (!g_thread_pool_push(pool, group, &error_local)) {
+			g_warning("failed to push coldplug group: %s", error_local->message);
+			g_clear_error(&error_local);
+		}
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	/* profile */
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineColdplugItem *item = g_ptr_array_index(items, i);
+		g_object_thaw_notify(G_OBJECT(item->device));
+		self->coldplug_probe_serial += item->elapsed;
+	}
+	self->coldplug_probe_wall += g_timer_elapsed(timer, NULL);
+	self->coldplug_probe_threads = MAX(self->coldplug_probe_threads, max_threads);
+	g_debug("probed %u devices in %u groups using %u threads in %.2fms",
+		items->len,
+		groups_ordered->len,
+		max_threads,
+		g_timer_elapsed(timer, NULL) * 1000.f);
+}
+
 static gboolean
 fu_engine_backends_coldplug_backend_add_devices(FuEngine *self,
 						FuBackend *backend,
@@ -8088,15 +9568,36 @@ fu_engine_backends_coldplug_backend_add_devices(FuEngine *self,
 						GError **error)
 {
 	g_autoptr(GPtrArray) devices = fu_backend_get_devices(backend);
+	g_autoptr(GPtrArray) items =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_coldplug_item_free);
 
-	/* progress */
-	fu_progress_set_id(progress, G_STRLOC);
-	fu_progress_set_steps(progress, devices->len);
+	/* probe the independent devices at the same time */
 	for (guint i = 0; i < devices->len; i++) {
 		FuDevice *device = g_ptr_array_index(devices, i);
+		FuEngineColdplugItem *item = g_new0(FuEngineColdplugItem, 1);
+		item->device = g_object_ref(device);
+		fu_device_set_context(device, self->ctx);
+		g_ptr_array_add(items, item);
+	}
+	fu_engine_backends_coldplug_backend_probe_devices(self, items);
+
+	/* progress */
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_set_steps(progress, items->len);
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineColdplugItem *item = g_ptr_array_index(items, i);
+		FuDevice *device = item->device;
 		g_autoptr(GPtrArray) possible_plugins = NULL;
 
-		fu_engine_backend_device_added(self, device, fu_progress_get_child(progress));
+		/* run the plugins in the main thread */
+		if (item->error != NULL) {
+			fu_engine_backend_device_probe_failed(device, item->error);
+			fu_progress_finished(fu_progress_get_child(progress));
+		} else {
+			fu_engine_backend_device_added(self,
+						       device,
+						       fu_progress_get_child(progress));
+		}
 		fu_progress_step_done(progress);
 
 		/* there's no point keeping this in the cache */
@@ -8187,6 +9688,39 @@ fu_engine_backends_coldplug(FuEngine *self, FuProgress *progress)
 	}
 }
 
+/**
+ * fu_engine_get_coldplug_profile:
+ * @self: a #FuEngine
+ *
+ * Gets a summary of how long the coldplug worker pool took to probe the backend devices, and how
+ * much wall-clock time was saved compared to probing them one after another.
+ *
+ * Returns: (transfer full): a string, or %NULL if the worker pool was not used
+ **/
+gchar *
+fu_engine_get_coldplug_profile(FuEngine *self)
+{
+	GString *str;
+
+	g_return_val_if_fail(FU_IS_ENGINE(self), NULL);
+
+	if (self->coldplug_probe_threads == 0)
+		return NULL;
+	str = g_string_new(NULL);
+	fwupd_codec_string_append_int(str, 0, "ColdplugThreads", self->coldplug_probe_threads);
+	fwupd_codec_string_append_int(str,
+				      0,
+				      "ProbeSerialMs",
+				      self->coldplug_probe_serial * 1000.f);
+	fwupd_codec_string_append_int(str, 0, "ProbeWallMs", self->coldplug_probe_wall * 1000.f);
+	fwupd_codec_string_append_int(
+	    str,
+	    0,
+	    "ProbeSavedMs",
+	    MAX(self->coldplug_probe_serial - self->coldplug_probe_wall, 0.f) * 1000.f);
+	return g_string_free(str, FALSE);
+}
+
 /**
  * fu_engine_load:
  * @self: a #FuEngine
@@ -8561,7 +10095,7 @@ fu_engine_load(FuEngine *self, FuEngineLoadFlags flags, FuProgress *progress, GE
 	fu_progress_step_done(progress);
 
 	/* update the devices JSON file */
-	if (!fu_engine_update_devices_file(self, &error_json_devices))
+	if (!fu_engine_devices_file_flush(self, &error_json_devices))
 		g_info("failed to update list of devices: %s", error_json_devices->message);
 
 #ifdef HAVE_PASSIM
@@ -8948,14 +10482,28 @@ fu_engine_init(FuEngine *self)
 	self->history = fu_history_new();
 	self->plugin_list = fu_plugin_list_new();
 	self->plugin_filter = g_ptr_array_new_with_free_func(g_free);
+	self->silos = g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_silo_free);
 	self->host_security_attrs = fu_security_attrs_new();
+	self->security_attrs_by_device =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_object_unref);
+	self->security_attrs_by_plugin =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_object_unref);
 	self->backends = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 	self->local_monitors = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 	self->acquiesce_loop = g_main_loop_new(NULL, FALSE);
+	self->main_thread = g_thread_self();
+	self->write_history = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_mutex_init(&self->devices_file_mutex);
+	self->devices_file_pool =
+	    g_thread_pool_new(fu_engine_devices_file_worker_cb, self, 1, FALSE, NULL);
 	self->emulation_phases = g_hash_table_new_full(g_direct_hash,
 						       g_direct_equal,
 						       NULL,
 						       (GDestroyNotify)g_bytes_unref);
+	self->emulation_payloads = g_hash_table_new_full(g_direct_hash,
+							 g_direct_equal,
+							 NULL,
+							 (GDestroyNotify)g_bytes_unref);
 	self->emulation_ids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 	self->device_changed_allowlist =
 	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
@@ -8984,16 +10532,18 @@ fu_engine_finalize(GObject *obj)
 		g_file_monitor_cancel(monitor);
 	}
 
-	if (self->silo != NULL)
-		g_object_unref(self->silo);
-	if (self->query_component_by_guid != NULL)
-		g_object_unref(self->query_component_by_guid);
-	if (self->query_container_checksum1 != NULL)
-		g_object_unref(self->query_container_checksum1);
-	if (self->query_container_checksum2 != NULL)
-		g_object_unref(self->query_container_checksum2);
-	if (self->query_tag_by_guid_version != NULL)
-		g_object_unref(self->query_tag_by_guid_version);
+	/* write any batched changes, and wait for the worker to finish */
+	if (self->devices_file_id != 0) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_engine_devices_file_flush(self, &error_local))
+			g_info("failed to update list of devices: %s", error_local->message);
+	}
+	g_thread_pool_free(self->devices_file_pool, FALSE, TRUE);
+	g_mutex_clear(&self->devices_file_mutex);
+
+	g_ptr_array_unref(self->silos);
+	if (self->backend_events != NULL)
+		g_ptr_array_unref(self->backend_events);
 	if (self->coldplug_id != 0)
 		g_source_remove(self->coldplug_id);
 	if (self->approved_firmware != NULL)
@@ -9012,7 +10562,12 @@ fu_engine_finalize(GObject *obj)
 
 	g_free(self->host_machine_id);
 	g_free(self->host_security_id);
+	g_free(self->devices_file_checksum);
 	g_object_unref(self->host_security_attrs);
+	if (self->host_security_attrs_raw != NULL)
+		g_object_unref(self->host_security_attrs_raw);
+	g_hash_table_unref(self->security_attrs_by_device);
+	g_hash_table_unref(self->security_attrs_by_plugin);
 	g_object_unref(self->idle);
 	g_object_unref(self->config);
 	g_object_unref(self->remote_list);
@@ -9024,8 +10579,10 @@ fu_engine_finalize(GObject *obj)
 	g_ptr_array_unref(self->backends);
 	g_ptr_array_unref(self->local_monitors);
 	g_hash_table_unref(self->emulation_phases);
+	g_hash_table_unref(self->emulation_payloads);
 	g_hash_table_unref(self->emulation_ids);
 	g_hash_table_unref(self->device_changed_allowlist);
+	g_hash_table_unref(self->write_history);
 	g_object_unref(self->plugin_list);
 
 	G_OBJECT_CLASS(fu_engine_parent_class)->finalize(obj);
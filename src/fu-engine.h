@@ -66,6 +66,12 @@ fu_engine_idle_uninhibit(FuEngine *self, guint32 token) G_GNUC_NON_NULL(1);
 gboolean
 fu_engine_load(FuEngine *self, FuEngineLoadFlags flags, FuProgress *progress, GError **error)
     G_GNUC_NON_NULL(1, 3);
+gchar *
+fu_engine_get_coldplug_profile(FuEngine *self) G_GNUC_NON_NULL(1);
+guint
+fu_engine_get_devices_file_writes(FuEngine *self) G_GNUC_NON_NULL(1);
+guint
+fu_engine_get_devices_file_writes_suppressed(FuEngine *self) G_GNUC_NON_NULL(1);
 const gchar *
 fu_engine_get_host_vendor(FuEngine *self) G_GNUC_NON_NULL(1);
 const gchar *
@@ -120,6 +126,9 @@ fu_engine_get_upgrades(FuEngine *self,
 		       FuEngineRequest *request,
 		       const gchar *device_id,
 		       GError **error) G_GNUC_NON_NULL(1, 2, 3);
+GPtrArray *
+fu_engine_get_upgrades_all(FuEngine *self, FuEngineRequest *request, GError **error)
+    G_GNUC_NON_NULL(1, 2);
 FwupdDevice *
 fu_engine_get_results(FuEngine *self, const gchar *device_id, GError **error) G_GNUC_NON_NULL(1, 2);
 FuSecurityAttrs *
@@ -206,6 +215,9 @@ fu_engine_install_releases(FuEngine *self,
 			   FuProgress *progress,
 			   FwupdInstallFlags flags,
 			   GError **error) G_GNUC_NON_NULL(1, 2, 3, 4, 5);
+GArray *
+fu_engine_install_releases_get_batches(FuEngine *self, GPtrArray *releases, FwupdInstallFlags flags)
+    G_GNUC_NON_NULL(1, 2);
 gboolean
 fu_engine_activate(FuEngine *self, const gchar *device_id, FuProgress *progress, GError **error)
     G_GNUC_NON_NULL(1, 2, 3);
@@ -46,3 +46,26 @@ enum FuClientFlag {
     None = 0,
     Active = 1 << 0,
 }
+
+#[repr(u16le)]
+#[derive(ToString)]
+enum FuEngineEmulationSectionKind {
+    Json = 0x01,     // the phase JSON, with payloads replaced by references
+    Payload = 0x02,  // raw event payloads referenced from the JSON
+}
+
+#[derive(New, ParseBytes, ValidateStream)]
+struct FuStructEngineEmulationHdr {
+    magic: [char; 8] == "FWUPDEMU",
+    version: u32le == 0x1,
+    nr_sections: u32le,
+}
+
+#[derive(New, ParseBytes)]
+struct FuStructEngineEmulationSection {
+    kind: FuEngineEmulationSectionKind,
+    phase: u16le,      // as FuEngineInstallPhase
+    _reserved: [u8; 4],
+    offset: u64le,     // from the start of the archive
+    size: u64le,
+}
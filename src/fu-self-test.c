@@ -24,8 +24,10 @@
 #include "fu-console.h"
 #include "fu-context-private.h"
 #include "fu-device-list.h"
+#include "fu-device-event-private.h"
 #include "fu-device-private.h"
 #include "fu-engine-config.h"
+#include "fu-engine-emulation.h"
 #include "fu-engine-helper.h"
 #include "fu-engine-requirements.h"
 #include "fu-engine.h"
@@ -1744,6 +1746,73 @@ fu_engine_device_unlock_func(gconstpointer user_data)
 	g_assert_false(fwupd_release_has_flag(rel, FWUPD_RELEASE_FLAG_TRUSTED_REPORT));
 }
 
+static void
+fu_engine_devices_file_wait_for_writes(FuEngine *engine, guint writes)
+{
+	/* the file is written in a worker thread */
+	for (guint i = 0; i < 5000; i++) {
+		if (fu_engine_get_devices_file_writes(engine) >= writes)
+			break;
+		g_usleep(1000);
+	}
+	g_assert_cmpint(fu_engine_get_devices_file_writes(engine), ==, writes);
+}
+
+static void
+fu_engine_devices_file_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	guint writes_suppressed;
+	g_autofree gchar *cachedirpkg = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
+	g_autofree gchar *fn = g_build_filename(cachedirpkg, "devices.json", NULL);
+	g_autofree gchar *json = NULL;
+	g_autoptr(FuDevice) device1 = fu_device_new(self->ctx);
+	g_autoptr(FuDevice) device2 = fu_device_new(self->ctx);
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GError) error = NULL;
+
+	/* ensure empty tree */
+	fu_self_test_mkroot();
+	g_assert_cmpint(g_mkdir_with_parents(cachedirpkg, 0755), ==, 0);
+
+	/* written once at startup */
+	ret = fu_engine_load(engine, FU_ENGINE_LOAD_FLAG_NO_CACHE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_engine_devices_file_wait_for_writes(engine, 1);
+	g_assert_cmpint(fu_engine_get_devices_file_writes_suppressed(engine), ==, 0);
+
+	/* both changes are written at the same time */
+	fu_device_set_id(device1, "dummy-dev1");
+	fu_device_add_protocol(device1, "com.acme");
+	fu_device_add_guid(device1, "2d47f29b-83a2-4f31-a2e8-63474f4d4c2e");
+	fu_engine_add_device(engine, device1);
+	fu_device_set_id(device2, "dummy-dev2");
+	fu_device_add_protocol(device2, "com.acme");
+	fu_device_add_guid(device2, "2d47f29b-83a2-4f31-a2e8-63474f4d4c2e");
+	fu_engine_add_device(engine, device2);
+	g_assert_cmpint(fu_engine_get_devices_file_writes_suppressed(engine), >=, 1);
+	fu_test_loop_run_with_timeout(1000);
+	fu_test_loop_quit();
+	fu_engine_devices_file_wait_for_writes(engine, 2);
+	ret = g_file_get_contents(fn, &json, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_nonnull(g_strstr_len(json, -1, "2d47f29b-83a2-4f31-a2e8-63474f4d4c2e"));
+
+	/* a change that does not affect the devices is not written */
+	writes_suppressed = fu_engine_get_devices_file_writes_suppressed(engine);
+	fu_context_security_changed(self->ctx);
+	fu_test_loop_run_with_timeout(1000);
+	fu_test_loop_quit();
+	g_assert_cmpint(fu_engine_get_devices_file_writes_suppressed(engine),
+			==,
+			writes_suppressed + 1);
+	g_assert_cmpint(fu_engine_get_devices_file_writes(engine), ==, 2);
+}
+
 static void
 fu_engine_device_md_set_flags_func(gconstpointer user_data)
 {
@@ -1971,6 +2040,111 @@ fu_engine_get_details_missing_func(gconstpointer user_data)
 	g_assert_cmpstr(fwupd_release_get_version(release), ==, "1.2.3");
 }
 
+static guint64
+fu_engine_metadata_shard_get_inode(const gchar *cachedirpkg, const gchar *basename)
+{
+	GStatBuf st = {0};
+	g_autofree gchar *fn = g_build_filename(cachedirpkg, basename, NULL);
+	g_assert_cmpint(g_stat(fn, &st), ==, 0);
+	return st.st_ino;
+}
+
+static void
+fu_engine_metadata_shards_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	guint64 inode_stable;
+	guint64 inode_testing;
+	g_autofree gchar *cachedirpkg = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
+	g_autofree gchar *fn_legacy = g_build_filename(cachedirpkg, "metadata.xmlb", NULL);
+	g_autofree gchar *fn_disabled = g_build_filename(cachedirpkg, "metadata-legacy.xmlb", NULL);
+	g_autofree gchar *fn_unknown = g_build_filename(cachedirpkg, "metadata-unknown.xmlb", NULL);
+	g_autoptr(FuEngine) engine1 = fu_engine_new(self->ctx);
+	g_autoptr(FuEngine) engine2 = fu_engine_new(self->ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file_stable = g_file_new_for_path("/tmp/fwupd-self-test/stable.xml");
+
+	/* ensure empty tree */
+	fu_self_test_mkroot();
+	g_assert_cmpint(g_mkdir_with_parents(cachedirpkg, 0755), ==, 0);
+
+	/* silos from a previous version, a disabled remote and a removed remote */
+	ret = g_file_set_contents(fn_legacy, "legacy", -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_file_set_contents(fn_disabled, "disabled", -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_file_set_contents(fn_unknown, "unknown", -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* metadata for two remotes */
+	ret = g_file_set_contents("/tmp/fwupd-self-test/stable.xml",
+				  "<components>"
+				  "  <component type=\"firmware\">"
+				  "    <id>stable</id>"
+				  "  </component>"
+				  "</components>",
+				  -1,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_file_set_contents("/tmp/fwupd-self-test/testing.xml",
+				  "<components>"
+				  "  <component type=\"firmware\">"
+				  "    <id>testing</id>"
+				  "  </component>"
+				  "</components>",
+				  -1,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* build each shard and delete the unused ones */
+	ret = fu_engine_load(engine1, FU_ENGINE_LOAD_FLAG_REMOTES, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_false(g_file_test(fn_legacy, G_FILE_TEST_EXISTS));
+	g_assert_false(g_file_test(fn_disabled, G_FILE_TEST_EXISTS));
+	g_assert_false(g_file_test(fn_unknown, G_FILE_TEST_EXISTS));
+	inode_stable = fu_engine_metadata_shard_get_inode(cachedirpkg, "metadata-stable.xmlb");
+	inode_testing = fu_engine_metadata_shard_get_inode(cachedirpkg, "metadata-testing.xmlb");
+
+	/* refresh only one remote */
+	ret = g_file_set_contents("/tmp/fwupd-self-test/stable.xml",
+				  "<components>"
+				  "  <component type=\"firmware\">"
+				  "    <id>stable-refreshed</id>"
+				  "  </component>"
+				  "</components>",
+				  -1,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_file_set_attribute_uint64(file_stable,
+					  G_FILE_ATTRIBUTE_TIME_MODIFIED,
+					  (guint64)g_get_real_time() / G_USEC_PER_SEC + 60,
+					  G_FILE_QUERY_INFO_NONE,
+					  NULL,
+					  &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* only the refreshed shard is rebuilt */
+	ret = fu_engine_load(engine2, FU_ENGINE_LOAD_FLAG_REMOTES, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_engine_metadata_shard_get_inode(cachedirpkg, "metadata-stable.xmlb"),
+			!=,
+			inode_stable);
+	g_assert_cmpint(fu_engine_metadata_shard_get_inode(cachedirpkg, "metadata-testing.xmlb"),
+			==,
+			inode_testing);
+}
+
 static void
 fu_engine_downgrade_func(gconstpointer user_data)
 {
@@ -1988,6 +2162,7 @@ fu_engine_downgrade_func(gconstpointer user_data)
 	g_autoptr(GPtrArray) releases = NULL;
 	g_autoptr(GPtrArray) releases_up = NULL;
 	g_autoptr(GPtrArray) releases_up2 = NULL;
+	g_autoptr(GPtrArray) devices_up = NULL;
 	g_autoptr(GPtrArray) remotes = NULL;
 	g_autoptr(XbSilo) silo_empty = xb_silo_new();
 
@@ -2148,6 +2323,16 @@ fu_engine_downgrade_func(gconstpointer user_data)
 	rel = FWUPD_RELEASE(g_ptr_array_index(releases_up, 1));
 	g_assert_cmpstr(fwupd_release_get_version(rel), ==, "1.2.4");
 
+	/* upgrades for all devices */
+	devices_up = fu_engine_get_upgrades_all(engine, request, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(devices_up);
+	g_assert_cmpint(devices_up->len, ==, 1);
+	g_assert_cmpstr(fwupd_device_get_id(g_ptr_array_index(devices_up, 0)),
+			==,
+			fu_device_get_id(device));
+	g_assert_cmpint(fwupd_device_get_releases(g_ptr_array_index(devices_up, 0))->len, ==, 2);
+
 	/* downgrades */
 	releases_dg = fu_engine_get_downgrades(engine, request, fu_device_get_id(device), &error);
 	g_assert_no_error(error);
@@ -2794,6 +2979,269 @@ fu_engine_multiple_rels_func(gconstpointer user_data)
 	g_assert_true(ret);
 }
 
+static void
+fu_engine_install_independent_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	g_autoptr(FuDevice) device1 = fu_device_new(self->ctx);
+	g_autoptr(FuDevice) device2 = fu_device_new(self->ctx);
+	g_autoptr(FuDevice) parent = fu_device_new(self->ctx);
+
+	/* nothing in common */
+	fu_device_set_physical_id(device1, "usb:01:00");
+	fu_device_set_physical_id(device2, "usb:02:00");
+	g_assert_true(fu_engine_install_release_devices_are_independent(device1, device2));
+
+	/* installed in a different order */
+	fu_device_set_order(device2, 1);
+	g_assert_false(fu_engine_install_release_devices_are_independent(device1, device2));
+	fu_device_set_order(device2, 0);
+
+	/* same physical device */
+	fu_device_set_physical_id(device2, "usb:01:00");
+	g_assert_false(fu_engine_install_release_devices_are_independent(device1, device2));
+	fu_device_set_physical_id(device2, "usb:02:00");
+
+	/* same root device */
+	fu_device_add_child(parent, device1);
+	fu_device_add_child(parent, device2);
+	g_assert_false(fu_engine_install_release_devices_are_independent(device1, device2));
+}
+
+static void
+fu_engine_install_batch_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	FuConfig *config;
+	gboolean ret;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuCabinet) cabinet = NULL;
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuEngineRequest) request = fu_engine_request_new();
+	g_autoptr(FuPlugin) plugin = fu_plugin_new_from_gtype(fu_test_plugin_get_type(), self->ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GArray) batches = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GPtrArray) devices =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	g_autoptr(GPtrArray) releases =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	g_autoptr(XbNode) component = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new();
+
+#ifndef HAVE_LIBARCHIVE
+	g_test_skip("no libarchive support");
+	return;
+#endif
+
+	/* ensure empty tree */
+	fu_self_test_mkroot();
+
+	/* no metadata in daemon */
+	fu_engine_set_silo(engine, silo_empty);
+
+	/* set up dummy plugin */
+	ret = fu_plugin_reset_config_values(plugin, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_engine_add_plugin(engine, plugin);
+
+	ret = fu_engine_load(engine, FU_ENGINE_LOAD_FLAG_NO_CACHE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* add two devices that can be updated at the same time */
+	for (guint i = 0; i < 2; i++) {
+		g_autofree gchar *id = g_strdup_printf("test_device%u", i);
+		g_autofree gchar *physical_id = g_strdup_printf("usb:0%u:00", i);
+		g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+		fu_device_set_version_format(device, FWUPD_VERSION_FORMAT_TRIPLET);
+		fu_device_set_version(device, "1.2.2");
+		fu_device_set_id(device, id);
+		fu_device_set_physical_id(device, physical_id);
+		fu_device_build_vendor_id_u16(device, "USB", 0xFFFF);
+		fu_device_add_protocol(device, "com.acme");
+		fu_device_set_name(device, "Test Device");
+		fu_device_set_plugin(device, "test");
+		fu_device_add_guid(device, "12345678-1234-1234-1234-123456789012");
+		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_UPDATABLE);
+		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_UNSIGNED_PAYLOAD);
+		fu_device_set_metadata_integer(device, "nr-update", 0);
+		fu_engine_add_device(engine, device);
+		g_ptr_array_add(devices, g_steal_pointer(&device));
+	}
+
+	filename =
+	    g_test_build_filename(G_TEST_BUILT, "tests", "missing-hwid", "noreqs-1.2.3.cab", NULL);
+	stream = fu_input_stream_from_path(filename, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream);
+	cabinet = fu_engine_build_cabinet_from_stream(engine, stream, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(cabinet);
+	component = fu_cabinet_get_component(cabinet, "com.hughski.test.firmware", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(component);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		g_autoptr(FuRelease) release = fu_release_new();
+		fu_release_set_device(release, device);
+		ret = fu_release_load(release,
+				      cabinet,
+				      component,
+				      NULL,
+				      FWUPD_INSTALL_FLAG_NONE,
+				      &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		g_ptr_array_add(releases, g_steal_pointer(&release));
+	}
+
+	/* installed one at a time by default */
+	batches = fu_engine_install_releases_get_batches(engine, releases, FWUPD_INSTALL_FLAG_NONE);
+	g_assert_cmpint(batches->len, ==, 2);
+	g_clear_pointer(&batches, g_array_unref);
+
+	/* both at the same time */
+	config = FU_CONFIG(fu_engine_get_config(engine));
+	ret = fu_config_set_value(config, "fwupd", "InstallThreads", "2", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	batches = fu_engine_install_releases_get_batches(engine, releases, FWUPD_INSTALL_FLAG_NONE);
+	g_assert_cmpint(batches->len, ==, 1);
+	g_assert_cmpint(g_array_index(batches, guint, 0), ==, 2);
+	g_clear_pointer(&batches, g_array_unref);
+
+	/* offline updates are never batched */
+	batches =
+	    fu_engine_install_releases_get_batches(engine, releases, FWUPD_INSTALL_FLAG_OFFLINE);
+	g_assert_cmpint(batches->len, ==, 2);
+	g_clear_pointer(&batches, g_array_unref);
+
+	/* install them */
+	ret = fu_engine_install_releases(engine,
+					 request,
+					 releases,
+					 cabinet,
+					 progress,
+					 FWUPD_INSTALL_FLAG_NONE,
+					 &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		g_assert_cmpint(fu_device_get_metadata_integer(device, "nr-update"), ==, 1);
+		g_assert_cmpint(fu_device_get_update_state(device),
+				==,
+				FWUPD_UPDATE_STATE_SUCCESS);
+		g_assert_cmpstr(fu_device_get_version(device), ==, "1.2.3");
+	}
+
+	/* the plugin has to opt-in */
+	fu_plugin_remove_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL);
+	batches = fu_engine_install_releases_get_batches(engine, releases, FWUPD_INSTALL_FLAG_NONE);
+	g_assert_cmpint(batches->len, ==, 2);
+
+	/* reset the config back to defaults */
+	ret = fu_config_set_value(config, "fwupd", "InstallThreads", "1", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+}
+
+static void
+fu_engine_security_attrs_assert_result(FuEngine *engine, FwupdSecurityAttrResult result)
+{
+	g_autoptr(FuSecurityAttrs) attrs = fu_engine_get_host_security_attrs(engine);
+	g_autoptr(FwupdSecurityAttr) attr = NULL;
+	g_autoptr(GError) error = NULL;
+
+	attr = fu_security_attrs_get_by_appstream_id(attrs,
+						     FWUPD_SECURITY_ATTR_ID_ENCRYPTED_RAM,
+						     &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(attr);
+	g_assert_cmpint(fwupd_security_attr_get_result(attr), ==, result);
+}
+
+static void
+fu_engine_security_attrs_cache_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+	g_autoptr(FuDevice) device_other = fu_device_new(self->ctx);
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuPlugin) plugin = fu_plugin_new_from_gtype(fu_test_plugin_get_type(), self->ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new();
+
+#ifndef HAVE_HSI
+	g_test_skip("no HSI support");
+	return;
+#endif
+
+	/* ensure empty tree */
+	fu_self_test_mkroot();
+
+	/* no metadata in daemon */
+	fu_engine_set_silo(engine, silo_empty);
+
+	/* set up dummy plugin */
+	ret = fu_plugin_reset_config_values(plugin, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_plugin_set_config_value(plugin, "SecurityAttrResult", "encrypted", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_engine_add_plugin(engine, plugin);
+
+	ret = fu_engine_load(engine, FU_ENGINE_LOAD_FLAG_NO_CACHE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* one device owned by the plugin, and one by a different plugin */
+	fu_device_set_id(device, "test_device");
+	fu_device_set_plugin(device, "test");
+	fu_device_add_guid(device, "12345678-1234-1234-1234-123456789012");
+	fu_engine_add_device(engine, device);
+	fu_device_set_id(device_other, "other_device");
+	fu_device_set_plugin(device_other, "other");
+	fu_device_add_guid(device_other, "b585990a-003e-5270-89d5-3705a17f9a43");
+	fu_engine_add_device(engine, device_other);
+	fu_engine_security_attrs_assert_result(engine, FWUPD_SECURITY_ATTR_RESULT_ENCRYPTED);
+
+	/* nothing has been invalidated, so the cached attr is used */
+	ret = fu_plugin_set_config_value(plugin, "SecurityAttrResult", "not-encrypted", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_engine_security_attrs_assert_result(engine, FWUPD_SECURITY_ATTR_RESULT_ENCRYPTED);
+
+	/* a device from a different plugin changed */
+	fu_engine_add_device(engine, device_other);
+	fu_engine_security_attrs_assert_result(engine, FWUPD_SECURITY_ATTR_RESULT_ENCRYPTED);
+
+	/* a device from the plugin changed */
+	fu_engine_add_device(engine, device);
+	fu_engine_security_attrs_assert_result(engine, FWUPD_SECURITY_ATTR_RESULT_NOT_ENCRYPTED);
+
+	/* everything is invalidated */
+	ret = fu_plugin_set_config_value(plugin, "SecurityAttrResult", "encrypted", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_context_security_changed(self->ctx);
+	fu_engine_security_attrs_assert_result(engine, FWUPD_SECURITY_ATTR_RESULT_ENCRYPTED);
+
+	/* plugins that cannot signal a change are queried again whenever anything changes */
+	fu_plugin_remove_flag(plugin, FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE);
+	ret = fu_plugin_set_config_value(plugin, "SecurityAttrResult", "not-encrypted", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_engine_add_device(engine, device_other);
+	fu_engine_security_attrs_assert_result(engine, FWUPD_SECURITY_ATTR_RESULT_NOT_ENCRYPTED);
+}
+
 static void
 fu_engine_history_inherit(gconstpointer user_data)
 {
@@ -3838,6 +4286,216 @@ fu_device_list_func(gconstpointer user_data)
 	g_assert_cmpstr(fu_device_get_id(device), ==, "1a8d0d9a96ad3e67ba76cf3033623625dc6d6882");
 }
 
+static void
+fu_device_list_index_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	g_autoptr(FuDeviceList) device_list = fu_device_list_new();
+	g_autoptr(FuDevice) device1 = fu_device_new(self->ctx);
+	g_autoptr(FuDevice) device2 = fu_device_new(self->ctx);
+	g_autoptr(FuDevice) donor = fu_device_new(self->ctx);
+	g_autoptr(FuDevice) device_tmp = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* add */
+	fu_device_set_id(device1, "device1");
+	fu_device_set_remove_delay(device1, 100);
+	fu_device_list_add(device_list, device1);
+
+	/* change the ID after adding */
+	fu_device_set_id(device1, "device1-renamed");
+	device_tmp = fu_device_list_get_by_id(device_list, fu_device_get_id(device1), &error);
+	g_assert_no_error(error);
+	g_assert_true(device_tmp == device1);
+	g_clear_object(&device_tmp);
+
+	/* add an equivalent ID after adding */
+	fu_device_set_equivalent_id(device1, "3a4e3d2ae6c8e6e5c3f9f3a1aa7bd5e3c1d0b4f2");
+	device_tmp = fu_device_list_get_by_id(device_list, "3a4e3d2a", &error);
+	g_assert_no_error(error);
+	g_assert_true(device_tmp == device1);
+	g_clear_object(&device_tmp);
+
+	/* add a GUID after adding */
+	fu_device_add_instance_id(device1, "late");
+	fu_device_convert_instance_ids(device1);
+	device_tmp =
+	    fu_device_list_get_by_guid(device_list, "f3d018ba-da0f-5a2f-8ee9-dbf17a8235fe", &error);
+	g_assert_no_error(error);
+	g_assert_true(device_tmp == device1);
+	g_clear_object(&device_tmp);
+
+	/* incorporate a GUID from a donor after adding */
+	fu_device_add_guid(donor, "8cd9a1b5-2f3e-4e0c-9c6d-3d8a7e1f0b42");
+	fu_device_incorporate(device1, donor);
+	device_tmp =
+	    fu_device_list_get_by_guid(device_list, "8cd9a1b5-2f3e-4e0c-9c6d-3d8a7e1f0b42", &error);
+	g_assert_no_error(error);
+	g_assert_true(device_tmp == device1);
+	g_clear_object(&device_tmp);
+
+	/* an index miss is final */
+	device_tmp =
+	    fu_device_list_get_by_guid(device_list, "00000000-0000-0000-0000-000000000000", &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null(device_tmp);
+	g_clear_error(&error);
+
+	/* set the connection after adding, then replug with a different ID */
+	fu_device_set_physical_id(device1, "usb:01:00");
+	fu_device_set_id(device2, "device2");
+	fu_device_set_physical_id(device2, "usb:01:00");
+	fu_device_list_remove(device_list, device1);
+	fu_device_list_add(device_list, device2);
+	device_tmp = fu_device_list_get_old(device_list, device2);
+	g_assert_true(device_tmp == device1);
+	g_clear_object(&device_tmp);
+
+	/* the old device is still found */
+	device_tmp = fu_device_list_get_by_id(device_list, "3a4e3d2a", &error);
+	g_assert_no_error(error);
+	g_assert_true(device_tmp == device2);
+}
+
+static void
+fu_device_list_speed_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	const guint n_devices = 10000;
+	g_autoptr(FuDeviceList) device_list = fu_device_list_new();
+	g_autoptr(GPtrArray) devices = g_ptr_array_new_with_free_func(g_object_unref);
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	/* add */
+	for (guint i = 0; i < n_devices; i++) {
+		g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+		g_autofree gchar *id = g_strdup_printf("device%u", i);
+		g_autofree gchar *physical_id = NULL;
+
+		physical_id = g_strdup_printf("usb:%02x:%02x", i / 0xff, i % 0xff);
+		fu_device_set_id(device, id);
+		fu_device_set_physical_id(device, physical_id);
+		fu_device_add_instance_id(device, id);
+		fu_device_convert_instance_ids(device);
+		fu_device_list_add(device_list, device);
+		g_ptr_array_add(devices, g_steal_pointer(&device));
+	}
+	g_test_message("added %u devices in %.1fms",
+		       n_devices,
+		       g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* look up by ID */
+	g_timer_reset(timer);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		g_autoptr(FuDevice) device_tmp = NULL;
+		g_autoptr(GError) error = NULL;
+		device_tmp =
+		    fu_device_list_get_by_id(device_list, fu_device_get_id(device), &error);
+		g_assert_no_error(error);
+		g_assert_true(device_tmp == device);
+	}
+	g_test_message("found %u devices by ID in %.1fms",
+		       n_devices,
+		       g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* look up by GUID */
+	g_timer_reset(timer);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		const gchar *guid = fu_device_get_guid_default(device);
+		g_autoptr(FuDevice) device_tmp = NULL;
+		g_autoptr(GError) error = NULL;
+		device_tmp = fu_device_list_get_by_guid(device_list, guid, &error);
+		g_assert_no_error(error);
+		g_assert_true(device_tmp == device);
+	}
+	g_test_message("found %u devices by GUID in %.1fms",
+		       n_devices,
+		       g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* replug */
+	g_timer_reset(timer);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		fu_device_list_add(device_list, device);
+	}
+	g_test_message("re-added %u devices in %.1fms",
+		       n_devices,
+		       g_timer_elapsed(timer, NULL) * 1000.f);
+}
+
+static void
+fu_device_list_coldplug_speed_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	const guint n_devices = 1000;
+	g_autofree gchar *messages_debug = g_strdup(g_getenv("G_MESSAGES_DEBUG"));
+	g_autofree gchar *verbose = g_strdup(g_getenv("FWUPD_VERBOSE"));
+	g_autoptr(GPtrArray) devices = g_ptr_array_new_with_free_func(g_object_unref);
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	/* like a host with lots of USB devices, each with a few instance IDs and a child */
+	for (guint i = 0; i < n_devices; i++) {
+		g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+		g_autoptr(FuDevice) child = fu_device_new(self->ctx);
+		g_autofree gchar *id = g_strdup_printf("device%u", i);
+		g_autofree gchar *id_child = g_strdup_printf("child%u", i);
+
+		fu_device_set_id(device, id);
+		fu_device_set_name(device, "Coldplug Device");
+		fu_device_set_vendor(device, "Hughski");
+		fu_device_set_version_format(device, FWUPD_VERSION_FORMAT_TRIPLET);
+		fu_device_set_version(device, "1.2.3");
+		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_UPDATABLE);
+		fu_device_add_protocol(device, "com.hughski.colorhug");
+		for (guint j = 0; j < 8; j++) {
+			g_autofree gchar *instance_id =
+			    g_strdup_printf("USB\\VID_273F&PID_%04X&REV_%04X", i, j);
+			fu_device_add_instance_id(device, instance_id);
+		}
+		fu_device_convert_instance_ids(device);
+		fu_device_set_id(child, id_child);
+		fu_device_add_instance_id(child, id_child);
+		fu_device_convert_instance_ids(child);
+		fu_device_add_child(device, child);
+		g_ptr_array_add(devices, g_steal_pointer(&device));
+	}
+
+	/* the daemon logs at message level by default */
+	g_unsetenv("G_MESSAGES_DEBUG");
+	g_unsetenv("FWUPD_VERBOSE");
+
+	/* what the engine used to do for each added device */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		g_autofree gchar *str1 = fu_device_to_string(device);
+		g_autofree gchar *str2 = fu_device_to_string(device);
+		g_assert_nonnull(str1);
+		g_assert_nonnull(str2);
+	}
+	g_test_message("stringified %u devices in %.1fms",
+		       n_devices,
+		       g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* only formatted if debugging is enabled for the domain */
+	g_timer_reset(timer);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		fu_device_dump(device, G_LOG_DOMAIN, "added");
+		fu_device_dump(device, G_LOG_DOMAIN, "after");
+	}
+	g_test_message("dumped %u devices in %.1fms",
+		       n_devices,
+		       g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* restore */
+	if (messages_debug != NULL)
+		(void)g_setenv("G_MESSAGES_DEBUG", messages_debug, TRUE);
+	if (verbose != NULL)
+		(void)g_setenv("FWUPD_VERBOSE", verbose, TRUE);
+}
+
 static void
 fu_plugin_list_func(gconstpointer user_data)
 {
@@ -4815,6 +5473,77 @@ fu_security_attr_func(gconstpointer user_data)
 	g_assert_true(ret);
 }
 
+static void
+fu_common_cabinet_speed_func(void)
+{
+	gboolean ret;
+	const gchar *xml = "<component type=\"firmware\">\n"
+			   "  <id>com.acme.example.firmware</id>\n"
+			   "  <releases>\n"
+			   "    <release version=\"1.2.3\"/>\n"
+			   "  </releases>\n"
+			   "</component>";
+	gsize bufsz = 64 * 1024 * 1024;
+	guint8 *buf = g_malloc(bufsz);
+	g_autofree gchar *csum = NULL;
+	g_autoptr(FuCabFirmware) cab_firmware = fu_cab_firmware_new();
+	g_autoptr(FuCabImage) img_fw = fu_cab_image_new();
+	g_autoptr(FuCabImage) img_xml = fu_cab_image_new();
+	g_autoptr(FuCabinet) cabinet = fu_cabinet_new();
+	g_autoptr(FuFirmware) img = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob_fw = NULL;
+	g_autoptr(GBytes) blob_xml = g_bytes_new_static(xml, strlen(xml));
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GInputStream) stream_img = NULL;
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	/* build a large compressed archive, with one CFDATA block for each 32kB */
+	for (gsize i = 0; i < bufsz; i++)
+		buf[i] = (guint8)((i / 64) ^ i);
+	blob_fw = g_bytes_new_take(buf, bufsz);
+	fu_firmware_set_id(FU_FIRMWARE(img_fw), "firmware.bin");
+	fu_firmware_set_bytes(FU_FIRMWARE(img_fw), blob_fw);
+	fu_firmware_add_image(FU_FIRMWARE(cab_firmware), FU_FIRMWARE(img_fw));
+	fu_firmware_set_id(FU_FIRMWARE(img_xml), "acme.metainfo.xml");
+	fu_firmware_set_bytes(FU_FIRMWARE(img_xml), blob_xml);
+	fu_firmware_add_image(FU_FIRMWARE(cab_firmware), FU_FIRMWARE(img_xml));
+	fu_cab_firmware_set_compressed(cab_firmware, TRUE);
+	blob = fu_firmware_write(FU_FIRMWARE(cab_firmware), &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob);
+	g_test_message("built %.1fMB compressed archive in %.1fms",
+		       g_bytes_get_size(blob) / 1024.f / 1024.f,
+		       g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* parse */
+	g_timer_reset(timer);
+	stream = g_memory_input_stream_new_from_bytes(blob);
+	ret = fu_firmware_parse_stream(FU_FIRMWARE(cabinet),
+				       stream,
+				       0x0,
+				       FWUPD_INSTALL_FLAG_NONE,
+				       &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_test_message("parsed archive in %.1fms", g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* stream the decompressed payload */
+	g_timer_reset(timer);
+	img = fu_firmware_get_image_by_id(FU_FIRMWARE(cabinet), "firmware.bin", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img);
+	stream_img = fu_firmware_get_stream(img, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream_img);
+	csum = fu_input_stream_compute_checksum(stream_img, G_CHECKSUM_SHA256, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(csum);
+	g_test_message("read payload at %.1f MB/s",
+		       (bufsz / 1024.f / 1024.f) / g_timer_elapsed(timer, NULL));
+}
+
 static void
 fu_common_cabinet_func(void)
 {
@@ -6403,6 +7132,97 @@ fu_config_migrate_1_7_func(void)
 	g_assert_cmpstr(localconf_data, ==, "");
 }
 
+static void
+fu_engine_emulation_binary_func(void)
+{
+	gboolean ret;
+	guint8 buf[100] = {0x0};
+	GBytes *json_blob2;
+	GBytes *payload;
+	g_autofree gchar *json = NULL;
+	g_autofree gchar *json3 = NULL;
+	g_autofree gchar *data = NULL;
+	g_autofree gchar *data_str = NULL;
+	g_autoptr(FuDeviceEvent) event = fu_device_event_new(NULL);
+	g_autoptr(GBytes) blob_bin = NULL;
+	g_autoptr(GBytes) blob_data = NULL;
+	g_autoptr(GBytes) json_blob3 = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GHashTable) phases = g_hash_table_new_full(g_direct_hash,
+							     g_direct_equal,
+							     NULL,
+							     (GDestroyNotify)g_bytes_unref);
+	g_autoptr(GHashTable) phases2 = g_hash_table_new_full(g_direct_hash,
+							      g_direct_equal,
+							      NULL,
+							      (GDestroyNotify)g_bytes_unref);
+	g_autoptr(GHashTable) payloads2 = g_hash_table_new_full(g_direct_hash,
+								g_direct_equal,
+								NULL,
+								(GDestroyNotify)g_bytes_unref);
+
+	/* one large payload, and one small enough to stay inline */
+	for (guint i = 0; i < sizeof(buf); i++)
+		buf[i] = i;
+	data = g_base64_encode(buf, sizeof(buf));
+	json = g_strdup_printf("{\"UsbDevices\":[{\"UsbEvents\":["
+			       "{\"Id\":\"foo\",\"Data\":\"%s\"},"
+			       "{\"Id\":\"bar\",\"Data\":\"AAAA\"}]}]}",
+			       data);
+	g_hash_table_insert(phases,
+			    GINT_TO_POINTER(FU_ENGINE_INSTALL_PHASE_SETUP),
+			    g_bytes_new(json, strlen(json)));
+
+	/* write binary */
+	blob_bin = fu_engine_emulation_write_binary(phases, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob_bin);
+	stream = g_memory_input_stream_new_from_bytes(blob_bin);
+	g_assert_cmpint(fu_engine_emulation_format_from_stream(stream),
+			==,
+			FU_ENGINE_EMULATION_FORMAT_BINARY);
+
+	/* parse it back */
+	ret = fu_engine_emulation_parse_binary(blob_bin, phases2, payloads2, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	json_blob2 =
+	    g_hash_table_lookup(phases2, GINT_TO_POINTER(FU_ENGINE_INSTALL_PHASE_SETUP));
+	g_assert_nonnull(json_blob2);
+	payload = g_hash_table_lookup(payloads2, GINT_TO_POINTER(FU_ENGINE_INSTALL_PHASE_SETUP));
+	g_assert_nonnull(payload);
+	g_assert_cmpint(g_bytes_get_size(payload), ==, sizeof(buf));
+
+	/* payload is referenced without copying */
+	ret = fwupd_codec_from_json_string(FWUPD_CODEC(event),
+					   "{\"Id\":\"foo\",\"Data\":{\"Offset\":0,\"Size\":100}}",
+					   &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	blob_data = fu_device_event_get_bytes(event, "Data", &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA);
+	g_assert_null(blob_data);
+	g_clear_error(&error);
+	ret = fu_device_event_resolve_payload(event, payload, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	blob_data = fu_device_event_get_bytes(event, "Data", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob_data);
+	g_assert_true(g_bytes_get_data(blob_data, NULL) == g_bytes_get_data(payload, NULL));
+	data_str = fu_device_event_get_str(event, "Data", NULL);
+	g_assert_cmpstr(data_str, ==, data);
+
+	/* convert back to JSON losslessly */
+	json_blob3 = fu_engine_emulation_json_inline_payload(json_blob2, payload, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(json_blob3);
+	json3 = g_strndup(g_bytes_get_data(json_blob3, NULL), g_bytes_get_size(json_blob3));
+	g_assert_nonnull(g_strstr_len(json3, -1, data));
+	g_assert_null(g_strstr_len(json3, -1, "Offset"));
+}
+
 static void
 fu_engine_machine_hash_func(void)
 {
@@ -6494,6 +7314,8 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/plugin{module}", self, fu_plugin_module_func);
 	g_test_add_data_func("/fwupd/memcpy", self, fu_memcpy_func);
 	g_test_add_func("/fwupd/cabinet", fu_common_cabinet_func);
+	if (g_test_perf())
+		g_test_add_func("/fwupd/cabinet{speed}", fu_common_cabinet_speed_func);
 	g_test_add_data_func("/fwupd/security-attr", self, fu_security_attr_func);
 	g_test_add_data_func("/fwupd/device-list", self, fu_device_list_func);
 	g_test_add_data_func("/fwupd/device-list{delay}", self, fu_device_list_delay_func);
@@ -6515,6 +7337,13 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/device-list{counterpart}",
 			     self,
 			     fu_device_list_counterpart_func);
+	g_test_add_data_func("/fwupd/device-list{index}", self, fu_device_list_index_func);
+	if (g_test_perf()) {
+		g_test_add_data_func("/fwupd/device-list{speed}", self, fu_device_list_speed_func);
+		g_test_add_data_func("/fwupd/device-list{coldplug-speed}",
+				     self,
+				     fu_device_list_coldplug_speed_func);
+	}
 	g_test_add_data_func("/fwupd/release{compare}", self, fu_release_compare_func);
 	g_test_add_func("/fwupd/release{uri-scheme}", fu_release_uri_scheme_func);
 	g_test_add_data_func("/fwupd/release{trusted-report}",
@@ -6536,12 +7365,20 @@ main(int argc, char **argv)
 			     self,
 			     fu_engine_get_details_missing_func);
 	g_test_add_data_func("/fwupd/engine{device-unlock}", self, fu_engine_device_unlock_func);
+	g_test_add_data_func("/fwupd/engine{devices-file}", self, fu_engine_devices_file_func);
 	g_test_add_data_func("/fwupd/engine{device-md-set-flags}",
 			     self,
 			     fu_engine_device_md_set_flags_func);
 	g_test_add_data_func("/fwupd/engine{multiple-releases}",
 			     self,
 			     fu_engine_multiple_rels_func);
+	g_test_add_data_func("/fwupd/engine{install-independent}",
+			     self,
+			     fu_engine_install_independent_func);
+	g_test_add_data_func("/fwupd/engine{install-batch}", self, fu_engine_install_batch_func);
+	g_test_add_data_func("/fwupd/engine{security-attrs-cache}",
+			     self,
+			     fu_engine_security_attrs_cache_func);
 	g_test_add_data_func("/fwupd/engine{install-request}", self, fu_engine_install_request);
 	g_test_add_data_func("/fwupd/engine{history-success}", self, fu_engine_history_func);
 	g_test_add_data_func("/fwupd/engine{history-verfmt}", self, fu_engine_history_verfmt_func);
@@ -6556,6 +7393,7 @@ main(int argc, char **argv)
 			     self,
 			     fu_device_list_replug_user_func);
 	g_test_add_func("/fwupd/engine{machine-hash}", fu_engine_machine_hash_func);
+	g_test_add_func("/fwupd/engine{emulation-binary}", fu_engine_emulation_binary_func);
 	g_test_add_data_func("/fwupd/engine{require-hwid}", self, fu_engine_require_hwid_func);
 	g_test_add_data_func("/fwupd/engine{requires-reboot}",
 			     self,
@@ -6563,6 +7401,7 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/engine{history-inherit}", self, fu_engine_history_inherit);
 	g_test_add_data_func("/fwupd/engine{partial-hash}", self, fu_engine_partial_hash_func);
 	g_test_add_data_func("/fwupd/engine{downgrade}", self, fu_engine_downgrade_func);
+	g_test_add_data_func("/fwupd/engine{metadata-shards}", self, fu_engine_metadata_shards_func);
 	g_test_add_data_func("/fwupd/engine{md-verfmt}", self, fu_engine_md_verfmt_func);
 	g_test_add_data_func("/fwupd/engine{requirements-success}",
 			     self,
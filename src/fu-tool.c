@@ -33,6 +33,7 @@
 #include "fu-context-private.h"
 #include "fu-debug.h"
 #include "fu-device-private.h"
+#include "fu-engine-emulation.h"
 #include "fu-engine-helper.h"
 #include "fu-engine-requirements.h"
 #include "fu-engine.h"
@@ -283,6 +284,21 @@ fu_util_maybe_prefix_sandbox_error(const gchar *value, GError **error)
 	}
 }
 
+/* fwupdtool only runs for the duration of the command, so map local archives and firmware to
+ * avoid copying them, but fall back to reading things like pipes and device nodes */
+static GInputStream *
+fu_util_input_stream_from_path(const gchar *path, GError **error)
+{
+	GInputStream *stream;
+	g_autoptr(GError) error_local = NULL;
+
+	stream = fu_mapped_input_stream_new_from_path(path, &error_local);
+	if (stream != NULL)
+		return stream;
+	g_debug("not mapping %s: %s", path, error_local->message);
+	return fu_input_stream_from_path(path, error);
+}
+
 static void
 fu_util_cancelled_cb(GCancellable *cancellable, gpointer user_data)
 {
@@ -717,7 +733,7 @@ fu_util_get_details(FuUtilPrivate *priv, gchar **values, GError **error)
 	priv->show_all = TRUE;
 
 	/* open file */
-	stream = fu_input_stream_from_path(values[0], error);
+	stream = fu_util_input_stream_from_path(values[0], error);
 	if (stream == NULL) {
 		fu_util_maybe_prefix_sandbox_error(values[0], error);
 		return FALSE;
@@ -871,6 +887,66 @@ fu_util_get_devices(FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_util_emulation_load(FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	g_autoptr(GInputStream) stream = NULL;
+
+	/* check args */
+	if (g_strv_length(values) != 1) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_ARGS,
+				    "Invalid arguments, expected FILENAME");
+		return FALSE;
+	}
+
+	/* load engine */
+	if (!fu_util_start_engine(priv,
+				  FU_ENGINE_LOAD_FLAG_COLDPLUG | FU_ENGINE_LOAD_FLAG_REMOTES,
+				  priv->progress,
+				  error))
+		return FALSE;
+
+	/* either the ZIP or binary format */
+	stream = fu_util_input_stream_from_path(values[0], error);
+	if (stream == NULL)
+		return FALSE;
+	if (!fu_engine_emulation_load(priv->engine, stream, error))
+		return FALSE;
+
+	/* show the emulated devices */
+	return fu_util_get_devices(priv, values + 1, error);
+}
+
+static gboolean
+fu_util_emulation_convert(FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	FuEngineEmulationFormat format = FU_ENGINE_EMULATION_FORMAT_BINARY;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+
+	/* check args */
+	if (g_strv_length(values) != 2) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_ARGS,
+				    "Invalid arguments, expected FILENAME-SRC FILENAME-DST");
+		return FALSE;
+	}
+
+	/* convert to the other format */
+	stream = fu_util_input_stream_from_path(values[0], error);
+	if (stream == NULL)
+		return FALSE;
+	if (fu_engine_emulation_format_from_stream(stream) == FU_ENGINE_EMULATION_FORMAT_BINARY)
+		format = FU_ENGINE_EMULATION_FORMAT_ZIP;
+	blob = fu_engine_emulation_convert(stream, format, error);
+	if (blob == NULL)
+		return FALSE;
+	return fu_bytes_set_contents(values[1], blob, error);
+}
+
 static void
 fu_util_update_device_changed_cb(FwupdClient *client, FwupdDevice *device, FuUtilPrivate *priv)
 {
@@ -951,7 +1027,7 @@ fu_util_install_blob(FuUtilPrivate *priv, gchar **values, GError **error)
 	}
 
 	/* parse blob */
-	stream_fw = fu_input_stream_from_path(values[0], error);
+	stream_fw = fu_util_input_stream_from_path(values[0], error);
 	if (stream_fw == NULL) {
 		fu_util_maybe_prefix_sandbox_error(values[0], error);
 		return FALSE;
@@ -1321,7 +1397,7 @@ fu_util_install(FuUtilPrivate *priv, gchar **values, GError **error)
 		return FALSE;
 
 	/* parse silo */
-	stream = fu_input_stream_from_path(filename, error);
+	stream = fu_util_input_stream_from_path(filename, error);
 	if (stream == NULL) {
 		fu_util_maybe_prefix_sandbox_error(filename, error);
 		return FALSE;
@@ -2626,7 +2702,7 @@ fu_util_firmware_parse(FuUtilPrivate *priv, gchar **values, GError **error)
 	}
 
 	/* load file */
-	stream = fu_input_stream_from_path(values[0], error);
+	stream = fu_util_input_stream_from_path(values[0], error);
 	if (stream == NULL)
 		return FALSE;
 
@@ -2679,8 +2755,10 @@ fu_util_firmware_parse(FuUtilPrivate *priv, gchar **values, GError **error)
 					error_local->message);
 				continue;
 			}
-			firmware_str = fu_firmware_to_string(firmware_tmp);
-			g_debug("parsed as %s: %s", gtype_id, firmware_str);
+			if (fu_dump_is_enabled(G_LOG_DOMAIN)) {
+				firmware_str = fu_firmware_to_string(firmware_tmp);
+				g_debug("parsed as %s: %s", gtype_id, firmware_str);
+			}
 			g_ptr_array_add(firmware_auto_types, g_strdup(gtype_id));
 		}
 		firmware_type = fu_util_prompt_for_firmware_type(priv, firmware_auto_types, error);
@@ -4259,6 +4337,7 @@ main(int argc, char *argv[])
 	gboolean ignore_checksum = FALSE;
 	gboolean ignore_requirements = FALSE;
 	gboolean ignore_vid_pid = FALSE;
+	gboolean startup_profile = FALSE;
 	g_auto(GStrv) plugin_glob = NULL;
 	g_autoptr(FuUtilPrivate) priv = g_new0(FuUtilPrivate, 1);
 	g_autoptr(GError) error_console = NULL;
@@ -4446,6 +4525,14 @@ main(int argc, char *argv[])
 	     /* TRANSLATORS: command line option */
 	     N_("Output in JSON format"),
 	     NULL},
+	    {"startup-profile",
+	     '\0',
+	     0,
+	     G_OPTION_ARG_NONE,
+	     &startup_profile,
+	     /* TRANSLATORS: command line option */
+	     N_("Show the time taken to start the engine and probe devices"),
+	     NULL},
 	    {NULL}};
 
 #ifdef _WIN32
@@ -4539,6 +4626,20 @@ main(int argc, char *argv[])
 			      /* TRANSLATORS: command description */
 			      _("Get all devices that support firmware updates"),
 			      fu_util_get_devices);
+	fu_util_cmd_array_add(cmd_array,
+			      "emulation-load",
+			      /* TRANSLATORS: command argument: uppercase, spaces->dashes */
+			      _("FILENAME"),
+			      /* TRANSLATORS: command description */
+			      _("Load device emulation data"),
+			      fu_util_emulation_load);
+	fu_util_cmd_array_add(cmd_array,
+			      "emulation-convert",
+			      /* TRANSLATORS: command argument: uppercase, spaces->dashes */
+			      _("FILENAME-SRC FILENAME-DST"),
+			      /* TRANSLATORS: command description */
+			      _("Convert device emulation data between the ZIP and binary formats"),
+			      fu_util_emulation_convert);
 	fu_util_cmd_array_add(cmd_array,
 			      "get-device-flags",
 			      NULL,
@@ -4945,7 +5046,8 @@ main(int argc, char *argv[])
 				 error->message);
 		return EXIT_FAILURE;
 	}
-	fu_progress_set_profile(priv->progress, g_getenv("FWUPD_VERBOSE") != NULL);
+	fu_progress_set_profile(priv->progress,
+				startup_profile || g_getenv("FWUPD_VERBOSE") != NULL);
 
 	/* allow disabling SSL strict mode for broken corporate proxies */
 	if (priv->disable_ssl_strict) {
@@ -5079,6 +5181,16 @@ main(int argc, char *argv[])
 			fu_console_print_literal(priv->console, str);
 	}
 
+	/* show how much the coldplug worker pool saved */
+	if (startup_profile) {
+		g_autofree gchar *str = fu_engine_get_coldplug_profile(priv->engine);
+		g_autofree gchar *str_quirks =
+		    fu_context_get_quirks_profile(fu_engine_get_context(priv->engine));
+		if (str != NULL)
+			fu_console_print_literal(priv->console, str);
+		fu_console_print_literal(priv->console, str_quirks);
+	}
+
 	/* success */
 	return EXIT_SUCCESS;
 }
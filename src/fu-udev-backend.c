@@ -92,17 +92,32 @@ fu_udev_backend_rescan_dpaux_devices(FuUdevBackend *self)
 static FuUdevDevice *
 fu_udev_backend_create_device(FuUdevBackend *self, GUdevDevice *udev_device);
 
+/* libudev is not thread-safe, but the lock is only held for the call itself */
+static GUdevDevice *
+fu_udev_backend_query_by_sysfs_path(FuUdevBackend *self, const gchar *sysfs_path)
+{
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
+	return g_udev_client_query_by_sysfs_path(self->gudev_client, sysfs_path);
+}
+
+static GUdevDevice *
+fu_udev_backend_get_udev_parent(GUdevDevice *udev_device)
+{
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
+	return g_udev_device_get_parent(udev_device);
+}
+
 static void
 fu_udev_backend_create_ddc_proxy(FuUdevBackend *self, FuDevice *device)
 {
 	g_autofree gchar *proxy_sysfs_path = NULL;
 	g_autoptr(FuUdevDevice) proxy = NULL;
 	g_autoptr(GError) error_local = NULL;
-	g_autoptr(GUdevDevice) proxy_udev_device = NULL;
+	g_autoptr(FuGUdevDevice) proxy_udev_device = NULL;
 
 	proxy_sysfs_path =
 	    g_build_filename(fu_udev_device_get_sysfs_path(FU_UDEV_DEVICE(device)), "ddc", NULL);
-	proxy_udev_device = g_udev_client_query_by_sysfs_path(self->gudev_client, proxy_sysfs_path);
+	proxy_udev_device = fu_udev_backend_query_by_sysfs_path(self, proxy_sysfs_path);
 	if (proxy_udev_device == NULL)
 		return;
 	proxy = fu_udev_backend_create_device(self, proxy_udev_device);
@@ -115,8 +130,9 @@ fu_udev_backend_create_ddc_proxy(FuUdevBackend *self, FuDevice *device)
 	fu_device_set_proxy(device, FU_DEVICE(proxy));
 }
 
-static FuUdevDevice *
-fu_udev_backend_create_device(FuUdevBackend *self, GUdevDevice *udev_device)
+/* returns G_TYPE_INVALID if the device should be ignored */
+static GType
+fu_udev_backend_get_gtype_for_udev_device(GUdevDevice *udev_device)
 {
 	GType gtype = FU_TYPE_UDEV_DEVICE;
 	struct {
@@ -129,9 +145,9 @@ fu_udev_backend_create_device(FuUdevBackend *self, GUdevDevice *udev_device)
 				   {"i2c-dev", FU_TYPE_I2C_DEVICE},
 				   {"drm_dp_aux_dev", FU_TYPE_DPAUX_DEVICE},
 				   {NULL, G_TYPE_INVALID}};
-	g_autoptr(FuDevice) device = NULL;
+	g_autoptr(GRecMutexLocker) locker = fu_udev_device_locker_new();
 
-	/* create the correct object depending on the subsystem */
+	/* use the subsystem to find the correct GType */
 	for (guint i = 0; subsystem_gtype_map[i].gtype != G_TYPE_INVALID; i++) {
 		if (g_strcmp0(g_udev_device_get_subsystem(udev_device),
 			      subsystem_gtype_map[i].subsystem) == 0) {
@@ -143,6 +159,17 @@ fu_udev_backend_create_device(FuUdevBackend *self, GUdevDevice *udev_device)
 	/* ensure this is the actual device */
 	if (gtype == FU_TYPE_USB_DEVICE &&
 	    g_strcmp0(g_udev_device_get_devtype(udev_device), "usb_device") != 0)
+		return G_TYPE_INVALID;
+	return gtype;
+}
+
+static FuUdevDevice *
+fu_udev_backend_create_device(FuUdevBackend *self, GUdevDevice *udev_device)
+{
+	GType gtype = fu_udev_backend_get_gtype_for_udev_device(udev_device);
+	g_autoptr(FuDevice) device = NULL;
+
+	if (gtype == G_TYPE_INVALID)
 		return NULL;
 
 	/* create device of correct kind */
@@ -388,7 +415,7 @@ fu_udev_backend_get_device_parent(FuBackend *backend,
 {
 	FuUdevBackend *self = FU_UDEV_BACKEND(backend);
 	GUdevDevice *udev_device = fu_udev_device_get_dev(FU_UDEV_DEVICE(device));
-	g_autoptr(GUdevDevice) device_tmp = NULL;
+	g_autoptr(FuGUdevDevice) device_tmp = NULL;
 
 	/* sanity check */
 	if (udev_device == NULL) {
@@ -396,7 +423,7 @@ fu_udev_backend_get_device_parent(FuBackend *backend,
 		return NULL;
 	}
 	if (subsystem == NULL) {
-		g_autoptr(GUdevDevice) udev_parent = g_udev_device_get_parent(udev_device);
+		g_autoptr(FuGUdevDevice) udev_parent = fu_udev_backend_get_udev_parent(udev_device);
 		g_autoptr(FuUdevDevice) parent = NULL;
 		if (udev_parent == NULL) {
 			g_set_error_literal(error,
@@ -415,9 +442,9 @@ fu_udev_backend_get_device_parent(FuBackend *backend,
 		}
 		return FU_DEVICE(g_steal_pointer(&parent));
 	}
-	device_tmp = g_udev_device_get_parent(udev_device);
+	device_tmp = fu_udev_backend_get_udev_parent(udev_device);
 	while (device_tmp != NULL) {
-		g_autoptr(GUdevDevice) udev_parent = NULL;
+		g_autoptr(FuGUdevDevice) udev_parent = NULL;
 		g_autoptr(FuUdevDevice) device_new = NULL;
 
 		/* a match! */
@@ -427,8 +454,9 @@ fu_udev_backend_get_device_parent(FuBackend *backend,
 		if (fu_udev_device_match_subsystem(device_new, subsystem))
 			return FU_DEVICE(g_steal_pointer(&device_new));
 
-		udev_parent = g_udev_device_get_parent(device_tmp);
-		g_set_object(&device_tmp, udev_parent);
+		udev_parent = fu_udev_backend_get_udev_parent(device_tmp);
+		fu_udev_device_gudev_unref(device_tmp);
+		device_tmp = g_steal_pointer(&udev_parent);
 	}
 
 	/* failed */
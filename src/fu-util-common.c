@@ -1661,6 +1661,8 @@ fu_util_plugin_flag_to_cli_text(FwupdPluginFlags plugin_flag)
 	case FWUPD_PLUGIN_FLAG_UNKNOWN:
 	case FWUPD_PLUGIN_FLAG_CLEAR_UPDATABLE:
 	case FWUPD_PLUGIN_FLAG_USER_WARNING:
+	case FWUPD_PLUGIN_FLAG_THREAD_SAFE_INSTALL:
+	case FWUPD_PLUGIN_FLAG_SECURITY_ATTRS_CACHEABLE:
 	case FWUPD_PLUGIN_FLAG_NONE:
 		return NULL;
 	case FWUPD_PLUGIN_FLAG_READY:
@@ -2061,9 +2061,9 @@ fu_util_download_metadata(FuUtilPrivate *priv, GError **error)
 	gboolean download_remote_enabled = FALSE;
 	guint devices_supported_cnt = 0;
 	guint devices_updatable_cnt = 0;
-	guint refresh_cnt = 0;
 	g_autoptr(GPtrArray) devs = NULL;
 	g_autoptr(GPtrArray) remotes = NULL;
+	g_autoptr(GPtrArray) remotes_refresh = g_ptr_array_new();
 	g_autoptr(GString) str = g_string_new(NULL);
 	g_autoptr(GError) error_local = NULL;
 
@@ -2088,13 +2088,17 @@ fu_util_download_metadata(FuUtilPrivate *priv, GError **error)
 				 "%s %s",
 				 _("Updating"),
 				 fwupd_remote_get_id(remote));
-		if (!fwupd_client_refresh_remote(priv->client,
-						 remote,
-						 priv->download_flags,
-						 priv->cancellable,
-						 error))
+		g_ptr_array_add(remotes_refresh, remote);
+	}
+
+	/* download them all at the same time */
+	if (remotes_refresh->len > 0) {
+		if (!fwupd_client_refresh_remotes(priv->client,
+						  remotes_refresh,
+						  priv->download_flags,
+						  priv->cancellable,
+						  error))
 			return FALSE;
-		refresh_cnt++;
 	}
 
 	/* no web remote is declared; try to enable LVFS */
@@ -2110,7 +2114,7 @@ fu_util_download_metadata(FuUtilPrivate *priv, GError **error)
 	}
 
 	/* metadata refreshed recently */
-	if ((priv->flags & FWUPD_INSTALL_FLAG_FORCE) == 0 && refresh_cnt == 0) {
+	if ((priv->flags & FWUPD_INSTALL_FLAG_FORCE) == 0 && remotes_refresh->len == 0) {
 		g_set_error_literal(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_NOTHING_TO_DO,
@@ -2404,8 +2408,60 @@ fu_util_perhaps_refresh_remotes(FuUtilPrivate *priv, GError **error)
 	return fu_util_download_metadata(priv, error);
 }
 
+/* device-id to releases for all devices with upgrades, or %NULL if the daemon is too old */
+static GHashTable *
+fu_util_get_upgrades_all(FuUtilPrivate *priv)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GHashTable) upgrades = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	devices = fwupd_client_get_upgrades_all(priv->client, priv->cancellable, &error_local);
+	if (devices == NULL) {
+		g_debug("getting upgrades for each device: %s", error_local->message);
+		return NULL;
+	}
+	upgrades = g_hash_table_new_full(g_str_hash,
+					 g_str_equal,
+					 g_free,
+					 (GDestroyNotify)g_ptr_array_unref);
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index(devices, i);
+		g_hash_table_insert(upgrades,
+				    g_strdup(fwupd_device_get_id(dev)),
+				    g_ptr_array_ref(fwupd_device_get_releases(dev)));
+	}
+	return g_steal_pointer(&upgrades);
+}
+
+static GPtrArray *
+fu_util_get_upgrades(FuUtilPrivate *priv, GHashTable *upgrades, FwupdDevice *dev, GError **error)
+{
+	GPtrArray *rels;
+
+	if (upgrades == NULL) {
+		return fwupd_client_get_upgrades(priv->client,
+						 fwupd_device_get_id(dev),
+						 priv->cancellable,
+						 error);
+	}
+	rels = g_hash_table_lookup(upgrades, fwupd_device_get_id(dev));
+	if (rels == NULL) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOTHING_TO_DO,
+			    "no upgrades for %s",
+			    fwupd_device_get_id(dev));
+		return NULL;
+	}
+	return g_ptr_array_ref(rels);
+}
+
 static gboolean
-fu_util_get_updates_as_json(FuUtilPrivate *priv, GPtrArray *devices, GError **error)
+fu_util_get_updates_as_json(FuUtilPrivate *priv,
+			    GPtrArray *devices,
+			    GHashTable *upgrades,
+			    GError **error)
 {
 	g_autoptr(JsonBuilder) builder = json_builder_new();
 	json_builder_begin_object(builder);
@@ -2421,10 +2477,7 @@ fu_util_get_updates_as_json(FuUtilPrivate *priv, GPtrArray *devices, GError **er
 			continue;
 
 		/* get the releases for this device and filter for validity */
-		rels = fwupd_client_get_upgrades(priv->client,
-						 fwupd_device_get_id(dev),
-						 priv->cancellable,
-						 &error_local);
+		rels = fu_util_get_upgrades(priv, upgrades, dev, &error_local);
 		if (rels == NULL) {
 			g_debug("no upgrades: %s", error_local->message);
 			continue;
@@ -2453,6 +2506,7 @@ fu_util_get_updates(FuUtilPrivate *priv, gchar **values, GError **error)
 {
 	g_autoptr(GPtrArray) devices = NULL;
 	gboolean supported = FALSE;
+	g_autoptr(GHashTable) upgrades = NULL;
 	g_autoptr(FuUtilNode) root = g_node_new(NULL);
 	g_autoptr(GPtrArray) devices_no_support = g_ptr_array_new();
 	g_autoptr(GPtrArray) devices_no_upgrades = g_ptr_array_new();
@@ -2466,6 +2520,9 @@ fu_util_get_updates(FuUtilPrivate *priv, gchar **values, GError **error)
 		devices = fwupd_client_get_devices(priv->client, priv->cancellable, error);
 		if (devices == NULL)
 			return FALSE;
+
+		/* save a D-Bus round-trip for each device */
+		upgrades = fu_util_get_upgrades_all(priv);
 	} else if (g_strv_length(values) == 1) {
 		FwupdDevice *device = fu_util_get_device_by_id(priv, values[0], error);
 		if (device == NULL)
@@ -2483,7 +2540,7 @@ fu_util_get_updates(FuUtilPrivate *priv, gchar **values, GError **error)
 
 	/* not for human consumption */
 	if (priv->as_json)
-		return fu_util_get_updates_as_json(priv, devices, error);
+		return fu_util_get_updates_as_json(priv, devices, upgrades, error);
 
 	for (guint i = 0; i < devices->len; i++) {
 		FwupdDevice *dev = g_ptr_array_index(devices, i);
@@ -2506,10 +2563,7 @@ fu_util_get_updates(FuUtilPrivate *priv, gchar **values, GError **error)
 		supported = TRUE;
 
 		/* get the releases for this device and filter for validity */
-		rels = fwupd_client_get_upgrades(priv->client,
-						 fwupd_device_get_id(dev),
-						 priv->cancellable,
-						 &error_local);
+		rels = fu_util_get_upgrades(priv, upgrades, dev, &error_local);
 		if (rels == NULL) {
 			g_ptr_array_add(devices_no_upgrades, dev);
 			/* discard the actual reason from user, but leave for debugging */